@@ -9,15 +9,20 @@
 #type vertex
 #version 330 core
 
+// Vertex of unit quad
 layout(location = 0) in vec3  a_Position;
-layout(location = 1) in vec4  a_Color;
-layout(location = 2) in vec2  a_TexCoord;
-layout(location = 3) in float a_TexIndex;
-layout(location = 4) in float a_TilingFactor;
-layout(location = 5) in vec3  a_LocalPosition;
-layout(location = 6) in float a_Thickness;
-layout(location = 7) in float a_Fade;
-layout(location = 8) in int   a_ObjectID;
+
+// Instance of circle. Transform is stored as first three rows of affine matrix
+layout(location = 1) in vec4  a_TransformRow0;
+layout(location = 2) in vec4  a_TransformRow1;
+layout(location = 3) in vec4  a_TransformRow2;
+layout(location = 4) in vec4  a_Color;
+layout(location = 5) in float a_TexIndex;
+layout(location = 6)  in float a_TilingFactor;
+layout(location = 7)  in float a_TexLayer;
+layout(location = 8)  in float a_Thickness;
+layout(location = 9)  in float a_Fade;
+layout(location = 10) in int   a_ObjectID;
 
 uniform mat4 u_ViewProjection;
 
@@ -28,6 +33,7 @@ out VS_OUT
   vec2  TexCoord;
   float TexIndex;
   float TilingFactor;
+  float TexLayer;
   float Thickness;
   float Fade;
   float ObjectID;
@@ -35,16 +41,22 @@ out VS_OUT
 
 void main()
 {
-  vs_out.LocalPosition = a_LocalPosition;
+  vec4 position = vec4(a_Position, 1.0);
+  vec3 world_position = vec3(dot(a_TransformRow0, position),
+                             dot(a_TransformRow1, position),
+                             dot(a_TransformRow2, position));
+  
+  vs_out.LocalPosition = a_Position * 2.0;
   vs_out.Color         = a_Color;
-  vs_out.TexCoord      = a_TexCoord;
+  vs_out.TexCoord      = a_Position.xy * 2.0;
   vs_out.TexIndex      = a_TexIndex;
   vs_out.TilingFactor  = a_TilingFactor;
+  vs_out.TexLayer      = a_TexLayer;
   vs_out.Thickness     = a_Thickness;
   vs_out.Fade          = a_Fade;
   vs_out.ObjectID      = a_ObjectID;
   
-  gl_Position = u_ViewProjection * vec4(a_Position, 1.0);
+  gl_Position = u_ViewProjection * vec4(world_position, 1.0);
 }
 
 // Fragment Shader
@@ -60,34 +72,37 @@ in VS_OUT
   vec2  TexCoord;
   float TexIndex;
   float TilingFactor;
+  float TexLayer;
   float Thickness;
   float Fade;
   float ObjectID;
 } fs_in;
 
-uniform sampler2D u_Textures[16];
+// Each slot is a texture array, layer of texture is third texture coordinate
+uniform sampler2DArray u_Textures[16];
 
 void main()
 {
   vec4 texColor = fs_in.Color;
+  vec3 tex_coord = vec3(fs_in.TexCoord * fs_in.TilingFactor, fs_in.TexLayer);
   switch(int(fs_in.TexIndex))
   {
-    case 0: texColor *= texture(u_Textures[0], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 1: texColor *= texture(u_Textures[1], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 2: texColor *= texture(u_Textures[2], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 3: texColor *= texture(u_Textures[3], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 4: texColor *= texture(u_Textures[4], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 5: texColor *= texture(u_Textures[5], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 6: texColor *= texture(u_Textures[6], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 7: texColor *= texture(u_Textures[7], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 8: texColor *= texture(u_Textures[8], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 9: texColor *= texture(u_Textures[9], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 10: texColor *= texture(u_Textures[10], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 11: texColor *= texture(u_Textures[11], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 12: texColor *= texture(u_Textures[12], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 13: texColor *= texture(u_Textures[13], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 14: texColor *= texture(u_Textures[14], fs_in.TexCoord * fs_in.TilingFactor); break;
-    case 15: texColor *= texture(u_Textures[15], fs_in.TexCoord * fs_in.TilingFactor); break;
+    case 0: texColor *= texture(u_Textures[0], tex_coord); break;
+    case 1: texColor *= texture(u_Textures[1], tex_coord); break;
+    case 2: texColor *= texture(u_Textures[2], tex_coord); break;
+    case 3: texColor *= texture(u_Textures[3], tex_coord); break;
+    case 4: texColor *= texture(u_Textures[4], tex_coord); break;
+    case 5: texColor *= texture(u_Textures[5], tex_coord); break;
+    case 6: texColor *= texture(u_Textures[6], tex_coord); break;
+    case 7: texColor *= texture(u_Textures[7], tex_coord); break;
+    case 8: texColor *= texture(u_Textures[8], tex_coord); break;
+    case 9: texColor *= texture(u_Textures[9], tex_coord); break;
+    case 10: texColor *= texture(u_Textures[10], tex_coord); break;
+    case 11: texColor *= texture(u_Textures[11], tex_coord); break;
+    case 12: texColor *= texture(u_Textures[12], tex_coord); break;
+    case 13: texColor *= texture(u_Textures[13], tex_coord); break;
+    case 14: texColor *= texture(u_Textures[14], tex_coord); break;
+    case 15: texColor *= texture(u_Textures[15], tex_coord); break;
   }
   if(texColor.a < 0.1)
     discard;
@@ -11,12 +11,11 @@
 
 namespace ikan {
   
-  EditorCamera::EditorCamera(bool update_rays,
-                             float aspect_ratio,
+  EditorCamera::EditorCamera(float aspect_ratio,
                              float fov,
                              float near_plane,
                              float far_plane)
-  : Camera(aspect_ratio, near_plane, far_plane), fov_(fov), update_rays_(update_rays) {
+  : Camera(aspect_ratio, near_plane, far_plane), fov_(fov) {
     UpdateCameraProjection();
     
     position_ = { -15, 5, 5};
@@ -25,9 +24,6 @@ namespace ikan {
     // Update the camera view matrix
     UpdateCameraView();
     
-    // Update the ray directions
-    UpdateRayDirections();
-    
     IK_CORE_TRACE(LogModule::EditorCamera, "Creating Editor Camera ... ");
     IK_CORE_TRACE(LogModule::EditorCamera, "  FOV          | {0} degree", glm::degrees(fov_));
     IK_CORE_TRACE(LogModule::EditorCamera, "  Aspect Ratio | {0}", aspect_ratio_);
@@ -124,7 +120,6 @@ namespace ikan {
     
     if (moved) {
       UpdateCameraView();
-      UpdateRayDirections();
     }
 
     return moved;
@@ -140,7 +135,6 @@ namespace ikan {
     MouseZoom(delta);
     
     UpdateCameraView();
-    UpdateRayDirections();
     return false;
   }
   
@@ -154,7 +148,6 @@ namespace ikan {
     
     UpdateCameraProjection();
     UpdateCameraView();
-    UpdateRayDirections();
     IK_CORE_TRACE(LogModule::EditorCamera, "Changing Viewport Size of Editor Camera : {0} x {1}."
                   "(NOTE: Updating View Projection Matrix)", width, height);
   }
@@ -179,24 +172,6 @@ namespace ikan {
     inverse_view_ = glm::inverse(view_matrix_);
   }
   
-  void EditorCamera::UpdateRayDirections() {
-    if (!update_rays_)
-      return;
-    
-    ray_directions_.resize(viewport_width_ * viewport_height_);
-    
-    dispatch_apply(viewport_height_, loop_dispactch_queue_, ^(size_t y) {
-      dispatch_apply(viewport_width_, loop_dispactch_queue_, ^(size_t x) {
-        glm::vec2 coord = { (float)x / (float)viewport_width_, (float)y / (float)viewport_height_ };
-        coord = coord * 2.0f - 1.0f; // -1 -> 1
-        
-        glm::vec4 target = inverse_projection_ * glm::vec4(coord.x, coord.y, 1, 1);
-        glm::vec3 ray_direction = glm::vec3(inverse_view_ * glm::vec4(glm::normalize(glm::vec3(target) / target.w), 0)); // World space
-        ray_directions_[x + y * viewport_width_] = ray_direction;
-      });
-    });
-  }
-  
   void EditorCamera::MouseZoom(float delta) {
     distance_ -= delta * ZoomSpeed();
     if (distance_ < 0.0f) {
@@ -252,9 +227,6 @@ namespace ikan {
     
     // Update the camera view matrix
     UpdateCameraView();
-    
-    // Update the ray directions
-    UpdateRayDirections();
   }
   
   void EditorCamera::RendererGui(bool *is_open) {
@@ -282,7 +254,6 @@ namespace ikan {
     if (modified) {
       UpdateCameraProjection();
       UpdateCameraView();
-      UpdateRayDirections();
     }
     
     ImGui::PopID();
@@ -330,8 +301,11 @@ namespace ikan {
   uint32_t EditorCamera::GetViewportWidth() const {
     return viewport_width_;
   }
-  const std::vector<glm::vec3>& EditorCamera::GetRayDirections() const {
-    return ray_directions_;
+  const glm::mat4& EditorCamera::GetInverseView() const {
+    return inverse_view_;
+  }
+  const glm::mat4& EditorCamera::GetInverseProjection() const {
+    return inverse_projection_;
   }
 
 }
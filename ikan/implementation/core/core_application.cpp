@@ -111,6 +111,9 @@ namespace ikan {
       
       if (specification_.enable_gui)
         RenderGui();
+      
+      // Fence the draw calls of frame
+      Renderer::EndFrame();
     }
 
     IK_CORE_INFO(LogModule::None, "--------------------------------------------------------------------------");
@@ -0,0 +1,96 @@
+//
+//  thread_pool.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "thread_pool.hpp"
+
+namespace ikan {
+  
+  ThreadPool::ThreadPool(uint32_t num_threads) {
+    if (num_threads == 0)
+      num_threads = std::max(1u, std::thread::hardware_concurrency());
+    
+    // Calling thread is also a worker
+    for (uint32_t thread_idx = 1; thread_idx < num_threads; thread_idx++) {
+      workers_.emplace_back(&ThreadPool::WorkerLoop, this, thread_idx);
+    }
+  }
+  
+  ThreadPool::~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    start_condition_.notify_all();
+    for (auto& worker : workers_) {
+      worker.join();
+    }
+  }
+  
+  void ThreadPool::ParallelFor(uint32_t count, const Job& job) {
+    if (count == 0)
+      return;
+    
+    // No need to wake the workers for single job
+    if (workers_.empty() or count == 1) {
+      for (uint32_t index = 0; index < count; index++)
+        job(index, 0);
+      return;
+    }
+    
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      job_ = &job;
+      job_count_ = count;
+      next_index_.store(0, std::memory_order_relaxed);
+      active_workers_ = (uint32_t)workers_.size();
+      generation_++;
+    }
+    start_condition_.notify_all();
+    
+    RunJobs(0);
+    
+    // Wait for workers to finish their last job
+    std::unique_lock<std::mutex> lock(mutex_);
+    finish_condition_.wait(lock, [this]() { return active_workers_ == 0; });
+    job_ = nullptr;
+  }
+  
+  void ThreadPool::WorkerLoop(uint32_t thread_idx) {
+    uint64_t last_generation = 0;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        start_condition_.wait(lock, [&]() { return stop_ or generation_ != last_generation; });
+        if (stop_)
+          return;
+        last_generation = generation_;
+      }
+      
+      RunJobs(thread_idx);
+      
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        active_workers_--;
+      }
+      finish_condition_.notify_one();
+    }
+  }
+  
+  void ThreadPool::RunJobs(uint32_t thread_idx) {
+    while (true) {
+      uint32_t index = next_index_.fetch_add(1, std::memory_order_relaxed);
+      if (index >= job_count_)
+        break;
+      (*job_)(index, thread_idx);
+    }
+  }
+  
+  uint32_t ThreadPool::GetNumThreads() const {
+    return (uint32_t)workers_.size() + 1;
+  }
+  
+}
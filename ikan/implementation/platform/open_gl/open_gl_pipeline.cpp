@@ -78,8 +78,17 @@ namespace ikan {
   
   void OpenGLPipeline::Bind() const {
     glBindVertexArray(renderer_id_);
-    for (auto vb : vertex_buffers_)
+    for (size_t i = 0; i < vertex_buffers_.size(); i++) {
+      const auto& vb = vertex_buffers_[i];
       vb->Bind();
+      
+      // Stream buffer draws each batch from different region, so attributes are pointed to current one
+      uint32_t base_offset = vb->GetBaseOffset();
+      if (base_offset != base_offsets_[i]) {
+        SetVertexAttributes(*vb, first_attribute_indices_[i], base_offset);
+        base_offsets_[i] = base_offset;
+      }
+    }
     
     if (index_buffer_)
       index_buffer_->Bind();
@@ -98,7 +107,9 @@ namespace ikan {
     glBindVertexArray(renderer_id_);
     vertex_buffers_.push_back(vertexBuffer);
     
-    uint32_t index = 0;
+    // Attribute pointers are taken from buffer bound at this time
+    vertexBuffer->Bind();
+    
     const auto& layout = vertexBuffer->GetLayout();
     
     IK_CORE_DEBUG(LogModule::Pipeline, "  Storing the Vertex Buffer (ID: {0}) into Pipeline (ID: {1})",
@@ -125,7 +136,22 @@ namespace ikan {
       }
       IK_CORE_DEBUG(LogModule::Pipeline, "      Offset | {0}", element.offset);
       IK_CORE_DEBUG(LogModule::Pipeline, "      Size   | {0}", element.size);
-      
+    } // for (const auto& element : layout.GetElements())
+    
+    first_attribute_indices_.push_back(vertex_attribute_index_);
+    base_offsets_.push_back(vertexBuffer->GetBaseOffset());
+    vertex_attribute_index_ = SetVertexAttributes(*vertexBuffer, vertex_attribute_index_, base_offsets_.back());
+  }
+  
+  uint32_t OpenGLPipeline::SetVertexAttributes(const VertexBuffer& vertex_buffer,
+                                               uint32_t first_index,
+                                               uint32_t base_offset) const {
+    uint32_t index = first_index;
+    const auto& layout = vertex_buffer.GetLayout();
+    const uint32_t divisor = layout.IsPerInstance() ? 1 : 0;
+    
+    for (const auto& element : layout.GetElements()) {
+      const size_t offset = base_offset + element.offset;
       switch (element.type) {
         case ShaderDataType::Int:
         case ShaderDataType::Int2:
@@ -137,7 +163,8 @@ namespace ikan {
                                  (int)element.count,
                                  ShaderDataTypeToOpenGLBaseType(element.type),
                                  (int)layout.GetStride(),
-                                 (const void*)element.offset);
+                                 (const void*)offset);
+          glVertexAttribDivisor(index, divisor);
           index++;
           break;
         }
@@ -152,7 +179,8 @@ namespace ikan {
                                 ShaderDataTypeToOpenGLBaseType(element.type),
                                 element.normalized ? GL_TRUE : GL_FALSE,
                                 (int)layout.GetStride(),
-                                (const void*)element.offset);
+                                (const void*)offset);
+          glVertexAttribDivisor(index, divisor);
           index++;
           break;
         }
@@ -166,7 +194,7 @@ namespace ikan {
                                   ShaderDataTypeToOpenGLBaseType(element.type),
                                   element.normalized ? GL_TRUE : GL_FALSE,
                                   (int)layout.GetStride(),
-                                  (const void*)(sizeof(float) * count * i));
+                                  (const void*)(base_offset + sizeof(float) * count * i));
             glVertexAttribDivisor(index, 1);
             index++;
           }
@@ -177,6 +205,7 @@ namespace ikan {
         }
       } // switch (element.Type)
     } // for (const auto& element : layout.GetElements())
+    return index;
   }
   
   void OpenGLPipeline::SetIndexBuffer(const std::shared_ptr<IndexBuffer>& indexBuffer) {
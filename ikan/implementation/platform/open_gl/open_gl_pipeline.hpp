@@ -49,9 +49,21 @@ namespace ikan {
     const std::shared_ptr<IndexBuffer>& GetIndexBuffer() const override;
 
   private:
+    /// This function points the attributes of vertex buffer to its data at base offset. Returns next location
+    /// - Parameters:
+    ///   - vertex_buffer: vertex buffer (bound) having layout of attributes
+    ///   - first_index: location of first attribute of buffer
+    ///   - base_offset: offset of vertices in buffer
+    uint32_t SetVertexAttributes(const VertexBuffer& vertex_buffer, uint32_t first_index, uint32_t base_offset) const;
+    
     RendererID renderer_id_ = 0;
     std::vector<std::shared_ptr<VertexBuffer>> vertex_buffers_;
     std::shared_ptr<IndexBuffer> index_buffer_;
+    /// Next attribute location, so that attributes of each vertex buffer follow the previous one
+    uint32_t vertex_attribute_index_ = 0;
+    /// First attribute location of each vertex buffer, and offset of buffer its attributes point to
+    std::vector<uint32_t> first_attribute_indices_;
+    mutable std::vector<uint32_t> base_offsets_;
   };
   
 } // namespace ikan
@@ -161,6 +161,19 @@ namespace ikan {
     pipeline->Unbind();
   }
 
+  void OpenGLRendererAPI::DrawIndexedInstanced(const std::shared_ptr<Pipeline>& pipeline,
+                                               uint32_t count,
+                                               uint32_t instance_count) const {
+    pipeline->Bind();
+    uint32_t index_count = (count ? count : pipeline->GetIndexBuffer()->GetCount());
+    glDrawElementsInstanced(GL_TRIANGLES, (GLsizei)index_count, GL_UNSIGNED_INT, nullptr, (GLsizei)instance_count);
+    
+    // Unbinding Textures and va
+    glBindTexture(GL_TEXTURE_2D, 0);
+    RendererStatistics::Get().draw_calls++;
+    pipeline->Unbind();
+  }
+
   void OpenGLRendererAPI::DrawLines(const std::shared_ptr<Pipeline>& pipeline,
                                     uint32_t vertex_count) const {
     pipeline->Bind();
@@ -84,6 +84,187 @@ namespace ikan {
   const BufferLayout& OpenGLVertexBuffer::GetLayout() const { return layout_; }
   RendererID OpenGLVertexBuffer::GetRendererID() const { return renderer_id_; }
   uint32_t OpenGLVertexBuffer::GetSize() const { return size_; }
+  uint32_t OpenGLVertexBuffer::GetBaseOffset() const { return 0; }
+  
+  // --------------------------------------------------------------------------
+  // Stream Vertex Buffer
+  // --------------------------------------------------------------------------
+  namespace stream_buffer_utils {
+    
+    /// Batches start at this alignment in region
+    static constexpr uint32_t kBatchAlignment = 64;
+    
+    /// This function rounds the size up to alignment of batch
+    /// - Parameter size: size in bytes
+    static uint32_t AlignBatch(uint32_t size) {
+      return (size + kBatchAlignment - 1) / kBatchAlignment * kBatchAlignment;
+    }
+    
+    /// Stream buffers alive, to end their frame together
+    static std::vector<OpenGLStreamVertexBuffer*> buffers;
+    
+  } // namespace stream_buffer_utils
+  
+  OpenGLStreamVertexBuffer::OpenGLStreamVertexBuffer(uint32_t batch_size,
+                                                     uint32_t batches_per_frame,
+                                                     uint32_t num_regions)
+  : batch_size_(batch_size),
+  region_size_(stream_buffer_utils::AlignBatch(batch_size) * std::max(batches_per_frame, 1u)),
+  num_regions_(std::max(num_regions, 1u)), fences_(num_regions_, nullptr) {
+    IDManager::GetBufferId(renderer_id_);
+    
+    glBindBuffer(GL_ARRAY_BUFFER, renderer_id_);
+    const uint32_t size = GetSize();
+    if (GLAD_GL_VERSION_4_4) {
+      const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+      glBufferStorage(GL_ARRAY_BUFFER, size, nullptr, flags);
+      persistent_data_ = (uint8_t*)glMapBufferRange(GL_ARRAY_BUFFER, 0, size, flags);
+    }
+    else {
+      glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW);
+    }
+    
+    RendererStatistics::Get().vertex_buffer_size += size;
+    stream_buffer_utils::buffers.push_back(this);
+    
+    IK_CORE_DEBUG(LogModule::VertexBuffer, "Creating Open GL Stream Vertex Buffer ...");
+    IK_CORE_DEBUG(LogModule::VertexBuffer, "  Renderer ID      | {0}", renderer_id_);
+    IK_CORE_DEBUG(LogModule::VertexBuffer, "  Regions          | {0} x {1} Bytes ({2} KB)",
+                  num_regions_, region_size_, region_size_ / 1000);
+    IK_CORE_DEBUG(LogModule::VertexBuffer, "  Batches          | {0} x {1} Bytes per Region",
+                  region_size_ / stream_buffer_utils::AlignBatch(batch_size_), batch_size_);
+    IK_CORE_DEBUG(LogModule::VertexBuffer, "  Mapping          | {0}",
+                  persistent_data_ ? "Persistent (Buffer Storage)" : "Per Batch (Orphaning)");
+  }
+  
+  OpenGLStreamVertexBuffer::~OpenGLStreamVertexBuffer() {
+    RendererStatistics::Get().vertex_buffer_size -= GetSize();
+    
+    IK_CORE_WARN(LogModule::VertexBuffer, "Destroying Open GL Stream Vertex Buffer !!!");
+    IK_CORE_WARN(LogModule::VertexBuffer, "  Renderer ID | {0}", renderer_id_);
+    IK_CORE_WARN(LogModule::VertexBuffer, "  Size        | {0} Bytes ({1} KB, {2} MB)",
+                 GetSize(), GetSize() / 1000, GetSize() / 1000000);
+    
+    std::vector<OpenGLStreamVertexBuffer*>& buffers = stream_buffer_utils::buffers;
+    buffers.erase(std::remove(buffers.begin(), buffers.end(), this), buffers.end());
+    
+    for (GLsync fence : fences_)
+      if (fence)
+        glDeleteSync(fence);
+    
+    if (persistent_data_ or mapped_) {
+      glBindBuffer(GL_ARRAY_BUFFER, renderer_id_);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+    IDManager::RemoveBufferId(renderer_id_);
+  }
+  
+  void* OpenGLStreamVertexBuffer::Map() {
+    if (mapped_)
+      Unmap(0);
+    
+    // Batches of a frame that does not fit in its region are written in next region, which may wait for GPU
+    if (write_offset_ + batch_size_ > region_size_) {
+      if (!overflow_warned_) {
+        uint32_t batches_per_frame = region_size_ / stream_buffer_utils::AlignBatch(batch_size_);
+        IK_CORE_WARN(LogModule::VertexBuffer, "Frame has more than {0} batches of Stream Vertex Buffer {1}, next "
+                     "batches wait for the region of older frame", batches_per_frame, renderer_id_);
+        overflow_warned_ = true;
+      }
+      NextRegion();
+    }
+    
+    // Region is waited for only at its first batch, GPU has drawn it (few frames back) by then in general
+    if (write_offset_ == 0)
+      WaitRegion();
+    
+    batch_offset_ = write_offset_;
+    region_used_ = true;
+    mapped_ = true;
+    
+    if (persistent_data_)
+      return persistent_data_ + GetBaseOffset();
+    
+    glBindBuffer(GL_ARRAY_BUFFER, renderer_id_);
+    return glMapBufferRange(GL_ARRAY_BUFFER, GetBaseOffset(), batch_size_,
+                            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+  }
+  
+  void OpenGLStreamVertexBuffer::Unmap(uint32_t size) {
+    IK_CORE_ASSERT(size <= batch_size_, "Data is larger than batch of stream buffer");
+    if (!mapped_)
+      return;
+    
+    mapped_ = false;
+    write_offset_ += stream_buffer_utils::AlignBatch(size);
+    if (!persistent_data_) {
+      glBindBuffer(GL_ARRAY_BUFFER, renderer_id_);
+      glUnmapBuffer(GL_ARRAY_BUFFER);
+    }
+  }
+  
+  void OpenGLStreamVertexBuffer::NextRegion() {
+    if (mapped_)
+      Unmap(0);
+    if (!region_used_)
+      return;
+    
+    // Fence covers the draw calls of current region, issued before this call
+    if (persistent_data_)
+      fences_[region_index_] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    
+    region_index_ = (region_index_ + 1) % num_regions_;
+    batch_offset_ = 0;
+    write_offset_ = 0;
+    region_used_ = false;
+    
+    // Orphaning gives new storage to the ring, so that regions of last cycle can still be drawn by GPU
+    if (!persistent_data_ and region_index_ == 0) {
+      glBindBuffer(GL_ARRAY_BUFFER, renderer_id_);
+      glBufferData(GL_ARRAY_BUFFER, GetSize(), nullptr, GL_STREAM_DRAW);
+    }
+  }
+  
+  void OpenGLStreamVertexBuffer::WaitRegion() {
+    GLsync fence = fences_[region_index_];
+    if (!fence)
+      return;
+    
+    GLbitfield wait_flags = 0;
+    while (true) {
+      GLenum result = glClientWaitSync(fence, wait_flags, 1000000 /* 1 ms */);
+      if (result == GL_ALREADY_SIGNALED or result == GL_CONDITION_SATISFIED or result == GL_WAIT_FAILED)
+        break;
+      wait_flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+    }
+    glDeleteSync(fence);
+    fences_[region_index_] = nullptr;
+  }
+  
+  void OpenGLStreamVertexBuffer::EndFrameOfBuffers() {
+    for (OpenGLStreamVertexBuffer* buffer : stream_buffer_utils::buffers)
+      buffer->NextRegion();
+  }
+  
+  void OpenGLStreamVertexBuffer::SetData(void* data, uint32_t size) {
+    memcpy(Map(), data, size);
+    Unmap(size);
+  }
+  
+  void OpenGLStreamVertexBuffer::Bind() const {
+    glBindBuffer(GL_ARRAY_BUFFER, renderer_id_);
+  }
+  
+  void OpenGLStreamVertexBuffer::Unbind() const {
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+  }
+  
+  void OpenGLStreamVertexBuffer::AddLayout(const BufferLayout& layout) { layout_ = layout; }
+  const BufferLayout& OpenGLStreamVertexBuffer::GetLayout() const { return layout_; }
+  RendererID OpenGLStreamVertexBuffer::GetRendererID() const { return renderer_id_; }
+  uint32_t OpenGLStreamVertexBuffer::GetSize() const { return region_size_ * num_regions_; }
+  uint32_t OpenGLStreamVertexBuffer::GetBaseOffset() const { return region_index_ * region_size_ + batch_offset_; }
+  uint32_t OpenGLStreamVertexBuffer::GetBatchSize() const { return batch_size_; }
 
   // --------------------------------------------------------------------------
   // Index Buffer
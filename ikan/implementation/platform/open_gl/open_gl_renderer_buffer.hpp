@@ -10,6 +10,7 @@
 // This file includes the implementaiton of Open GL Renderer Buffers
 
 #include "renderer/graphics/renderer_buffer.hpp"
+#include <glad/glad.h>
 
 namespace ikan {
   
@@ -59,6 +60,8 @@ namespace ikan {
     const BufferLayout& GetLayout() const override;
     /// This function returns the size of Vertex Buffer in GPU
     uint32_t GetSize() const override;
+    /// This function returns the offset of vertices of next draw call in buffer (always 0)
+    uint32_t GetBaseOffset() const override;
 
   public:
     RendererID renderer_id_ = 0;
@@ -66,6 +69,94 @@ namespace ikan {
     BufferLayout layout_;
   };
   
+  /// This class is the implementation of Open GL Renderer Stream Vertex Buffer. With buffer storage (Open GL 4.4)
+  /// whole buffer is mapped once, persistent and coherent, and region of each frame is guarded by a fence placed
+  /// at the end of frame. Without it, buffer is orphaned each time the ring wraps, and each batch is mapped
+  /// unsynchronized, as GPU never draws from a range of new storage before it is written
+  class OpenGLStreamVertexBuffer : public StreamVertexBuffer {
+  public:
+    // ---------------------------------
+    // Constructors and Destructor
+    // ---------------------------------
+    /// This constructor creates the Buffer of all the regions
+    /// - Parameters:
+    ///   - batch_size: size of data of single batch
+    ///   - batches_per_frame: number of batches in region of a frame
+    ///   - num_regions: number of regions in buffer
+    OpenGLStreamVertexBuffer(uint32_t batch_size, uint32_t batches_per_frame, uint32_t num_regions);
+    /// This destructor destroy the Renderer Stream Vertex Buffer
+    ~OpenGLStreamVertexBuffer();
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(OpenGLStreamVertexBuffer);
+    
+    // --------------
+    // Fundamentals
+    // --------------
+    /// This function uptate the Buffer layeout value in Vertex Buffer
+    /// - Parameter layout: new Buffer layout
+    void AddLayout(const BufferLayout& layout) override;
+    /// This function writes the data in next batch and ends it
+    /// - Parameters:
+    ///   - data: Data pointer to be stored in GPU
+    ///   - size: size of data
+    void SetData(void* data, uint32_t size) override;
+    /// This function returns the pointer to write the vertices of next batch
+    void* Map() override;
+    /// This function ends the writing of batch
+    /// - Parameter size: number of bytes written in batch
+    void Unmap(uint32_t size) override;
+    /// This function binds the Vertex Buffer before rendering
+    void Bind() const override;
+    /// This function unbinds the Vertex Buffer after rendering
+    void Unbind() const override;
+    
+    // -----------
+    // Getters
+    // -----------
+    /// This function returns the renderer ID of Vertex Buffer
+    RendererID GetRendererID() const override;
+    /// This function returns the Buffer layout stored in Vertex Buffer
+    const BufferLayout& GetLayout() const override;
+    /// This function returns the size of Vertex Buffer in GPU
+    uint32_t GetSize() const override;
+    /// This function returns the offset of current batch in buffer
+    uint32_t GetBaseOffset() const override;
+    /// This function returns the maximum size of one batch
+    uint32_t GetBatchSize() const override;
+    
+    // -----------------
+    // Static Function
+    // -----------------
+    /// This static function ends the frame of all the stream buffers
+    static void EndFrameOfBuffers();
+    
+  private:
+    // Member Functions
+    /// This function places the fence of current region, if used, and moves to next region
+    void NextRegion();
+    /// This function waits till GPU has finished drawing from current region
+    void WaitRegion();
+    
+    // Member Variables
+    RendererID renderer_id_ = 0;
+    uint32_t batch_size_ = 0, region_size_ = 0, num_regions_ = 0;
+    BufferLayout layout_;
+    
+    /// Region of current frame, offset of current batch and offset of next batch in region
+    uint32_t region_index_ = 0;
+    uint32_t batch_offset_ = 0, write_offset_ = 0;
+    bool mapped_ = false;
+    /// True when a batch is given by 'Map()' in current region, so that its fence is placed at the end of frame
+    bool region_used_ = false;
+    /// True once a frame has more batches than its region, to warn only once
+    bool overflow_warned_ = false;
+    
+    /// Persistent mapping of whole buffer. Null if buffer storage is not supported
+    uint8_t* persistent_data_ = nullptr;
+    /// Fence of each region, placed after the draw calls of its frame
+    std::vector<GLsync> fences_;
+  };
+  
   /// This class is the implementation of Open GL of Renderer Index Buffer, to store the indices of the objects.
   class OpenGLIndexBuffer : public IndexBuffer {
   public:
@@ -138,6 +138,7 @@ namespace ikan {
   OpenGLShaderResourceDeclaration::StringToType(const std::string& type) {
     if (type == "sampler2D")    return Type::kTexture2D;
     if (type == "sampler2DMS")  return Type::kTexture2D;
+    if (type == "sampler2DArray") return Type::kTexture2DArray;
     if (type == "samplerCube")  return Type::kTextureCubeMap;
     
     return Type::kNone;
@@ -147,6 +148,7 @@ namespace ikan {
     switch (type) {
       case Type::kNone:           return "None       ";
       case Type::kTexture2D:      return "sampler2D  ";
+      case Type::kTexture2DArray: return "sampler2DArray";
       case Type::kTextureCubeMap: return "samplerCube";
     }
     return "Invalid Type";
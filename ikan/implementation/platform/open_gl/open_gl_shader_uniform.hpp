@@ -114,7 +114,7 @@ namespace ikan {
   class OpenGLShaderResourceDeclaration : public ShaderResourceDeclaration {
   public:
     enum class Type {
-      kNone, kTexture2D, kTextureCubeMap
+      kNone, kTexture2D, kTexture2DArray, kTextureCubeMap
     };
     
     // ------------------------------
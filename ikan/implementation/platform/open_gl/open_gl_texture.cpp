@@ -23,6 +23,7 @@ namespace ikan {
       if (format == GL_RGB8)        return "GL_RGB8";
       if (format == GL_RGB)         return "GL_RGB";
       if (format == GL_RED)         return "GL_RED";
+      if (format == GL_R8)          return "GL_R8";
       if (format == GL_R32I)        return "GL_R32I";
       if (format == GL_RED_INTEGER) return "GL_RED_INTEGER";
 
@@ -36,15 +37,37 @@ namespace ikan {
       switch (format) {
         case TextureFormat::None:    return (GLint)0;
         case TextureFormat::RGBA:    return GL_RGBA;
+        case TextureFormat::RGB:     return GL_RGB;
+        case TextureFormat::Red:     return GL_RED;
       }
       return (GLint)0;
     }
     
+    GLint ikanFormatToOpenGLInternalFormat(TextureFormat format) {
+      switch (format) {
+        case TextureFormat::None:    return (GLint)0;
+        case TextureFormat::RGBA:    return GL_RGBA8;
+        case TextureFormat::RGB:     return GL_RGB8;
+        case TextureFormat::Red:     return GL_R8;
+      }
+      return (GLint)0;
+    }
+    
+    TextureFormat OpenGLInternalFormatToIkanFormat(GLint internal_format) {
+      switch (internal_format) {
+        case GL_RGBA8:  return TextureFormat::RGBA;
+        case GL_RGB8:   return TextureFormat::RGB;
+        case GL_R8:     return TextureFormat::Red;
+        default:        return TextureFormat::None;
+      }
+    }
+    
     GLint GetTextureType(GLint format_type) {
       switch (format_type) {
         case GL_RGBA8:
         case GL_RGB8:
         case GL_RGBA:
+        case GL_R8:
         case GL_RED:
         case GL_R32I:
           return GL_UNSIGNED_BYTE;
@@ -61,7 +84,7 @@ namespace ikan {
  
   OpenGLTexture::OpenGLTexture(const std::string& file_path,
                                bool linear)
-  : file_path_(file_path), name_(StringUtils::GetNameFromFilePath(file_path)),
+  : linear_(linear), file_path_(file_path), name_(StringUtils::GetNameFromFilePath(file_path)),
   internal_format_(GL_RGBA8), data_format_(GL_RGBA) {
     if (renderer_id_)
       glDeleteTextures(1, &renderer_id_);
@@ -90,7 +113,7 @@ namespace ikan {
           break;
         case 2 :
         case 1 :
-          internal_format_ = GL_RED;
+          internal_format_ = GL_R8;
           data_format_     = GL_RED;
           break;
           
@@ -228,6 +251,142 @@ namespace ikan {
   RendererID OpenGLTexture::GetRendererID() const { return renderer_id_; }
   const std::string& OpenGLTexture::GetfilePath() const { return file_path_; }
   const std::string& OpenGLTexture::GetName() const { return name_; }
+  TextureFormat OpenGLTexture::GetFormat() const {
+    return texture_utils::OpenGLInternalFormatToIkanFormat((GLint)internal_format_);
+  }
+  bool OpenGLTexture::IsLinear() const { return linear_; }
+
+  // --------------------------------------------------------------------------
+  // Texture Array
+  // --------------------------------------------------------------------------
+  OpenGLTextureArray::OpenGLTextureArray(uint32_t width,
+                                         uint32_t height,
+                                         TextureFormat format,
+                                         bool linear,
+                                         uint32_t num_layers)
+  : width_(width), height_(height), num_layers_(num_layers), format_(format),
+  internal_format_((uint32_t)texture_utils::ikanFormatToOpenGLInternalFormat(format)),
+  data_format_((uint32_t)texture_utils::ikanFormatToOpenGLFormat(format)) {
+    // Texture array bound by renderer is restored after the layers are allocated
+    GLint prev_texture_array = 0;
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &prev_texture_array);
+    
+    IDManager::GetTextureId(&renderer_id_);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, renderer_id_);
+    
+    // Setup min and Mag filter
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, (linear ? GL_LINEAR : GL_NEAREST));
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, (linear ? GL_LINEAR : GL_NEAREST));
+    
+    // Texuter Flags
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    
+    // Allocate all the layers, they are filled by 'SetLayer'
+    glTexImage3D(GL_TEXTURE_2D_ARRAY,
+                 0, // Level
+                 (GLint)internal_format_,
+                 (GLsizei)width_,
+                 (GLsizei)height_,
+                 (GLsizei)num_layers_,
+                 0, // Border
+                 data_format_,
+                 texture_utils::GetTextureType((GLint)internal_format_),
+                 nullptr);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)prev_texture_array);
+    
+    uint32_t bytes_per_pixel = format_ == TextureFormat::RGBA ? 4 : (format_ == TextureFormat::RGB ? 3 : 1);
+    size_ = width_ * height_ * num_layers_ * bytes_per_pixel;
+    RendererStatistics::Get().texture_buffer_size += size_;
+    
+    // Framebuffer to read the source textures of 'SetLayer'
+    IDManager::GetFramebufferId(copy_framebuffer_id_);
+    
+    IK_CORE_DEBUG(LogModule::Texture, "Creating Open GL Texture Array ... ");
+    IK_CORE_DEBUG(LogModule::Texture, "  Renderer ID       | {0}", renderer_id_);
+    IK_CORE_DEBUG(LogModule::Texture, "  Width             | {0}", width_);
+    IK_CORE_DEBUG(LogModule::Texture, "  Height            | {0}", height_);
+    IK_CORE_DEBUG(LogModule::Texture, "  Layers            | {0}", num_layers_);
+    IK_CORE_DEBUG(LogModule::Texture, "  Size              | {0} Bytes ({1} KB {2} MB)", size_, (float)size_ / 1000.0f, (float)size_ / 1000000.0f);
+    IK_CORE_DEBUG(LogModule::Texture, "  InternalFormat    | {0}", texture_utils::GetFormatNameFromEnum(internal_format_));
+  }
+  
+  OpenGLTextureArray::~OpenGLTextureArray() noexcept {
+    IK_CORE_WARN(LogModule::Texture, "Destroying Open GL Texture Array ({0} x {1}, {2} Layers) !!! ", width_, height_,
+                 num_layers_);
+    IDManager::RemoveFramebufferId(copy_framebuffer_id_);
+    IDManager::RemoveTextureId(&renderer_id_);
+    RendererStatistics::Get().texture_buffer_size -= size_;
+  }
+  
+  void OpenGLTextureArray::Bind(uint32_t slot) const {
+    glActiveTexture(GL_TEXTURE0 + slot);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, renderer_id_);
+  }
+  
+  void OpenGLTextureArray::Unbind() const {
+    glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+  }
+  
+  void OpenGLTextureArray::SetLayer(uint32_t layer, const Texture& texture) {
+    IK_CORE_ASSERT(texture.GetWidth() == width_ and texture.GetHeight() == height_ and
+                   texture.GetFormat() == format_, "Texture must have size and format of Texture Array");
+    SetRegion(layer, 0, 0, texture);
+  }
+  
+  void OpenGLTextureArray::SetRegion(uint32_t layer, uint32_t x, uint32_t y, const Texture& texture,
+                                     uint32_t extrusion) {
+    const uint32_t width = texture.GetWidth(), height = texture.GetHeight();
+    IK_CORE_ASSERT(layer < num_layers_, "Invalid layer of Texture Array");
+    IK_CORE_ASSERT(x >= extrusion and y >= extrusion and x + width + extrusion <= width_ and
+                   y + height + extrusion <= height_, "Region must be inside the layer of Texture Array");
+    
+    // Texture is attached to read framebuffer and copied in layer without coming to CPU. Framebuffer and texture
+    // array bound by renderer are restored after copy
+    GLint prev_read_framebuffer = 0, prev_texture_array = 0;
+    glGetIntegerv(GL_READ_FRAMEBUFFER_BINDING, &prev_read_framebuffer);
+    glGetIntegerv(GL_TEXTURE_BINDING_2D_ARRAY, &prev_texture_array);
+    
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, copy_framebuffer_id_);
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, texture.GetRendererID(), 0);
+    glReadBuffer(GL_COLOR_ATTACHMENT0);
+    
+    glBindTexture(GL_TEXTURE_2D_ARRAY, renderer_id_);
+    auto copy = [layer](uint32_t dst_x, uint32_t dst_y, uint32_t src_x, uint32_t src_y, uint32_t w, uint32_t h) {
+      glCopyTexSubImage3D(GL_TEXTURE_2D_ARRAY,
+                          0, // Level
+                          (GLint)dst_x, (GLint)dst_y, (GLint)layer, // Offset in array
+                          (GLint)src_x, (GLint)src_y, // Offset in texture
+                          (GLsizei)w,
+                          (GLsizei)h);
+    };
+    copy(x, y, 0, 0, width, height);
+    
+    // Edge rows, columns and corner pixels are repeated, so that filter never samples the neighbour of rectangle
+    const uint32_t right = x + width - 1, top = y + height - 1;
+    for (uint32_t i = 1; i <= extrusion; i++) {
+      copy(x, y - i, 0, 0, width, 1);
+      copy(x, top + i, 0, height - 1, width, 1);
+      copy(x - i, y, 0, 0, 1, height);
+      copy(right + i, y, width - 1, 0, 1, height);
+      for (uint32_t j = 1; j <= extrusion; j++) {
+        copy(x - i, y - j, 0, 0, 1, 1);
+        copy(right + i, y - j, width - 1, 0, 1, 1);
+        copy(x - i, top + j, 0, height - 1, 1, 1);
+        copy(right + i, top + j, width - 1, height - 1, 1, 1);
+      }
+    }
+    
+    glFramebufferTexture2D(GL_READ_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, 0, 0);
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, (GLuint)prev_read_framebuffer);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, (GLuint)prev_texture_array);
+  }
+  
+  RendererID OpenGLTextureArray::GetRendererID() const { return renderer_id_; }
+  uint32_t OpenGLTextureArray::GetWidth() const { return width_; }
+  uint32_t OpenGLTextureArray::GetHeight() const { return height_; }
+  uint32_t OpenGLTextureArray::GetNumLayers() const { return num_layers_; }
+  TextureFormat OpenGLTextureArray::GetFormat() const { return format_; }
 
   // --------------------------------------------------------------------------
   // Char Texture
@@ -352,6 +511,24 @@ namespace ikan {
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
   }
   
+  void OpenGLImage::SetData(void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height) {
+    // Rows of rectangle are read with the stride of whole image
+    glBindTexture(GL_TEXTURE_2D, renderer_id_);
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, width_);
+    glTexSubImage2D(
+                    GL_TEXTURE_2D,
+                    0, // Level
+                    x,
+                    y,
+                    width,
+                    height,
+                    data_format_,
+                    texture_utils::GetTextureType(internal_format_),
+                    static_cast<uint32_t*>(data) + (size_t)y * width_ + x
+                    );
+    glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+  }
+  
   void OpenGLImage::Resize(uint32_t width, uint32_t height) {
     if (image_data_ and width_ == width and height_ == height)
       return;
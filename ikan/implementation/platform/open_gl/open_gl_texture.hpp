@@ -59,11 +59,16 @@ namespace ikan {
     const std::string& GetfilePath() const override;
     /// This function returns name of texture
     const std::string& GetName() const override;
+    /// This function returns the pixel format of texture
+    TextureFormat GetFormat() const override;
+    /// This function returns true if texture is sampled with linear filter
+    bool IsLinear() const override;
         
   public:
     RendererID renderer_id_ = 0;
     
     bool uploaded_ = false;
+    bool linear_ = true;
 
     int32_t width_ = 0, height_ = 0;
     int32_t channel_ = 0;
@@ -74,6 +79,75 @@ namespace ikan {
     std::string file_path_ = "", name_ = "";
   };
   
+  // -------------------------------------------------------------------------
+  // Texture Array Class for Open GL
+  // -------------------------------------------------------------------------
+  /// Implementation for Open GL Texture Array class
+  class OpenGLTextureArray : public TextureArray {
+  public:
+    // ------------------------------
+    // Constructors and Destructors
+    // ------------------------------
+    /// This constructor creates the Open GL Texture Array with empty layers
+    /// - Parameters:
+    ///   - width: width of each layer
+    ///   - height: height of each layer
+    ///   - format: pixel format of layers
+    ///   - linear: min linear filter
+    ///   - num_layers: number of layers
+    OpenGLTextureArray(uint32_t width, uint32_t height, TextureFormat format, bool linear, uint32_t num_layers);
+    /// Default destructor that delete the texture array
+    virtual ~OpenGLTextureArray() noexcept;
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(OpenGLTextureArray);
+    
+    // -------------
+    // Fundamentals
+    // -------------
+    /// This function binds the texture array at slot
+    /// - Parameter slot: shader slot where this texture array to be binded
+    void Bind(uint32_t slot = 0) const override;
+    /// This function unbinds the texture array
+    void Unbind() const override;
+    /// This function copies the texture in a layer. Copy is done by GPU, texture is read through a framebuffer
+    /// - Parameters:
+    ///   - layer: index of layer
+    ///   - texture: texture to be copied
+    void SetLayer(uint32_t layer, const Texture& texture) override;
+    /// This function copies the texture in a rectangle of layer, and repeats its edge pixels around it
+    /// - Parameters:
+    ///   - layer: index of layer
+    ///   - x: first column of rectangle
+    ///   - y: first row of rectangle
+    ///   - texture: texture to be copied
+    ///   - extrusion: number of times edge pixels are repeated out of rectangle
+    void SetRegion(uint32_t layer, uint32_t x, uint32_t y, const Texture& texture, uint32_t extrusion = 0) override;
+    
+    // ----------
+    // Getters
+    // ----------
+    /// This function returns renderer ID of texture array
+    RendererID GetRendererID() const override;
+    /// This function returns width of each layer
+    uint32_t GetWidth() const override;
+    /// This function returns height of each layer
+    uint32_t GetHeight() const override;
+    /// This function returns the number of layers
+    uint32_t GetNumLayers() const override;
+    /// This function returns the pixel format of layers
+    TextureFormat GetFormat() const override;
+    
+  private:
+    RendererID renderer_id_ = 0;
+    RendererID copy_framebuffer_id_ = 0;
+    
+    uint32_t width_ = 0, height_ = 0;
+    uint32_t num_layers_ = 0;
+    uint32_t size_ = 0;
+    TextureFormat format_ = TextureFormat::None;
+    uint32_t internal_format_ = 0, data_format_ = 0;
+  };
+  
   // -------------------------------------------------------------------------
   // Char Texture Class for Open GL
   // -------------------------------------------------------------------------
@@ -160,6 +234,14 @@ namespace ikan {
     /// This function loads the data in GPU
     /// - Parameter data: data to be loaded
     void SetData(void* data) override;
+    /// This function loads the rectangle of data in GPU
+    /// - Parameters:
+    ///   - data: data of whole image, only the pixels of rectangle are read
+    ///   - x: first column of rectangle
+    ///   - y: first row of rectangle
+    ///   - width: width of rectangle
+    ///   - height: height of rectangle
+    void SetData(void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height) override;
     
     // ----------
     // Getters
@@ -203,6 +285,12 @@ namespace ikan {
     /// This function returns the Open GL Format type from i kan type
     /// - Parameter format: i kan type
     GLint ikanFormatToOpenGLFormat(TextureFormat format);
+    /// This function returns the Open GL internal Format from i kan type
+    /// - Parameter format: i kan type
+    GLint ikanFormatToOpenGLInternalFormat(TextureFormat format);
+    /// This function returns the i kan Format from Open GL internal format
+    /// - Parameter internal_format: Open GL internal format
+    TextureFormat OpenGLInternalFormatToIkanFormat(GLint internal_format);
     /// This function returns the texture fype from internal format
     /// - Parameter format_tyoe: format type
     GLint GetTextureType(GLint format_tyoe);
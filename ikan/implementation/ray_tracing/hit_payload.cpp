@@ -12,7 +12,8 @@ namespace ikan {
   HitPayload::HitPayload(const HitPayload& other)
   : hit_distance(other.hit_distance), world_normal(other.world_normal),
   world_position(other.world_position), front_face(other.front_face),
-  object_idx(other.object_idx) {
+  object_idx(other.object_idx), material_idx(other.material_idx),
+  light_idx(other.light_idx) {
     IK_CORE_TRACE(LogModule::HitPayload, "Copying Hit payload ...");
   }
   
@@ -9,6 +9,12 @@
 
 namespace ikan {
   
+  Ray::Ray(const Ray& other)
+  : origin(other.origin), direction(other.direction) { }
+  
+  Ray::Ray(Ray&& other)
+  : origin(other.origin), direction(other.direction) { }
+  
   Ray& Ray::operator=(const Ray &other) {
 //    IK_CORE_TRACE(LogModule::Ray, "Copying Ray ...");
     origin = other.origin;
@@ -0,0 +1,443 @@
+//
+//  ray_bvh.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_bvh.hpp"
+
+namespace ikan {
+
+  /// All the nodes are refit if more than this fraction of primitives changed. Walking up from each changed
+  /// primitive touches most of the tree anyway, and can not be done in parallel
+  static constexpr float kFullRefitRatio = 0.125f;
+  /// Number of nodes of one level refit by one job
+  static constexpr uint32_t kRefitBatchSize = 1024;
+
+  // -------------------------------------------------------------------------
+  // Bounds
+  // -------------------------------------------------------------------------
+  void RayBvh::Bounds::Grow(const glm::vec3& point) {
+    min = glm::min(min, point);
+    max = glm::max(max, point);
+  }
+
+  void RayBvh::Bounds::Grow(const Bounds& other) {
+    min = glm::min(min, other.min);
+    max = glm::max(max, other.max);
+  }
+
+  float RayBvh::Bounds::HalfArea() const {
+    glm::vec3 extent = max - min;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+  }
+
+  glm::vec3 RayBvh::Bounds::Center() const {
+    return (min + max) * 0.5f;
+  }
+
+  // -------------------------------------------------------------------------
+  // BVH
+  // -------------------------------------------------------------------------
+  RayBvh::RayBvh(const RayBvh& other)
+  : nodes_(other.nodes_), primitive_indices_(other.primitive_indices_), parent_indices_(other.parent_indices_),
+  primitive_leaves_(other.primitive_leaves_), primitive_slots_(other.primitive_slots_),
+  level_nodes_(other.level_nodes_), level_offsets_(other.level_offsets_), refit_flags_(other.refit_flags_),
+  sah_cost_(other.sah_cost_), build_cost_(other.build_cost_), dirty_(other.dirty_) { }
+
+  RayBvh::RayBvh(RayBvh&& other)
+  : nodes_(std::move(other.nodes_)), primitive_indices_(std::move(other.primitive_indices_)),
+  parent_indices_(std::move(other.parent_indices_)), primitive_leaves_(std::move(other.primitive_leaves_)),
+  primitive_slots_(std::move(other.primitive_slots_)), level_nodes_(std::move(other.level_nodes_)),
+  level_offsets_(std::move(other.level_offsets_)), refit_flags_(std::move(other.refit_flags_)),
+  sah_cost_(other.sah_cost_), build_cost_(other.build_cost_), dirty_(other.dirty_) { }
+
+  RayBvh& RayBvh::operator=(const RayBvh& other) {
+    nodes_ = other.nodes_;
+    primitive_indices_ = other.primitive_indices_;
+    parent_indices_ = other.parent_indices_;
+    primitive_leaves_ = other.primitive_leaves_;
+    primitive_slots_ = other.primitive_slots_;
+    level_nodes_ = other.level_nodes_;
+    level_offsets_ = other.level_offsets_;
+    refit_flags_ = other.refit_flags_;
+    sah_cost_ = other.sah_cost_;
+    build_cost_ = other.build_cost_;
+    dirty_ = other.dirty_;
+    return *this;
+  }
+
+  RayBvh& RayBvh::operator=(RayBvh&& other) {
+    nodes_ = std::move(other.nodes_);
+    primitive_indices_ = std::move(other.primitive_indices_);
+    parent_indices_ = std::move(other.parent_indices_);
+    primitive_leaves_ = std::move(other.primitive_leaves_);
+    primitive_slots_ = std::move(other.primitive_slots_);
+    level_nodes_ = std::move(other.level_nodes_);
+    level_offsets_ = std::move(other.level_offsets_);
+    refit_flags_ = std::move(other.refit_flags_);
+    sah_cost_ = other.sah_cost_;
+    build_cost_ = other.build_cost_;
+    dirty_ = other.dirty_;
+    return *this;
+  }
+
+  RayBvh::Bounds RayBvh::GetBounds(const RaySphere& sphere) {
+    return { sphere.position - glm::vec3(sphere.radius), sphere.position + glm::vec3(sphere.radius) };
+  }
+
+  void RayBvh::Build(const std::vector<RaySphere>& spheres) {
+    std::vector<Bounds> primitive_bounds(spheres.size());
+    for (size_t i = 0; i < spheres.size(); i++) {
+      primitive_bounds[i] = GetBounds(spheres[i]);
+    }
+    Build(primitive_bounds);
+  }
+
+  void RayBvh::Build(const std::vector<Bounds>& primitive_bounds) {
+    Clear();
+    if (primitive_bounds.empty())
+      return;
+
+    const uint32_t num_primitives = (uint32_t)primitive_bounds.size();
+
+    std::vector<glm::vec3> centroids(num_primitives);
+    primitive_indices_.resize(num_primitives);
+    for (uint32_t i = 0; i < num_primitives; i++) {
+      centroids[i] = primitive_bounds[i].Center();
+      primitive_indices_[i] = i;
+    }
+
+    // Binary tree with N leaves never have more than 2N - 1 nodes
+    nodes_.reserve(2 * num_primitives - 1);
+    nodes_.emplace_back();
+    nodes_[0].left_first = 0;
+    nodes_[0].count = num_primitives;
+    UpdateNodeBounds(0, primitive_bounds);
+
+    // Subdivide the nodes iteratively. Stack stores the node index with its depth
+    std::vector<std::pair<uint32_t, uint32_t>> node_stack = { { 0, 0 } };
+    while (!node_stack.empty()) {
+      auto [node_idx, depth] = node_stack.back();
+      node_stack.pop_back();
+
+      // Degenerate splits can make a deep tree. Node at the depth limit stays a leaf, so that traversal never
+      // pushes more entries than its stack can hold
+      Node node = nodes_[node_idx];
+      if (node.count <= 2 or depth + 1 >= kMaxStackSize)
+        continue;
+
+      int32_t axis = -1;
+      float split_position = 0.0f;
+      float split_cost = FindBestSplit(node, centroids, primitive_bounds, axis, split_position);
+
+      // Leaf cost is number of primitives times area of node. Split only if cheaper. Leaves bigger than
+      // max leaf size are always splitted
+      Bounds node_bounds { node.aabb_min, node.aabb_max };
+      float leaf_cost = node.count * node_bounds.HalfArea();
+      split_cost += kTraversalCost * node_bounds.HalfArea();
+      if (axis < 0 or (split_cost >= leaf_cost and node.count <= kMaxLeafSize))
+        continue;
+
+      // In place partition of primitive indices
+      int32_t i = (int32_t)node.left_first;
+      int32_t j = i + (int32_t)node.count - 1;
+      while (i <= j) {
+        if (centroids[primitive_indices_[i]][axis] < split_position)
+          i++;
+        else
+          std::swap(primitive_indices_[i], primitive_indices_[j--]);
+      }
+
+      uint32_t left_count = (uint32_t)i - node.left_first;
+      if (left_count == 0 or left_count == node.count)
+        continue;
+
+      // Create the child nodes next to each other
+      uint32_t left_child_idx = (uint32_t)nodes_.size();
+      nodes_.emplace_back();
+      nodes_.emplace_back();
+
+      nodes_[left_child_idx].left_first = node.left_first;
+      nodes_[left_child_idx].count = left_count;
+      nodes_[left_child_idx + 1].left_first = (uint32_t)i;
+      nodes_[left_child_idx + 1].count = node.count - left_count;
+
+      nodes_[node_idx].left_first = left_child_idx;
+      nodes_[node_idx].count = 0;
+
+      UpdateNodeBounds(left_child_idx, primitive_bounds);
+      UpdateNodeBounds(left_child_idx + 1, primitive_bounds);
+
+      node_stack.push_back({ left_child_idx + 1, depth + 1 });
+      node_stack.push_back({ left_child_idx, depth + 1 });
+    }
+
+    BuildRefitData();
+    build_cost_ = GetCost();
+
+    IK_CORE_TRACE(LogModule::RayBvh, "Building BVH of {0} primitives. Nodes : {1}", num_primitives, nodes_.size());
+  }
+
+  void RayBvh::Clear() {
+    nodes_.clear();
+    primitive_indices_.clear();
+    parent_indices_.clear();
+    primitive_leaves_.clear();
+    primitive_slots_.clear();
+    level_nodes_.clear();
+    level_offsets_.clear();
+    refit_flags_.clear();
+    sah_cost_ = 0.0f;
+    build_cost_ = 0.0f;
+    dirty_ = false;
+  }
+
+  void RayBvh::MarkDirty() {
+    dirty_ = true;
+  }
+
+  void RayBvh::BuildRefitData() {
+    const uint32_t num_nodes = (uint32_t)nodes_.size();
+    parent_indices_.assign(num_nodes, kInvalidNode);
+    primitive_leaves_.resize(primitive_indices_.size());
+    primitive_slots_.resize(primitive_indices_.size());
+    refit_flags_.assign(num_nodes, 0);
+
+    // Children are always created after their parent, so depth of parent is known before its children
+    std::vector<uint32_t> depths(num_nodes, 0);
+    uint32_t max_depth = 0;
+    sah_cost_ = 0.0f;
+    for (uint32_t node_idx = 0; node_idx < num_nodes; node_idx++) {
+      const Node& node = nodes_[node_idx];
+      sah_cost_ += GetNodeCost(node);
+      max_depth = std::max(max_depth, depths[node_idx]);
+      if (node.IsLeaf()) {
+        for (uint32_t slot = node.left_first; slot < node.left_first + node.count; slot++) {
+          primitive_leaves_[primitive_indices_[slot]] = node_idx;
+          primitive_slots_[primitive_indices_[slot]] = slot;
+        }
+        continue;
+      }
+      for (uint32_t child = 0; child < 2; child++) {
+        parent_indices_[node.left_first + child] = node_idx;
+        depths[node.left_first + child] = depths[node_idx] + 1;
+      }
+    }
+
+    // Counting sort of nodes by depth
+    level_offsets_.assign(max_depth + 2, 0);
+    for (uint32_t node_idx = 0; node_idx < num_nodes; node_idx++)
+      level_offsets_[depths[node_idx] + 1]++;
+    for (uint32_t level = 0; level <= max_depth; level++)
+      level_offsets_[level + 1] += level_offsets_[level];
+
+    std::vector<uint32_t> level_cursors(level_offsets_.begin(), level_offsets_.end() - 1);
+    level_nodes_.resize(num_nodes);
+    for (uint32_t node_idx = 0; node_idx < num_nodes; node_idx++)
+      level_nodes_[level_cursors[depths[node_idx]]++] = node_idx;
+  }
+
+  void RayBvh::Refit(const std::vector<Bounds>& primitive_bounds,
+                     const std::vector<uint32_t>& changed_primitives,
+                     ThreadPool* thread_pool) {
+    if (nodes_.empty() or changed_primitives.empty())
+      return;
+    IK_ASSERT(primitive_bounds.size() == primitive_indices_.size(), "BVH is build with different primitives");
+    dirty_ = false;
+
+    if ((float)changed_primitives.size() < kFullRefitRatio * (float)primitive_indices_.size()) {
+      // Collect the changed leaves and their ancestors. Walk stops at node already collected by other primitive
+      refit_nodes_.clear();
+      for (uint32_t primitive_idx : changed_primitives) {
+        for (uint32_t node_idx = primitive_leaves_[primitive_idx];
+             node_idx != kInvalidNode and !refit_flags_[node_idx];
+             node_idx = parent_indices_[node_idx]) {
+          refit_flags_[node_idx] = 1;
+          refit_nodes_.push_back(node_idx);
+        }
+      }
+
+      // Children have higher index than parent, so decreasing order refits bottom up
+      std::sort(refit_nodes_.begin(), refit_nodes_.end(), std::greater<uint32_t>());
+      for (uint32_t node_idx : refit_nodes_) {
+        sah_cost_ -= GetNodeCost(nodes_[node_idx]);
+        RefitNode(node_idx, primitive_bounds);
+        sah_cost_ += GetNodeCost(nodes_[node_idx]);
+        refit_flags_[node_idx] = 0;
+      }
+      return;
+    }
+
+    // Nodes of one level are independent of each other, so each level is refit in parallel, deepest first
+    const uint32_t num_levels = (uint32_t)level_offsets_.size() - 1;
+    for (uint32_t level = num_levels; level-- > 0;) {
+      const uint32_t begin = level_offsets_[level];
+      const uint32_t end = level_offsets_[level + 1];
+      const uint32_t num_batches = (end - begin + kRefitBatchSize - 1) / kRefitBatchSize;
+      auto refit_batch = [&](uint32_t batch_idx, uint32_t) {
+        uint32_t batch_end = std::min(end, begin + (batch_idx + 1) * kRefitBatchSize);
+        for (uint32_t i = begin + batch_idx * kRefitBatchSize; i < batch_end; i++)
+          RefitNode(level_nodes_[i], primitive_bounds);
+      };
+
+      if (thread_pool and num_batches > 1) {
+        thread_pool->ParallelFor(num_batches, refit_batch);
+      }
+      else {
+        for (uint32_t batch_idx = 0; batch_idx < num_batches; batch_idx++)
+          refit_batch(batch_idx, 0);
+      }
+    }
+
+    // Sum is computed again, so that error of partial updates does not pile up
+    sah_cost_ = 0.0f;
+    for (const Node& node : nodes_)
+      sah_cost_ += GetNodeCost(node);
+  }
+
+  void RayBvh::RefitNode(uint32_t node_idx, const std::vector<Bounds>& primitive_bounds) {
+    Node& node = nodes_[node_idx];
+    if (node.IsLeaf()) {
+      UpdateNodeBounds(node_idx, primitive_bounds);
+      return;
+    }
+    const Node& left = nodes_[node.left_first];
+    const Node& right = nodes_[node.left_first + 1];
+    node.aabb_min = glm::min(left.aabb_min, right.aabb_min);
+    node.aabb_max = glm::max(left.aabb_max, right.aabb_max);
+  }
+
+  float RayBvh::GetNodeCost(const Node& node) {
+    Bounds bounds { node.aabb_min, node.aabb_max };
+    return bounds.HalfArea() * (node.IsLeaf() ? (float)node.count : kTraversalCost);
+  }
+
+  void RayBvh::UpdateNodeBounds(uint32_t node_idx, const std::vector<Bounds>& primitive_bounds) {
+    Node& node = nodes_[node_idx];
+    Bounds bounds;
+    for (uint32_t i = 0; i < node.count; i++) {
+      bounds.Grow(primitive_bounds[primitive_indices_[node.left_first + i]]);
+    }
+    node.aabb_min = bounds.min;
+    node.aabb_max = bounds.max;
+  }
+
+  float RayBvh::FindBestSplit(const Node& node,
+                              const std::vector<glm::vec3>& centroids,
+                              const std::vector<Bounds>& primitive_bounds,
+                              int32_t& axis,
+                              float& split_position) const {
+    struct Bin {
+      Bounds bounds;
+      uint32_t count = 0;
+    };
+
+    float best_cost = std::numeric_limits<float>::max();
+
+    // Bins are distributed over the bounds of centroids, not the bounds of node
+    Bounds centroid_bounds;
+    for (uint32_t i = 0; i < node.count; i++) {
+      centroid_bounds.Grow(centroids[primitive_indices_[node.left_first + i]]);
+    }
+
+    for (int32_t a = 0; a < 3; a++) {
+      float bounds_min = centroid_bounds.min[a];
+      float bounds_max = centroid_bounds.max[a];
+      if (bounds_min == bounds_max)
+        continue;
+
+      Bin bins[kNumBins];
+      float scale = kNumBins / (bounds_max - bounds_min);
+      for (uint32_t i = 0; i < node.count; i++) {
+        uint32_t primitive_idx = primitive_indices_[node.left_first + i];
+        uint32_t bin_idx = std::min(kNumBins - 1, (uint32_t)((centroids[primitive_idx][a] - bounds_min) * scale));
+        bins[bin_idx].count++;
+        bins[bin_idx].bounds.Grow(primitive_bounds[primitive_idx]);
+      }
+
+      // Sweep from both sides to get the area and count of each plane in linear time
+      float left_area[kNumBins - 1], right_area[kNumBins - 1];
+      uint32_t left_count[kNumBins - 1], right_count[kNumBins - 1];
+      Bounds left_box, right_box;
+      uint32_t left_sum = 0, right_sum = 0;
+      for (uint32_t i = 0; i < kNumBins - 1; i++) {
+        left_sum += bins[i].count;
+        left_count[i] = left_sum;
+        left_box.Grow(bins[i].bounds);
+        left_area[i] = left_box.HalfArea();
+
+        right_sum += bins[kNumBins - 1 - i].count;
+        right_count[kNumBins - 2 - i] = right_sum;
+        right_box.Grow(bins[kNumBins - 1 - i].bounds);
+        right_area[kNumBins - 2 - i] = right_box.HalfArea();
+      }
+
+      float plane_width = (bounds_max - bounds_min) / kNumBins;
+      for (uint32_t i = 0; i < kNumBins - 1; i++) {
+        if (left_count[i] == 0 or right_count[i] == 0)
+          continue;
+
+        float plane_cost = left_count[i] * left_area[i] + right_count[i] * right_area[i];
+        if (plane_cost < best_cost) {
+          axis = a;
+          split_position = bounds_min + plane_width * (i + 1);
+          best_cost = plane_cost;
+        }
+      }
+    }
+    return best_cost;
+  }
+
+  bool RayBvh::Intersect(const Ray& ray,
+                         const std::vector<RaySphere>& spheres,
+                         float& hit_distance,
+                         int32_t& object_idx) const {
+    bool hit = false;
+    Traverse(ray, hit_distance, [&](uint32_t first, uint32_t count) {
+      for (uint32_t i = first; i < first + count; i++) {
+        uint32_t sphere_idx = primitive_indices_[i];
+        if (spheres[sphere_idx].Hit(ray, hit_distance)) {
+          object_idx = (int32_t)sphere_idx;
+          hit = true;
+        }
+      }
+    });
+    return hit;
+  }
+
+  float RayBvh::IntersectAABB(const glm::vec3& origin,
+                              const glm::vec3& inv_direction,
+                              const Node& node,
+                              float hit_distance) {
+    // Slab test
+    float tx1 = (node.aabb_min.x - origin.x) * inv_direction.x, tx2 = (node.aabb_max.x - origin.x) * inv_direction.x;
+    float tmin = std::min(tx1, tx2), tmax = std::max(tx1, tx2);
+    float ty1 = (node.aabb_min.y - origin.y) * inv_direction.y, ty2 = (node.aabb_max.y - origin.y) * inv_direction.y;
+    tmin = std::max(tmin, std::min(ty1, ty2)), tmax = std::min(tmax, std::max(ty1, ty2));
+    float tz1 = (node.aabb_min.z - origin.z) * inv_direction.z, tz2 = (node.aabb_max.z - origin.z) * inv_direction.z;
+    tmin = std::max(tmin, std::min(tz1, tz2)), tmax = std::min(tmax, std::max(tz1, tz2));
+
+    if (tmax >= tmin and tmin < hit_distance and tmax > 0)
+      return tmin;
+    return std::numeric_limits<float>::max();
+  }
+
+  const std::vector<RayBvh::Node>& RayBvh::GetNodes() const { return nodes_; }
+  const std::vector<uint32_t>& RayBvh::GetPrimitiveIndices() const { return primitive_indices_; }
+  uint32_t RayBvh::GetPrimitiveCount() const { return (uint32_t)primitive_indices_.size(); }
+  bool RayBvh::IsBuilt(size_t num_primitives) const {
+    return !dirty_ and num_primitives > 0 and primitive_indices_.size() == num_primitives;
+  }
+  bool RayBvh::IsDirty() const { return dirty_; }
+  uint32_t RayBvh::GetPrimitiveSlot(uint32_t primitive_idx) const { return primitive_slots_[primitive_idx]; }
+  float RayBvh::GetCost() const {
+    if (nodes_.empty())
+      return 0.0f;
+    Bounds root_bounds { nodes_[0].aabb_min, nodes_[0].aabb_max };
+    return sah_cost_ / std::max(root_bounds.HalfArea(), std::numeric_limits<float>::min());
+  }
+  float RayBvh::GetBuildCost() const { return build_cost_; }
+
+}
@@ -0,0 +1,55 @@
+//
+//  ray_camera.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_camera.hpp"
+
+namespace ikan {
+  
+  RayCamera::RayCamera(float fov, float near_plane, float far_plane)
+  : fov_(fov), near_plane_(near_plane), far_plane_(far_plane) {
+    LookAt(position_, target_, up_);
+  }
+  
+  void RayCamera::LookAt(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up) {
+    position_ = position;
+    target_ = target;
+    up_ = up;
+    
+    inverse_view_ = glm::inverse(glm::lookAt(position_, target_, up_));
+  }
+  
+  void RayCamera::SetFOV(float fov) {
+    fov_ = fov;
+    UpdateProjection();
+  }
+  
+  void RayCamera::SetViewportSize(uint32_t width, uint32_t height) {
+    if (viewport_width_ == width and viewport_height_ == height)
+      return;
+    
+    viewport_width_ = width;
+    viewport_height_ = height;
+    UpdateProjection();
+  }
+  
+  void RayCamera::UpdateProjection() {
+    if (viewport_width_ == 0 or viewport_height_ == 0)
+      return;
+    
+    float aspect_ratio = (float)viewport_width_ / (float)viewport_height_;
+    inverse_projection_ = glm::inverse(glm::perspective(fov_, aspect_ratio, near_plane_, far_plane_));
+  }
+  
+  const glm::vec3& RayCamera::GetPosition() const { return position_; }
+  const glm::vec3& RayCamera::GetTarget() const { return target_; }
+  float RayCamera::GetFOV() const { return fov_; }
+  const glm::mat4& RayCamera::GetInverseView() const { return inverse_view_; }
+  const glm::mat4& RayCamera::GetInverseProjection() const { return inverse_projection_; }
+  uint32_t RayCamera::GetViewportWidth() const { return viewport_width_; }
+  uint32_t RayCamera::GetViewportHeight() const { return viewport_height_; }
+  
+}
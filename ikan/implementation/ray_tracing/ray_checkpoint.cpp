@@ -0,0 +1,249 @@
+//
+//  ray_checkpoint.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_checkpoint.hpp"
+#include "ray_sampler.hpp"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <filesystem>
+
+namespace ikan {
+
+  static_assert(std::is_trivially_copyable_v<RayCheckpoint::Header>, "Header is written as bytes");
+  static_assert(std::is_trivially_copyable_v<RayCheckpoint::TileRecord>, "Tiles are written as bytes");
+
+  /// This function returns the size of checkpoint file of header
+  /// - Parameter header: header of checkpoint
+  static size_t GetFileSize(const RayCheckpoint::Header& header) {
+    const size_t num_pixels = (size_t)header.width * header.height;
+    return sizeof(RayCheckpoint::Header) + header.num_tiles * sizeof(RayCheckpoint::TileRecord) +
+    num_pixels * (3 * sizeof(glm::vec4) + sizeof(float));
+  }
+
+  /// This function writes the rows of buffer without padding
+  /// - Parameters:
+  ///   - file: output file
+  ///   - data: first pixel of buffer
+  ///   - header: header of checkpoint
+  ///   - stride: pixels from one row to next in buffer
+  template<typename T>
+  static void WriteRows(std::ofstream& file, const T* data, const RayCheckpoint::Header& header, uint32_t stride) {
+    for (uint32_t y = 0; y < header.height; y++)
+      file.write(reinterpret_cast<const char*>(data + (size_t)y * stride), (std::streamsize)(header.width * sizeof(T)));
+  }
+
+  /// This function flushes the file or directory to disk. Returns false if it could not be flushed
+  /// - Parameter path: path of file or directory
+  static bool SyncToDisk(const std::string& path) {
+    int file = open(path.c_str(), O_RDONLY);
+    if (file < 0)
+      return false;
+    bool synced = fsync(file) == 0;
+    close(file);
+    return synced;
+  }
+
+  RayCheckpoint::~RayCheckpoint() {
+    Close();
+  }
+
+  bool RayCheckpoint::Open(const std::string& file_path) {
+    Close();
+    int file = open(file_path.c_str(), O_RDONLY);
+    if (file < 0) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "Failed to open checkpoint {0}", file_path);
+      return false;
+    }
+
+    struct stat file_stat;
+    if (fstat(file, &file_stat) != 0 or (size_t)file_stat.st_size < sizeof(Header)) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "Checkpoint {0} is too small", file_path);
+      close(file);
+      return false;
+    }
+
+    // Mapping stays valid after file is closed
+    mapped_size_ = (size_t)file_stat.st_size;
+    mapped_data_ = mmap(nullptr, mapped_size_, PROT_READ, MAP_PRIVATE, file, 0);
+    close(file);
+    if (mapped_data_ == MAP_FAILED) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "Failed to map checkpoint {0}", file_path);
+      mapped_data_ = nullptr;
+      mapped_size_ = 0;
+      return false;
+    }
+
+    // Header is also checked for values that renderer can not use, as it goes to resize and tiles as it is
+    header_ = static_cast<const Header*>(mapped_data_);
+    if (header_->magic != kMagic or header_->version != kVersion or GetFileSize(*header_) != mapped_size_ or
+        header_->width == 0 or header_->height == 0 or header_->tile_size == 0 or
+        header_->sampler > (uint32_t)RaySampler::Type::BlueNoise) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "{0} is not a valid checkpoint (version {1})", file_path, kVersion);
+      Close();
+      return false;
+    }
+
+    const std::byte* data = static_cast<const std::byte*>(mapped_data_) + sizeof(Header);
+    tiles_ = reinterpret_cast<const TileRecord*>(data);
+    data += header_->num_tiles * sizeof(TileRecord);
+
+    const size_t num_pixels = (size_t)header_->width * header_->height;
+    buffers_.accumulation = reinterpret_cast<const glm::vec4*>(data);
+    buffers_.albedo = buffers_.accumulation + num_pixels;
+    buffers_.normal_depth = buffers_.albedo + num_pixels;
+    buffers_.luminance_sq = reinterpret_cast<const float*>(buffers_.normal_depth + num_pixels);
+    buffers_.stride = header_->width;
+    return true;
+  }
+
+  void RayCheckpoint::Close() {
+    if (mapped_data_)
+      munmap(mapped_data_, mapped_size_);
+    mapped_data_ = nullptr;
+    mapped_size_ = 0;
+    header_ = nullptr;
+    tiles_ = nullptr;
+    buffers_ = Buffers();
+  }
+
+  bool RayCheckpoint::Write(const std::string& file_path,
+                            Header header,
+                            const std::vector<TileRecord>& tiles,
+                            const Buffers& buffers) {
+    header.magic = kMagic;
+    header.version = kVersion;
+    header.num_tiles = (uint32_t)tiles.size();
+
+    const std::string temp_path = file_path + ".tmp";
+    {
+      std::ofstream file(temp_path, std::ios::out | std::ios::binary | std::ios::trunc);
+      if (!file) {
+        IK_CORE_ERROR(LogModule::RayCheckpoint, "Failed to create checkpoint {0}", temp_path);
+        return false;
+      }
+      file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+      file.write(reinterpret_cast<const char*>(tiles.data()), (std::streamsize)(tiles.size() * sizeof(TileRecord)));
+      WriteRows(file, buffers.accumulation, header, buffers.stride);
+      WriteRows(file, buffers.albedo, header, buffers.stride);
+      WriteRows(file, buffers.normal_depth, header, buffers.stride);
+      WriteRows(file, buffers.luminance_sq, header, buffers.stride);
+      if (!file.flush()) {
+        IK_CORE_ERROR(LogModule::RayCheckpoint, "Failed to write checkpoint {0}", temp_path);
+        return false;
+      }
+    }
+
+    // Data is on disk before the rename, and the rename is on disk after it, so that a crash leaves either the old
+    // or the new checkpoint and never a renamed file with missing data
+    if (!SyncToDisk(temp_path)) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "Failed to flush checkpoint {0}", temp_path);
+      return false;
+    }
+    if (std::rename(temp_path.c_str(), file_path.c_str()) != 0) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "Failed to replace checkpoint {0}", file_path);
+      return false;
+    }
+    const std::filesystem::path directory = std::filesystem::path(file_path).parent_path();
+    if (!SyncToDisk(directory.empty() ? "." : directory.string()))
+      IK_CORE_WARN(LogModule::RayCheckpoint, "Failed to flush directory of checkpoint {0}", file_path);
+    return true;
+  }
+
+  bool RayCheckpoint::Merge(const std::vector<std::string>& input_paths, const std::string& output_path) {
+    if (input_paths.empty())
+      return false;
+
+    std::vector<std::unique_ptr<RayCheckpoint>> inputs;
+    for (const std::string& input_path : input_paths) {
+      inputs.push_back(std::make_unique<RayCheckpoint>());
+      if (!inputs.back()->Open(input_path))
+        return false;
+    }
+
+    // Samples of one view and one estimator can be added. Same seed gives same samples, which would be counted twice
+    const Header& first = inputs[0]->GetHeader();
+    for (size_t i = 1; i < inputs.size(); i++) {
+      const Header& header = inputs[i]->GetHeader();
+      bool same_image = header.width == first.width and header.height == first.height and
+      header.tile_size == first.tile_size and header.num_tiles == first.num_tiles;
+      bool same_view = header.origin == first.origin and header.corner == first.corner and
+      header.step_x == first.step_x and header.step_y == first.step_y;
+      bool same_estimator = header.sampler == first.sampler and header.max_depth == first.max_depth and
+      header.russian_roulette == first.russian_roulette and
+      header.russian_roulette_depth == first.russian_roulette_depth and
+      header.next_event_estimation == first.next_event_estimation;
+      if (!same_image or !same_view or !same_estimator) {
+        IK_CORE_ERROR(LogModule::RayCheckpoint, "{0} is not a render of same view and setting as {1}",
+                      input_paths[i], input_paths[0]);
+        return false;
+      }
+      for (size_t j = 0; j < i; j++) {
+        if (inputs[j]->GetHeader().seed == header.seed) {
+          IK_CORE_ERROR(LogModule::RayCheckpoint, "{0} and {1} have same seed, their samples are not independent",
+                        input_paths[j], input_paths[i]);
+          return false;
+        }
+      }
+    }
+
+    // Adaptive sampling state is rebuilt from merged samples in next frame
+    Header header = first;
+    header.frame_index = 1;
+    std::vector<TileRecord> tiles(inputs[0]->GetTiles(), inputs[0]->GetTiles() + first.num_tiles);
+    for (TileRecord& tile : tiles) {
+      tile.total_samples = 0;
+      tile.min_pixel_samples = 0;
+      tile.num_frames = 0;
+      tile.num_samples = 1;
+      tile.error = std::numeric_limits<float>::max();
+      tile.converged = 0;
+    }
+
+    const size_t num_pixels = (size_t)first.width * first.height;
+    std::vector<glm::vec4> accumulation(num_pixels, glm::vec4(0.0f));
+    std::vector<glm::vec4> albedo(num_pixels, glm::vec4(0.0f));
+    std::vector<glm::vec4> normal_depth(num_pixels, glm::vec4(0.0f));
+    std::vector<float> luminance_sq(num_pixels, 0.0f);
+    for (const std::unique_ptr<RayCheckpoint>& input : inputs) {
+      const Header& input_header = input->GetHeader();
+      // Accumulation of checkpoint saved before reset has no samples
+      if (input_header.frame_index == 1)
+        continue;
+      header.frame_index += input_header.frame_index - 1;
+
+      const Buffers& buffers = input->GetBuffers();
+      for (size_t i = 0; i < num_pixels; i++) {
+        accumulation[i] += buffers.accumulation[i];
+        albedo[i] += buffers.albedo[i];
+        normal_depth[i] += buffers.normal_depth[i];
+        luminance_sq[i] += buffers.luminance_sq[i];
+      }
+      for (uint32_t tile_idx = 0; tile_idx < header.num_tiles; tile_idx++) {
+        const TileRecord& input_tile = input->GetTiles()[tile_idx];
+        TileRecord& tile = tiles[tile_idx];
+        tile.total_samples += input_tile.total_samples;
+        tile.min_pixel_samples += input_tile.min_pixel_samples;
+        tile.num_frames += input_tile.num_frames;
+      }
+    }
+
+    Buffers buffers;
+    buffers.accumulation = accumulation.data();
+    buffers.albedo = albedo.data();
+    buffers.normal_depth = normal_depth.data();
+    buffers.luminance_sq = luminance_sq.data();
+    buffers.stride = first.width;
+    return Write(output_path, header, tiles, buffers);
+  }
+
+  const RayCheckpoint::Header& RayCheckpoint::GetHeader() const { return *header_; }
+  const RayCheckpoint::TileRecord* RayCheckpoint::GetTiles() const { return tiles_; }
+  const RayCheckpoint::Buffers& RayCheckpoint::GetBuffers() const { return buffers_; }
+
+}
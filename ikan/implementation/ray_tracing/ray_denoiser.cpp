@@ -0,0 +1,199 @@
+//
+//  ray_denoiser.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_denoiser.hpp"
+
+#include <bit>
+
+namespace ikan {
+  
+  /// B3 spline kernel of A-Trous wavelet
+  static constexpr float kKernel[5] = { 1.0f / 16.0f, 1.0f / 4.0f, 3.0f / 8.0f, 1.0f / 4.0f, 1.0f / 16.0f };
+  
+  /// This function returns the approximate exp(x) for x <= 0 (relative error < 1e-3). Unlike std::exp it has no
+  /// branch or library call, so the filter loop can be vectorized
+  static inline float FastExpNegative(float x) {
+    x = std::max(x, -80.0f) * 1.44269504f; // exp(x) = 2^(x * log2(e))
+    float integer = std::floor(x);
+    float fraction = x - integer;
+    
+    // 2^fraction for fraction in [0, 1)
+    float p = 1.0f + fraction * (0.69314718f + fraction * (0.24022650f + fraction * (0.05550411f + fraction * 0.00961813f)));
+    
+    // 2^integer is added to exponent bits
+    return std::bit_cast<float>(std::bit_cast<int32_t>(p) + ((int32_t)integer << 23));
+  }
+  
+  /// Data of one tap of the filter, applied on a row
+  struct FilterTap {
+    // Row of pixel (p) and row of tap (q) : r, g, b, normal x, normal y, normal z, depth
+    const float* p[7];
+    const float* q[7];
+    const float* inv_depth;
+    float* sum[4]; // r, g, b, weight
+    
+    float kernel_weight;
+    float inv_color_sigma_sq, inv_normal_sigma_sq, inv_depth_sigma_sq;
+    int32_t offset, width;
+  };
+  
+  /// This function accumulates one tap for pixels in range [x_begin, x_end). Pixels whose tap is inside the row
+  /// are processed without clamp, so the loop reads continuous memory and can be vectorized
+  template<bool kClamp> static void AccumulateTap(const FilterTap& tap, int32_t x_begin, int32_t x_end) {
+    // Without clamp the tap rows are shifted by offset, so that pixel and tap share the same index
+    const int32_t offset = tap.offset;
+    const int32_t shift = kClamp ? 0 : offset;
+    const int32_t max_x = tap.width - 1;
+    const float* __restrict p_r = tap.p[0]; const float* __restrict q_r = tap.q[0] + shift;
+    const float* __restrict p_g = tap.p[1]; const float* __restrict q_g = tap.q[1] + shift;
+    const float* __restrict p_b = tap.p[2]; const float* __restrict q_b = tap.q[2] + shift;
+    const float* __restrict p_nx = tap.p[3]; const float* __restrict q_nx = tap.q[3] + shift;
+    const float* __restrict p_ny = tap.p[4]; const float* __restrict q_ny = tap.q[4] + shift;
+    const float* __restrict p_nz = tap.p[5]; const float* __restrict q_nz = tap.q[5] + shift;
+    const float* __restrict p_depth = tap.p[6]; const float* __restrict q_depth = tap.q[6] + shift;
+    const float* __restrict inv_depth = tap.inv_depth;
+    float* __restrict sum_r = tap.sum[0];
+    float* __restrict sum_g = tap.sum[1];
+    float* __restrict sum_b = tap.sum[2];
+    float* __restrict sum_weight = tap.sum[3];
+    const float kernel_weight = tap.kernel_weight;
+    const float inv_color_sigma_sq = tap.inv_color_sigma_sq;
+    const float inv_normal_sigma_sq = tap.inv_normal_sigma_sq;
+    const float inv_depth_sigma_sq = tap.inv_depth_sigma_sq;
+    
+    for (int32_t x = x_begin; x < x_end; x++) {
+      int32_t qx = kClamp ? std::clamp(x + offset, 0, max_x) : x;
+      
+      float dr = q_r[qx] - p_r[x], dg = q_g[qx] - p_g[x], db = q_b[qx] - p_b[x];
+      float color_dist = dr * dr + dg * dg + db * db;
+      
+      float dnx = q_nx[qx] - p_nx[x], dny = q_ny[qx] - p_ny[x], dnz = q_nz[qx] - p_nz[x];
+      float normal_dist = dnx * dnx + dny * dny + dnz * dnz;
+      
+      float dz = (q_depth[qx] - p_depth[x]) * inv_depth[x];
+      float depth_dist = dz * dz;
+      
+      // One exponent for all the edge stopping functions
+      float weight = kernel_weight * FastExpNegative(-(color_dist * inv_color_sigma_sq +
+                                                       normal_dist * inv_normal_sigma_sq +
+                                                       depth_dist * inv_depth_sigma_sq));
+      sum_r[x] += weight * q_r[qx];
+      sum_g[x] += weight * q_g[qx];
+      sum_b[x] += weight * q_b[qx];
+      sum_weight[x] += weight;
+    }
+  }
+  
+  void RayDenoiser::Resize(uint32_t width, uint32_t height) {
+    width_ = width;
+    height_ = height;
+    
+    size_t num_pixels = (size_t)width * height;
+    for (int32_t c = 0; c < 3; c++) {
+      color_[c].assign(num_pixels, 0.0f);
+      temp_[c].assign(num_pixels, 0.0f);
+      albedo_[c].assign(num_pixels, 1.0f);
+      normal_[c].assign(num_pixels, 0.0f);
+      output_[c] = color_[c].data();
+    }
+    depth_.assign(num_pixels, kSkyDepth);
+  }
+  
+  void RayDenoiser::Denoise(ThreadPool& thread_pool, const Setting& setting) {
+    if (width_ == 0 or height_ == 0)
+      return;
+    
+    size_t scratch_size = (size_t)thread_pool.GetNumThreads() * width_ * 5;
+    if (scratch_.size() < scratch_size)
+      scratch_.resize(scratch_size);
+    
+    // Ping pong between temp and color planes. Color planes are input of next frame so they can be overwritten
+    float* src[3] = { color_[0].data(), color_[1].data(), color_[2].data() };
+    float* dst[3] = { temp_[0].data(), temp_[1].data(), temp_[2].data() };
+    
+    float color_sigma = setting.color_sigma;
+    for (uint32_t iteration = 0; iteration < setting.iterations; iteration++) {
+      uint32_t step = 1u << iteration;
+      float inv_color_sigma_sq = 1.0f / std::max(color_sigma * color_sigma, 1e-6f);
+      thread_pool.ParallelFor(height_, [&](uint32_t y, uint32_t thread_idx) {
+        FilterRow(y, step, setting, inv_color_sigma_sq, src, dst, scratch_.data() + (size_t)thread_idx * width_ * 5);
+      });
+      
+      std::swap(src, dst);
+      color_sigma *= 0.5f;
+    }
+    
+    for (int32_t c = 0; c < 3; c++)
+      output_[c] = src[c];
+  }
+  
+  void RayDenoiser::FilterRow(uint32_t y,
+                              uint32_t step,
+                              const Setting& setting,
+                              float inv_color_sigma_sq,
+                              const float* const src[3],
+                              float* const dst[3],
+                              float* scratch) const {
+    float* sum_r = scratch;
+    float* sum_g = scratch + width_;
+    float* sum_b = scratch + width_ * 2;
+    float* sum_weight = scratch + width_ * 3;
+    float* inv_depth = scratch + width_ * 4;
+    std::fill(scratch, scratch + width_ * 4, 0.0f);
+    
+    const int32_t width = (int32_t)width_;
+    const int32_t height = (int32_t)height_;
+    const size_t p_row = (size_t)y * width_;
+    
+    FilterTap tap;
+    tap.p[0] = src[0] + p_row; tap.p[1] = src[1] + p_row; tap.p[2] = src[2] + p_row;
+    tap.p[3] = normal_[0].data() + p_row; tap.p[4] = normal_[1].data() + p_row; tap.p[5] = normal_[2].data() + p_row;
+    tap.p[6] = depth_.data() + p_row;
+    tap.inv_depth = inv_depth;
+    tap.sum[0] = sum_r; tap.sum[1] = sum_g; tap.sum[2] = sum_b; tap.sum[3] = sum_weight;
+    tap.inv_color_sigma_sq = inv_color_sigma_sq;
+    tap.inv_normal_sigma_sq = 1.0f / std::max(setting.normal_sigma * setting.normal_sigma, 1e-6f);
+    tap.inv_depth_sigma_sq = 1.0f / std::max(setting.depth_sigma * setting.depth_sigma, 1e-6f);
+    tap.width = width;
+    
+    for (int32_t x = 0; x < width; x++)
+      inv_depth[x] = 1.0f / std::max(tap.p[6][x], 1e-3f);
+    
+    // Loop over the taps outside and pixels of row inside, so that inner loop reads continuous memory and has no
+    // branch. Only the pixels whose tap is outside the image use the clamped index
+    for (int32_t j = -2; j <= 2; j++) {
+      int32_t qy = std::clamp((int32_t)y + j * (int32_t)step, 0, height - 1);
+      const size_t q_row = (size_t)qy * width_;
+      tap.q[0] = src[0] + q_row; tap.q[1] = src[1] + q_row; tap.q[2] = src[2] + q_row;
+      tap.q[3] = normal_[0].data() + q_row; tap.q[4] = normal_[1].data() + q_row; tap.q[5] = normal_[2].data() + q_row;
+      tap.q[6] = depth_.data() + q_row;
+      
+      for (int32_t i = -2; i <= 2; i++) {
+        tap.kernel_weight = kKernel[i + 2] * kKernel[j + 2];
+        tap.offset = i * (int32_t)step;
+        
+        int32_t inner_begin = std::clamp(-tap.offset, 0, width);
+        int32_t inner_end = std::clamp(width - tap.offset, inner_begin, width);
+        AccumulateTap<true>(tap, 0, inner_begin);
+        AccumulateTap<false>(tap, inner_begin, inner_end);
+        AccumulateTap<true>(tap, inner_end, width);
+      }
+    }
+    
+    // Center tap has weight of kernel, so sum of weight is never 0
+    float* dst_r = dst[0] + p_row;
+    float* dst_g = dst[1] + p_row;
+    float* dst_b = dst[2] + p_row;
+    for (int32_t x = 0; x < width; x++) {
+      float inv_weight = 1.0f / sum_weight[x];
+      dst_r[x] = sum_r[x] * inv_weight;
+      dst_g[x] = sum_g[x] * inv_weight;
+      dst_b[x] = sum_b[x] * inv_weight;
+    }
+  }
+  
+}
@@ -20,17 +20,38 @@ namespace ikan {
   }
   
   RayMaterial::RayMaterial(const RayMaterial& other)
-  : albedo(other.albedo), type(other.type), fuzz(other.fuzz), refractive_index(other.refractive_index) {
+  : albedo(other.albedo), type(other.type), fuzz(other.fuzz), refractive_index(other.refractive_index),
+  intensity(other.intensity) {
 //    IK_CORE_TRACE(LogModule::RayMaterial, "Copying Ray Material ...");
   }
   
   RayMaterial::RayMaterial(RayMaterial&& other)
-  : albedo(other.albedo), type(other.type), fuzz(other.fuzz), refractive_index(other.refractive_index) {
+  : albedo(other.albedo), type(other.type), fuzz(other.fuzz), refractive_index(other.refractive_index),
+  intensity(other.intensity) {
 //    IK_CORE_TRACE(LogModule::RayMaterial, "Moving Ray Material ...");
   }
   
-  bool RayMaterial::Scatter(const Ray &ray_in,
-                         const HitPayload &payload,
+  RayMaterial& RayMaterial::operator=(const RayMaterial& other) {
+    albedo = other.albedo;
+    type = other.type;
+    fuzz = other.fuzz;
+    refractive_index = other.refractive_index;
+    intensity = other.intensity;
+    return *this;
+  }
+  
+  RayMaterial& RayMaterial::operator=(RayMaterial&& other) {
+    albedo = other.albedo;
+    type = other.type;
+    fuzz = other.fuzz;
+    refractive_index = other.refractive_index;
+    intensity = other.intensity;
+    return *this;
+  }
+  
+  bool RayMaterial::Scatter(const Ray& ray_in,
+                         const HitPayload& payload,
+                         RaySampler& sampler,
                          glm::vec3 &attenuation,
                          Ray &scattered_ray) const {
     /*
@@ -45,11 +66,13 @@ namespace ikan {
         scattered_ray = Ray(payload.world_position, -ray_in.direction);
         return true;
       case RayMaterial::Type::Metal:
-        return ScatterMatelic(ray_in, payload, attenuation, scattered_ray);
+        return ScatterMatelic(ray_in, payload, sampler, attenuation, scattered_ray);
       case RayMaterial::Type::Lambertian:
-        return ScatterLambertian(ray_in, payload, attenuation, scattered_ray);
+        return ScatterLambertian(ray_in, payload, sampler, attenuation, scattered_ray);
       case RayMaterial::Type::Dielectric:
-        return ScatterDielectric(ray_in, payload, attenuation, scattered_ray);
+        return ScatterDielectric(ray_in, payload, sampler, attenuation, scattered_ray);
+      case RayMaterial::Type::Emissive:
+        return false;
       default:
         IK_ASSERT(false, "invalid type");
     }
@@ -57,19 +80,21 @@ namespace ikan {
 
   bool RayMaterial::ScatterMatelic(const Ray& ray_in,
                                 const HitPayload& payload,
+                                RaySampler& sampler,
                                 glm::vec3& attenuation,
                                 Ray& scattered_ray) const {
     glm::vec3 reflected = reflect(glm::normalize(ray_in.direction), payload.world_normal);
-    scattered_ray = Ray(payload.world_position, reflected + fuzz * ikan::Math::RandomInUnitSphere());
+    scattered_ray = Ray(payload.world_position, reflected + fuzz * RaySampler::SampleBall(sampler.Next2D(), sampler.Next1D()));
     attenuation = albedo;
     return (dot(scattered_ray.direction, payload.world_normal) > 0);
   }
   
   bool RayMaterial::ScatterLambertian(const Ray& ray_in,
                                    const HitPayload& payload,
+                                   RaySampler& sampler,
                                    glm::vec3& attenuation,
                                    Ray& scattered_ray) const {
-    auto scatter_direction = payload.world_normal + glm::normalize(ikan::Math::RandomInUnitSphere());
+    auto scatter_direction = payload.world_normal + RaySampler::SampleSphere(sampler.Next2D());
     
     // Catch degenerate scatter direction
     if (NearZeroVec(scatter_direction))
@@ -82,6 +107,7 @@ namespace ikan {
 
   bool RayMaterial::ScatterDielectric(const Ray& ray_in,
                                    const HitPayload& payload,
+                                   RaySampler& sampler,
                                    glm::vec3& attenuation,
                                    Ray& scattered_ray) const {
     attenuation = glm::vec3(1.0, 1.0, 1.0);
@@ -95,7 +121,7 @@ namespace ikan {
     bool cannot_refract = refraction_ratio * sin_theta > 1.0;
     glm::vec3 direction;
     
-    if (cannot_refract || Reflectance(cos_theta) > ikan::Math::RandomDouble())
+    if (cannot_refract || Reflectance(cos_theta) > sampler.Next1D())
       direction = reflect(unit_direction, payload.world_normal);
     else
       direction = ikan::Math::Refract(unit_direction, payload.world_normal, refraction_ratio);
@@ -105,6 +131,10 @@ namespace ikan {
     return true;
   }
   
+  glm::vec3 RayMaterial::GetEmission() const {
+    return type == Type::Emissive ? albedo * intensity : glm::vec3(0.0f);
+  }
+  
   float RayMaterial::Reflectance(float cosine) const {
     // Use Schlick's approximation for reflectance.
     auto r0 = (1 - refractive_index) / (1 + refractive_index);
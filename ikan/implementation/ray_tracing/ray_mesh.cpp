@@ -0,0 +1,415 @@
+//
+//  ray_mesh.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_mesh.hpp"
+#include <sstream>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IK_RAY_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define IK_RAY_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ikan {
+
+  // Minimum distance of hit to avoid self intersection (Same as RaySphere::Hit)
+  static constexpr float kMinHitDistance = 0.001f;
+  // Triangles tested at once by SIMD kernel
+  static constexpr uint32_t kSimdWidth = 4;
+
+  // -------------------------------------------------------------------------
+  // Watertight Ray
+  // -------------------------------------------------------------------------
+  RayMesh::WatertightRay::WatertightRay(const Ray& ray) {
+    // Largest component of direction becomes z, so that shear never divides by small value
+    glm::vec3 abs_direction = glm::abs(ray.direction);
+    kz = abs_direction.x > abs_direction.y ? (abs_direction.x > abs_direction.z ? 0 : 2) : (abs_direction.y > abs_direction.z ? 1 : 2);
+    kx = (kz + 1) % 3;
+    ky = (kx + 1) % 3;
+
+    // Swap to keep the winding of triangles
+    if (ray.direction[kz] < 0.0f)
+      std::swap(kx, ky);
+
+    shear_x = ray.direction[kx] / ray.direction[kz];
+    shear_y = ray.direction[ky] / ray.direction[kz];
+    shear_z = 1.0f / ray.direction[kz];
+    origin = glm::vec3(ray.origin[kx], ray.origin[ky], ray.origin[kz]);
+  }
+
+  // -------------------------------------------------------------------------
+  // Mesh
+  // -------------------------------------------------------------------------
+  RayMesh::RayMesh(const RayMesh& other)
+  : positions(other.positions), indices(other.indices), file_path(other.file_path), bvh_(other.bvh_),
+  vertex_0_{ other.vertex_0_[0], other.vertex_0_[1], other.vertex_0_[2] },
+  vertex_1_{ other.vertex_1_[0], other.vertex_1_[1], other.vertex_1_[2] },
+  vertex_2_{ other.vertex_2_[0], other.vertex_2_[1], other.vertex_2_[2] },
+  triangle_indices_(other.triangle_indices_), normals_(other.normals_), num_triangles_(other.num_triangles_) { }
+
+  RayMesh::RayMesh(RayMesh&& other)
+  : positions(std::move(other.positions)), indices(std::move(other.indices)), file_path(std::move(other.file_path)),
+  bvh_(std::move(other.bvh_)),
+  vertex_0_{ std::move(other.vertex_0_[0]), std::move(other.vertex_0_[1]), std::move(other.vertex_0_[2]) },
+  vertex_1_{ std::move(other.vertex_1_[0]), std::move(other.vertex_1_[1]), std::move(other.vertex_1_[2]) },
+  vertex_2_{ std::move(other.vertex_2_[0]), std::move(other.vertex_2_[1]), std::move(other.vertex_2_[2]) },
+  triangle_indices_(std::move(other.triangle_indices_)), normals_(std::move(other.normals_)),
+  num_triangles_(other.num_triangles_) { }
+
+  RayMesh& RayMesh::operator=(const RayMesh& other) {
+    positions = other.positions;
+    indices = other.indices;
+    file_path = other.file_path;
+    bvh_ = other.bvh_;
+    for (int32_t c = 0; c < 3; c++) {
+      vertex_0_[c] = other.vertex_0_[c];
+      vertex_1_[c] = other.vertex_1_[c];
+      vertex_2_[c] = other.vertex_2_[c];
+    }
+    triangle_indices_ = other.triangle_indices_;
+    normals_ = other.normals_;
+    num_triangles_ = other.num_triangles_;
+    return *this;
+  }
+
+  RayMesh& RayMesh::operator=(RayMesh&& other) {
+    positions = std::move(other.positions);
+    indices = std::move(other.indices);
+    file_path = std::move(other.file_path);
+    bvh_ = std::move(other.bvh_);
+    for (int32_t c = 0; c < 3; c++) {
+      vertex_0_[c] = std::move(other.vertex_0_[c]);
+      vertex_1_[c] = std::move(other.vertex_1_[c]);
+      vertex_2_[c] = std::move(other.vertex_2_[c]);
+    }
+    triangle_indices_ = std::move(other.triangle_indices_);
+    normals_ = std::move(other.normals_);
+    num_triangles_ = other.num_triangles_;
+    return *this;
+  }
+
+  bool RayMesh::LoadObj(const std::string& file_path) {
+    std::ifstream file(file_path);
+    if (!file.is_open()) {
+      IK_CORE_ERROR(LogModule::RayMesh, "Failed to open OBJ file {0}", file_path);
+      return false;
+    }
+
+    Clear();
+    std::string line, vertex;
+    std::vector<uint32_t> face;
+    uint32_t line_number = 0;
+    while (std::getline(file, line)) {
+      line_number++;
+      std::istringstream stream(line);
+      std::string type;
+      stream >> type;
+
+      if (type == "v") {
+        glm::vec3& position = positions.emplace_back(0.0f);
+        stream >> position.x >> position.y >> position.z;
+      }
+      else if (type == "f") {
+        // Vertex is 'v', 'v/vt', 'v//vn' or 'v/vt/vn'. Only position index is used
+        face.clear();
+        while (stream >> vertex) {
+          long index = std::strtol(vertex.c_str(), nullptr, 10);
+
+          // Negative index is relative to the end of positions read so far
+          if (index < 0)
+            index += (long)positions.size() + 1;
+          if (index <= 0 or index > (long)positions.size()) {
+            IK_CORE_ERROR(LogModule::RayMesh, "Invalid vertex index {0} at line {1} of {2}", vertex, line_number, file_path);
+            Clear();
+            return false;
+          }
+          face.push_back((uint32_t)index - 1);
+        }
+
+        for (size_t i = 1; i + 1 < face.size(); i++) {
+          indices.push_back(face[0]);
+          indices.push_back(face[i]);
+          indices.push_back(face[i + 1]);
+        }
+      }
+    }
+
+    this->file_path = file_path;
+    Build();
+
+    IK_CORE_TRACE(LogModule::RayMesh, "Loaded OBJ {0}. Vertices : {1}, Triangles : {2}", file_path, positions.size(),
+                  num_triangles_);
+    return true;
+  }
+
+  void RayMesh::Build() {
+    const uint32_t num_triangles = (uint32_t)(indices.size() / 3);
+    std::vector<RayBvh::Bounds> triangle_bounds(num_triangles);
+    normals_.resize(num_triangles);
+    for (uint32_t t = 0; t < num_triangles; t++) {
+      const glm::vec3& p0 = positions[indices[t * 3 + 0]];
+      const glm::vec3& p1 = positions[indices[t * 3 + 1]];
+      const glm::vec3& p2 = positions[indices[t * 3 + 2]];
+      triangle_bounds[t].Grow(p0);
+      triangle_bounds[t].Grow(p1);
+      triangle_bounds[t].Grow(p2);
+
+      glm::vec3 normal = glm::cross(p1 - p0, p2 - p0);
+      float length = glm::length(normal);
+      normals_[t] = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+    bvh_.Build(triangle_bounds);
+
+    // Vertices are copied in leaf order, so that leaf is a continuous range. Padding triangles are degenerate, so
+    // their determinant is always 0
+    triangle_indices_ = bvh_.GetPrimitiveIndices();
+    const size_t padded_size = num_triangles + RaySphereSoA::kMaxSimdWidth;
+    for (int32_t c = 0; c < 3; c++) {
+      vertex_0_[c].assign(padded_size, 0.0f);
+      vertex_1_[c].assign(padded_size, 0.0f);
+      vertex_2_[c].assign(padded_size, 0.0f);
+    }
+    for (uint32_t slot = 0; slot < num_triangles; slot++) {
+      const uint32_t t = triangle_indices_[slot];
+      for (int32_t c = 0; c < 3; c++) {
+        vertex_0_[c][slot] = positions[indices[t * 3 + 0]][c];
+        vertex_1_[c][slot] = positions[indices[t * 3 + 1]][c];
+        vertex_2_[c][slot] = positions[indices[t * 3 + 2]][c];
+      }
+    }
+    num_triangles_ = num_triangles;
+  }
+
+  void RayMesh::Clear() {
+    positions.clear();
+    indices.clear();
+    file_path.clear();
+    bvh_.Clear();
+    for (int32_t c = 0; c < 3; c++) {
+      vertex_0_[c].clear();
+      vertex_1_[c].clear();
+      vertex_2_[c].clear();
+    }
+    triangle_indices_.clear();
+    normals_.clear();
+    num_triangles_ = 0;
+  }
+
+  bool RayMesh::Intersect(const Ray& ray,
+                          RaySphereSoA::Kernel kernel,
+                          float& hit_distance,
+                          uint32_t& triangle_idx) const {
+    if (!IsBuilt())
+      return false;
+
+    const WatertightRay watertight_ray(ray);
+    bool hit = false;
+    bvh_.Traverse(ray, hit_distance, [&](uint32_t first, uint32_t count) {
+      if (kernel == RaySphereSoA::Kernel::Scalar)
+        hit |= IntersectScalar(watertight_ray, first, count, hit_distance, triangle_idx);
+      else
+        hit |= IntersectSimd4(watertight_ray, first, count, hit_distance, triangle_idx);
+    });
+    return hit;
+  }
+
+  // Watertight ray triangle intersection (Woop, Benthin and Wald, 2013). Vertices are moved to ray space where ray
+  // is the +z axis, and the 2D edge functions U, V and W tell on which side of each edge the ray is. Edge shared by
+  // two triangles gives exactly negated edge function in both, and 0 counts as inside, so there is no gap between
+  // the triangles. Products are separate statements, so that compiler does not fuse only one of them with the
+  // subtraction and break the symmetry
+  bool RayMesh::IntersectScalar(const WatertightRay& ray,
+                                uint32_t first,
+                                uint32_t count,
+                                float& hit_distance,
+                                uint32_t& triangle_idx) const {
+    const float* v0_x = vertex_0_[ray.kx].data(); const float* v0_y = vertex_0_[ray.ky].data(); const float* v0_z = vertex_0_[ray.kz].data();
+    const float* v1_x = vertex_1_[ray.kx].data(); const float* v1_y = vertex_1_[ray.ky].data(); const float* v1_z = vertex_1_[ray.kz].data();
+    const float* v2_x = vertex_2_[ray.kx].data(); const float* v2_y = vertex_2_[ray.ky].data(); const float* v2_z = vertex_2_[ray.kz].data();
+
+    bool hit = false;
+    for (uint32_t i = first; i < first + count; i++) {
+      const float a_z = v0_z[i] - ray.origin.z;
+      const float b_z = v1_z[i] - ray.origin.z;
+      const float c_z = v2_z[i] - ray.origin.z;
+      const float a_x = (v0_x[i] - ray.origin.x) - ray.shear_x * a_z, a_y = (v0_y[i] - ray.origin.y) - ray.shear_y * a_z;
+      const float b_x = (v1_x[i] - ray.origin.x) - ray.shear_x * b_z, b_y = (v1_y[i] - ray.origin.y) - ray.shear_y * b_z;
+      const float c_x = (v2_x[i] - ray.origin.x) - ray.shear_x * c_z, c_y = (v2_y[i] - ray.origin.y) - ray.shear_y * c_z;
+
+      const float u_0 = c_x * b_y, u_1 = c_y * b_x;
+      const float v_0 = a_x * c_y, v_1 = a_y * c_x;
+      const float w_0 = b_x * a_y, w_1 = b_y * a_x;
+      const float u = u_0 - u_1, v = v_0 - v_1, w = w_0 - w_1;
+      if ((u < 0.0f or v < 0.0f or w < 0.0f) and (u > 0.0f or v > 0.0f or w > 0.0f))
+        continue;
+
+      const float determinant = u + v + w;
+      if (determinant == 0.0f)
+        continue;
+
+      const float t = ray.shear_z * (u * a_z + v * b_z + w * c_z) / determinant;
+      if (t >= kMinHitDistance and t < hit_distance) {
+        hit_distance = t;
+        triangle_idx = triangle_indices_[i];
+        hit = true;
+      }
+    }
+    return hit;
+  }
+
+  bool RayMesh::IntersectSimd4(const WatertightRay& ray,
+                               uint32_t first,
+                               uint32_t count,
+                               float& hit_distance,
+                               uint32_t& triangle_idx) const {
+    const float* v0_x = vertex_0_[ray.kx].data(); const float* v0_y = vertex_0_[ray.ky].data(); const float* v0_z = vertex_0_[ray.kz].data();
+    const float* v1_x = vertex_1_[ray.kx].data(); const float* v1_y = vertex_1_[ray.ky].data(); const float* v1_z = vertex_1_[ray.kz].data();
+    const float* v2_x = vertex_2_[ray.kx].data(); const float* v2_y = vertex_2_[ray.ky].data(); const float* v2_z = vertex_2_[ray.kz].data();
+
+#if IK_RAY_SIMD_X86
+    const __m128 origin_x = _mm_set1_ps(ray.origin.x);
+    const __m128 origin_y = _mm_set1_ps(ray.origin.y);
+    const __m128 origin_z = _mm_set1_ps(ray.origin.z);
+    const __m128 shear_x = _mm_set1_ps(ray.shear_x);
+    const __m128 shear_y = _mm_set1_ps(ray.shear_y);
+    const __m128 shear_z = _mm_set1_ps(ray.shear_z);
+    const __m128 min_t = _mm_set1_ps(kMinHitDistance);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 end = _mm_set1_ps((float)count);
+
+    __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 best_t = _mm_set1_ps(hit_distance);
+    __m128 best_lane = _mm_set1_ps(-1.0f);
+
+    for (uint32_t i = 0; i < count; i += kSimdWidth) {
+      const uint32_t idx = first + i;
+      __m128 a_z = _mm_sub_ps(_mm_loadu_ps(&v0_z[idx]), origin_z);
+      __m128 b_z = _mm_sub_ps(_mm_loadu_ps(&v1_z[idx]), origin_z);
+      __m128 c_z = _mm_sub_ps(_mm_loadu_ps(&v2_z[idx]), origin_z);
+      __m128 a_x = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&v0_x[idx]), origin_x), _mm_mul_ps(shear_x, a_z));
+      __m128 a_y = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&v0_y[idx]), origin_y), _mm_mul_ps(shear_y, a_z));
+      __m128 b_x = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&v1_x[idx]), origin_x), _mm_mul_ps(shear_x, b_z));
+      __m128 b_y = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&v1_y[idx]), origin_y), _mm_mul_ps(shear_y, b_z));
+      __m128 c_x = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&v2_x[idx]), origin_x), _mm_mul_ps(shear_x, c_z));
+      __m128 c_y = _mm_sub_ps(_mm_sub_ps(_mm_loadu_ps(&v2_y[idx]), origin_y), _mm_mul_ps(shear_y, c_z));
+
+      __m128 u = _mm_sub_ps(_mm_mul_ps(c_x, b_y), _mm_mul_ps(c_y, b_x));
+      __m128 v = _mm_sub_ps(_mm_mul_ps(a_x, c_y), _mm_mul_ps(a_y, c_x));
+      __m128 w = _mm_sub_ps(_mm_mul_ps(b_x, a_y), _mm_mul_ps(b_y, a_x));
+
+      // Ray is outside if edge functions have different signs
+      __m128 negative = _mm_or_ps(_mm_or_ps(_mm_cmplt_ps(u, zero), _mm_cmplt_ps(v, zero)), _mm_cmplt_ps(w, zero));
+      __m128 positive = _mm_or_ps(_mm_or_ps(_mm_cmpgt_ps(u, zero), _mm_cmpgt_ps(v, zero)), _mm_cmpgt_ps(w, zero));
+      __m128 determinant = _mm_add_ps(_mm_add_ps(u, v), w);
+      __m128 t_scaled = _mm_add_ps(_mm_add_ps(_mm_mul_ps(u, a_z), _mm_mul_ps(v, b_z)), _mm_mul_ps(w, c_z));
+      __m128 t = _mm_div_ps(_mm_mul_ps(shear_z, t_scaled), determinant);
+
+      __m128 valid = _mm_andnot_ps(_mm_and_ps(negative, positive), _mm_cmpneq_ps(determinant, zero));
+      valid = _mm_and_ps(valid, _mm_and_ps(_mm_cmpge_ps(t, min_t), _mm_cmplt_ps(t, best_t)));
+      valid = _mm_and_ps(valid, _mm_cmplt_ps(lane, end));
+
+      best_t = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, best_t));
+      best_lane = _mm_or_ps(_mm_and_ps(valid, lane), _mm_andnot_ps(valid, best_lane));
+      lane = _mm_add_ps(lane, _mm_set1_ps((float)kSimdWidth));
+    }
+
+    alignas(16) float lane_t[4], lane_idx[4];
+    _mm_store_ps(lane_t, best_t);
+    _mm_store_ps(lane_idx, best_lane);
+#elif IK_RAY_SIMD_NEON
+    const float32x4_t origin_x = vdupq_n_f32(ray.origin.x);
+    const float32x4_t origin_y = vdupq_n_f32(ray.origin.y);
+    const float32x4_t origin_z = vdupq_n_f32(ray.origin.z);
+    const float32x4_t shear_x = vdupq_n_f32(ray.shear_x);
+    const float32x4_t shear_y = vdupq_n_f32(ray.shear_y);
+    const float32x4_t shear_z = vdupq_n_f32(ray.shear_z);
+    const float32x4_t min_t = vdupq_n_f32(kMinHitDistance);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t end = vdupq_n_f32((float)count);
+
+    const float lane_init[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t lane = vld1q_f32(lane_init);
+    float32x4_t best_t = vdupq_n_f32(hit_distance);
+    float32x4_t best_lane = vdupq_n_f32(-1.0f);
+
+    for (uint32_t i = 0; i < count; i += kSimdWidth) {
+      const uint32_t idx = first + i;
+      float32x4_t a_z = vsubq_f32(vld1q_f32(&v0_z[idx]), origin_z);
+      float32x4_t b_z = vsubq_f32(vld1q_f32(&v1_z[idx]), origin_z);
+      float32x4_t c_z = vsubq_f32(vld1q_f32(&v2_z[idx]), origin_z);
+      float32x4_t a_x = vsubq_f32(vsubq_f32(vld1q_f32(&v0_x[idx]), origin_x), vmulq_f32(shear_x, a_z));
+      float32x4_t a_y = vsubq_f32(vsubq_f32(vld1q_f32(&v0_y[idx]), origin_y), vmulq_f32(shear_y, a_z));
+      float32x4_t b_x = vsubq_f32(vsubq_f32(vld1q_f32(&v1_x[idx]), origin_x), vmulq_f32(shear_x, b_z));
+      float32x4_t b_y = vsubq_f32(vsubq_f32(vld1q_f32(&v1_y[idx]), origin_y), vmulq_f32(shear_y, b_z));
+      float32x4_t c_x = vsubq_f32(vsubq_f32(vld1q_f32(&v2_x[idx]), origin_x), vmulq_f32(shear_x, c_z));
+      float32x4_t c_y = vsubq_f32(vsubq_f32(vld1q_f32(&v2_y[idx]), origin_y), vmulq_f32(shear_y, c_z));
+
+      float32x4_t u = vsubq_f32(vmulq_f32(c_x, b_y), vmulq_f32(c_y, b_x));
+      float32x4_t v = vsubq_f32(vmulq_f32(a_x, c_y), vmulq_f32(a_y, c_x));
+      float32x4_t w = vsubq_f32(vmulq_f32(b_x, a_y), vmulq_f32(b_y, a_x));
+
+      // Ray is outside if edge functions have different signs
+      uint32x4_t negative = vorrq_u32(vorrq_u32(vcltq_f32(u, zero), vcltq_f32(v, zero)), vcltq_f32(w, zero));
+      uint32x4_t positive = vorrq_u32(vorrq_u32(vcgtq_f32(u, zero), vcgtq_f32(v, zero)), vcgtq_f32(w, zero));
+      float32x4_t determinant = vaddq_f32(vaddq_f32(u, v), w);
+      float32x4_t t_scaled = vaddq_f32(vaddq_f32(vmulq_f32(u, a_z), vmulq_f32(v, b_z)), vmulq_f32(w, c_z));
+      float32x4_t t = vdivq_f32(vmulq_f32(shear_z, t_scaled), determinant);
+
+      uint32x4_t valid = vbicq_u32(vmvnq_u32(vceqq_f32(determinant, zero)), vandq_u32(negative, positive));
+      valid = vandq_u32(valid, vandq_u32(vcgeq_f32(t, min_t), vcltq_f32(t, best_t)));
+      valid = vandq_u32(valid, vcltq_f32(lane, end));
+
+      best_t = vbslq_f32(valid, t, best_t);
+      best_lane = vbslq_f32(valid, lane, best_lane);
+      lane = vaddq_f32(lane, vdupq_n_f32((float)kSimdWidth));
+    }
+
+    float lane_t[4], lane_idx[4];
+    vst1q_f32(lane_t, best_t);
+    vst1q_f32(lane_idx, best_lane);
+#else
+    return IntersectScalar(ray, first, count, hit_distance, triangle_idx);
+#endif
+
+#if IK_RAY_SIMD_X86 || IK_RAY_SIMD_NEON
+    // Lane wise minimum
+    int32_t best = -1;
+    for (int32_t l = 0; l < 4; l++) {
+      if (lane_idx[l] >= 0.0f and lane_t[l] < hit_distance) {
+        hit_distance = lane_t[l];
+        best = (int32_t)lane_idx[l];
+      }
+    }
+    if (best < 0)
+      return false;
+
+    triangle_idx = triangle_indices_[first + best];
+    return true;
+#endif
+  }
+
+  const glm::vec3& RayMesh::GetNormal(uint32_t triangle_idx) const { return normals_[triangle_idx]; }
+  RayBvh::Bounds RayMesh::GetBounds() const {
+    if (bvh_.GetNodes().empty())
+      return RayBvh::Bounds();
+    return { bvh_.GetNodes()[0].aabb_min, bvh_.GetNodes()[0].aabb_max };
+  }
+  uint32_t RayMesh::GetNumTriangles() const { return num_triangles_; }
+  bool RayMesh::IsBuilt() const {
+    return num_triangles_ > 0 and num_triangles_ == indices.size() / 3 and bvh_.IsBuilt(num_triangles_);
+  }
+
+  // -------------------------------------------------------------------------
+  // Mesh Instance
+  // -------------------------------------------------------------------------
+  glm::mat4 RayMeshInstance::GetTransform() const {
+    return Math::GetTransformMatrix(position, rotation, scale);
+  }
+
+}
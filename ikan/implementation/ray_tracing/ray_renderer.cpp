@@ -8,7 +8,100 @@
 #include "ray_renderer.hpp"
 
 namespace ikan {
+  
+  static constexpr uint32_t kCacheLineSize = 64;
+  static constexpr uint32_t kPixelsPerCacheLine = kCacheLineSize / sizeof(glm::vec4);
+  static constexpr uint32_t kImagePixelsPerCacheLine = kCacheLineSize / sizeof(uint32_t);
+
+  /// This function interleaves the bits of x and y (Z order curve)
+  static uint32_t MortonCode(uint32_t x, uint32_t y) {
+    auto spread_bits = [](uint32_t v) {
+      v &= 0x0000ffff;
+      v = (v | (v << 8)) & 0x00ff00ff;
+      v = (v | (v << 4)) & 0x0f0f0f0f;
+      v = (v | (v << 2)) & 0x33333333;
+      v = (v | (v << 1)) & 0x55555555;
+      return v;
+    };
+    return spread_bits(x) | (spread_bits(y) << 1);
+  }
+
+  /// Relative error of dark pixels is measured against this luminance, so that noise which is not visible does not
+  /// keep the tile active forever
+  static constexpr float kMinErrorLuminance = 0.05f;
+
+  static constexpr float kInvPi = 0.318309886f;
+  
+  /// Coarsest resolution divisor of interactive preview (1/64 of pixels)
+  static constexpr uint32_t kMaxPreviewScale = 8;
+  
+  /// Minimum dot product of first hit normal and history normal to accept the reprojected history
+  static constexpr float kMinHistoryNormalSimilarity = 0.8f;
+  
+  /// Object id of pixel whose samples saw different objects, and of pixel without samples
+  static constexpr int32_t kMixedObjects = -2;
+  static constexpr int32_t kNoObject = -3;
+  /// Footprint of tile is dropped above these many objects, and any edit resets the tile
+  static constexpr size_t kMaxFootprintObjects = 1024;
+
+  static float Luminance(const glm::vec3& color) {
+    return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+  }
+
+  /// This function maps value in range [0, 1] to blue -> green -> red
+  static glm::vec4 HeatmapColor(float value) {
+    value = glm::clamp(value, 0.0f, 1.0f);
+    if (value < 0.5f)
+      return glm::vec4(0.0f, value * 2.0f, 1.0f - value * 2.0f, 1.0f);
+    return glm::vec4(value * 2.0f - 1.0f, 2.0f - value * 2.0f, 0.0f, 1.0f);
+  }
 
+  /// This function allocates the buffer aligned to cache line
+  template<typename T> static T* AllocateAligned(size_t count) {
+    return static_cast<T*>(::operator new[](count * sizeof(T), std::align_val_t(kCacheLineSize)));
+  }
+  /// This function deletes the buffer allocated with 'AllocateAligned'
+  template<typename T> static void FreeAligned(T* buffer) {
+    ::operator delete[](buffer, std::align_val_t(kCacheLineSize));
+  }
+
+  /// This function rounds the tile size up to multiple of RGBA8 pixels per cache line, so tiles never share a cache
+  /// line of image or accumulation buffer (cache line of image has more pixels)
+  static uint32_t RoundTileSize(uint32_t tile_size) {
+    tile_size = std::max(tile_size, kImagePixelsPerCacheLine);
+    return (tile_size + kImagePixelsPerCacheLine - 1) / kImagePixelsPerCacheLine * kImagePixelsPerCacheLine;
+  }
+
+  /// This function adds the objects to sorted list of objects
+  /// - Parameters:
+  ///   - sorted_objects: sorted list of objects
+  ///   - objects: objects to be added, in any order
+  static void MergeObjects(std::vector<uint32_t>& sorted_objects, const std::vector<uint32_t>& objects) {
+    // Footprint of tile rarely grows after first frames
+    if (std::all_of(objects.begin(), objects.end(), [&sorted_objects](uint32_t object_id) {
+      return std::binary_search(sorted_objects.begin(), sorted_objects.end(), object_id);
+    }))
+      return;
+    
+    std::vector<uint32_t> new_objects = objects;
+    std::sort(new_objects.begin(), new_objects.end());
+    std::vector<uint32_t> merged;
+    merged.reserve(sorted_objects.size() + new_objects.size());
+    std::set_union(sorted_objects.begin(), sorted_objects.end(), new_objects.begin(), new_objects.end(),
+                   std::back_inserter(merged));
+    sorted_objects.swap(merged);
+  }
+  
+  /// This function returns true if two sorted lists of objects have a common object
+  static bool HasCommonObject(const std::vector<uint32_t>& a, const std::vector<uint32_t>& b) {
+    for (auto it_a = a.begin(), it_b = b.begin(); it_a != a.end() and it_b != b.end(); ) {
+      if (*it_a == *it_b)
+        return true;
+      *it_a < *it_b ? ++it_a : ++it_b;
+    }
+    return false;
+  }
+  
   static uint32_t ConevrtToRgba(const glm::vec4& pixel) {
     uint8_t r = uint8_t(pixel.r * 255.0f);
     uint8_t g = uint8_t(pixel.g * 255.0f);
@@ -17,132 +110,891 @@ namespace ikan {
     return ( (a << 24) | (b << 16) | (g << 8) | r);
   }
 
+  RayRenderer::RayRenderer(bool headless)
+  : headless_(headless), wavefronts_(thread_pool_.GetNumThreads()), row_directions_(thread_pool_.GetNumThreads()),
+  hit_objects_(thread_pool_.GetNumThreads()), visible_objects_(thread_pool_.GetNumThreads()) { }
+  
+  RayRenderer::~RayRenderer() {
+    // Image is not loaded to GPU while stopping, as graphics context may be gone already
+    final_image_.reset();
+    StopAsyncRender();
+    FreeAligned(image_data_);
+    FreeAligned(object_id_data_);
+    FreeAligned(accumulation_data_);
+    FreeAligned(luminance_sq_data_);
+    FreeAligned(albedo_data_);
+    FreeAligned(normal_depth_data_);
+    FreeAligned(history_accumulation_data_);
+    FreeAligned(history_luminance_sq_data_);
+    FreeAligned(history_albedo_data_);
+    FreeAligned(history_normal_depth_data_);
+  }
+
   void RayRenderer::Resize(uint32_t width, uint32_t height) {
-    if (final_image_) {
-      // No resize
-      if (final_image_->GetWidth() == width and final_image_->GetHeight() == height)
-        return;
-      
-      final_image_->Resize(width, height);
+    // No resize
+    if (image_data_ and width_ == width and height_ == height)
+      return;
+    
+    StopAsyncRender();
+#ifndef IK_HEADLESS
+    if (!headless_) {
+      if (final_image_)
+        final_image_->Resize(width, height);
+      else
+        final_image_ = Image::Create(width, height, TextureFormat::RGBA);
     }
-    else {
-      final_image_ = Image::Create(width, height, TextureFormat::RGBA);
+#endif
+    
+    width_ = width;
+    height_ = height;
+    
+    // Rows of image and object ids are padded to cache line like accumulation rows, as tiles write their pixels
+    // from all threads. Image is packed to 'width' pixels per row when published
+    image_stride_ = (width + kImagePixelsPerCacheLine - 1) / kImagePixelsPerCacheLine * kImagePixelsPerCacheLine;
+    FreeAligned(image_data_);
+    FreeAligned(object_id_data_);
+    image_data_ = AllocateAligned<uint32_t>((size_t)image_stride_ * height);
+    object_id_data_ = AllocateAligned<int32_t>((size_t)image_stride_ * height);
+    std::fill_n(object_id_data_, (size_t)image_stride_ * height, kNoObject);
+    if (image_stride_ != width)
+      packed_image_data_.assign((size_t)width * height, 0);
+    else
+      packed_image_data_.clear();
+    
+    accumulation_stride_ = (width + kPixelsPerCacheLine - 1) / kPixelsPerCacheLine * kPixelsPerCacheLine;
+    size_t buffer_size = (size_t)accumulation_stride_ * height;
+    FreeAligned(accumulation_data_);
+    FreeAligned(luminance_sq_data_);
+    FreeAligned(albedo_data_);
+    FreeAligned(normal_depth_data_);
+    accumulation_data_ = AllocateAligned<glm::vec4>(buffer_size);
+    luminance_sq_data_ = AllocateAligned<float>(buffer_size);
+    albedo_data_ = AllocateAligned<glm::vec4>(buffer_size);
+    normal_depth_data_ = AllocateAligned<glm::vec4>(buffer_size);
+    
+    // History of old size can not be reprojected
+    FreeAligned(history_accumulation_data_);
+    FreeAligned(history_luminance_sq_data_);
+    FreeAligned(history_albedo_data_);
+    FreeAligned(history_normal_depth_data_);
+    history_accumulation_data_ = nullptr;
+    history_luminance_sq_data_ = nullptr;
+    history_albedo_data_ = nullptr;
+    history_normal_depth_data_ = nullptr;
+    
+    denoiser_.Resize(width, height);
+    
+    UpdateTiles();
+    ResetFrameIndex();
+  }
+  
+  void RayRenderer::UpdateTiles() {
+    tile_size_ = RoundTileSize(setting_.tile_size);
+    for (std::vector<glm::vec3>& row_directions : row_directions_)
+      row_directions.resize(tile_size_);
+    
+    tiles_.clear();
+    uint32_t num_tiles_x = (width_ + tile_size_ - 1) / tile_size_;
+    uint32_t num_tiles_y = (height_ + tile_size_ - 1) / tile_size_;
+    for (uint32_t tile_y = 0; tile_y < num_tiles_y; tile_y++) {
+      for (uint32_t tile_x = 0; tile_x < num_tiles_x; tile_x++) {
+        Tile tile;
+        tile.x = tile_x * tile_size_;
+        tile.y = tile_y * tile_size_;
+        tile.width = std::min(tile_size_, width_ - tile.x);
+        tile.height = std::min(tile_size_, height_ - tile.y);
+        tiles_.push_back(tile);
+      }
     }
     
-    delete[] image_data_ ;
-    image_data_ = new uint32_t[width * height];
+    // Workers pick the tiles in order, so neighbour tiles (sharing the scene data in cache) are rendered together
+    std::sort(tiles_.begin(), tiles_.end(), [this](const Tile& a, const Tile& b) {
+      return MortonCode(a.x / tile_size_, a.y / tile_size_) < MortonCode(b.x / tile_size_, b.y / tile_size_);
+    });
     
-    delete[] accumulation_data_ ;
-    accumulation_data_ = new glm::vec4[width * height];
+    // Tiles queued for upload are of old tiling. Whole image is published after the frame
+    if (publish_tiles_) {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      async_tiles_ = tiles_;
+      tile_queued_.assign(tiles_.size(), 0);
+      queued_tiles_.clear();
+    }
   }
   
+#ifndef IK_HEADLESS
   void RayRenderer::Render(const RayScene &scene, const EditorCamera &camera) {
-    active_scene_ = &scene;
-    active_camera_ = &camera;
+    PrimaryRays rays;
+    rays.Update(camera.GetPosition(), camera.GetInverseView(), camera.GetInverseProjection(), width_, height_);
+    Render(scene, rays);
+  }
+#endif
+  
+  void RayRenderer::Render(const RayScene &scene, const RayCamera &camera) {
+    PrimaryRays rays;
+    rays.Update(camera.GetPosition(), camera.GetInverseView(), camera.GetInverseProjection(), width_, height_);
+    Render(scene, rays);
+  }
+  
+  void RayRenderer::Render(const RayScene& scene, const PrimaryRays& rays) {
+    if (!requested_setting_.async_render) {
+      StopAsyncRender();
+      setting_ = requested_setting_;
+      active_scene_ = &scene;
+      UpdateCamera(rays);
+      RenderFrame();
+      published_statistics_ = statistics_;
+      return;
+    }
+    
+    if (!render_thread_.joinable())
+      StartAsyncRender();
     
+    {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      if (!(requested_setting_ == async_setting_) or &scene != async_scene_ or !(rays == async_rays_)) {
+        // Rest of the frame is skipped, so that new view is shown without waiting for old one. History of
+        // reprojection is the frame before move, so it needs the full frame
+        if (!(rays == async_rays_) and !requested_setting_.temporal_reprojection)
+          async_cancel_ = true;
+        async_setting_ = requested_setting_;
+        async_scene_ = &scene;
+        async_rays_ = rays;
+        async_input_changed_ = true;
+        async_condition_.notify_one();
+      }
+      published_statistics_ = async_statistics_;
+    }
+    UploadTiles();
+  }
+  
+  void RayRenderer::UpdateCamera(const PrimaryRays& rays) {
+    camera_moved_ = !(rays == primary_rays_);
+    if (!camera_moved_)
+      return;
+    
+    // History is reprojected in next frame. Nothing to reproject if accumulation is reset
+    if (setting_.temporal_reprojection and setting_.accumulate and frame_index_ > 1) {
+      previous_rays_ = primary_rays_;
+      reproject_history_ = true;
+    }
+    primary_rays_ = rays;
+  }
+  
+  bool RayRenderer::RenderFrame() {
     if (setting_.render) {
-      if (frame_index_ == 1) {
-        memset(accumulation_data_, 0, final_image_->GetWidth() * final_image_->GetHeight());
+      // Blue noise mask is generated before the frame is timed
+      RaySampler::Prepare(setting_.sampler);
+      auto start_time = std::chrono::high_resolution_clock::now();
+      // Sample count is stored per tile, so accumulation restarts with new tiles
+      if (tile_size_ != RoundTileSize(setting_.tile_size)) {
+        UpdateTiles();
+        frame_index_ = 1;
       }
+      ApplyInvalidations();
       
-      dispatch_apply(final_image_->GetHeight(), loop_dispactch_queue_, ^(size_t y_) {
-        dispatch_apply(final_image_->GetWidth(), loop_dispactch_queue_, ^(size_t x_) {
-          uint32_t x = (uint32_t)x_;
-          uint32_t y = (uint32_t)y_;
-          
-          uint32_t pixel_idx = x + y * final_image_->GetWidth();
-          glm::vec4 pixel = PerPixel(x, y);
-          
-          pixel = glm::clamp(pixel, glm::vec4(0.0f), glm::vec4(1.0f));
-          if (frame_index_ == 1)
-            accumulation_data_[pixel_idx] = pixel;
-          else
-            accumulation_data_[pixel_idx] += pixel;
+      // Frames are counted per tile, as invalidated tiles restart their count
+      if (setting_.accumulate and setting_.max_frames > 0 and frame_index_ > 1 and
+          std::all_of(tiles_.begin(), tiles_.end(), [this](const Tile& tile) {
+        return tile.num_frames >= setting_.max_frames;
+      })) {
+        statistics_.num_rays = statistics_.num_paths = statistics_.num_roulette_terminations = 0;
+        statistics_.render_time_ms = 0.0f;
+        return false;
+      }
+      
+      // In interactive mode renderer restarts the accumulation on camera move, unless history is reprojected at
+      // full resolution
+      uint32_t preview_scale = SelectPreviewScale();
+      if (setting_.interactive_preview and camera_moved_ and (preview_scale > 1 or !reproject_history_))
+        frame_index_ = 1;
+      camera_moved_ = false;
+      
+      if (preview_scale > 1) {
+        PathCounters counters = RenderPreview(preview_scale);
+        PublishImage();
+        
+        statistics_.num_rays = counters.num_rays;
+        statistics_.num_paths = counters.num_paths;
+        statistics_.num_roulette_terminations = counters.num_roulette_terminations;
+        statistics_.average_path_length = counters.num_paths > 0 ? (float)counters.num_rays / counters.num_paths : 0.0f;
+        statistics_.preview_scale = preview_scale_ = preview_scale;
+        statistics_.render_time_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                              start_time).count();
+        
+        // Accumulation starts at full resolution
+        return true;
+      }
+      
+      if (frame_index_ == 1)
+        reproject_history_ = false;
+      if (reproject_history_) {
+        // Accumulated samples become the history, and pixels are rebuilt from it while rendering
+        size_t buffer_size = (size_t)accumulation_stride_ * height_;
+        if (!history_accumulation_data_) {
+          history_accumulation_data_ = AllocateAligned<glm::vec4>(buffer_size);
+          history_luminance_sq_data_ = AllocateAligned<float>(buffer_size);
+          history_albedo_data_ = AllocateAligned<glm::vec4>(buffer_size);
+          history_normal_depth_data_ = AllocateAligned<glm::vec4>(buffer_size);
+        }
+        std::swap(accumulation_data_, history_accumulation_data_);
+        std::swap(luminance_sq_data_, history_luminance_sq_data_);
+        std::swap(albedo_data_, history_albedo_data_);
+        std::swap(normal_depth_data_, history_normal_depth_data_);
+        
+        // Error of tiles is not valid for the new view
+        for (Tile& tile : tiles_) {
+          tile.num_samples = 1;
+          tile.error = std::numeric_limits<float>::max();
+          tile.converged = false;
+        }
+      }
+      
+      // Denoiser needs all the tiles, so tiles are published after it
+      const bool denoise = setting_.denoise and !setting_.show_sample_heatmap;
+      std::atomic<uint64_t> num_rays = 0, num_paths = 0, num_roulette_terminations = 0;
+      thread_pool_.ParallelFor((uint32_t)tiles_.size(), [&](uint32_t tile_idx, uint32_t thread_idx) {
+        if (async_cancel_.load(std::memory_order_relaxed))
+          return;
+        PathCounters counters = RenderTile(tiles_[tile_idx], thread_idx);
+        num_rays.fetch_add(counters.num_rays, std::memory_order_relaxed);
+        num_paths.fetch_add(counters.num_paths, std::memory_order_relaxed);
+        num_roulette_terminations.fetch_add(counters.num_roulette_terminations, std::memory_order_relaxed);
+        if (publish_tiles_ and !denoise)
+          PublishTile(tile_idx);
+      });
+      
+      // Tiles of cancelled frame have different sample counts, which is valid as samples are counted per tile. Frame
+      // index is not advanced, so that skipped tiles are also reset if this frame was resetting the accumulation
+      const bool cancelled = async_cancel_.load();
+      if (denoise and !cancelled)
+        DenoiseImage();
+      if (!publish_tiles_ or denoise)
+        PublishImage();
+      
+      statistics_.num_rays = num_rays.load();
+      statistics_.num_paths = num_paths.load();
+      statistics_.num_roulette_terminations = num_roulette_terminations.load();
+      statistics_.average_path_length = statistics_.num_paths > 0 ? (float)statistics_.num_rays / statistics_.num_paths : 0.0f;
+      
+      reproject_history_ = false;
+      UpdateAdaptiveSampling();
+      statistics_.render_time_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                            start_time).count();
+      statistics_.preview_scale = preview_scale_ = 1;
+      if (statistics_.num_paths > 0)
+        UpdatePathCost(statistics_.render_time_ms / statistics_.num_paths);
+      
+      if (!cancelled)
+        frame_index_ = setting_.accumulate ? frame_index_ + 1 : 1;
+      statistics_.num_accumulated_frames = setting_.accumulate ? frame_index_ - 1 : 1;
+      return statistics_.num_paths > 0;
+    }
+    return false;
+  }
+  
+  void RayRenderer::PublishImage() {
+    if (publish_tiles_) {
+      for (uint32_t tile_idx = 0; tile_idx < (uint32_t)tiles_.size(); tile_idx++)
+        PublishTile(tile_idx);
+    }
+    else {
+      UploadImage(PackImage());
+    }
+  }
+  
+  const uint32_t* RayRenderer::PackImage() {
+    if (image_stride_ == width_)
+      return image_data_;
+    for (uint32_t y = 0; y < height_; y++)
+      std::copy_n(image_data_ + (size_t)y * image_stride_, width_, packed_image_data_.data() + (size_t)y * width_);
+    return packed_image_data_.data();
+  }
+  
+  void RayRenderer::UploadImage([[maybe_unused]] const uint32_t* data) {
+#ifndef IK_HEADLESS
+    if (final_image_)
+      final_image_->SetData((void*)data);
+#endif
+  }
+  
+  void RayRenderer::UploadImage([[maybe_unused]] const uint32_t* data, [[maybe_unused]] const Tile& tile) {
+#ifndef IK_HEADLESS
+    if (final_image_)
+      final_image_->SetData((void*)data, tile.x, tile.y, tile.width, tile.height);
+#endif
+  }
+  
+  uint32_t RayRenderer::SelectPreviewScale() const {
+    if (!setting_.interactive_preview)
+      return 1;
+    
+    // Refine the preview after camera stops
+    if (!camera_moved_)
+      return std::max(preview_scale_ / 2, 1u);
+    
+    // Coarsest preview till the cost of path is measured
+    if (time_per_path_ms_ <= 0.0f)
+      return kMaxPreviewScale;
+    
+    // Smallest scale whose estimated time of one sample per traced pixel fits the target
+    float full_frame_time_ms = time_per_path_ms_ * (float)width_ * (float)height_;
+    uint32_t scale = 1;
+    while (scale < kMaxPreviewScale and
+           full_frame_time_ms / (float)(scale * scale) + upscale_time_ms_ > setting_.target_frame_time_ms)
+      scale *= 2;
+    return scale;
+  }
+  
+  void RayRenderer::UpdatePathCost(float time_per_path_ms) {
+    // Averaged with previous frames, so that noise of one frame does not switch the scale back and forth
+    time_per_path_ms_ = time_per_path_ms_ > 0.0f ? glm::mix(time_per_path_ms_, time_per_path_ms, 0.5f) : time_per_path_ms;
+  }
+  
+  RayRenderer::PathCounters RayRenderer::RenderPreview(uint32_t scale) {
+    const uint32_t preview_width = (width_ + scale - 1) / scale;
+    const uint32_t preview_height = (height_ + scale - 1) / scale;
+    preview_data_.resize((size_t)preview_width * preview_height);
+    
+    // One sample at the center of each block
+    auto start_time = std::chrono::high_resolution_clock::now();
+    std::atomic<uint64_t> num_rays = 0, num_paths = 0, num_roulette_terminations = 0;
+    thread_pool_.ParallelFor(preview_height, [&](uint32_t py, uint32_t) {
+      PathCounters counters;
+      uint32_t y = std::min(py * scale + scale / 2, height_ - 1);
+      glm::vec4* preview_row = preview_data_.data() + (size_t)py * preview_width;
+      for (uint32_t px = 0; px < preview_width; px++) {
+        uint32_t x = std::min(px * scale + scale / 2, width_ - 1);
+        glm::vec3 direction;
+        primary_rays_.GenerateRow(x, y, 1, &direction);
+        
+        AuxiliarySample auxiliary;
+        glm::vec4 pixel = PerPixel(x, y, direction, 0 /* sample_idx */, counters, auxiliary, nullptr);
+        preview_row[px] = glm::clamp(pixel, glm::vec4(0.0f), glm::vec4(1.0f));
+      }
+      num_rays.fetch_add(counters.num_rays, std::memory_order_relaxed);
+      num_paths.fetch_add(counters.num_paths, std::memory_order_relaxed);
+      num_roulette_terminations.fetch_add(counters.num_roulette_terminations, std::memory_order_relaxed);
+    });
+    
+    // Cost of upscale is measured separately from path cost, as it depends on full resolution
+    auto trace_end_time = std::chrono::high_resolution_clock::now();
+    if (num_paths.load() > 0)
+      UpdatePathCost(std::chrono::duration<float, std::milli>(trace_end_time - start_time).count() / num_paths.load());
+    
+    // Bilinear upscale, sample of block is at its center
+    const float inv_scale = 1.0f / (float)scale;
+    thread_pool_.ParallelFor(height_, [&](uint32_t y, uint32_t) {
+      float fy = std::clamp(((float)y + 0.5f) * inv_scale - 0.5f, 0.0f, (float)(preview_height - 1));
+      uint32_t y0 = (uint32_t)fy;
+      uint32_t y1 = std::min(y0 + 1, preview_height - 1);
+      float ty = fy - (float)y0;
+      const glm::vec4* row_0 = preview_data_.data() + (size_t)y0 * preview_width;
+      const glm::vec4* row_1 = preview_data_.data() + (size_t)y1 * preview_width;
+      uint32_t* image_row = image_data_ + (size_t)y * image_stride_;
+      
+      for (uint32_t x = 0; x < width_; x++) {
+        float fx = std::clamp(((float)x + 0.5f) * inv_scale - 0.5f, 0.0f, (float)(preview_width - 1));
+        uint32_t x0 = (uint32_t)fx;
+        uint32_t x1 = std::min(x0 + 1, preview_width - 1);
+        float tx = fx - (float)x0;
+        glm::vec4 top = glm::mix(row_0[x0], row_0[x1], tx);
+        glm::vec4 bottom = glm::mix(row_1[x0], row_1[x1], tx);
+        image_row[x] = ConevrtToRgba(glm::mix(top, bottom, ty));
+      }
+    });
+    upscale_time_ms_ = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                trace_end_time).count();
+    
+    PathCounters counters;
+    counters.num_rays = num_rays.load();
+    counters.num_paths = num_paths.load();
+    counters.num_roulette_terminations = num_roulette_terminations.load();
+    return counters;
+  }
+  
+  void RayRenderer::ResolveImage() {
+    StopAsyncRender();
+    setting_ = requested_setting_;
+    
+    // Preview frame has no accumulated samples
+    if (preview_scale_ > 1)
+      return;
+    thread_pool_.ParallelFor((uint32_t)tiles_.size(), [this](uint32_t tile_idx, uint32_t thread_idx) {
+      RenderTile(tiles_[tile_idx], thread_idx, false /* trace_rays */);
+    });
+    if (setting_.denoise and !setting_.show_sample_heatmap)
+      DenoiseImage();
+    PublishImage();
+  }
+  
+  void RayRenderer::ApplyInvalidations() {
+    std::vector<uint32_t> object_ids;
+    {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      object_ids.swap(pending_invalidations_);
+    }
+    // Whole image restarts anyway
+    if (object_ids.empty() or frame_index_ == 1)
+      return;
+    
+    std::sort(object_ids.begin(), object_ids.end());
+    object_ids.erase(std::unique(object_ids.begin(), object_ids.end()), object_ids.end());
+    
+    std::atomic<uint32_t> num_invalidated_tiles = 0;
+    std::atomic<uint64_t> num_invalidated_pixels = 0;
+    thread_pool_.ParallelFor((uint32_t)tiles_.size(), [&](uint32_t tile_idx, uint32_t) {
+      Tile& tile = tiles_[tile_idx];
+      if (tile.total_samples == 0)
+        return;
+      
+      // Object changed the light reaching other surfaces of tile
+      if (tile.footprint_unknown or HasCommonObject(tile.footprint, object_ids)) {
+        tile.Reset();
+        num_invalidated_tiles.fetch_add(1, std::memory_order_relaxed);
+        num_invalidated_pixels.fetch_add(tile.width * tile.height, std::memory_order_relaxed);
+        return;
+      }
+      if (!HasCommonObject(tile.visible_objects, object_ids))
+        return;
+      
+      // Only the pixels that see the object restart. Pixel whose samples saw several objects may have seen it
+      uint32_t num_pixels = 0;
+      for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+        const size_t row_offset = (size_t)y * accumulation_stride_;
+        int32_t* object_id_row = object_id_data_ + (size_t)y * image_stride_;
+        for (uint32_t x = tile.x; x < tile.x + tile.width; x++) {
+          const int32_t object_id = object_id_row[x];
+          if (object_id != kMixedObjects and
+              (object_id < 0 or !std::binary_search(object_ids.begin(), object_ids.end(), (uint32_t)object_id)))
+            continue;
+          accumulation_data_[row_offset + x] = glm::vec4(0.0f);
+          luminance_sq_data_[row_offset + x] = 0.0f;
+          albedo_data_[row_offset + x] = glm::vec4(0.0f);
+          normal_depth_data_[row_offset + x] = glm::vec4(0.0f);
+          object_id_row[x] = kNoObject;
+          num_pixels++;
+        }
+      }
+      
+      // Samples of tile are kept, its convergence and frame count restart with the pixels
+      tile.num_samples = 1;
+      tile.min_pixel_samples = 0;
+      tile.error = std::numeric_limits<float>::max();
+      tile.converged = false;
+      tile.num_frames = 0;
+      num_invalidated_tiles.fetch_add(1, std::memory_order_relaxed);
+      num_invalidated_pixels.fetch_add(num_pixels, std::memory_order_relaxed);
+    });
+    statistics_.num_invalidated_tiles = num_invalidated_tiles.load();
+    statistics_.num_invalidated_pixels = num_invalidated_pixels.load();
+  }
+  
+  void RayRenderer::Tile::Reset() {
+    total_samples = 0;
+    num_samples = 1;
+    min_pixel_samples = 0;
+    error = std::numeric_limits<float>::max();
+    converged = false;
+    num_frames = 0;
+    visible_objects.clear();
+    footprint.clear();
+    footprint_unknown = false;
+  }
+  
+  RayRenderer::PathCounters RayRenderer::RenderTile(Tile& tile, uint32_t thread_idx, bool trace_rays) {
+    PathCounters counters;
+    if (trace_rays and frame_index_ == 1)
+      tile.Reset();
+    
+    // Converged tiles only update the image, as debug view can be changed any time
+    const bool max_frames_reached = setting_.accumulate and setting_.max_frames > 0 and
+    tile.num_frames >= setting_.max_frames;
+    uint32_t num_samples = (tile.converged or !trace_rays or max_frames_reached) ? 0 : tile.num_samples;
+    uint32_t total_samples = tile.total_samples + num_samples;
+    if (trace_rays and !max_frames_reached)
+      tile.num_frames++;
+    if (total_samples == 0)
+      return counters;
+    
+    // Objects hit by the samples of this frame, added to footprint of tile after them
+    RayScene::ObjectSet& hit_objects = hit_objects_[thread_idx];
+    RayScene::ObjectSet& visible_objects = visible_objects_[thread_idx];
+    if (num_samples > 0) {
+      hit_objects.Clear(active_scene_->GetNumObjects());
+      visible_objects.Clear(active_scene_->GetNumObjects());
+    }
+    
+    // Wavefront traces all the samples of tile first, then they are accumulated in same order as megakernel
+    const bool wavefront = setting_.integrator == Integrator::Wavefront and num_samples > 0;
+    if (wavefront)
+      TraceTileWavefront(tile, num_samples, thread_idx, counters);
+    uint32_t path_idx = 0;
+    
+    // After camera move, pixels are cleared and their history is added after the first sample, when the first hit
+    // of pixel is known
+    const bool reproject = reproject_history_ and num_samples > 0;
+    
+    float max_error = 0.0f;
+    float min_pixel_samples = std::numeric_limits<float>::max();
+    
+    for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+      glm::vec4* accumulation_row = accumulation_data_ + y * accumulation_stride_;
+      float* luminance_sq_row = luminance_sq_data_ + y * accumulation_stride_;
+      glm::vec4* albedo_row = albedo_data_ + y * accumulation_stride_;
+      glm::vec4* normal_depth_row = normal_depth_data_ + y * accumulation_stride_;
+      uint32_t* image_row = image_data_ + (size_t)y * image_stride_;
+      int32_t* object_id_row = object_id_data_ + (size_t)y * image_stride_;
+      
+      glm::vec3* row_directions = row_directions_[thread_idx].data();
+      if (num_samples > 0)
+        primary_rays_.GenerateRow(tile.x, y, tile.width, row_directions);
+      
+      for (uint32_t x = tile.x; x < tile.x + tile.width; x++) {
+        if (tile.total_samples == 0 or reproject) {
+          accumulation_row[x] = glm::vec4(0.0f);
+          luminance_sq_row[x] = 0.0f;
+          albedo_row[x] = glm::vec4(0.0f);
+          normal_depth_row[x] = glm::vec4(0.0f);
+          object_id_row[x] = kNoObject;
+        }
+        
+        for (uint32_t sample = 0; sample < num_samples; sample++) {
+          // Sample index starts from 0, as index of sampler sequence (same as paths of wavefront)
+          AuxiliarySample auxiliary;
+          glm::vec4 pixel;
+          if (wavefront) {
+            const RayWavefront& paths = wavefronts_[thread_idx];
+            pixel = glm::vec4(paths.GetColor(path_idx), 1.0f);
+            auxiliary.albedo = paths.GetAlbedo(path_idx);
+            auxiliary.normal = paths.GetNormal(path_idx);
+            auxiliary.depth = paths.GetDepth(path_idx);
+            auxiliary.object_id = paths.GetObjectId(path_idx);
+            path_idx++;
+          }
+          else {
+            pixel = PerPixel(x, y, row_directions[x - tile.x], tile.total_samples + sample, counters, auxiliary,
+                             &hit_objects);
+          }
+          if (auxiliary.object_id >= 0)
+            visible_objects.Insert((uint32_t)auxiliary.object_id);
+          if (object_id_row[x] == kNoObject)
+            object_id_row[x] = auxiliary.object_id;
+          else if (object_id_row[x] != auxiliary.object_id)
+            object_id_row[x] = kMixedObjects;
+          if (reproject and sample == 0)
+            ReprojectHistory(x, y, row_directions[x - tile.x], auxiliary);
+          albedo_row[x] += glm::vec4(auxiliary.albedo, 0.0f);
+          normal_depth_row[x] += glm::vec4(auxiliary.normal, auxiliary.depth);
           
-          glm::vec4 accumulated_color = accumulation_data_[pixel_idx];
-          accumulated_color /= (float)frame_index_;
+          // Samples are not clamped to 1 before accumulation, as reweighted paths of russian roulette can be
+          // brighter than 1 and clamping them would darken the converged image
+          pixel = glm::max(pixel, glm::vec4(0.0f));
+          accumulation_row[x] += pixel;
           
-          accumulated_color = glm::clamp(accumulated_color, glm::vec4(0.0f), glm::vec4(1.0f));
-          image_data_[pixel_idx] = ConevrtToRgba(accumulated_color);
-        });
-      });
-      final_image_->SetData(image_data_);
+          float luminance = Luminance(glm::vec3(pixel));
+          luminance_sq_row[x] += luminance * luminance;
+        }
+        
+        // Pixels have different number of samples after reprojection or invalidation. Invalidated pixel is black
+        // till its first sample
+        float pixel_samples = accumulation_row[x].w;
+        float inv_pixel_samples = pixel_samples > 0.0f ? 1.0f / pixel_samples : 0.0f;
+        glm::vec4 accumulated_color = accumulation_row[x] * inv_pixel_samples;
+        min_pixel_samples = std::min(min_pixel_samples, pixel_samples);
+        
+        // Standard error of mean luminance relative to the mean
+        if (pixel_samples > 1 and num_samples > 0) {
+          float mean = Luminance(glm::vec3(accumulated_color));
+          float variance = std::max(luminance_sq_row[x] * inv_pixel_samples - mean * mean, 0.0f) *
+          pixel_samples / (pixel_samples - 1);
+          float error = std::sqrt(variance * inv_pixel_samples) / std::max(mean, kMinErrorLuminance);
+          max_error = std::max(max_error, error);
+        }
+        
+        if (setting_.show_sample_heatmap)
+          accumulated_color = HeatmapColor(pixel_samples / (float)max_tile_samples_);
+        
+        accumulated_color = glm::clamp(accumulated_color, glm::vec4(0.0f), glm::vec4(1.0f));
+        image_row[x] = ConevrtToRgba(accumulated_color);
+      }
+    }
+    
+    if (num_samples > 0) {
+      tile.total_samples = total_samples;
+      tile.min_pixel_samples = (uint32_t)min_pixel_samples;
+      tile.error = tile.min_pixel_samples > 1 ? max_error : std::numeric_limits<float>::max();
       
-      if (setting_.accumulate) {
-        frame_index_++;
-      } else {
-        frame_index_ = 1;
+      // History comes from pixels of other tiles, whose paths are not known
+      if (reproject)
+        tile.footprint_unknown = true;
+      if (!tile.footprint_unknown) {
+        MergeObjects(tile.visible_objects, visible_objects.GetObjects());
+        MergeObjects(tile.footprint, hit_objects.GetObjects());
+        tile.footprint_unknown = tile.visible_objects.size() + tile.footprint.size() > kMaxFootprintObjects;
+      }
+      if (tile.footprint_unknown) {
+        tile.visible_objects.clear();
+        tile.footprint.clear();
       }
     }
+    return counters;
   }
   
-  glm::vec4 RayRenderer::PerPixel(uint32_t x, uint32_t y) {
-    glm::vec3 color(0.0f);
+  void RayRenderer::TraceTileWavefront(const Tile& tile, uint32_t num_samples, uint32_t thread_idx,
+                                       PathCounters& counters) {
+    RayWavefront& wavefront = wavefronts_[thread_idx];
+    glm::vec3* row_directions = row_directions_[thread_idx].data();
+    
+    wavefront.Clear();
+    for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+      primary_rays_.GenerateRow(tile.x, y, tile.width, row_directions);
+      for (uint32_t x = tile.x; x < tile.x + tile.width; x++) {
+        uint32_t pixel_idx = x + y * width_;
+        for (uint32_t sample = 0; sample < num_samples; sample++) {
+          wavefront.AddPath(primary_rays_.origin, row_directions[x - tile.x], pixel_idx, tile.total_samples + sample);
+        }
+      }
+    }
+    
+    RayWavefront::PathSetting path_setting;
+    path_setting.sphere_kernel = setting_.sphere_kernel;
+    path_setting.max_depth = setting_.max_depth;
+    path_setting.russian_roulette = setting_.russian_roulette;
+    path_setting.russian_roulette_depth = setting_.russian_roulette_depth;
+    path_setting.seed = setting_.seed;
+    path_setting.sampler = setting_.sampler;
+    path_setting.width = width_;
+    path_setting.sky_color = active_scene_->sky_color;
+    path_setting.next_event_estimation = setting_.next_event_estimation;
+    wavefront.Trace(*active_scene_, path_setting, &hit_objects_[thread_idx]);
+    
+    counters.num_paths += wavefront.GetNumPaths();
+    counters.num_rays += wavefront.GetNumRays();
+    counters.num_roulette_terminations += wavefront.GetNumRouletteTerminations();
+  }
+  
+  void RayRenderer::ReprojectHistory(uint32_t x, uint32_t y, const glm::vec3& direction,
+                                     const AuxiliarySample& auxiliary) {
+    // Sky is at infinite distance, so only direction is reprojected
+    const bool sky = auxiliary.depth >= RayDenoiser::kSkyDepth;
+    const glm::vec3 hit_position = primary_rays_.origin + direction * auxiliary.depth;
+    const glm::vec3 previous_direction = sky ? direction : hit_position - previous_rays_.origin;
+    
+    glm::vec2 previous_pixel;
+    if (!previous_rays_.Project(previous_direction, previous_pixel))
+      return;
+    
+    int32_t previous_x = (int32_t)std::floor(previous_pixel.x + 0.5f);
+    int32_t previous_y = (int32_t)std::floor(previous_pixel.y + 0.5f);
+    if (previous_x < 0 or previous_y < 0 or previous_x >= (int32_t)width_ or previous_y >= (int32_t)height_)
+      return;
+    
+    size_t history_idx = (size_t)previous_y * accumulation_stride_ + (size_t)previous_x;
+    glm::vec4 history = history_accumulation_data_[history_idx];
+    if (history.w <= 0.0f)
+      return;
+    
+    // Disocclusion : previous pixel saw other surface, or mix of surfaces at an edge
+    glm::vec4 history_normal_depth = history_normal_depth_data_[history_idx] / history.w;
+    bool history_sky = history_normal_depth.w >= RayDenoiser::kSkyDepth * 0.5f;
+    if (sky != history_sky)
+      return;
+    if (!sky) {
+      float expected_depth = glm::length(previous_direction);
+      if (std::abs(history_normal_depth.w - expected_depth) > setting_.reprojection_depth_tolerance * expected_depth)
+        return;
+      if (glm::dot(glm::vec3(history_normal_depth), auxiliary.normal) < kMinHistoryNormalSimilarity)
+        return;
+    }
+    
+    // History is scaled down to max samples. Mean and variance of history are not changed by scale
+    float scale = std::min(1.0f, (float)setting_.reprojection_max_samples / history.w);
+    size_t pixel_idx = (size_t)y * accumulation_stride_ + x;
+    accumulation_data_[pixel_idx] += history * scale;
+    luminance_sq_data_[pixel_idx] += history_luminance_sq_data_[history_idx] * scale;
+    albedo_data_[pixel_idx] += history_albedo_data_[history_idx] * scale;
+    normal_depth_data_[pixel_idx] += history_normal_depth_data_[history_idx] * scale;
+  }
+  
+  void RayRenderer::DenoiseImage() {
+    // Input planes of denoiser are not padded, so they are filled by rows after tracing instead of by tiles
+    thread_pool_.ParallelFor(height_, [this](uint32_t y, uint32_t) {
+      const size_t row_offset = (size_t)y * accumulation_stride_;
+      for (uint32_t x = 0; x < width_; x++) {
+        float pixel_samples = accumulation_data_[row_offset + x].w;
+        float inv_pixel_samples = pixel_samples > 0.0f ? 1.0f / pixel_samples : 0.0f;
+        glm::vec4 normal_depth = normal_depth_data_[row_offset + x] * inv_pixel_samples;
+        denoiser_.SetPixel(x + y * width_, glm::vec3(accumulation_data_[row_offset + x]) * inv_pixel_samples,
+                           glm::vec3(albedo_data_[row_offset + x]) * inv_pixel_samples, glm::vec3(normal_depth),
+                           normal_depth.w);
+      }
+    });
+    denoiser_.Denoise(thread_pool_, setting_.denoiser);
+    thread_pool_.ParallelFor(height_, [this](uint32_t y, uint32_t) {
+      uint32_t* image_row = image_data_ + (size_t)y * image_stride_;
+      for (uint32_t x = 0; x < width_; x++) {
+        glm::vec3 color = glm::clamp(denoiser_.GetPixel(x + y * width_), glm::vec3(0.0f), glm::vec3(1.0f));
+        image_row[x] = ConevrtToRgba(glm::vec4(color, 1.0f));
+      }
+    });
+  }
+  
+  void RayRenderer::UpdateAdaptiveSampling() {
+    max_tile_samples_ = 1;
+    statistics_.num_converged_tiles = 0;
+    if (!setting_.accumulate or !setting_.adaptive_sampling) {
+      for (Tile& tile : tiles_) {
+        tile.num_samples = 1;
+        tile.converged = false;
+        max_tile_samples_ = std::max(max_tile_samples_, tile.total_samples);
+      }
+      return;
+    }
+    
+    // Pixels of converged tiles are the budget to be shared among active tiles
+    uint64_t free_pixels = 0;
+    double total_error = 0.0;
+    for (Tile& tile : tiles_) {
+      max_tile_samples_ = std::max(max_tile_samples_, tile.total_samples);
+      if (!tile.converged and tile.min_pixel_samples >= setting_.adaptive_min_samples and
+          tile.error < setting_.adaptive_threshold)
+        tile.converged = true;
+      
+      if (tile.converged) {
+        free_pixels += tile.width * tile.height;
+        statistics_.num_converged_tiles++;
+      }
+      else if (tile.min_pixel_samples >= setting_.adaptive_min_samples) {
+        total_error += tile.error;
+      }
+    }
+    
+    // Extra samples are given in proportion of error. Tiles without enough samples have no reliable error yet
+    for (Tile& tile : tiles_) {
+      tile.num_samples = 1;
+      if (tile.converged or tile.min_pixel_samples < setting_.adaptive_min_samples or total_error <= 0.0)
+        continue;
+      
+      double extra_pixels = free_pixels * (tile.error / total_error);
+      uint32_t extra_samples = (uint32_t)(extra_pixels / (tile.width * tile.height));
+      tile.num_samples = std::min(1 + extra_samples, std::max(setting_.adaptive_max_samples, 1u));
+    }
+  }
+  
+  glm::vec4 RayRenderer::PerPixel(uint32_t x,
+                                  uint32_t y,
+                                  const glm::vec3& direction,
+                                  uint32_t sample_idx,
+                                  PathCounters& counters,
+                                  AuxiliarySample& auxiliary,
+                                  RayScene::ObjectSet* hit_objects) {
     Ray ray;
-    ray.origin = active_camera_->GetPosition();
+    ray.origin = primary_rays_.origin;
+    ray.direction = direction;
     
-    uint32_t pixel_idx = x + y * final_image_->GetWidth();
-    ray.direction = active_camera_->GetRayDirections().at(pixel_idx);
+    // Throughput is the fraction of light carried by the path from current bounce to camera
+    glm::vec3 color(0.0f);
+    glm::vec3 throughput(1.0f);
+    counters.num_paths++;
     
-    float multiplier = 1.0f;
-    int32_t bounces = 10;
+    // Pdf of BSDF sampling the current ray. 0 for camera ray and specular bounce, which light sampling can not
+    // generate, so the light they hit is not weighted
+    const bool next_event_estimation = setting_.next_event_estimation and active_scene_->GetNumLights() > 0;
+    float bsdf_pdf = 0.0f;
     
-    // Ray Color
-    for (uint32_t i = 0; i < bounces; i++) {
+    for (uint32_t i = 0; i < setting_.max_depth; i++) {
       HitPayload payload = TraceRay(ray);
+      counters.num_rays++;
       if (payload.hit_distance < 0) {
-        glm::vec3 sky_color = glm::vec3(0.6, 0.7, 0.9);
-        color += sky_color * multiplier;
+        color += active_scene_->sky_color * throughput;
         break;
       }
       
-      const RaySphere& sphere = active_scene_->spheres[payload.object_idx];
-      const RayMaterial& material = active_scene_->materials[sphere.material_index];
-      if (i == 0)
-        color = material.albedo;
-      glm::vec3 sphere_color;
-      Ray scattered_ray;
+      const RayMaterial& material = active_scene_->materials[payload.material_idx];
+      if (i == 0) {
+        auxiliary.albedo = material.albedo;
+        auxiliary.normal = payload.world_normal;
+        auxiliary.depth = payload.hit_distance;
+        auxiliary.object_id = payload.object_idx;
+      }
+      else if (hit_objects) {
+        hit_objects->Insert((uint32_t)payload.object_idx);
+      }
       
-      if (material.Scatter(ray, payload, sphere_color, scattered_ray)) {
-        color *= sphere_color;// * multiplier;
-        ray = scattered_ray;
-      } else {
+      if (material.type == RayMaterial::Type::Emissive) {
+        float weight = 1.0f;
+        if (next_event_estimation and bsdf_pdf > 0.0f)
+          weight = RayScene::GetMisWeight(bsdf_pdf, active_scene_->GetLightPdf(payload.light_idx, ray.origin,
+                                                                               payload.world_position));
+        color += throughput * material.GetEmission() * weight;
         break;
       }
       
-      // Decreasing the energy
-      multiplier *= 0.5f;
+      // Each bounce has its own sequence, so result does not depend on the thread rendering the pixel
+      RaySampler sampler(setting_.sampler, x, y, sample_idx, i, setting_.seed);
+      
+      // Next event estimation : light is sampled directly from diffuse surface and the shadow ray is traced. Light
+      // sampling and BSDF sampling are both counted and weighted by multiple importance sampling
+      if (next_event_estimation and material.type == RayMaterial::Type::Lambertian) {
+        RayScene::LightSample light;
+        if (active_scene_->SampleLight(payload.world_position, sampler, light)) {
+          float cos_theta = glm::dot(payload.world_normal, light.direction);
+          if (cos_theta > 0.0f) {
+            counters.num_rays++;
+            if (!active_scene_->IsOccluded(Ray(payload.world_position, light.direction), light.distance,
+                                           setting_.sphere_kernel)) {
+              float light_bsdf_pdf = cos_theta * kInvPi;
+              float weight = RayScene::GetMisWeight(light.pdf, light_bsdf_pdf);
+              color += throughput * material.albedo * (kInvPi * cos_theta * weight / light.pdf) * light.radiance;
+            }
+          }
+        }
+      }
+      
+      glm::vec3 attenuation;
+      Ray scattered_ray;
+      if (!material.Scatter(ray, payload, sampler, attenuation, scattered_ray))
+        break;
+      
+      // Lambertian scatter is cosine weighted
+      bsdf_pdf = 0.0f;
+      if (material.type == RayMaterial::Type::Lambertian)
+        bsdf_pdf = std::max(glm::dot(payload.world_normal, glm::normalize(scattered_ray.direction)), 0.0f) * kInvPi;
+      
+      throughput *= attenuation;
+      ray = scattered_ray;
+      
+      // Russian roulette : continue the path with probability of its throughput and divide the survivors by the
+      // same probability, so the expected value of path stays same. Probability is clamped below 1 so that paths
+      // bouncing between white surfaces also terminate
+      if (setting_.russian_roulette and i + 1 >= setting_.russian_roulette_depth) {
+        float survive_probability = std::min(std::max(throughput.r, std::max(throughput.g, throughput.b)), 0.95f);
+        if (sampler.Next1D() >= survive_probability) {
+          counters.num_roulette_terminations++;
+          break;
+        }
+        throughput /= survive_probability;
+      }
     }
     
     return glm::vec4(color, 1.0f);
   }
   
   HitPayload RayRenderer::TraceRay(const Ray& ray) {
-    int32_t closest_sphere_idx = -1;
-    float hit_distance = std::numeric_limits<float>::max();
-    
-    for (size_t i = 0; i < active_scene_->spheres.size(); i++) {
-      const RaySphere& sphere = active_scene_->spheres[i];
-      if (sphere.Hit(ray, hit_distance)) {
-        closest_sphere_idx = (int32_t)i;
-      } else {
-        continue;
-      }
-    }
-    if (closest_sphere_idx < 0)
+    RayScene::Hit hit;
+    if (!active_scene_->Intersect(ray, setting_.sphere_kernel, hit))
       return Miss(ray);
     
-    return ClosestHit(ray, hit_distance, closest_sphere_idx);
+    return ClosestHit(ray, hit);
   }
   
-  HitPayload RayRenderer::ClosestHit(const Ray& ray, float hit_distance, int32_t object_idx) {
+  HitPayload RayRenderer::ClosestHit(const Ray& ray, const RayScene::Hit& hit) {
     HitPayload payload;
-    payload.hit_distance = hit_distance;
-    payload.object_idx = object_idx;
-    
-    const RaySphere closest_sphere = active_scene_->spheres[object_idx];
+    payload.hit_distance = hit.distance;
+    payload.object_idx = (int32_t)active_scene_->GetObjectId(hit);
     payload.world_position = ray.At(payload.hit_distance);
-    payload.world_normal = (payload.world_position - closest_sphere.position) / closest_sphere.radius;
+    active_scene_->GetSurface(ray, hit, payload.world_normal, payload.material_idx);
+    payload.light_idx = active_scene_->GetLightIndex(hit);
     
     payload.SetFaceNormal(ray);
     return payload;
@@ -154,8 +1006,517 @@ namespace ikan {
     return payload;
   }
   
-  void RayRenderer::ResetFrameIndex() { frame_index_ = 1;}
+  // -------------------------------------------------------------------------
+  // Asynchronous Render
+  // -------------------------------------------------------------------------
+  void RayRenderer::StartAsyncRender() {
+    // Image is loaded once with full data, tiles are loaded in its rectangles after it
+    const size_t image_size = (size_t)width_ * height_;
+    const uint32_t* image_data = PackImage();
+    display_data_.assign(image_data, image_data + image_size);
+    staging_data_ = display_data_;
+    UploadImage(display_data_.data());
+    
+    async_tiles_ = tiles_;
+    tile_queued_.assign(tiles_.size(), 0);
+    queued_tiles_.clear();
+    async_statistics_ = published_statistics_;
+    async_scene_ = nullptr;
+    async_input_changed_ = false;
+    async_reset_ = false;
+    async_stop_ = false;
+    async_cancel_ = false;
+    
+    publish_tiles_ = true;
+    render_thread_ = std::thread(&RayRenderer::AsyncRenderLoop, this);
+  }
+  
+  void RayRenderer::StopAsyncRender() {
+    if (!render_thread_.joinable())
+      return;
+    
+    {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      async_stop_ = true;
+      async_cancel_ = true;
+      async_condition_.notify_one();
+    }
+    render_thread_.join();
+    publish_tiles_ = false;
+    async_cancel_ = false;
+    
+    // Frame state is owned by calling thread again. Pending reset is applied here, as background thread is gone
+    if (async_reset_)
+      frame_index_ = 1;
+    async_reset_ = false;
+    published_statistics_ = statistics_;
+    UploadImage(PackImage());
+  }
+  
+  void RayRenderer::AsyncRenderLoop() {
+    // Waits for first input, as scene is not known before it
+    bool idle = true;
+    while (true) {
+      PrimaryRays rays;
+      {
+        std::unique_lock<std::mutex> lock(async_mutex_);
+        async_condition_.wait(lock, [&] { return async_stop_ or async_input_changed_ or !idle; });
+        if (async_stop_)
+          return;
+        
+        async_input_changed_ = false;
+        async_cancel_ = false;
+        setting_ = async_setting_;
+        active_scene_ = async_scene_;
+        rays = async_rays_;
+        if (async_reset_)
+          frame_index_ = 1;
+        async_reset_ = false;
+      }
+      
+      UpdateCamera(rays);
+      idle = !RenderFrame();
+      
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      async_statistics_ = statistics_;
+    }
+  }
+  
+  void RayRenderer::PublishTile(uint32_t tile_idx) {
+    const Tile& tile = tiles_[tile_idx];
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+      const uint32_t* row = image_data_ + (size_t)y * image_stride_ + tile.x;
+      std::copy(row, row + tile.width, staging_data_.data() + (size_t)y * width_ + tile.x);
+    }
+    if (!tile_queued_[tile_idx]) {
+      tile_queued_[tile_idx] = 1;
+      queued_tiles_.push_back(tile_idx);
+    }
+  }
+  
+  void RayRenderer::UploadTiles() {
+    auto start_time = std::chrono::high_resolution_clock::now();
+    float upload_time_ms = 0.0f;
+    uint32_t num_uploaded_tiles = 0, num_pending_tiles = 0;
+    
+    // At least one tile is uploaded in each call, so that image progresses with any budget
+    do {
+      Tile tile;
+      {
+        std::lock_guard<std::mutex> lock(async_mutex_);
+        num_pending_tiles = (uint32_t)queued_tiles_.size();
+        if (queued_tiles_.empty())
+          break;
+        
+        const uint32_t tile_idx = queued_tiles_.front();
+        queued_tiles_.pop_front();
+        tile_queued_[tile_idx] = 0;
+        num_pending_tiles--;
+        
+        tile = async_tiles_[tile_idx];
+        for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+          const uint32_t* row = staging_data_.data() + (size_t)y * width_ + tile.x;
+          std::copy(row, row + tile.width, display_data_.data() + (size_t)y * width_ + tile.x);
+        }
+      }
+      
+      UploadImage(display_data_.data(), tile);
+      num_uploaded_tiles++;
+      upload_time_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                start_time).count();
+    } while (upload_time_ms < requested_setting_.frame_budget_ms);
+    
+    published_statistics_.upload_time_ms = upload_time_ms;
+    published_statistics_.num_uploaded_tiles = num_uploaded_tiles;
+    published_statistics_.num_pending_tiles = num_pending_tiles;
+  }
+  
+  // -------------------------------------------------------------------------
+  // Checkpoint
+  // -------------------------------------------------------------------------
+  bool RayRenderer::SaveCheckpoint(const std::string& file_path) {
+    StopAsyncRender();
+    
+    // Setting of last frame, which traced the accumulated samples
+    RayCheckpoint::Header header;
+    header.width = width_;
+    header.height = height_;
+    header.tile_size = tile_size_;
+    header.frame_index = frame_index_;
+    header.seed = setting_.seed;
+    header.sampler = static_cast<uint32_t>(setting_.sampler);
+    header.max_depth = setting_.max_depth;
+    header.russian_roulette = setting_.russian_roulette;
+    header.russian_roulette_depth = setting_.russian_roulette_depth;
+    header.next_event_estimation = setting_.next_event_estimation;
+    header.origin = primary_rays_.origin;
+    header.corner = primary_rays_.corner;
+    header.step_x = primary_rays_.step_x;
+    header.step_y = primary_rays_.step_y;
+    
+    std::vector<RayCheckpoint::TileRecord> tile_records;
+    tile_records.reserve(tiles_.size());
+    for (const Tile& tile : tiles_) {
+      RayCheckpoint::TileRecord& record = tile_records.emplace_back();
+      record.x = tile.x;
+      record.y = tile.y;
+      record.width = tile.width;
+      record.height = tile.height;
+      record.total_samples = tile.total_samples;
+      record.num_samples = tile.num_samples;
+      record.min_pixel_samples = tile.min_pixel_samples;
+      record.num_frames = tile.num_frames;
+      record.error = tile.error;
+      record.converged = tile.converged;
+    }
+    
+    RayCheckpoint::Buffers buffers;
+    buffers.accumulation = accumulation_data_;
+    buffers.albedo = albedo_data_;
+    buffers.normal_depth = normal_depth_data_;
+    buffers.luminance_sq = luminance_sq_data_;
+    buffers.stride = accumulation_stride_;
+    return RayCheckpoint::Write(file_path, header, tile_records, buffers);
+  }
+  
+  bool RayRenderer::LoadCheckpoint(const std::string& file_path) {
+    RayCheckpoint checkpoint;
+    if (!checkpoint.Open(file_path))
+      return false;
+    
+    StopAsyncRender();
+    const RayCheckpoint::Header& header = checkpoint.GetHeader();
+    requested_setting_.tile_size = header.tile_size;
+    requested_setting_.seed = header.seed;
+    requested_setting_.sampler = static_cast<RaySampler::Type>(header.sampler);
+    requested_setting_.max_depth = header.max_depth;
+    requested_setting_.russian_roulette = header.russian_roulette;
+    requested_setting_.russian_roulette_depth = header.russian_roulette_depth;
+    requested_setting_.next_event_estimation = header.next_event_estimation;
+    setting_ = requested_setting_;
+    
+    Resize(header.width, header.height);
+    if (tile_size_ != RoundTileSize(setting_.tile_size))
+      UpdateTiles();
+    
+    // Tiles are ordered by position, so same size and tile size give same tiles
+    const RayCheckpoint::TileRecord* tile_records = checkpoint.GetTiles();
+    bool same_tiles = header.num_tiles == tiles_.size();
+    for (uint32_t tile_idx = 0; same_tiles and tile_idx < header.num_tiles; tile_idx++)
+      same_tiles = tile_records[tile_idx].x == tiles_[tile_idx].x and tile_records[tile_idx].y == tiles_[tile_idx].y;
+    if (!same_tiles) {
+      IK_CORE_ERROR(LogModule::RayCheckpoint, "Tiles of checkpoint {0} do not match the renderer", file_path);
+      ResetFrameIndex();
+      return false;
+    }
+    
+    max_tile_samples_ = 1;
+    for (uint32_t tile_idx = 0; tile_idx < header.num_tiles; tile_idx++) {
+      const RayCheckpoint::TileRecord& record = tile_records[tile_idx];
+      Tile& tile = tiles_[tile_idx];
+      tile.Reset();
+      tile.total_samples = record.total_samples;
+      tile.num_samples = record.num_samples;
+      tile.min_pixel_samples = record.min_pixel_samples;
+      tile.num_frames = record.num_frames;
+      tile.error = record.error;
+      tile.converged = record.converged;
+      // Objects seen by the samples are not stored
+      tile.footprint_unknown = true;
+      max_tile_samples_ = std::max(max_tile_samples_, tile.total_samples);
+    }
+    
+    // Pages of mapped file are read once, while copying to the padded rows
+    const RayCheckpoint::Buffers& buffers = checkpoint.GetBuffers();
+    thread_pool_.ParallelFor(height_, [&](uint32_t y, uint32_t) {
+      const size_t src_offset = (size_t)y * buffers.stride;
+      const size_t dst_offset = (size_t)y * accumulation_stride_;
+      std::copy_n(buffers.accumulation + src_offset, width_, accumulation_data_ + dst_offset);
+      std::copy_n(buffers.albedo + src_offset, width_, albedo_data_ + dst_offset);
+      std::copy_n(buffers.normal_depth + src_offset, width_, normal_depth_data_ + dst_offset);
+      std::copy_n(buffers.luminance_sq + src_offset, width_, luminance_sq_data_ + dst_offset);
+    });
+    std::fill_n(object_id_data_, (size_t)image_stride_ * height_, kNoObject);
+    
+    // Camera of checkpoint is the current camera, so that same camera is not seen as a move
+    PrimaryRays rays;
+    rays.origin = header.origin;
+    rays.corner = header.corner;
+    rays.step_x = header.step_x;
+    rays.step_y = header.step_y;
+    rays.UpdateInverseBasis();
+    primary_rays_ = rays;
+    camera_moved_ = false;
+    reproject_history_ = false;
+    preview_scale_ = 1;
+    frame_index_ = header.frame_index;
+    
+    statistics_ = Statistics();
+    statistics_.num_accumulated_frames = frame_index_ - 1;
+    published_statistics_ = statistics_;
+    ResolveImage();
+    return true;
+  }
+  
+  // -------------------------------------------------------------------------
+  // Regions
+  // -------------------------------------------------------------------------
+  RayCheckpoint::Buffers RayRenderer::TraceRegion(const RayScene& scene,
+                                                  const RayCamera& camera,
+                                                  const Region& region,
+                                                  uint32_t first_sample,
+                                                  uint32_t num_samples) {
+    StopAsyncRender();
+    setting_ = requested_setting_;
+    setting_.denoise = false;
+    setting_.show_sample_heatmap = false;
+    setting_.max_frames = 0;
+    if (tile_size_ != RoundTileSize(setting_.tile_size))
+      UpdateTiles();
+    active_scene_ = &scene;
+    primary_rays_.Update(camera.GetPosition(), camera.GetInverseView(), camera.GetInverseProjection(), width_, height_);
+    camera_moved_ = false;
+    reproject_history_ = false;
+    
+    // Region is split in tiles of renderer, which start from the first sample instead of their accumulated samples
+    std::vector<Tile> region_tiles;
+    for (uint32_t y = region.y; y < region.y + region.height; y += tile_size_) {
+      for (uint32_t x = region.x; x < region.x + region.width; x += tile_size_) {
+        Tile& tile = region_tiles.emplace_back();
+        tile.x = x;
+        tile.y = y;
+        tile.width = std::min(tile_size_, region.x + region.width - x);
+        tile.height = std::min(tile_size_, region.y + region.height - y);
+        tile.total_samples = first_sample;
+        tile.num_samples = num_samples;
+        tile.footprint_unknown = true;
+      }
+    }
+    for (uint32_t y = region.y; y < region.y + region.height; y++) {
+      const size_t offset = (size_t)y * accumulation_stride_ + region.x;
+      std::fill_n(accumulation_data_ + offset, region.width, glm::vec4(0.0f));
+      std::fill_n(luminance_sq_data_ + offset, region.width, 0.0f);
+      std::fill_n(albedo_data_ + offset, region.width, glm::vec4(0.0f));
+      std::fill_n(normal_depth_data_ + offset, region.width, glm::vec4(0.0f));
+      std::fill_n(object_id_data_ + (size_t)y * image_stride_ + region.x, region.width, kNoObject);
+    }
+    
+    // Frame index of accumulated render, so that region tiles are not reset
+    auto start_time = std::chrono::high_resolution_clock::now();
+    frame_index_ = 2;
+    std::atomic<uint64_t> num_rays = 0, num_paths = 0, num_roulette_terminations = 0;
+    thread_pool_.ParallelFor((uint32_t)region_tiles.size(), [&](uint32_t tile_idx, uint32_t thread_idx) {
+      PathCounters counters = RenderTile(region_tiles[tile_idx], thread_idx);
+      num_rays.fetch_add(counters.num_rays, std::memory_order_relaxed);
+      num_paths.fetch_add(counters.num_paths, std::memory_order_relaxed);
+      num_roulette_terminations.fetch_add(counters.num_roulette_terminations, std::memory_order_relaxed);
+    });
+    
+    // Accumulation has the samples of region only
+    frame_index_ = 1;
+    statistics_ = Statistics();
+    statistics_.num_rays = num_rays.load();
+    statistics_.num_paths = num_paths.load();
+    statistics_.num_roulette_terminations = num_roulette_terminations.load();
+    statistics_.average_path_length = statistics_.num_paths > 0 ? (float)statistics_.num_rays / statistics_.num_paths : 0.0f;
+    statistics_.render_time_ms = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                          start_time).count();
+    published_statistics_ = statistics_;
+    
+    const size_t offset = (size_t)region.y * accumulation_stride_ + region.x;
+    RayCheckpoint::Buffers buffers;
+    buffers.accumulation = accumulation_data_ + offset;
+    buffers.albedo = albedo_data_ + offset;
+    buffers.normal_depth = normal_depth_data_ + offset;
+    buffers.luminance_sq = luminance_sq_data_ + offset;
+    buffers.stride = accumulation_stride_;
+    return buffers;
+  }
+  
+  void RayRenderer::AccumulateRegion(const RayCamera& camera,
+                                     const Region& region,
+                                     const RayCheckpoint::Buffers& samples) {
+    StopAsyncRender();
+    setting_ = requested_setting_;
+    PrimaryRays rays;
+    rays.Update(camera.GetPosition(), camera.GetInverseView(), camera.GetInverseProjection(), width_, height_);
+    
+    if (tile_size_ != RoundTileSize(setting_.tile_size)) {
+      UpdateTiles();
+      frame_index_ = 1;
+    }
+    if (frame_index_ == 1 or !(rays == primary_rays_)) {
+      for (Tile& tile : tiles_)
+        tile.Reset();
+      const size_t buffer_size = (size_t)accumulation_stride_ * height_;
+      std::fill_n(accumulation_data_, buffer_size, glm::vec4(0.0f));
+      std::fill_n(luminance_sq_data_, buffer_size, 0.0f);
+      std::fill_n(albedo_data_, buffer_size, glm::vec4(0.0f));
+      std::fill_n(normal_depth_data_, buffer_size, glm::vec4(0.0f));
+      std::fill_n(object_id_data_, (size_t)image_stride_ * height_, kNoObject);
+      primary_rays_ = rays;
+      camera_moved_ = false;
+      reproject_history_ = false;
+      preview_scale_ = 1;
+    }
+    
+    for (uint32_t y = 0; y < region.height; y++) {
+      const size_t src_offset = (size_t)y * samples.stride;
+      const size_t dst_offset = (size_t)(region.y + y) * accumulation_stride_ + region.x;
+      for (uint32_t x = 0; x < region.width; x++) {
+        accumulation_data_[dst_offset + x] += samples.accumulation[src_offset + x];
+        luminance_sq_data_[dst_offset + x] += samples.luminance_sq[src_offset + x];
+        albedo_data_[dst_offset + x] += samples.albedo[src_offset + x];
+        normal_depth_data_[dst_offset + x] += samples.normal_depth[src_offset + x];
+      }
+    }
+    
+    // Samples of tiles are counted from pixels, as regions need not be aligned to tiles. Objects of samples are
+    // not known
+    uint32_t min_samples = std::numeric_limits<uint32_t>::max();
+    for (Tile& tile : tiles_) {
+      bool overlaps = tile.x < region.x + region.width and region.x < tile.x + tile.width and
+      tile.y < region.y + region.height and region.y < tile.y + tile.height;
+      if (overlaps) {
+        float tile_min_samples = std::numeric_limits<float>::max(), tile_max_samples = 0.0f;
+        for (uint32_t y = tile.y; y < tile.y + tile.height; y++) {
+          const glm::vec4* accumulation_row = accumulation_data_ + (size_t)y * accumulation_stride_;
+          for (uint32_t x = tile.x; x < tile.x + tile.width; x++) {
+            tile_min_samples = std::min(tile_min_samples, accumulation_row[x].w);
+            tile_max_samples = std::max(tile_max_samples, accumulation_row[x].w);
+          }
+        }
+        tile.Reset();
+        tile.total_samples = tile.num_frames = (uint32_t)tile_max_samples;
+        tile.min_pixel_samples = (uint32_t)tile_min_samples;
+        tile.footprint_unknown = true;
+        max_tile_samples_ = std::max(max_tile_samples_, tile.total_samples);
+      }
+      min_samples = std::min(min_samples, tile.min_pixel_samples);
+    }
+    
+    // Next frame continues the accumulation from the fewest samples of a pixel
+    frame_index_ = std::max(min_samples, 1u) + 1;
+    statistics_ = Statistics();
+    statistics_.num_accumulated_frames = min_samples;
+    published_statistics_ = statistics_;
+  }
+  
+  // -------------------------------------------------------------------------
+  // Primary Rays
+  // -------------------------------------------------------------------------
+  void RayRenderer::PrimaryRays::Update(const glm::vec3& position,
+                                        const glm::mat4& inverse_view,
+                                        const glm::mat4& inverse_projection,
+                                        uint32_t width,
+                                        uint32_t height) {
+    // Pixel coordinate maps to [-1, 1) as in camera. View is rigid and projection is perspective, so the
+    // unnormalised world direction is linear in pixel coordinate and only 3 directions are needed
+    auto world_direction = [&](float coord_x, float coord_y) {
+      glm::vec4 target = inverse_projection * glm::vec4(coord_x, coord_y, 1, 1);
+      return glm::vec3(inverse_view * glm::vec4(glm::vec3(target) / target.w, 0));
+    };
+    
+    origin = position;
+    corner = world_direction(-1.0f, -1.0f);
+    step_x = width > 0 ? (world_direction(1.0f, -1.0f) - corner) / (float)width : glm::vec3(0.0f);
+    step_y = height > 0 ? (world_direction(-1.0f, 1.0f) - corner) / (float)height : glm::vec3(0.0f);
+    UpdateInverseBasis();
+  }
+  
+  void RayRenderer::PrimaryRays::UpdateInverseBasis() {
+    // Direction of pixel (x, y) is basis * (x, y, 1), so inverse of basis gives back the pixel of a direction
+    glm::mat3 basis(step_x, step_y, corner);
+    inverse_basis = glm::determinant(basis) != 0.0f ? glm::inverse(basis) : glm::mat3(1.0f);
+  }
+  
+  bool RayRenderer::PrimaryRays::Project(const glm::vec3& direction, glm::vec2& pixel) const {
+    glm::vec3 coord = inverse_basis * direction;
+    if (coord.z <= 0.0f)
+      return false;
+    pixel = glm::vec2(coord) / coord.z;
+    return true;
+  }
+  
+  bool RayRenderer::PrimaryRays::operator==(const PrimaryRays& other) const {
+    return origin == other.origin and corner == other.corner and step_x == other.step_x and step_y == other.step_y;
+  }
+  
+  void RayRenderer::PrimaryRays::GenerateRow(uint32_t x, uint32_t y, uint32_t count, glm::vec3* directions) const {
+    const glm::vec3 row_start = corner + step_y * (float)y + step_x * (float)x;
+    
+    // Components are computed separately so that compiler can use SIMD across the pixels of row
+    float* __restrict output = &directions[0].x;
+    for (uint32_t i = 0; i < count; i++) {
+      float dx = row_start.x + step_x.x * (float)i;
+      float dy = row_start.y + step_x.y * (float)i;
+      float dz = row_start.z + step_x.z * (float)i;
+      float inv_length = 1.0f / std::sqrt(dx * dx + dy * dy + dz * dz);
+      output[i * 3 + 0] = dx * inv_length;
+      output[i * 3 + 1] = dy * inv_length;
+      output[i * 3 + 2] = dz * inv_length;
+    }
+  }
+  
+  void RayRenderer::ResetFrameIndex() {
+    if (render_thread_.joinable()) {
+      std::lock_guard<std::mutex> lock(async_mutex_);
+      async_reset_ = true;
+      async_cancel_ = true;
+      async_input_changed_ = true;
+      async_condition_.notify_one();
+      return;
+    }
+    frame_index_ = 1;
+  }
+  
+  void RayRenderer::InvalidateObjects(const std::vector<uint32_t>& object_ids) {
+    std::lock_guard<std::mutex> lock(async_mutex_);
+    pending_invalidations_.insert(pending_invalidations_.end(), object_ids.begin(), object_ids.end());
+    
+    // Background thread waits for input after all the tiles are converged
+    if (render_thread_.joinable()) {
+      async_input_changed_ = true;
+      async_condition_.notify_one();
+    }
+  }
+  
+  void RayRenderer::InvalidateMaterial(const RayScene& scene, uint32_t material_idx) {
+    if (scene.IsLightMaterial(material_idx)) {
+      ResetFrameIndex();
+      return;
+    }
+    
+    std::vector<uint32_t> object_ids;
+    for (uint32_t sphere_idx = 0; sphere_idx < (uint32_t)scene.spheres.size(); sphere_idx++) {
+      if (scene.spheres[sphere_idx].material_index == (int32_t)material_idx)
+        object_ids.push_back(sphere_idx);
+    }
+    for (uint32_t instance_idx = 0; instance_idx < (uint32_t)scene.mesh_instances.size(); instance_idx++) {
+      if (scene.mesh_instances[instance_idx].material_index == (int32_t)material_idx)
+        object_ids.push_back((uint32_t)scene.spheres.size() + instance_idx);
+    }
+    InvalidateObjects(object_ids);
+  }
+  
   std::shared_ptr<Image> RayRenderer::GetFinalImage() const { return final_image_; }
-  RayRenderer::Setting& RayRenderer::GetSetting() { return setting_; }
+  const uint32_t* RayRenderer::GetImageData() const {
+    if (render_thread_.joinable())
+      return display_data_.data();
+    return image_stride_ == width_ ? image_data_ : packed_image_data_.data();
+  }
+  uint32_t RayRenderer::GetWidth() const { return width_; }
+  uint32_t RayRenderer::GetHeight() const { return height_; }
+  const RayRenderer::Statistics& RayRenderer::GetStatistics() const { return published_statistics_; }
+  RayRenderer::Setting& RayRenderer::GetSetting() { return requested_setting_; }
+  
+  const char* RayRenderer::GetIntegratorName(Integrator integrator) {
+    switch (integrator) {
+      case Integrator::Megakernel: return "Megakernel";
+      case Integrator::Wavefront: return "Wavefront";
+      default: return "Invalid";
+    }
+  }
 
 }
@@ -0,0 +1,142 @@
+//
+//  ray_sampler.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_sampler.hpp"
+
+namespace ikan {
+
+  /// Void and cluster mask of Ulichney. Pixels are ranked one by one : each new pixel is the largest void of the
+  /// pixels ranked so far, measured by the sum of gaussians around them, so every threshold of mask is a well
+  /// spread (blue noise) point set.
+  class BlueNoiseMask {
+  public:
+    static constexpr uint32_t kSize = RaySampler::kBlueNoiseSize;
+    static constexpr uint32_t kNumPixels = kSize * kSize;
+
+    /// This constructor generates the mask
+    BlueNoiseMask() {
+      // Gaussian of toroidal distance, so that mask tiles without seams
+      static constexpr float kSigma = 1.5f;
+      for (uint32_t y = 0; y < kSize; y++) {
+        for (uint32_t x = 0; x < kSize; x++) {
+          float dx = (float)std::min(x, kSize - x);
+          float dy = (float)std::min(y, kSize - y);
+          gaussian_[y * kSize + x] = std::exp(-(dx * dx + dy * dy) / (2.0f * kSigma * kSigma));
+        }
+      }
+
+      // Initial pattern : 10% random pixels, relaxed by moving the tightest cluster to the largest void till the
+      // pattern is stable
+      std::vector<uint8_t> initial(kNumPixels, 0);
+      std::vector<float> initial_energy(kNumPixels, 0.0f);
+      RandomGenerator rng(kNumPixels);
+      uint32_t num_initial = kNumPixels / 10;
+      for (uint32_t placed = 0; placed < num_initial; ) {
+        uint32_t pixel = rng.NextUInt() % kNumPixels;
+        if (initial[pixel])
+          continue;
+        Toggle(initial, initial_energy, pixel);
+        placed++;
+      }
+      for (uint32_t iteration = 0; iteration < kNumPixels; iteration++) {
+        uint32_t cluster = FindTightestCluster(initial, initial_energy);
+        Toggle(initial, initial_energy, cluster);
+        uint32_t void_pixel = FindLargestVoid(initial, initial_energy);
+        Toggle(initial, initial_energy, void_pixel);
+        if (void_pixel == cluster)
+          break;
+      }
+
+      // Initial pixels are ranked by removing the tightest cluster, rest by filling the largest void. Filling the
+      // void is same as removing the tightest cluster of empty pixels, as energy of all pixels sums to constant
+      std::vector<uint32_t> rank(kNumPixels, 0);
+      std::vector<uint8_t> pattern = initial;
+      std::vector<float> energy = initial_energy;
+      for (uint32_t r = num_initial; r > 0; r--) {
+        uint32_t cluster = FindTightestCluster(pattern, energy);
+        Toggle(pattern, energy, cluster);
+        rank[cluster] = r - 1;
+      }
+      for (uint32_t r = num_initial; r < kNumPixels; r++) {
+        uint32_t void_pixel = FindLargestVoid(initial, initial_energy);
+        Toggle(initial, initial_energy, void_pixel);
+        rank[void_pixel] = r;
+      }
+
+      // Rank is centred in its interval, so that mask is uniform in [0, 1)
+      for (uint32_t i = 0; i < kNumPixels; i++)
+        values_[i] = (rank[i] + 0.5f) / kNumPixels;
+    }
+
+    /// This function returns the mask values
+    const float* GetValues() const { return values_; }
+
+  private:
+    /// This function adds or removes the pixel from pattern and updates the energy of all pixels
+    /// - Parameters:
+    ///   - pattern: pattern of pixels
+    ///   - energy: energy of pattern
+    ///   - pixel: index of pixel
+    void Toggle(std::vector<uint8_t>& pattern, std::vector<float>& energy, uint32_t pixel) const {
+      const float sign = pattern[pixel] ? -1.0f : 1.0f;
+      pattern[pixel] ^= 1;
+      const uint32_t px = pixel % kSize, py = pixel / kSize;
+      for (uint32_t y = 0; y < kSize; y++) {
+        const float* gaussian_row = &gaussian_[((y + kSize - py) % kSize) * kSize];
+        for (uint32_t x = 0; x < kSize; x++)
+          energy[y * kSize + x] += sign * gaussian_row[(x + kSize - px) % kSize];
+      }
+    }
+    /// This function returns the set pixel with maximum energy
+    static uint32_t FindTightestCluster(const std::vector<uint8_t>& pattern, const std::vector<float>& energy) {
+      uint32_t result = 0;
+      float max_energy = -std::numeric_limits<float>::max();
+      for (uint32_t i = 0; i < kNumPixels; i++) {
+        if (pattern[i] and energy[i] > max_energy) {
+          max_energy = energy[i];
+          result = i;
+        }
+      }
+      return result;
+    }
+    /// This function returns the empty pixel with minimum energy
+    static uint32_t FindLargestVoid(const std::vector<uint8_t>& pattern, const std::vector<float>& energy) {
+      uint32_t result = 0;
+      float min_energy = std::numeric_limits<float>::max();
+      for (uint32_t i = 0; i < kNumPixels; i++) {
+        if (!pattern[i] and energy[i] < min_energy) {
+          min_energy = energy[i];
+          result = i;
+        }
+      }
+      return result;
+    }
+
+    float gaussian_[kNumPixels];
+    float values_[kNumPixels];
+  };
+
+  const float* RaySampler::GetBlueNoiseMask() {
+    static const BlueNoiseMask mask;
+    return mask.GetValues();
+  }
+
+  void RaySampler::Prepare(Type type) {
+    if (type == Type::BlueNoise)
+      GetBlueNoiseMask();
+  }
+
+  const char* RaySampler::GetTypeName(Type type) {
+    switch (type) {
+      case Type::Random: return "Random";
+      case Type::Sobol: return "Sobol";
+      case Type::BlueNoise: return "Blue noise";
+      default: return "Invalid";
+    }
+  }
+
+}
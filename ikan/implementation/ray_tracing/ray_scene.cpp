@@ -0,0 +1,409 @@
+//
+//  ray_scene.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_scene.hpp"
+
+namespace ikan {
+  
+  // Shadow ray stops this fraction before the light, so that light surface does not shadow itself
+  static constexpr float kShadowEpsilon = 1e-3f;
+  // Triangle light seen at grazing angle has huge pdf and no contribution
+  static constexpr float kMinLightCosine = 1e-6f;
+  
+  /// This function returns two unit vectors perpendicular to the normal and each other (Duff et al. 2017)
+  /// - Parameters:
+  ///   - normal: unit vector
+  ///   - tangent: first perpendicular output
+  ///   - bitangent: second perpendicular output
+  static void GetBasis(const glm::vec3& normal, glm::vec3& tangent, glm::vec3& bitangent) {
+    const float sign = std::copysign(1.0f, normal.z);
+    const float a = -1.0f / (sign + normal.z);
+    const float b = normal.x * normal.y * a;
+    tangent = glm::vec3(1.0f + sign * normal.x * normal.x * a, sign * b, -sign * normal.x);
+    bitangent = glm::vec3(b, sign + normal.y * normal.y * a, -normal.y);
+  }
+  
+  RayScene::RayScene(const RayScene& other)
+  : spheres(other.spheres), materials(other.materials), meshes(other.meshes), mesh_instances(other.mesh_instances),
+  sky_color(other.sky_color), bvh(other.bvh), sphere_soa(other.sphere_soa), instance_bvh(other.instance_bvh),
+  bvh_rebuild_threshold(other.bvh_rebuild_threshold), sphere_bounds_(other.sphere_bounds_),
+  changed_spheres_(other.changed_spheres_), sphere_changed_flags_(other.sphere_changed_flags_),
+  instance_inverse_transforms_(other.instance_inverse_transforms_), lights_(other.lights_), light_cdf_(other.light_cdf_),
+  sphere_lights_(other.sphere_lights_), instance_lights_(other.instance_lights_) { }
+  
+  RayScene::RayScene(RayScene&& other)
+  : spheres(std::move(other.spheres)), materials(std::move(other.materials)), meshes(std::move(other.meshes)),
+  mesh_instances(std::move(other.mesh_instances)), sky_color(other.sky_color), bvh(std::move(other.bvh)),
+  sphere_soa(std::move(other.sphere_soa)), instance_bvh(std::move(other.instance_bvh)),
+  bvh_rebuild_threshold(other.bvh_rebuild_threshold),
+  sphere_bounds_(std::move(other.sphere_bounds_)), changed_spheres_(std::move(other.changed_spheres_)),
+  sphere_changed_flags_(std::move(other.sphere_changed_flags_)),
+  instance_inverse_transforms_(std::move(other.instance_inverse_transforms_)), lights_(std::move(other.lights_)),
+  light_cdf_(std::move(other.light_cdf_)), sphere_lights_(std::move(other.sphere_lights_)),
+  instance_lights_(std::move(other.instance_lights_)) { }
+  
+  RayScene& RayScene::operator=(const RayScene& other) {
+    spheres = other.spheres;
+    materials = other.materials;
+    meshes = other.meshes;
+    mesh_instances = other.mesh_instances;
+    sky_color = other.sky_color;
+    bvh = other.bvh;
+    sphere_soa = other.sphere_soa;
+    instance_bvh = other.instance_bvh;
+    bvh_rebuild_threshold = other.bvh_rebuild_threshold;
+    sphere_bounds_ = other.sphere_bounds_;
+    changed_spheres_ = other.changed_spheres_;
+    sphere_changed_flags_ = other.sphere_changed_flags_;
+    instance_inverse_transforms_ = other.instance_inverse_transforms_;
+    lights_ = other.lights_;
+    light_cdf_ = other.light_cdf_;
+    sphere_lights_ = other.sphere_lights_;
+    instance_lights_ = other.instance_lights_;
+    return *this;
+  }
+  
+  RayScene& RayScene::operator=(RayScene&& other) {
+    spheres = std::move(other.spheres);
+    materials = std::move(other.materials);
+    meshes = std::move(other.meshes);
+    mesh_instances = std::move(other.mesh_instances);
+    sky_color = other.sky_color;
+    bvh = std::move(other.bvh);
+    sphere_soa = std::move(other.sphere_soa);
+    instance_bvh = std::move(other.instance_bvh);
+    bvh_rebuild_threshold = other.bvh_rebuild_threshold;
+    sphere_bounds_ = std::move(other.sphere_bounds_);
+    changed_spheres_ = std::move(other.changed_spheres_);
+    sphere_changed_flags_ = std::move(other.sphere_changed_flags_);
+    instance_inverse_transforms_ = std::move(other.instance_inverse_transforms_);
+    lights_ = std::move(other.lights_);
+    light_cdf_ = std::move(other.light_cdf_);
+    sphere_lights_ = std::move(other.sphere_lights_);
+    instance_lights_ = std::move(other.instance_lights_);
+    return *this;
+  }
+  
+  void RayScene::BuildAccelerationStructure() {
+    sphere_bounds_.resize(spheres.size());
+    for (size_t i = 0; i < spheres.size(); i++)
+      sphere_bounds_[i] = RayBvh::GetBounds(spheres[i]);
+    bvh.Build(sphere_bounds_);
+    sphere_soa.Build(spheres, bvh.GetPrimitiveIndices());
+    
+    changed_spheres_.clear();
+    sphere_changed_flags_.assign(spheres.size(), 0);
+    
+    // Top level : world bounds of each instance are the bounds of 8 transformed corners of its mesh bounds
+    for (RayMesh& mesh : meshes) {
+      if (!mesh.IsBuilt())
+        mesh.Build();
+    }
+    std::vector<RayBvh::Bounds> instance_bounds(mesh_instances.size());
+    instance_inverse_transforms_.resize(mesh_instances.size());
+    for (size_t i = 0; i < mesh_instances.size(); i++) {
+      const RayMeshInstance& instance = mesh_instances[i];
+      glm::mat4 transform = instance.GetTransform();
+      instance_inverse_transforms_[i] = glm::inverse(transform);
+      
+      RayBvh::Bounds mesh_bounds = meshes[instance.mesh_index].GetBounds();
+      for (int32_t corner = 0; corner < 8; corner++) {
+        glm::vec3 point((corner & 1) ? mesh_bounds.max.x : mesh_bounds.min.x,
+                        (corner & 2) ? mesh_bounds.max.y : mesh_bounds.min.y,
+                        (corner & 4) ? mesh_bounds.max.z : mesh_bounds.min.z);
+        instance_bounds[i].Grow(glm::vec3(transform * glm::vec4(point, 1.0f)));
+      }
+    }
+    instance_bvh.Build(instance_bounds);
+    
+    BuildLights();
+  }
+  
+  void RayScene::BuildLights() {
+    lights_.clear();
+    sphere_lights_.assign(spheres.size(), -1);
+    instance_lights_.assign(mesh_instances.size(), -1);
+    
+    for (size_t i = 0; i < spheres.size(); i++) {
+      if (materials[spheres[i].material_index].type != RayMaterial::Type::Emissive)
+        continue;
+      sphere_lights_[i] = (int32_t)lights_.size();
+      Light& light = lights_.emplace_back();
+      light.sphere_idx = (int32_t)i;
+      light.material_index = spheres[i].material_index;
+      light.area = 4.0f * glm::pi<float>() * spheres[i].radius * spheres[i].radius;
+    }
+    
+    // Triangles of emissive instance are stored in world space, in the order of mesh triangles
+    for (size_t i = 0; i < mesh_instances.size(); i++) {
+      const RayMeshInstance& instance = mesh_instances[i];
+      if (materials[instance.material_index].type != RayMaterial::Type::Emissive)
+        continue;
+      instance_lights_[i] = (int32_t)lights_.size();
+      
+      const RayMesh& mesh = meshes[instance.mesh_index];
+      const glm::mat4 transform = instance.GetTransform();
+      for (uint32_t t = 0; t < mesh.GetNumTriangles(); t++) {
+        glm::vec3 p0 = glm::vec3(transform * glm::vec4(mesh.positions[mesh.indices[t * 3 + 0]], 1.0f));
+        glm::vec3 p1 = glm::vec3(transform * glm::vec4(mesh.positions[mesh.indices[t * 3 + 1]], 1.0f));
+        glm::vec3 p2 = glm::vec3(transform * glm::vec4(mesh.positions[mesh.indices[t * 3 + 2]], 1.0f));
+        
+        Light& light = lights_.emplace_back();
+        light.material_index = instance.material_index;
+        light.vertex = p0;
+        light.edge_1 = p1 - p0;
+        light.edge_2 = p2 - p0;
+        glm::vec3 cross = glm::cross(light.edge_1, light.edge_2);
+        light.area = 0.5f * glm::length(cross);
+        light.normal = light.area > 0.0f ? cross / (2.0f * light.area) : glm::vec3(0.0f);
+      }
+    }
+    
+    // Lights are chosen by power, so that small dim lights do not take the samples of large bright ones
+    light_cdf_.resize(lights_.size());
+    float total_power = 0.0f;
+    for (size_t i = 0; i < lights_.size(); i++) {
+      const glm::vec3 emission = materials[lights_[i].material_index].GetEmission();
+      total_power += glm::dot(emission, glm::vec3(0.2126f, 0.7152f, 0.0722f)) * lights_[i].area;
+      light_cdf_[i] = total_power;
+    }
+    for (float& cdf : light_cdf_)
+      cdf = total_power > 0.0f ? cdf / total_power : 1.0f;
+  }
+  
+  void RayScene::MarkSphereChanged(uint32_t sphere_idx) {
+    if (sphere_idx >= sphere_changed_flags_.size() or sphere_changed_flags_[sphere_idx])
+      return;
+    sphere_changed_flags_[sphere_idx] = 1;
+    changed_spheres_.push_back(sphere_idx);
+    bvh.MarkDirty();
+  }
+  
+  bool RayScene::UpdateAccelerationStructure(ThreadPool* thread_pool) {
+    // BVH marked dirty without any changed sphere is out of date with all the spheres (e.g. scene reloaded)
+    const bool spheres_replaced = bvh.IsDirty() and changed_spheres_.empty();
+    if ((!spheres.empty() and (bvh.GetPrimitiveCount() != spheres.size() or spheres_replaced)) or
+        sphere_bounds_.size() != spheres.size() or instance_inverse_transforms_.size() != mesh_instances.size() or
+        instance_bvh.IsDirty()) {
+      BuildAccelerationStructure();
+      return true;
+    }
+    if (changed_spheres_.empty())
+      return false;
+    
+    for (uint32_t sphere_idx : changed_spheres_) {
+      sphere_bounds_[sphere_idx] = RayBvh::GetBounds(spheres[sphere_idx]);
+      sphere_soa.Update(bvh.GetPrimitiveSlot(sphere_idx), spheres[sphere_idx]);
+      sphere_changed_flags_[sphere_idx] = 0;
+    }
+    bvh.Refit(sphere_bounds_, changed_spheres_, thread_pool);
+    changed_spheres_.clear();
+    
+    // Refit keeps the tree of old positions, and its nodes grow and overlap as the spheres move apart
+    if (bvh.GetCost() > bvh.GetBuildCost() * (1.0f + bvh_rebuild_threshold)) {
+      IK_CORE_TRACE(LogModule::RayBvh, "Rebuilding BVH. SAH cost {0} (build cost {1})", bvh.GetCost(), bvh.GetBuildCost());
+      BuildAccelerationStructure();
+      return true;
+    }
+    return false;
+  }
+  
+  bool RayScene::Intersect(const Ray& ray, RaySphereSoA::Kernel kernel, Hit& hit) const {
+    bool any_hit = false;
+    if (bvh.IsBuilt(spheres.size()) and sphere_soa.count == spheres.size()) {
+      bvh.Traverse(ray, hit.distance, [&](uint32_t first, uint32_t count) {
+        if (sphere_soa.Intersect(kernel, ray, first, count, hit.distance, hit.sphere_idx))
+          any_hit = true;
+      });
+    }
+    else {
+      // Acceleration structure is not build yet. Test all the spheres
+      for (size_t i = 0; i < spheres.size(); i++) {
+        if (spheres[i].Hit(ray, hit.distance)) {
+          hit.sphere_idx = (int32_t)i;
+          any_hit = true;
+        }
+      }
+    }
+    
+    if (mesh_instances.empty() or !instance_bvh.IsBuilt(mesh_instances.size()) or
+        instance_inverse_transforms_.size() != mesh_instances.size())
+      return any_hit;
+    
+    // Ray is moved to object space of instance without normalising the direction, so that hit distance in object
+    // space is same as in world space and meshes share the closest hit distance with spheres
+    const std::vector<uint32_t>& instance_indices = instance_bvh.GetPrimitiveIndices();
+    instance_bvh.Traverse(ray, hit.distance, [&](uint32_t first, uint32_t count) {
+      for (uint32_t slot = first; slot < first + count; slot++) {
+        const uint32_t instance_idx = instance_indices[slot];
+        const glm::mat4& inverse_transform = instance_inverse_transforms_[instance_idx];
+        Ray object_ray(glm::vec3(inverse_transform * glm::vec4(ray.origin, 1.0f)),
+                       glm::vec3(inverse_transform * glm::vec4(ray.direction, 0.0f)));
+        
+        uint32_t triangle_idx = 0;
+        if (meshes[mesh_instances[instance_idx].mesh_index].Intersect(object_ray, kernel, hit.distance, triangle_idx)) {
+          hit.sphere_idx = -1;
+          hit.instance_idx = (int32_t)instance_idx;
+          hit.triangle_idx = triangle_idx;
+          any_hit = true;
+        }
+      }
+    });
+    return any_hit;
+  }
+  
+  void RayScene::GetSurface(const Ray& ray, const Hit& hit, glm::vec3& normal, int32_t& material_index) const {
+    if (hit.sphere_idx >= 0) {
+      const RaySphere& sphere = spheres[hit.sphere_idx];
+      normal = (ray.At(hit.distance) - sphere.position) / sphere.radius;
+      material_index = sphere.material_index;
+      return;
+    }
+    
+    // Normals are transformed by inverse transpose, so that they stay perpendicular under non uniform scale
+    const RayMeshInstance& instance = mesh_instances[hit.instance_idx];
+    const glm::vec3& object_normal = meshes[instance.mesh_index].GetNormal(hit.triangle_idx);
+    normal = glm::normalize(glm::transpose(glm::mat3(instance_inverse_transforms_[hit.instance_idx])) * object_normal);
+    material_index = instance.material_index;
+  }
+  
+  bool RayScene::IsOccluded(const Ray& ray, float distance, RaySphereSoA::Kernel kernel) const {
+    Hit hit;
+    hit.distance = distance * (1.0f - kShadowEpsilon);
+    return Intersect(ray, kernel, hit);
+  }
+  
+  uint32_t RayScene::GetObjectId(const Hit& hit) const {
+    return hit.sphere_idx >= 0 ? (uint32_t)hit.sphere_idx : (uint32_t)(spheres.size() + hit.instance_idx);
+  }
+  
+  uint32_t RayScene::GetNumObjects() const { return (uint32_t)(spheres.size() + mesh_instances.size()); }
+  
+  bool RayScene::SampleLight(const glm::vec3& position, RaySampler& sampler, LightSample& sample) const {
+    if (lights_.empty())
+      return false;
+    
+    const uint32_t light_idx = std::min((uint32_t)(std::upper_bound(light_cdf_.begin(), light_cdf_.end(), sampler.Next1D()) -
+                                                   light_cdf_.begin()), (uint32_t)lights_.size() - 1);
+    const Light& light = lights_[light_idx];
+    const glm::vec2 u = sampler.Next2D();
+    const float u_1 = u.x;
+    const float u_2 = u.y;
+    
+    if (light.sphere_idx >= 0) {
+      // Direction is sampled uniformly in the cone of directions that hit the sphere
+      const RaySphere& sphere = spheres[light.sphere_idx];
+      const glm::vec3 to_center = sphere.position - position;
+      const float distance_squared = glm::dot(to_center, to_center);
+      const float radius_squared = sphere.radius * sphere.radius;
+      if (distance_squared <= radius_squared)
+        return false;
+      
+      // 1 - cos is computed from sin, as the cos of small cone is too close to 1 for float
+      const float sin_max_squared = radius_squared / distance_squared;
+      const float cos_max = std::sqrt(1.0f - sin_max_squared);
+      const float one_minus_cos_max = sin_max_squared / (1.0f + cos_max);
+      
+      const float cos_theta = 1.0f - u_1 * one_minus_cos_max;
+      const float sin_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f));
+      const float phi = 2.0f * glm::pi<float>() * u_2;
+      
+      glm::vec3 tangent, bitangent;
+      const glm::vec3 axis = to_center / std::sqrt(distance_squared);
+      GetBasis(axis, tangent, bitangent);
+      sample.direction = glm::normalize(tangent * (sin_theta * std::cos(phi)) + bitangent * (sin_theta * std::sin(phi)) +
+                                        axis * cos_theta);
+      
+      // Nearest intersection of sampled direction with sphere
+      const float projection = glm::dot(sample.direction, to_center);
+      sample.distance = projection - std::sqrt(std::max(projection * projection - distance_squared + radius_squared, 0.0f));
+      sample.pdf = 1.0f / (2.0f * glm::pi<float>() * one_minus_cos_max);
+    }
+    else {
+      // Uniform point on triangle, converted from area pdf to solid angle pdf
+      const float sqrt_u_1 = std::sqrt(u_1);
+      const glm::vec3 light_position = light.vertex + light.edge_1 * (sqrt_u_1 * (1.0f - u_2)) + light.edge_2 * (sqrt_u_1 * u_2);
+      const glm::vec3 to_light = light_position - position;
+      const float distance_squared = glm::dot(to_light, to_light);
+      sample.distance = std::sqrt(distance_squared);
+      sample.direction = to_light / sample.distance;
+      
+      const float cos_light = std::abs(glm::dot(light.normal, sample.direction));
+      if (cos_light < kMinLightCosine or light.area <= 0.0f)
+        return false;
+      sample.pdf = distance_squared / (cos_light * light.area);
+    }
+    
+    sample.pdf *= GetLightProbability(light_idx);
+    sample.radiance = materials[light.material_index].GetEmission();
+    return sample.pdf > 0.0f and sample.distance > 0.0f;
+  }
+  
+  float RayScene::GetLightPdf(int32_t light_idx, const glm::vec3& position, const glm::vec3& light_position) const {
+    if (light_idx < 0 or light_idx >= (int32_t)lights_.size())
+      return 0.0f;
+    
+    const Light& light = lights_[light_idx];
+    float pdf = 0.0f;
+    if (light.sphere_idx >= 0) {
+      const RaySphere& sphere = spheres[light.sphere_idx];
+      const glm::vec3 to_center = sphere.position - position;
+      const float distance_squared = glm::dot(to_center, to_center);
+      const float radius_squared = sphere.radius * sphere.radius;
+      if (distance_squared <= radius_squared)
+        return 0.0f;
+      
+      const float sin_max_squared = radius_squared / distance_squared;
+      const float one_minus_cos_max = sin_max_squared / (1.0f + std::sqrt(1.0f - sin_max_squared));
+      pdf = 1.0f / (2.0f * glm::pi<float>() * one_minus_cos_max);
+    }
+    else {
+      const glm::vec3 to_light = light_position - position;
+      const float distance_squared = glm::dot(to_light, to_light);
+      const float cos_light = std::abs(glm::dot(light.normal, to_light)) / std::sqrt(distance_squared);
+      if (cos_light < kMinLightCosine or light.area <= 0.0f)
+        return 0.0f;
+      pdf = distance_squared / (cos_light * light.area);
+    }
+    return pdf * GetLightProbability(light_idx);
+  }
+  
+  int32_t RayScene::GetLightIndex(const Hit& hit) const {
+    if (hit.sphere_idx >= 0)
+      return hit.sphere_idx < (int32_t)sphere_lights_.size() ? sphere_lights_[hit.sphere_idx] : -1;
+    if (hit.instance_idx < 0 or hit.instance_idx >= (int32_t)instance_lights_.size() or instance_lights_[hit.instance_idx] < 0)
+      return -1;
+    return instance_lights_[hit.instance_idx] + (int32_t)hit.triangle_idx;
+  }
+  
+  uint32_t RayScene::GetNumLights() const { return (uint32_t)lights_.size(); }
+  bool RayScene::IsLightMaterial(uint32_t material_idx) const {
+    if (material_idx < materials.size() and materials[material_idx].type == RayMaterial::Type::Emissive)
+      return true;
+    return std::any_of(lights_.begin(), lights_.end(), [material_idx](const Light& light) {
+      return light.material_index == (int32_t)material_idx;
+    });
+  }
+  float RayScene::GetMisWeight(float pdf, float other_pdf) {
+    const float pdf_squared = pdf * pdf;
+    return pdf_squared > 0.0f ? pdf_squared / (pdf_squared + other_pdf * other_pdf) : 0.0f;
+  }
+  
+  void RayScene::ObjectSet::Clear(uint32_t num_objects) {
+    objects_.clear();
+    stamp_++;
+    if (stamps_.size() != num_objects or stamp_ == 0) {
+      stamps_.assign(num_objects, 0);
+      stamp_ = 1;
+    }
+  }
+  
+  float RayScene::GetLightProbability(uint32_t light_idx) const {
+    return light_cdf_[light_idx] - (light_idx > 0 ? light_cdf_[light_idx - 1] : 0.0f);
+  }
+  
+}
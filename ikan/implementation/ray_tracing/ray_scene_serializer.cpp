@@ -0,0 +1,225 @@
+//
+//  ray_scene_serializer.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_scene_serializer.hpp"
+
+#include <yaml-cpp/yaml.h>
+#include <filesystem>
+
+namespace ikan {
+  
+  static YAML::Emitter& operator<<(YAML::Emitter& out, const glm::vec3& v) {
+    out << YAML::Flow;
+    out << YAML::BeginSeq << v.x << v.y << v.z << YAML::EndSeq;
+    return out;
+  }
+  
+  /// This function reads the vec3 from yaml sequence
+  /// - Parameters:
+  ///   - node: yaml node
+  ///   - default_value: value if node is not a sequence of 3 elements
+  static glm::vec3 ReadVec3(const YAML::Node& node, const glm::vec3& default_value) {
+    if (!node or !node.IsSequence() or node.size() != 3)
+      return default_value;
+    return glm::vec3(node[0].as<float>(), node[1].as<float>(), node[2].as<float>());
+  }
+  
+  static const char* MaterialTypeToString(RayMaterial::Type type) {
+    switch (type) {
+      case RayMaterial::Type::Metal: return "Metal";
+      case RayMaterial::Type::Lambertian: return "Lambertian";
+      case RayMaterial::Type::Dielectric: return "Dielectric";
+      case RayMaterial::Type::Emissive: return "Emissive";
+      case RayMaterial::Type::None:
+      default: return "None";
+    }
+  }
+  
+  static RayMaterial::Type MaterialTypeFromString(const std::string& type) {
+    if (type == "Metal") return RayMaterial::Type::Metal;
+    if (type == "Lambertian") return RayMaterial::Type::Lambertian;
+    if (type == "Dielectric") return RayMaterial::Type::Dielectric;
+    if (type == "Emissive") return RayMaterial::Type::Emissive;
+    return RayMaterial::Type::None;
+  }
+  
+  RaySceneSerializer::RaySceneSerializer(RayScene* scene, RayCamera* camera) : scene_(scene), camera_(camera) { }
+  RaySceneSerializer::~RaySceneSerializer() { }
+  
+  void RaySceneSerializer::Serialize(const std::string& file_path) {
+    IK_CORE_INFO(LogModule::SceneSerializer, "Serialising a Ray Scene");
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Path      | {0}", file_path);
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Spheres   | {0}", scene_->spheres.size());
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Materials | {0}", scene_->materials.size());
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Meshes    | {0}", scene_->meshes.size());
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Instances | {0}", scene_->mesh_instances.size());
+
+    YAML::Emitter out;
+    out << YAML::BeginMap;
+    out << YAML::Key << "Scene" << YAML::Value << "Ray Scene";
+    out << YAML::Key << "SkyColor" << YAML::Value << scene_->sky_color;
+    
+    if (camera_) {
+      out << YAML::Key << "Camera" << YAML::Value << YAML::BeginMap;
+      out << YAML::Key << "Position" << YAML::Value << camera_->GetPosition();
+      out << YAML::Key << "Target" << YAML::Value << camera_->GetTarget();
+      out << YAML::Key << "FOV" << YAML::Value << glm::degrees(camera_->GetFOV());
+      out << YAML::EndMap;
+    }
+    
+    out << YAML::Key << "Materials" << YAML::Value << YAML::BeginSeq;
+    for (const RayMaterial& material : scene_->materials) {
+      out << YAML::BeginMap;
+      out << YAML::Key << "Type" << YAML::Value << MaterialTypeToString(material.type);
+      out << YAML::Key << "Albedo" << YAML::Value << material.albedo;
+      out << YAML::Key << "Fuzz" << YAML::Value << material.fuzz;
+      out << YAML::Key << "RefractiveIndex" << YAML::Value << material.refractive_index;
+      out << YAML::Key << "Intensity" << YAML::Value << material.intensity;
+      out << YAML::EndMap;
+    }
+    out << YAML::EndSeq;
+    
+    out << YAML::Key << "Spheres" << YAML::Value << YAML::BeginSeq;
+    for (const RaySphere& sphere : scene_->spheres) {
+      out << YAML::BeginMap;
+      out << YAML::Key << "Position" << YAML::Value << sphere.position;
+      out << YAML::Key << "Radius" << YAML::Value << sphere.radius;
+      out << YAML::Key << "Material" << YAML::Value << sphere.material_index;
+      out << YAML::EndMap;
+    }
+    out << YAML::EndSeq;
+    
+    // Mesh paths are saved relative to the scene file, so that scene can be moved with its meshes
+    std::filesystem::path scene_directory = std::filesystem::absolute(file_path).parent_path();
+    out << YAML::Key << "Meshes" << YAML::Value << YAML::BeginSeq;
+    for (const RayMesh& mesh : scene_->meshes) {
+      std::filesystem::path mesh_path = std::filesystem::absolute(mesh.file_path).lexically_relative(scene_directory);
+      out << YAML::BeginMap;
+      out << YAML::Key << "Path" << YAML::Value << (mesh_path.empty() ? mesh.file_path : mesh_path.string());
+      out << YAML::EndMap;
+    }
+    out << YAML::EndSeq;
+    
+    out << YAML::Key << "Instances" << YAML::Value << YAML::BeginSeq;
+    for (const RayMeshInstance& instance : scene_->mesh_instances) {
+      out << YAML::BeginMap;
+      out << YAML::Key << "Mesh" << YAML::Value << instance.mesh_index;
+      out << YAML::Key << "Material" << YAML::Value << instance.material_index;
+      out << YAML::Key << "Position" << YAML::Value << instance.position;
+      out << YAML::Key << "Rotation" << YAML::Value << glm::degrees(instance.rotation);
+      out << YAML::Key << "Scale" << YAML::Value << instance.scale;
+      out << YAML::EndMap;
+    }
+    out << YAML::EndSeq;
+    out << YAML::EndMap;
+    
+    std::ofstream fout(file_path);
+    fout << out.c_str();
+  }
+  
+  bool RaySceneSerializer::Deserialize(const std::string& file_path) {
+    if (file_path == "") return false;
+    
+    YAML::Node data;
+    try {
+      data = YAML::LoadFile(file_path);
+    }
+    catch (const YAML::Exception& e) {
+      IK_CORE_ERROR(LogModule::SceneSerializer, "Failed to load Ray Scene {0} : {1}", file_path, e.what());
+      return false;
+    }
+    
+    if (!data["Scene"])
+      return false;
+    
+    scene_->sky_color = ReadVec3(data["SkyColor"], RayScene().sky_color);
+    
+    scene_->materials.clear();
+    if (auto materials = data["Materials"]) {
+      for (auto material_node : materials) {
+        RayMaterial& material = scene_->materials.emplace_back();
+        material.type = MaterialTypeFromString(material_node["Type"].as<std::string>("None"));
+        material.albedo = ReadVec3(material_node["Albedo"], glm::vec3(0.8f));
+        material.fuzz = material_node["Fuzz"].as<float>(material.fuzz);
+        material.refractive_index = material_node["RefractiveIndex"].as<float>(material.refractive_index);
+        material.intensity = material_node["Intensity"].as<float>(material.intensity);
+      }
+    }
+    
+    // Trees are out of date till the new scene is built, also if loading fails in between
+    scene_->spheres.clear();
+    scene_->bvh.MarkDirty();
+    if (auto spheres = data["Spheres"]) {
+      for (auto sphere_node : spheres) {
+        int32_t material_index = sphere_node["Material"].as<int32_t>(0);
+        if (material_index < 0 or material_index >= (int32_t)scene_->materials.size()) {
+          IK_CORE_ERROR(LogModule::SceneSerializer, "Invalid material index {0} in Ray Scene {1}", material_index, file_path);
+          return false;
+        }
+        scene_->spheres.emplace_back(ReadVec3(sphere_node["Position"], glm::vec3(0.0f)),
+                                     sphere_node["Radius"].as<float>(0.5f),
+                                     material_index);
+      }
+    }
+    
+    // Relative mesh paths are relative to the scene file
+    scene_->meshes.clear();
+    if (auto meshes = data["Meshes"]) {
+      std::filesystem::path scene_directory = std::filesystem::path(file_path).parent_path();
+      for (auto mesh_node : meshes) {
+        std::filesystem::path mesh_path = mesh_node["Path"].as<std::string>("");
+        if (mesh_path.is_relative())
+          mesh_path = scene_directory / mesh_path;
+        if (!scene_->meshes.emplace_back().LoadObj(mesh_path.string())) {
+          IK_CORE_ERROR(LogModule::SceneSerializer, "Failed to load mesh {0} in Ray Scene {1}", mesh_path.string(), file_path);
+          return false;
+        }
+      }
+    }
+    
+    scene_->mesh_instances.clear();
+    scene_->instance_bvh.MarkDirty();
+    if (auto instances = data["Instances"]) {
+      for (auto instance_node : instances) {
+        RayMeshInstance& instance = scene_->mesh_instances.emplace_back();
+        instance.mesh_index = instance_node["Mesh"].as<uint32_t>(0);
+        instance.material_index = instance_node["Material"].as<int32_t>(0);
+        instance.position = ReadVec3(instance_node["Position"], instance.position);
+        instance.rotation = glm::radians(ReadVec3(instance_node["Rotation"], glm::vec3(0.0f)));
+        instance.scale = ReadVec3(instance_node["Scale"], instance.scale);
+        
+        if (instance.mesh_index >= scene_->meshes.size()) {
+          IK_CORE_ERROR(LogModule::SceneSerializer, "Invalid mesh index {0} in Ray Scene {1}", instance.mesh_index, file_path);
+          return false;
+        }
+        if (instance.material_index < 0 or instance.material_index >= (int32_t)scene_->materials.size()) {
+          IK_CORE_ERROR(LogModule::SceneSerializer, "Invalid material index {0} in Ray Scene {1}", instance.material_index, file_path);
+          return false;
+        }
+      }
+    }
+    
+    if (camera_) {
+      if (auto camera_node = data["Camera"]) {
+        camera_->SetFOV(glm::radians(camera_node["FOV"].as<float>(glm::degrees(camera_->GetFOV()))));
+        camera_->LookAt(ReadVec3(camera_node["Position"], camera_->GetPosition()),
+                        ReadVec3(camera_node["Target"], camera_->GetTarget()));
+      }
+    }
+    
+    scene_->BuildAccelerationStructure();
+    
+    IK_CORE_INFO(LogModule::SceneSerializer, "Deserialising Ray Scene");
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Path      | {0}", file_path);
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Spheres   | {0}", scene_->spheres.size());
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Materials | {0}", scene_->materials.size());
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Meshes    | {0}", scene_->meshes.size());
+    IK_CORE_INFO(LogModule::SceneSerializer, "  Instances | {0}", scene_->mesh_instances.size());
+    return true;
+  }
+  
+}
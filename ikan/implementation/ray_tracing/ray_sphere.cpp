@@ -10,10 +10,29 @@
 namespace ikan {
   
   RaySphere::RaySphere(const RaySphere& other)
-  : position(other.position), radius(other.radius) {
+  : position(other.position), radius(other.radius), material_index(other.material_index) {
 //    IK_CORE_TRACE(LogModule::Sphere, "Copying Sphere ...");
   }
   
+  RaySphere::RaySphere(RaySphere&& other)
+  : position(other.position), radius(other.radius), material_index(other.material_index) {
+//    IK_CORE_TRACE(LogModule::Sphere, "Moving Sphere ...");
+  }
+  
+  RaySphere& RaySphere::operator=(const RaySphere& other) {
+    position = other.position;
+    radius = other.radius;
+    material_index = other.material_index;
+    return *this;
+  }
+  
+  RaySphere& RaySphere::operator=(RaySphere&& other) {
+    position = other.position;
+    radius = other.radius;
+    material_index = other.material_index;
+    return *this;
+  }
+  
   RaySphere::RaySphere(const glm::vec3& position, float radius, int32_t material_index)
   : position(position), radius(radius), material_index(material_index) { }
   
@@ -0,0 +1,355 @@
+//
+//  ray_sphere_soa.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_sphere_soa.hpp"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define IK_RAY_SIMD_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#define IK_RAY_SIMD_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace ikan {
+
+  // Minimum distance of hit to avoid self intersection (Same as RaySphere::Hit)
+  static constexpr float kMinHitDistance = 0.001f;
+
+  void RaySphereSoA::Build(const std::vector<RaySphere>& spheres, const std::vector<uint32_t>& order) {
+    Clear();
+    count = (uint32_t)order.size();
+
+    // Padding lanes have negative radius, so discriminant is always negative
+    const size_t padded_size = count + kMaxSimdWidth;
+    center_x.resize(padded_size, 0.0f);
+    center_y.resize(padded_size, 0.0f);
+    center_z.resize(padded_size, 0.0f);
+    radius_sq.resize(padded_size, -std::numeric_limits<float>::max());
+    material_index.resize(padded_size, -1);
+    sphere_index.resize(padded_size, 0);
+
+    for (uint32_t i = 0; i < count; i++) {
+      const RaySphere& sphere = spheres[order[i]];
+      center_x[i] = sphere.position.x;
+      center_y[i] = sphere.position.y;
+      center_z[i] = sphere.position.z;
+      radius_sq[i] = sphere.radius * sphere.radius;
+      material_index[i] = sphere.material_index;
+      sphere_index[i] = order[i];
+    }
+  }
+
+  void RaySphereSoA::Update(uint32_t slot, const RaySphere& sphere) {
+    center_x[slot] = sphere.position.x;
+    center_y[slot] = sphere.position.y;
+    center_z[slot] = sphere.position.z;
+    radius_sq[slot] = sphere.radius * sphere.radius;
+    material_index[slot] = sphere.material_index;
+  }
+
+  void RaySphereSoA::Clear() {
+    center_x.clear();
+    center_y.clear();
+    center_z.clear();
+    radius_sq.clear();
+    material_index.clear();
+    sphere_index.clear();
+    count = 0;
+  }
+
+  bool RaySphereSoA::Intersect(Kernel kernel,
+                               const Ray& ray,
+                               uint32_t first,
+                               uint32_t num_spheres,
+                               float& hit_distance,
+                               int32_t& object_idx) const {
+    switch (kernel) {
+      case Kernel::Simd8: return IntersectSimd8(ray, first, num_spheres, hit_distance, object_idx);
+      case Kernel::Simd4: return IntersectSimd4(ray, first, num_spheres, hit_distance, object_idx);
+      case Kernel::Scalar:
+      default:
+        return IntersectScalar(ray, first, num_spheres, hit_distance, object_idx);
+    }
+  }
+
+  bool RaySphereSoA::IntersectScalar(const Ray& ray,
+                                     uint32_t first,
+                                     uint32_t num_spheres,
+                                     float& hit_distance,
+                                     int32_t& object_idx) const {
+    bool hit = false;
+    const float a = glm::dot(ray.direction, ray.direction);
+    for (uint32_t i = first; i < first + num_spheres; i++) {
+      float oc_x = ray.origin.x - center_x[i];
+      float oc_y = ray.origin.y - center_y[i];
+      float oc_z = ray.origin.z - center_z[i];
+
+      float half_b = oc_x * ray.direction.x + oc_y * ray.direction.y + oc_z * ray.direction.z;
+      float c = oc_x * oc_x + oc_y * oc_y + oc_z * oc_z - radius_sq[i];
+      float discriminant = half_b * half_b - a * c;
+      if (discriminant < 0)
+        continue;
+
+      float sqrt_d = std::sqrt(discriminant);
+      float t = (-half_b - sqrt_d) / a;
+      if (t < kMinHitDistance)
+        t = (-half_b + sqrt_d) / a;
+
+      if (t >= kMinHitDistance and t < hit_distance) {
+        hit_distance = t;
+        object_idx = (int32_t)sphere_index[i];
+        hit = true;
+      }
+    }
+    return hit;
+  }
+
+  bool RaySphereSoA::IntersectSimd4(const Ray& ray,
+                                    uint32_t first,
+                                    uint32_t num_spheres,
+                                    float& hit_distance,
+                                    int32_t& object_idx) const {
+#if IK_RAY_SIMD_X86
+    const __m128 origin_x = _mm_set1_ps(ray.origin.x);
+    const __m128 origin_y = _mm_set1_ps(ray.origin.y);
+    const __m128 origin_z = _mm_set1_ps(ray.origin.z);
+    const __m128 dir_x = _mm_set1_ps(ray.direction.x);
+    const __m128 dir_y = _mm_set1_ps(ray.direction.y);
+    const __m128 dir_z = _mm_set1_ps(ray.direction.z);
+    const __m128 a = _mm_set1_ps(glm::dot(ray.direction, ray.direction));
+    const __m128 inv_a = _mm_div_ps(_mm_set1_ps(1.0f), a);
+    const __m128 min_t = _mm_set1_ps(kMinHitDistance);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 end = _mm_set1_ps((float)num_spheres);
+
+    __m128 lane = _mm_setr_ps(0.0f, 1.0f, 2.0f, 3.0f);
+    __m128 best_t = _mm_set1_ps(hit_distance);
+    __m128 best_lane = _mm_set1_ps(-1.0f);
+
+    for (uint32_t i = 0; i < num_spheres; i += 4) {
+      const uint32_t idx = first + i;
+      __m128 oc_x = _mm_sub_ps(origin_x, _mm_loadu_ps(&center_x[idx]));
+      __m128 oc_y = _mm_sub_ps(origin_y, _mm_loadu_ps(&center_y[idx]));
+      __m128 oc_z = _mm_sub_ps(origin_z, _mm_loadu_ps(&center_z[idx]));
+
+      __m128 half_b = _mm_add_ps(_mm_add_ps(_mm_mul_ps(oc_x, dir_x), _mm_mul_ps(oc_y, dir_y)), _mm_mul_ps(oc_z, dir_z));
+      __m128 c = _mm_add_ps(_mm_add_ps(_mm_mul_ps(oc_x, oc_x), _mm_mul_ps(oc_y, oc_y)), _mm_mul_ps(oc_z, oc_z));
+      c = _mm_sub_ps(c, _mm_loadu_ps(&radius_sq[idx]));
+      __m128 discriminant = _mm_sub_ps(_mm_mul_ps(half_b, half_b), _mm_mul_ps(a, c));
+
+      __m128 sqrt_d = _mm_sqrt_ps(_mm_max_ps(discriminant, zero));
+      __m128 neg_b = _mm_sub_ps(zero, half_b);
+      __m128 t_near = _mm_mul_ps(_mm_sub_ps(neg_b, sqrt_d), inv_a);
+      __m128 t_far = _mm_mul_ps(_mm_add_ps(neg_b, sqrt_d), inv_a);
+
+      // Take the near root if it is in front of ray, else far root
+      __m128 use_near = _mm_cmpge_ps(t_near, min_t);
+      __m128 t = _mm_or_ps(_mm_and_ps(use_near, t_near), _mm_andnot_ps(use_near, t_far));
+
+      __m128 valid = _mm_and_ps(_mm_cmpge_ps(discriminant, zero), _mm_cmpge_ps(t, min_t));
+      valid = _mm_and_ps(valid, _mm_cmplt_ps(t, best_t));
+      valid = _mm_and_ps(valid, _mm_cmplt_ps(lane, end));
+
+      best_t = _mm_or_ps(_mm_and_ps(valid, t), _mm_andnot_ps(valid, best_t));
+      best_lane = _mm_or_ps(_mm_and_ps(valid, lane), _mm_andnot_ps(valid, best_lane));
+      lane = _mm_add_ps(lane, _mm_set1_ps(4.0f));
+    }
+
+    alignas(16) float lane_t[4], lane_idx[4];
+    _mm_store_ps(lane_t, best_t);
+    _mm_store_ps(lane_idx, best_lane);
+#elif IK_RAY_SIMD_NEON
+    const float32x4_t origin_x = vdupq_n_f32(ray.origin.x);
+    const float32x4_t origin_y = vdupq_n_f32(ray.origin.y);
+    const float32x4_t origin_z = vdupq_n_f32(ray.origin.z);
+    const float32x4_t dir_x = vdupq_n_f32(ray.direction.x);
+    const float32x4_t dir_y = vdupq_n_f32(ray.direction.y);
+    const float32x4_t dir_z = vdupq_n_f32(ray.direction.z);
+    const float32x4_t a = vdupq_n_f32(glm::dot(ray.direction, ray.direction));
+    const float32x4_t inv_a = vdupq_n_f32(1.0f / glm::dot(ray.direction, ray.direction));
+    const float32x4_t min_t = vdupq_n_f32(kMinHitDistance);
+    const float32x4_t zero = vdupq_n_f32(0.0f);
+    const float32x4_t end = vdupq_n_f32((float)num_spheres);
+
+    const float lane_init[4] = { 0.0f, 1.0f, 2.0f, 3.0f };
+    float32x4_t lane = vld1q_f32(lane_init);
+    float32x4_t best_t = vdupq_n_f32(hit_distance);
+    float32x4_t best_lane = vdupq_n_f32(-1.0f);
+
+    for (uint32_t i = 0; i < num_spheres; i += 4) {
+      const uint32_t idx = first + i;
+      float32x4_t oc_x = vsubq_f32(origin_x, vld1q_f32(&center_x[idx]));
+      float32x4_t oc_y = vsubq_f32(origin_y, vld1q_f32(&center_y[idx]));
+      float32x4_t oc_z = vsubq_f32(origin_z, vld1q_f32(&center_z[idx]));
+
+      float32x4_t half_b = vaddq_f32(vaddq_f32(vmulq_f32(oc_x, dir_x), vmulq_f32(oc_y, dir_y)), vmulq_f32(oc_z, dir_z));
+      float32x4_t c = vaddq_f32(vaddq_f32(vmulq_f32(oc_x, oc_x), vmulq_f32(oc_y, oc_y)), vmulq_f32(oc_z, oc_z));
+      c = vsubq_f32(c, vld1q_f32(&radius_sq[idx]));
+      float32x4_t discriminant = vsubq_f32(vmulq_f32(half_b, half_b), vmulq_f32(a, c));
+
+      float32x4_t sqrt_d = vsqrtq_f32(vmaxq_f32(discriminant, zero));
+      float32x4_t neg_b = vnegq_f32(half_b);
+      float32x4_t t_near = vmulq_f32(vsubq_f32(neg_b, sqrt_d), inv_a);
+      float32x4_t t_far = vmulq_f32(vaddq_f32(neg_b, sqrt_d), inv_a);
+
+      // Take the near root if it is in front of ray, else far root
+      float32x4_t t = vbslq_f32(vcgeq_f32(t_near, min_t), t_near, t_far);
+
+      uint32x4_t valid = vandq_u32(vcgeq_f32(discriminant, zero), vcgeq_f32(t, min_t));
+      valid = vandq_u32(valid, vcltq_f32(t, best_t));
+      valid = vandq_u32(valid, vcltq_f32(lane, end));
+
+      best_t = vbslq_f32(valid, t, best_t);
+      best_lane = vbslq_f32(valid, lane, best_lane);
+      lane = vaddq_f32(lane, vdupq_n_f32(4.0f));
+    }
+
+    float lane_t[4], lane_idx[4];
+    vst1q_f32(lane_t, best_t);
+    vst1q_f32(lane_idx, best_lane);
+#else
+    return IntersectScalar(ray, first, num_spheres, hit_distance, object_idx);
+#endif
+
+#if IK_RAY_SIMD_X86 || IK_RAY_SIMD_NEON
+    // Lane wise minimum
+    int32_t best = -1;
+    for (int32_t l = 0; l < 4; l++) {
+      if (lane_idx[l] >= 0.0f and lane_t[l] < hit_distance) {
+        hit_distance = lane_t[l];
+        best = (int32_t)lane_idx[l];
+      }
+    }
+    if (best < 0)
+      return false;
+
+    object_idx = (int32_t)sphere_index[first + best];
+    return true;
+#endif
+  }
+
+#if IK_RAY_SIMD_X86
+  __attribute__((target("avx2")))
+  static int32_t IntersectAvx2(const RaySphereSoA& soa,
+                               const Ray& ray,
+                               uint32_t first,
+                               uint32_t num_spheres,
+                               float& hit_distance) {
+    const __m256 origin_x = _mm256_set1_ps(ray.origin.x);
+    const __m256 origin_y = _mm256_set1_ps(ray.origin.y);
+    const __m256 origin_z = _mm256_set1_ps(ray.origin.z);
+    const __m256 dir_x = _mm256_set1_ps(ray.direction.x);
+    const __m256 dir_y = _mm256_set1_ps(ray.direction.y);
+    const __m256 dir_z = _mm256_set1_ps(ray.direction.z);
+    const __m256 a = _mm256_set1_ps(glm::dot(ray.direction, ray.direction));
+    const __m256 inv_a = _mm256_div_ps(_mm256_set1_ps(1.0f), a);
+    const __m256 min_t = _mm256_set1_ps(kMinHitDistance);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 end = _mm256_set1_ps((float)num_spheres);
+
+    __m256 lane = _mm256_setr_ps(0.0f, 1.0f, 2.0f, 3.0f, 4.0f, 5.0f, 6.0f, 7.0f);
+    __m256 best_t = _mm256_set1_ps(hit_distance);
+    __m256 best_lane = _mm256_set1_ps(-1.0f);
+
+    for (uint32_t i = 0; i < num_spheres; i += 8) {
+      const uint32_t idx = first + i;
+      __m256 oc_x = _mm256_sub_ps(origin_x, _mm256_loadu_ps(&soa.center_x[idx]));
+      __m256 oc_y = _mm256_sub_ps(origin_y, _mm256_loadu_ps(&soa.center_y[idx]));
+      __m256 oc_z = _mm256_sub_ps(origin_z, _mm256_loadu_ps(&soa.center_z[idx]));
+
+      __m256 half_b = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(oc_x, dir_x), _mm256_mul_ps(oc_y, dir_y)),
+                                    _mm256_mul_ps(oc_z, dir_z));
+      __m256 c = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(oc_x, oc_x), _mm256_mul_ps(oc_y, oc_y)),
+                               _mm256_mul_ps(oc_z, oc_z));
+      c = _mm256_sub_ps(c, _mm256_loadu_ps(&soa.radius_sq[idx]));
+      __m256 discriminant = _mm256_sub_ps(_mm256_mul_ps(half_b, half_b), _mm256_mul_ps(a, c));
+
+      __m256 sqrt_d = _mm256_sqrt_ps(_mm256_max_ps(discriminant, zero));
+      __m256 neg_b = _mm256_sub_ps(zero, half_b);
+      __m256 t_near = _mm256_mul_ps(_mm256_sub_ps(neg_b, sqrt_d), inv_a);
+      __m256 t_far = _mm256_mul_ps(_mm256_add_ps(neg_b, sqrt_d), inv_a);
+
+      // Take the near root if it is in front of ray, else far root
+      __m256 t = _mm256_blendv_ps(t_far, t_near, _mm256_cmp_ps(t_near, min_t, _CMP_GE_OQ));
+
+      __m256 valid = _mm256_and_ps(_mm256_cmp_ps(discriminant, zero, _CMP_GE_OQ), _mm256_cmp_ps(t, min_t, _CMP_GE_OQ));
+      valid = _mm256_and_ps(valid, _mm256_cmp_ps(t, best_t, _CMP_LT_OQ));
+      valid = _mm256_and_ps(valid, _mm256_cmp_ps(lane, end, _CMP_LT_OQ));
+
+      best_t = _mm256_blendv_ps(best_t, t, valid);
+      best_lane = _mm256_blendv_ps(best_lane, lane, valid);
+      lane = _mm256_add_ps(lane, _mm256_set1_ps(8.0f));
+    }
+
+    alignas(32) float lane_t[8], lane_idx[8];
+    _mm256_store_ps(lane_t, best_t);
+    _mm256_store_ps(lane_idx, best_lane);
+
+    // Lane wise minimum
+    int32_t best = -1;
+    for (int32_t l = 0; l < 8; l++) {
+      if (lane_idx[l] >= 0.0f and lane_t[l] < hit_distance) {
+        hit_distance = lane_t[l];
+        best = (int32_t)lane_idx[l];
+      }
+    }
+    return best;
+  }
+#endif
+
+  bool RaySphereSoA::IntersectSimd8(const Ray& ray,
+                                    uint32_t first,
+                                    uint32_t num_spheres,
+                                    float& hit_distance,
+                                    int32_t& object_idx) const {
+#if IK_RAY_SIMD_X86
+    static const bool avx2_supported = IsSupported(Kernel::Simd8);
+    if (avx2_supported) {
+      int32_t best = IntersectAvx2(*this, ray, first, num_spheres, hit_distance);
+      if (best < 0)
+        return false;
+      object_idx = (int32_t)sphere_index[first + best];
+      return true;
+    }
+#endif
+    return IntersectSimd4(ray, first, num_spheres, hit_distance, object_idx);
+  }
+
+  bool RaySphereSoA::IsSupported(Kernel kernel) {
+    switch (kernel) {
+      case Kernel::Scalar: return true;
+#if IK_RAY_SIMD_X86
+      case Kernel::Simd4: return true;
+      case Kernel::Simd8: return __builtin_cpu_supports("avx2");
+#elif IK_RAY_SIMD_NEON
+      case Kernel::Simd4: return true;
+      case Kernel::Simd8: return false;
+#else
+      case Kernel::Simd4: return false;
+      case Kernel::Simd8: return false;
+#endif
+      default: return false;
+    }
+  }
+
+  RaySphereSoA::Kernel RaySphereSoA::GetBestKernel() {
+    if (IsSupported(Kernel::Simd8)) return Kernel::Simd8;
+    if (IsSupported(Kernel::Simd4)) return Kernel::Simd4;
+    return Kernel::Scalar;
+  }
+
+  const char* RaySphereSoA::GetKernelName(Kernel kernel) {
+    switch (kernel) {
+      case Kernel::Scalar: return "Scalar";
+      case Kernel::Simd4: return "SIMD 4 (SSE / NEON)";
+      case Kernel::Simd8: return "SIMD 8 (AVX2)";
+      default: return "Invalid";
+    }
+  }
+
+}
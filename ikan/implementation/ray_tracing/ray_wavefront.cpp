@@ -0,0 +1,314 @@
+//
+//  ray_wavefront.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "ray_wavefront.hpp"
+#include "ray_denoiser.hpp"
+
+namespace ikan {
+
+  /// State of path after shading
+  static constexpr uint8_t kPathAlive = 0;
+  static constexpr uint8_t kPathAbsorbed = 1;
+  static constexpr uint8_t kPathTerminated = 2; // Terminated by russian roulette
+
+  static constexpr float kInvPi = 0.318309886f;
+
+  // -------------------------------------------------------------------------
+  // Path Buffer
+  // -------------------------------------------------------------------------
+  void RayWavefront::PathBuffer::Resize(size_t size) {
+    for (int32_t c = 0; c < 3; c++) {
+      origin[c].resize(size);
+      direction[c].resize(size);
+      throughput[c].resize(size);
+      normal[c].resize(size);
+    }
+    bsdf_pdf.resize(size);
+    path_idx.resize(size);
+    pixel_idx.resize(size);
+    sample_idx.resize(size);
+    material_idx.resize(size);
+    front_face.resize(size);
+    state.resize(size);
+  }
+
+  void RayWavefront::PathBuffer::Copy(uint32_t dst_idx, const PathBuffer& src, uint32_t src_idx) {
+    for (int32_t c = 0; c < 3; c++) {
+      origin[c][dst_idx] = src.origin[c][src_idx];
+      direction[c][dst_idx] = src.direction[c][src_idx];
+      throughput[c][dst_idx] = src.throughput[c][src_idx];
+      normal[c][dst_idx] = src.normal[c][src_idx];
+    }
+    bsdf_pdf[dst_idx] = src.bsdf_pdf[src_idx];
+    path_idx[dst_idx] = src.path_idx[src_idx];
+    pixel_idx[dst_idx] = src.pixel_idx[src_idx];
+    sample_idx[dst_idx] = src.sample_idx[src_idx];
+    material_idx[dst_idx] = src.material_idx[src_idx];
+    front_face[dst_idx] = src.front_face[src_idx];
+    state[dst_idx] = src.state[src_idx];
+  }
+
+  // -------------------------------------------------------------------------
+  // Wavefront
+  // -------------------------------------------------------------------------
+  void RayWavefront::Clear() {
+    color_.clear();
+    albedo_.clear();
+    normal_.clear();
+    depth_.clear();
+    object_id_.clear();
+    active_buffer_ = 0;
+    num_active_paths_ = 0;
+  }
+
+  void RayWavefront::AddPath(const glm::vec3& origin, const glm::vec3& direction, uint32_t pixel_idx, uint32_t sample_idx) {
+    PathBuffer& paths = buffers_[active_buffer_];
+    if (paths.path_idx.size() <= num_active_paths_)
+      paths.Resize(std::max<size_t>(paths.path_idx.size() * 2, 1024));
+
+    uint32_t path_idx = (uint32_t)color_.size();
+    color_.emplace_back(0.0f);
+    albedo_.emplace_back(1.0f);
+    normal_.emplace_back(0.0f);
+    depth_.push_back(RayDenoiser::kSkyDepth);
+    object_id_.push_back(-1);
+
+    uint32_t i = num_active_paths_++;
+    for (int32_t c = 0; c < 3; c++) {
+      paths.origin[c][i] = origin[c];
+      paths.direction[c][i] = direction[c];
+      paths.throughput[c][i] = 1.0f;
+    }
+    paths.bsdf_pdf[i] = 0.0f;
+    paths.path_idx[i] = path_idx;
+    paths.pixel_idx[i] = pixel_idx;
+    paths.sample_idx[i] = sample_idx;
+  }
+
+  void RayWavefront::Trace(const RayScene& scene, const PathSetting& setting, RayScene::ObjectSet* hit_objects) {
+    num_rays_ = 0;
+    num_roulette_terminations_ = 0;
+
+    using Type = RayMaterial::Type;
+    for (uint32_t bounce = 0; bounce < setting.max_depth and num_active_paths_ > 0; bounce++) {
+      uint32_t bin_offsets[kNumBins + 1];
+      IntersectAndBin(scene, setting, bounce, hit_objects, bin_offsets);
+
+      // Each material type is shaded in its own loop
+      PathBuffer& paths = buffers_[active_buffer_ ^ 1];
+      auto bin = [&bin_offsets](Type type) { return bin_offsets[static_cast<uint32_t>(type)]; };
+      auto bin_end = [&bin_offsets](Type type) { return bin_offsets[static_cast<uint32_t>(type) + 1]; };
+      Shade<Type::None>(paths, bin(Type::None), bin_end(Type::None), scene, setting, bounce);
+      Shade<Type::Metal>(paths, bin(Type::Metal), bin_end(Type::Metal), scene, setting, bounce);
+      Shade<Type::Lambertian>(paths, bin(Type::Lambertian), bin_end(Type::Lambertian), scene, setting, bounce);
+      Shade<Type::Dielectric>(paths, bin(Type::Dielectric), bin_end(Type::Dielectric), scene, setting, bounce);
+
+      Compact(bin_offsets[kNumBins]);
+    }
+  }
+
+  void RayWavefront::IntersectAndBin(const RayScene& scene,
+                                     const PathSetting& setting,
+                                     uint32_t bounce,
+                                     RayScene::ObjectSet* hit_objects,
+                                     uint32_t* bin_offsets) {
+    PathBuffer& src = buffers_[active_buffer_];
+    PathBuffer& dst = buffers_[active_buffer_ ^ 1];
+    if (dst.path_idx.size() < src.path_idx.size())
+      dst.Resize(src.path_idx.size());
+    if (bins_.size() < num_active_paths_)
+      bins_.resize(src.path_idx.size());
+
+    const bool next_event_estimation = setting.next_event_estimation and scene.GetNumLights() > 0;
+    uint32_t bin_counts[kNumBins] = { 0 };
+    for (uint32_t i = 0; i < num_active_paths_; i++) {
+      Ray ray(glm::vec3(src.origin[0][i], src.origin[1][i], src.origin[2][i]),
+              glm::vec3(src.direction[0][i], src.direction[1][i], src.direction[2][i]));
+      RayScene::Hit hit;
+      num_rays_++;
+
+      const uint32_t path_idx = src.path_idx[i];
+      if (!scene.Intersect(ray, setting.sphere_kernel, hit)) {
+        color_[path_idx] += setting.sky_color * glm::vec3(src.throughput[0][i], src.throughput[1][i], src.throughput[2][i]);
+        bins_[i] = kNumBins;
+        continue;
+      }
+
+      glm::vec3 position = ray.At(hit.distance);
+      glm::vec3 normal;
+      int32_t material_idx = 0;
+      scene.GetSurface(ray, hit, normal, material_idx);
+      const RayMaterial& material = scene.materials[material_idx];
+      bool front_face = glm::dot(ray.direction, normal) >= 0;
+      normal = front_face ? -normal : normal;
+
+      for (int32_t c = 0; c < 3; c++) {
+        src.origin[c][i] = position[c];
+        src.normal[c][i] = normal[c];
+      }
+      src.front_face[i] = front_face;
+      src.material_idx[i] = material_idx;
+
+      if (bounce == 0) {
+        albedo_[path_idx] = material.albedo;
+        normal_[path_idx] = normal;
+        depth_[path_idx] = hit.distance;
+        object_id_[path_idx] = (int32_t)scene.GetObjectId(hit);
+      }
+      else if (hit_objects) {
+        hit_objects->Insert(scene.GetObjectId(hit));
+      }
+
+      // Emissive surface finishes the path. Light sampled by the last diffuse bounce is weighted by MIS
+      if (material.type == RayMaterial::Type::Emissive) {
+        float weight = 1.0f;
+        if (next_event_estimation and src.bsdf_pdf[i] > 0.0f)
+          weight = RayScene::GetMisWeight(src.bsdf_pdf[i], scene.GetLightPdf(scene.GetLightIndex(hit), ray.origin, position));
+        color_[path_idx] += material.GetEmission() * weight *
+                            glm::vec3(src.throughput[0][i], src.throughput[1][i], src.throughput[2][i]);
+        bins_[i] = kNumBins;
+        continue;
+      }
+
+      bins_[i] = static_cast<uint8_t>(material.type);
+      bin_counts[bins_[i]]++;
+    }
+
+    // Counting sort of paths by material type
+    uint32_t bin_cursors[kNumBins];
+    bin_offsets[0] = 0;
+    for (uint32_t b = 0; b < kNumBins; b++) {
+      bin_cursors[b] = bin_offsets[b];
+      bin_offsets[b + 1] = bin_offsets[b] + bin_counts[b];
+    }
+    for (uint32_t i = 0; i < num_active_paths_; i++) {
+      if (bins_[i] < kNumBins)
+        dst.Copy(bin_cursors[bins_[i]]++, src, i);
+    }
+  }
+
+  template<RayMaterial::Type kType>
+  void RayWavefront::Shade(PathBuffer& paths,
+                           uint32_t begin,
+                           uint32_t end,
+                           const RayScene& scene,
+                           const PathSetting& setting,
+                           uint32_t bounce) {
+    const bool russian_roulette = setting.russian_roulette and bounce + 1 >= setting.russian_roulette_depth;
+    const bool next_event_estimation = setting.next_event_estimation and scene.GetNumLights() > 0;
+    for (uint32_t i = begin; i < end; i++) {
+      const RayMaterial& material = scene.materials[paths.material_idx[i]];
+      const uint32_t pixel_idx = paths.pixel_idx[i];
+      RaySampler sampler(setting.sampler, pixel_idx % setting.width, pixel_idx / setting.width, paths.sample_idx[i], bounce,
+                         setting.seed);
+
+      glm::vec3 direction(paths.direction[0][i], paths.direction[1][i], paths.direction[2][i]);
+      glm::vec3 normal(paths.normal[0][i], paths.normal[1][i], paths.normal[2][i]);
+      glm::vec3 attenuation = material.albedo;
+      bool scattered = true;
+      float bsdf_pdf = 0.0f;
+
+      // Random directions are sampled without rejection loop, and both sides of a choice are computed and one is
+      // selected, so that the loop has no data dependent branch
+      if constexpr (kType == RayMaterial::Type::None) {
+        direction = -direction;
+      }
+      else if constexpr (kType == RayMaterial::Type::Metal) {
+        glm::vec3 fuzz = RaySampler::SampleBall(sampler.Next2D(), sampler.Next1D());
+        direction = glm::reflect(glm::normalize(direction), normal) + material.fuzz * fuzz;
+        scattered = glm::dot(direction, normal) > 0.0f;
+      }
+      else if constexpr (kType == RayMaterial::Type::Lambertian) {
+        // Same light sampling as megakernel, shadow ray is traced right away
+        if (next_event_estimation) {
+          glm::vec3 position(paths.origin[0][i], paths.origin[1][i], paths.origin[2][i]);
+          RayScene::LightSample light;
+          if (scene.SampleLight(position, sampler, light)) {
+            float cos_theta = glm::dot(normal, light.direction);
+            if (cos_theta > 0.0f) {
+              num_rays_++;
+              if (!scene.IsOccluded(Ray(position, light.direction), light.distance, setting.sphere_kernel)) {
+                float weight = RayScene::GetMisWeight(light.pdf, cos_theta * kInvPi);
+                glm::vec3 throughput(paths.throughput[0][i], paths.throughput[1][i], paths.throughput[2][i]);
+                color_[paths.path_idx[i]] += throughput * material.albedo * (kInvPi * cos_theta * weight / light.pdf) *
+                                             light.radiance;
+              }
+            }
+          }
+        }
+
+        glm::vec3 scatter_direction = normal + RaySampler::SampleSphere(sampler.Next2D());
+        direction = glm::dot(scatter_direction, scatter_direction) < 1e-16f ? normal : scatter_direction;
+        bsdf_pdf = std::max(glm::dot(normal, glm::normalize(direction)), 0.0f) * kInvPi;
+      }
+      else if constexpr (kType == RayMaterial::Type::Dielectric) {
+        attenuation = glm::vec3(1.0f);
+        float refraction_ratio = paths.front_face[i] ? material.refractive_index : (1.0f / material.refractive_index);
+
+        glm::vec3 unit_direction = glm::normalize(direction);
+        float cos_theta = std::min(glm::dot(-unit_direction, normal), 1.0f);
+        float sin_theta = std::sqrt(std::max(1.0f - cos_theta * cos_theta, 0.0f));
+
+        // Schlick's approximation for reflectance
+        float r0 = (1.0f - material.refractive_index) / (1.0f + material.refractive_index);
+        r0 = r0 * r0;
+        float reflectance = r0 + (1.0f - r0) * std::pow(1.0f - cos_theta, 5.0f);
+
+        bool cannot_refract = refraction_ratio * sin_theta > 1.0f;
+        bool reflect = cannot_refract | (reflectance > sampler.Next1D());
+        glm::vec3 reflected = glm::reflect(unit_direction, normal);
+        glm::vec3 refracted = Math::Refract(unit_direction, normal, refraction_ratio);
+        direction = reflect ? reflected : refracted;
+      }
+
+      glm::vec3 throughput = glm::vec3(paths.throughput[0][i], paths.throughput[1][i], paths.throughput[2][i]) * attenuation;
+      uint8_t state = scattered ? kPathAlive : kPathAbsorbed;
+
+      // Same russian roulette as megakernel : survivors are divided by the probability of surviving
+      if (russian_roulette) {
+        float survive_probability = std::min(std::max(throughput.r, std::max(throughput.g, throughput.b)), 0.95f);
+        bool survived = sampler.Next1D() < survive_probability;
+        throughput /= survive_probability;
+        state = (survived or !scattered) ? state : kPathTerminated;
+      }
+
+      for (int32_t c = 0; c < 3; c++) {
+        paths.direction[c][i] = direction[c];
+        paths.throughput[c][i] = throughput[c];
+      }
+      paths.bsdf_pdf[i] = bsdf_pdf;
+      paths.state[i] = state;
+    }
+  }
+
+  void RayWavefront::Compact(uint32_t num_paths) {
+    PathBuffer& paths = buffers_[active_buffer_ ^ 1];
+    uint32_t num_alive = 0;
+    for (uint32_t i = 0; i < num_paths; i++) {
+      if (paths.state[i] == kPathTerminated)
+        num_roulette_terminations_++;
+      if (paths.state[i] != kPathAlive)
+        continue;
+      if (num_alive != i)
+        paths.Copy(num_alive, paths, i);
+      num_alive++;
+    }
+
+    active_buffer_ ^= 1;
+    num_active_paths_ = num_alive;
+  }
+
+  uint32_t RayWavefront::GetNumPaths() const { return (uint32_t)color_.size(); }
+  const glm::vec3& RayWavefront::GetColor(uint32_t path_idx) const { return color_[path_idx]; }
+  const glm::vec3& RayWavefront::GetAlbedo(uint32_t path_idx) const { return albedo_[path_idx]; }
+  const glm::vec3& RayWavefront::GetNormal(uint32_t path_idx) const { return normal_[path_idx]; }
+  float RayWavefront::GetDepth(uint32_t path_idx) const { return depth_[path_idx]; }
+  int32_t RayWavefront::GetObjectId(uint32_t path_idx) const { return object_id_[path_idx]; }
+  uint64_t RayWavefront::GetNumRays() const { return num_rays_; }
+  uint64_t RayWavefront::GetNumRouletteTerminations() const { return num_roulette_terminations_; }
+
+}
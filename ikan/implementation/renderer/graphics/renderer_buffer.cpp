@@ -33,6 +33,30 @@ namespace ikan {
     }
   }
   // --------------------------------------------------------------------------
+  // Stream Vertex Buffer
+  // --------------------------------------------------------------------------
+  std::shared_ptr<StreamVertexBuffer> StreamVertexBuffer::Create(uint32_t batch_size,
+                                                                 uint32_t batches_per_frame,
+                                                                 uint32_t num_regions) {
+    switch (Renderer::GetApi()) {
+      case Renderer::Api::OpenGl:
+        return std::make_shared<OpenGLStreamVertexBuffer>(batch_size, batches_per_frame, num_regions);
+      case Renderer::Api::None:
+      default:
+        IK_CORE_ASSERT(false, "Invalid Renderer API (None)"); break;
+    }
+  }
+  
+  void StreamVertexBuffer::EndFrame() {
+    switch (Renderer::GetApi()) {
+      case Renderer::Api::OpenGl:
+        OpenGLStreamVertexBuffer::EndFrameOfBuffers(); break;
+      case Renderer::Api::None:
+      default:
+        IK_CORE_ASSERT(false, "Invalid Renderer API (None)"); break;
+    }
+  }
+  // --------------------------------------------------------------------------
   // Index Buffer
   // --------------------------------------------------------------------------
   std::shared_ptr<IndexBuffer> IndexBuffer::CreateWithCount(void* data, uint32_t count) {
@@ -131,6 +155,11 @@ namespace ikan {
     CalculateOffsetAndStride();
   }
   
+  BufferLayout::BufferLayout(const std::initializer_list<BufferElement>& elements, bool per_instance)
+  : elements_(elements), per_instance_(per_instance) {
+    CalculateOffsetAndStride();
+  }
+  
   void BufferLayout::CalculateOffsetAndStride() {
     size_t offset = 0;
     stride_ = 0;
@@ -143,18 +172,20 @@ namespace ikan {
   
   const std::vector<BufferElement> BufferLayout::GetElements() const { return elements_; }
   uint32_t BufferLayout::GetStride() const { return stride_; }
+  bool BufferLayout::IsPerInstance() const { return per_instance_; }
   std::vector<BufferElement>::iterator BufferLayout::begin() { return elements_.begin(); }
   std::vector<BufferElement>::iterator BufferLayout::end() { return elements_.end(); }
   std::vector<BufferElement>::const_iterator BufferLayout::begin() const { return elements_.begin(); }
   std::vector<BufferElement>::const_iterator BufferLayout::end() const { return elements_.end(); }
   
   BufferLayout::BufferLayout(const BufferLayout& other)
-  : stride_(other.stride_) {
+  : stride_(other.stride_), per_instance_(other.per_instance_) {
     for (const auto& elem : other.elements_)
       elements_.emplace_back(elem);
   }
   BufferLayout& BufferLayout::operator=(const BufferLayout& other) {
     stride_ = other.stride_;
+    per_instance_ = other.per_instance_;
     for (const auto& elem : other.elements_)
       elements_.emplace_back(elem);
     return *this;
@@ -37,6 +37,23 @@ namespace ikan {
     }
   }
   
+  // --------------------------------------------------------------------------
+  // Texture Array
+  // --------------------------------------------------------------------------
+  std::shared_ptr<TextureArray> TextureArray::Create(uint32_t width,
+                                                     uint32_t height,
+                                                     TextureFormat format,
+                                                     bool linear,
+                                                     uint32_t num_layers) {
+    switch (Renderer::GetApi()) {
+      case Renderer::Api::OpenGl:
+        return std::make_shared<OpenGLTextureArray>(width, height, format, linear, num_layers);
+      case Renderer::Api::None:
+      default:
+        IK_CORE_ASSERT(false, "Invalid Renderer API (None)"); break;
+    }
+  }
+  
   // --------------------------------------------------------------------------
   // Character texture
   // --------------------------------------------------------------------------
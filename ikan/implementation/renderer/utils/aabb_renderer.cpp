@@ -20,20 +20,23 @@ namespace ikan {
     };
     
     static constexpr uint32_t max_box_per_batch = 1000;
+    /// Batches of boxes in region of a frame in stream buffer, as batch of boxes is big
+    static constexpr uint32_t kBatchesPerFrame = 2;
     
     std::shared_ptr<Pipeline> pipeline;
-    std::shared_ptr<VertexBuffer> vertex_buffer;
+    std::shared_ptr<StreamVertexBuffer> vertex_buffer;
     std::shared_ptr<Shader> shader;
     
-    // Pointers attribute of vertex
+    // Pointers attribute of vertex, in mapped region of stream buffer
     Vertex* vertex_buffer_base = nullptr;
     Vertex* vertex_buffer_ptr = nullptr;
     
     uint32_t num_cubes = 0;
     
-    /// start new batch for quad rendering
+    /// start new batch for quad rendering. Batch is mapped in stream buffer at its first box
     void StartBatch() {
-      vertex_buffer_ptr = vertex_buffer_base;
+      vertex_buffer_base = nullptr;
+      vertex_buffer_ptr = nullptr;
       num_cubes = 0;
     }
   };
@@ -46,15 +49,15 @@ namespace ikan {
     // Create Vertex Array
     s_data->pipeline = Pipeline::Create();
     
-    // Create vertes Buffer
-    s_data->vertex_buffer = VertexBuffer::Create(36 * s_data->max_box_per_batch * sizeof(AABBRendererData::Vertex));
+    // Create vertes Buffer. Vertices are written directly in its mapped regions
+    s_data->vertex_buffer = StreamVertexBuffer::Create(36 * s_data->max_box_per_batch *
+                                                       sizeof(AABBRendererData::Vertex),
+                                                       AABBRendererData::kBatchesPerFrame);
     s_data->vertex_buffer->AddLayout({
       { "a_Position", ShaderDataType::Float3 },
     });
     s_data->pipeline->AddVertexBuffer(s_data->vertex_buffer);
     
-    s_data->vertex_buffer_base = new AABBRendererData::Vertex[36 * s_data->max_box_per_batch];
-    
     // Setup the 3d Box Shader
     s_data->shader = Renderer::GetShader(AM::CoreAsset("shaders/aabb_shader.glsl"));
     
@@ -91,8 +94,13 @@ namespace ikan {
   }
   
   void AABBRenderer::EndRenderer() {
+    if (s_data->num_cubes == 0) {
+      Renderer::EndWireframe();
+      return;
+    }
+    
     uint32_t data_size = (uint32_t)((uint8_t*)s_data->vertex_buffer_ptr - (uint8_t*)s_data->vertex_buffer_base);
-    s_data->vertex_buffer->SetData(s_data->vertex_buffer_base, data_size);
+    s_data->vertex_buffer->Unmap(data_size);
     
     Renderer::DrawCube(s_data->pipeline, s_data->num_cubes);
     Renderer::EndWireframe();
@@ -107,6 +115,11 @@ namespace ikan {
       Renderer::BeginWireframe();
     }
     
+    if (!s_data->vertex_buffer_base) {
+      s_data->vertex_buffer_base = (AABBRendererData::Vertex*)s_data->vertex_buffer->Map();
+      s_data->vertex_buffer_ptr = s_data->vertex_buffer_base;
+    }
+    
     s_data->vertex_buffer_ptr[0].Position  = glm::vec4(aabb.min.x, aabb.min.y, aabb.min.z, 1.0f );
     s_data->vertex_buffer_ptr[1].Position  = glm::vec4(aabb.max.x, aabb.max.y, aabb.min.z, 1.0f );
     s_data->vertex_buffer_ptr[2].Position  = glm::vec4(aabb.max.x, aabb.min.y, aabb.min.z, 1.0f );
@@ -7,6 +7,8 @@
 
 #include "batch_2d_renderer.hpp"
 #include "renderer/utils/renderer_stats.hpp"
+#include "renderer/utils/texture_array_pool.hpp"
+#include "renderer/utils/sprite_atlas.hpp"
 #include "renderer/graphics/pipeline.hpp"
 #include "renderer/graphics/renderer_buffer.hpp"
 #include "renderer/graphics/shader.hpp"
@@ -18,20 +20,45 @@ namespace ikan {
     { 0.0f, 0.0f }, { 1.0f, 0.0f }, { 1.0f, 1.0f }, { 0.0f, 1.0f }
   };
   
-  struct BaseVertex {
-    glm::vec3 position;
+  /// Common data of single quad or circle instance. Shape is drawn by transforming the vertices of unit quad in
+  /// vertex shader, so only first three rows of transform are stored (last row of affine transform is 0, 0, 0, 1)
+  struct BaseInstance {
+    glm::vec4 transform_rows[3];
     glm::vec4 color;
-    glm::vec2 texture_coords;
     
     float texture_index;
     float tiling_factor;
+    float texture_layer;
+    
+    /// This function stores the first three rows of transform matrix
+    /// - Parameter rows: first three rows of transform matrix of shape
+    void SetTransform(const glm::vec4* rows) {
+      std::copy(rows, rows + 3, transform_rows);
+    }
   };
   
+  /// This function returns the first three rows of transform matrix, as stored in instance
+  /// - Parameters:
+  ///   - transform: transform matrix of shape
+  ///   - transform_rows: first three rows of transform
+  static void GetTransformRows(const glm::mat4& transform, glm::vec4* transform_rows) {
+    for (int32_t row = 0; row < 3; row++)
+      transform_rows[row] = { transform[0][row], transform[1][row], transform[2][row], transform[3][row] };
+  }
+  
+  /// Pool of texture arrays shared by quads and circles. Textures are sampled from their layer in array, so that
+  /// all the textures of same size and format take one texture slot of batch
+  static TextureArrayPool* texture_array_pool_;
+  /// Atlas of small textures, stored in pages of pool. Untiled quads of all the packed textures are then sampled
+  /// from few pages. Disabled by default, as its pages take memory even for few textures
+  static SpriteAtlas* sprite_atlas_;
+  static bool use_sprite_atlas_ = false;
+  
   /// This structure holds the common batch renderer data for Quads, circle and lines
   struct CommonData {
     /// Renderer Data storage
     std::shared_ptr<Pipeline> pipeline;
-    std::shared_ptr<VertexBuffer> vertex_buffer;
+    std::shared_ptr<StreamVertexBuffer> vertex_buffer;
     std::shared_ptr<Shader> shader;
     
     /// Max element to be rendered in single batch
@@ -56,30 +83,90 @@ namespace ikan {
       glm::mat4 camera_view_projection_matrix;
     };
     
-    /// Store the Vertex and Indices size
+    /// Store the Indices size of unit quad
     uint32_t max_indices = 0;
     
     /// Store the Environment data
     Environment environment;
     
-    /// Count of Indices to be renderer in Single Batch
-    uint32_t index_count = 0;
+    /// Vertex buffer of unit quad, shared by all the instances
+    std::shared_ptr<VertexBuffer> unit_vertex_buffer;
+    
+    /// Count of Instances to be renderer in Single Batch
+    uint32_t instance_count = 0;
     
-    /// Stores all the 16 Texture in array so that there is no need to load texture each frame
-    /// NOTE: Load only if new texture is added or older replaced with new
-    std::array<std::shared_ptr<Texture>, kMaxTextureSlotsInShader> texture_slots;
+    /// Stores all the 16 Texture arrays of batch, bound in slots of shader
+    std::array<std::shared_ptr<TextureArray>, kMaxTextureSlotsInShader> texture_slots;
     
-    /// Texture Slot index sent to Shader to render a specific Texture from slots
-    /// Slot 0 is reserved for white texture (No Image only color)
+    /// Texture Slot index sent to Shader to render a specific Texture array from slots
+    /// Slot 0 is reserved for array of white texture (No Image only color)
     uint32_t texture_slot_index = 1; // 0 = white texture
     
+    /// Slot of texture array in a batch
+    struct ArraySlot {
+      uint32_t batch_index = 0;
+      uint32_t slot = 0;
+    };
+    /// Slots of arrays, indexed by array index of pool. Slot is valid only for batch of its index, so that slots
+    /// are not cleared at the start of each batch
+    std::vector<ArraySlot> array_slots;
+    uint32_t batch_index = 0;
+    
     /// Basic vertex of quad
     /// Vertex of circle is taken as Quad only
     glm::vec4 vertex_base_position[4];
     
     void StartCommonBatch() {
-      index_count = 0;
-      texture_slot_index = 1;
+      instance_count = 0;
+      batch_index++;
+      
+      // Array of white texture is first array of pool
+      texture_slot_index = 0;
+      AddArraySlot(0);
+    }
+    
+    /// This function returns the slot of texture array in current batch, or -1 if array is not bound
+    /// - Parameter array_index: index of array in pool
+    int32_t GetArraySlot(uint32_t array_index) const {
+      if (array_index < array_slots.size() and array_slots[array_index].batch_index == batch_index)
+        return (int32_t)array_slots[array_index].slot;
+      return -1;
+    }
+    
+    /// This function binds the texture array in next free slot of current batch and returns the slot
+    /// - Parameter array_index: index of array in pool
+    uint32_t AddArraySlot(uint32_t array_index) {
+      if (array_index >= array_slots.size())
+        array_slots.resize(array_index + 1);
+      
+      uint32_t slot = texture_slot_index++;
+      texture_slots[slot] = texture_array_pool_->GetArray(array_index);
+      array_slots[array_index] = { batch_index, slot };
+      return slot;
+    }
+    
+    /// This function creates the vertex buffer and index buffer of unit quad, and adds them in pipeline before
+    /// the instance buffer
+    void InitUnitQuad() {
+      // Setting basic Vertex point of quad
+      vertex_base_position[0] = { -0.5f, -0.5f, 0.0f, 1.0f };
+      vertex_base_position[1] = {  0.5f, -0.5f, 0.0f, 1.0f };
+      vertex_base_position[2] = {  0.5f,  0.5f, 0.0f, 1.0f };
+      vertex_base_position[3] = { -0.5f,  0.5f, 0.0f, 1.0f };
+      
+      glm::vec3 unit_vertices[VertexForSingleElement];
+      for (size_t i = 0; i < VertexForSingleElement; i++)
+        unit_vertices[i] = glm::vec3(vertex_base_position[i]);
+      
+      unit_vertex_buffer = VertexBuffer::Create(unit_vertices, sizeof(unit_vertices));
+      unit_vertex_buffer->AddLayout({
+        { "a_Position",     ShaderDataType::Float3 },
+      });
+      pipeline->AddVertexBuffer(unit_vertex_buffer);
+      
+      uint32_t unit_indices[IndicesForSingleElement] = { 0, 1, 2, 2, 3, 0 };
+      max_indices = IndicesForSingleElement;
+      pipeline->SetIndexBuffer(IndexBuffer::CreateWithCount(unit_indices, max_indices));
     }
     
     /// Virtual Destructor
@@ -96,15 +183,17 @@ namespace ikan {
   
   /// Batch Data to Rendering Quads
   struct QuadData : BatchRendererData {
-    /// Single vertex of a Quad
-    struct Vertex : BaseVertex {
+    /// Single instance of a Quad
+    struct Instance : BaseInstance {
+      glm::vec4 texture_rect;   // Min (xy) and max (zw) texture coordinates
       int32_t object_id;        // Pixel ID of Quad
     };
     
-    /// Base pointer of Vertex Data. This is start of Batch data for single draw call
-    Vertex* vertex_buffer_base_ptr = nullptr;
-    /// Incrememntal Vetrtex Data Pointer to store all the batch data in Buffer
-    Vertex* vertex_buffer_ptr = nullptr;
+    /// Base pointer of Instance Data, in mapped region of stream buffer. This is start of Batch data for single
+    /// draw call
+    Instance* vertex_buffer_base_ptr = nullptr;
+    /// Incrememntal Instance Data Pointer to store all the batch data in Buffer
+    Instance* vertex_buffer_ptr = nullptr;
     
     /// Constructor
     QuadData() {
@@ -113,15 +202,22 @@ namespace ikan {
     /// Destructor
     virtual ~QuadData() {
       IK_CORE_WARN(LogModule::Batch2DRenderer, "Destroying QuadData instance and clearing the data !!!");
-      delete [] vertex_buffer_base_ptr;
       vertex_buffer_base_ptr = nullptr;
-      
-      RendererStatistics::Get().vertex_buffer_size -= max_vertices * sizeof(QuadData::Vertex);
     }
     
-    /// start new batch for quad rendering
+    /// start new batch for quad rendering. Batch is mapped in stream buffer at its first quad, so that batches
+    /// without quads take no space of buffer
     void StartBatch() {
       StartCommonBatch();
+      vertex_buffer_base_ptr = nullptr;
+      vertex_buffer_ptr = nullptr;
+    }
+    
+    /// This function maps the batch in stream buffer, if not mapped yet
+    void MapBatch() {
+      if (vertex_buffer_base_ptr)
+        return;
+      vertex_buffer_base_ptr = (Instance*)vertex_buffer->Map();
       vertex_buffer_ptr = vertex_buffer_base_ptr;
     }
   };
@@ -129,19 +225,19 @@ namespace ikan {
   
   /// Batch Data to Rendering Circles
   struct CircleData : BatchRendererData {
-    /// Single vertex of a Circle
-    struct Vertex : BaseVertex {
-      glm::vec3 local_position;
+    /// Single instance of a Circle
+    struct Instance : BaseInstance {
       float thickness;    // Thickness of Circle
       float fade;         // Fadeness of Edge of Circle
       
       int32_t object_id; // Pixel ID of Quad
     };
     
-    /// Base pointer of Vertex Data. This is start of Batch data for single draw call
-    Vertex* vertex_buffer_base_ptr = nullptr;
-    /// Incrememntal Vetrtex Data Pointer to store all the batch data in Buffer
-    Vertex* vertex_buffer_ptr = nullptr;
+    /// Base pointer of Instance Data, in mapped region of stream buffer. This is start of Batch data for single
+    /// draw call
+    Instance* vertex_buffer_base_ptr = nullptr;
+    /// Incrememntal Instance Data Pointer to store all the batch data in Buffer
+    Instance* vertex_buffer_ptr = nullptr;
     
     /// Constructor
     CircleData() {
@@ -150,15 +246,22 @@ namespace ikan {
     /// Destructir
     virtual ~CircleData() {
       IK_CORE_WARN(LogModule::Batch2DRenderer, "Destroying Circle Data instance and clearing the data !!!");
-      delete [] vertex_buffer_base_ptr;
       vertex_buffer_base_ptr = nullptr;
-      
-      RendererStatistics::Get().vertex_buffer_size -= CircleData::max_vertices * sizeof(CircleData::Vertex);
     }
     
-    /// start new batch for quad rendering
+    /// start new batch for circle rendering. Batch is mapped in stream buffer at its first circle, so that batches
+    /// without circles take no space of buffer
     void StartBatch() {
       StartCommonBatch();
+      vertex_buffer_base_ptr = nullptr;
+      vertex_buffer_ptr = nullptr;
+    }
+    
+    /// This function maps the batch in stream buffer, if not mapped yet
+    void MapBatch() {
+      if (vertex_buffer_base_ptr)
+        return;
+      vertex_buffer_base_ptr = (Instance*)vertex_buffer->Map();
       vertex_buffer_ptr = vertex_buffer_base_ptr;
     }
   };
@@ -176,7 +279,8 @@ namespace ikan {
     /// Count of Indices to be renderer in Single Batch
     uint32_t vertex_count = 0;
     
-    /// Base pointer of Vertex Data. This is start of Batch data for single draw call
+    /// Base pointer of Vertex Data, in mapped region of stream buffer. This is start of Batch data for single
+    /// draw call
     Vertex* vertex_buffer_base_ptr = nullptr;
     /// Incrememntal Vetrtex Data Pointer to store all the batch data in Buffer
     Vertex* vertex_buffer_ptr = nullptr;
@@ -188,20 +292,196 @@ namespace ikan {
     /// Destructir
     virtual ~LineData() {
       IK_CORE_WARN(LogModule::Batch2DRenderer, "Destroying Line Data instance and clearing the data !!!");
-      delete [] vertex_buffer_base_ptr;
       vertex_buffer_base_ptr = nullptr;
-      
-      RendererStatistics::Get().vertex_buffer_size -= LineData::max_vertices * sizeof(LineData::Vertex);
     }
     
-    /// start new batch for quad rendering
+    /// start new batch for line rendering. Batch is mapped in stream buffer at its first line, so that batches
+    /// without lines take no space of buffer
     void StartBatch() {
       vertex_count = 0;
+      vertex_buffer_base_ptr = nullptr;
+      vertex_buffer_ptr = nullptr;
+    }
+    
+    /// This function maps the batch in stream buffer, if not mapped yet
+    void MapBatch() {
+      if (vertex_buffer_base_ptr)
+        return;
+      vertex_buffer_base_ptr = (Vertex*)vertex_buffer->Map();
       vertex_buffer_ptr = vertex_buffer_base_ptr;
     }
   };
   static LineData* line_data_;
   
+  /// Data of deferred submission. Quads and circles are recorded as commands with a sort key, and their vertices
+  /// are generated at the end of batch in order of keys
+  struct DeferredData {
+    /// Draw call of single quad or circle. Transform is stored as rows of instance, and texture coordinates as the
+    /// rectangle from first to third corner, which is all that instance uses
+    struct Command {
+      glm::vec4 transform_rows[3];
+      glm::vec4 color;
+      glm::vec4 texture_rect;
+      float tiling_factor;
+      float thickness;
+      float fade;
+      int32_t object_id;
+      uint32_t texture_id;
+      bool circle;
+    };
+    
+    /// Sort key of command. Bits from most significant : layer (8), depth (24), shader (8) and texture array (24)
+    struct Key {
+      uint64_t key;
+      uint32_t command_idx;
+    };
+    
+    /// Texture array slots and instances of immediate submission, to count the flushes that sorted submission
+    /// avoids
+    struct SlotState {
+      std::array<uint32_t, kMaxTextureSlotsInShader> slots;
+      uint32_t slot_index = 1;
+      uint32_t instance_count = 0;
+    };
+    
+    bool enabled = false;
+    /// True while commands are replayed, so that draw calls write the vertices
+    bool replaying = false;
+    uint8_t layer = 0;
+    
+    std::vector<Command> commands;
+    std::vector<Key> keys, temp_keys;
+    
+    /// Textures of this batch, indexed by texture id of commands. Id 0 is no texture
+    std::vector<std::shared_ptr<Texture>> textures;
+    std::unordered_map<const Texture*, uint32_t> texture_ids;
+    
+    /// Slot state of quads and circles, and number of batches immediate submission would flush. Batches flushed
+    /// while commands are replayed are counted in 'replay_flushes'
+    SlotState quad_slots, circle_slots;
+    uint32_t immediate_flushes = 0, replay_flushes = 0;
+    
+    /// Start new batch of commands
+    void StartBatch() {
+      layer = 0;
+      commands.clear();
+      keys.clear();
+      textures.resize(1);
+      texture_ids.clear();
+      ResetSlots();
+      immediate_flushes = 0;
+      replay_flushes = 0;
+    }
+    
+    /// Clears the slots and instances of both the shapes, as batch of both is flushed together
+    void ResetSlots() {
+      quad_slots.slot_index = 1;
+      quad_slots.instance_count = 0;
+      circle_slots.slot_index = 1;
+      circle_slots.instance_count = 0;
+    }
+    
+    /// Returns the id of texture in this batch
+    uint32_t GetTextureId(const std::shared_ptr<Texture>& texture) {
+      if (!texture)
+        return 0;
+      auto [it, inserted] = texture_ids.try_emplace(texture.get(), (uint32_t)textures.size());
+      if (inserted)
+        textures.push_back(texture);
+      return it->second;
+    }
+    
+    /// Adds the instance and its texture array in slots of immediate submission. A full instance buffer or a full
+    /// slot array would have flushed both the batches. Array id is index of array in pool plus 1, id 0 (no texture)
+    /// and 1 (white texture) are in slot 0
+    void SimulateImmediateSlots(SlotState& state, uint32_t array_id, uint32_t max_instances) {
+      if (state.instance_count >= max_instances) {
+        immediate_flushes++;
+        ResetSlots();
+      }
+      
+      if (array_id > 1 and
+          std::find(state.slots.begin() + 1, state.slots.begin() + state.slot_index, array_id) ==
+          state.slots.begin() + state.slot_index) {
+        if (state.slot_index >= kMaxTextureSlotsInShader) {
+          immediate_flushes++;
+          ResetSlots();
+        }
+        state.slots[state.slot_index++] = array_id;
+      }
+      state.instance_count++;
+    }
+    
+    /// Returns the depth bits of key. Float is mapped to unsigned integer with same order, and its top 24 bits
+    /// are kept, so that far shapes (smaller z) are drawn first
+    static uint64_t GetDepthBits(float depth) {
+      uint32_t bits;
+      memcpy(&bits, &depth, sizeof(bits));
+      bits = (bits & 0x80000000u) ? ~bits : bits | 0x80000000u;
+      return bits >> 8;
+    }
+    
+    /// Sorts the keys with least significant digit radix sort of 8 bit digits. Passes where all the keys have
+    /// same digit are skipped. Sort is stable, so commands with equal keys stay in order of submission
+    void SortKeys() {
+      temp_keys.resize(keys.size());
+      for (uint32_t shift = 0; shift < 64; shift += 8) {
+        uint32_t count[256] = {};
+        for (const Key& key : keys)
+          count[(key.key >> shift) & 0xFF]++;
+        if (count[(keys[0].key >> shift) & 0xFF] == keys.size())
+          continue;
+        
+        uint32_t offset = 0;
+        for (uint32_t& digit_count : count) {
+          uint32_t digit_offset = offset;
+          offset += digit_count;
+          digit_count = digit_offset;
+        }
+        for (const Key& key : keys)
+          temp_keys[count[(key.key >> shift) & 0xFF]++] = key;
+        keys.swap(temp_keys);
+      }
+    }
+  };
+  static DeferredData deferred_data_;
+  
+  /// This function creates the pool of texture arrays shared by quads and circles, and the sprite atlas stored in
+  /// it, if not created already. White texture is the default texture of pool
+  static void CreateTextureArrayPool() {
+    if (texture_array_pool_)
+      return;
+    
+    // Creating white texture for colorful shapes witout any texture or sprite
+    uint32_t white_texture_data = 0xffffffff;
+    texture_array_pool_ = new TextureArrayPool(Texture::Create(1, 1, &white_texture_data, sizeof(uint32_t)));
+    sprite_atlas_ = new SpriteAtlas(*texture_array_pool_, SpriteAtlas::Setting());
+  }
+  
+  /// This function returns the location of texture in pool. If texture rectangle is given, texture is not tiled
+  /// and rectangle is inside the texture, then texture is sampled from its region in sprite atlas and rectangle
+  /// is changed to the coordinates of page
+  /// - Parameters:
+  ///   - texture: texture
+  ///   - tiling_factor: tiling factor of texture
+  ///   - texture_rect: min (xy) and max (zw) texture coordinates. Can be nullptr
+  static TextureArrayPool::Location GetTextureLocation(const std::shared_ptr<Texture>& texture,
+                                                       float tiling_factor,
+                                                       glm::vec4* texture_rect) {
+    // Coordinates outside the texture are wrapped, which is not possible in atlas page
+    if (sprite_atlas_ and use_sprite_atlas_ and texture_rect and tiling_factor == 1.0f and
+        std::min({ texture_rect->x, texture_rect->y, texture_rect->z, texture_rect->w }) >= 0.0f and
+        std::max({ texture_rect->x, texture_rect->y, texture_rect->z, texture_rect->w }) <= 1.0f) {
+      if (const SpriteAtlas::Region* region = sprite_atlas_->GetRegion(texture)) {
+        glm::vec2 min = region->uv_min + glm::vec2(texture_rect->x, texture_rect->y) * region->uv_size;
+        glm::vec2 max = region->uv_min + glm::vec2(texture_rect->z, texture_rect->w) * region->uv_size;
+        *texture_rect = glm::vec4(min.x, min.y, max.x, max.y);
+        return region->location;
+      }
+    }
+    return texture_array_pool_->GetLocation(texture);
+  }
+  
   // --------------------------------------------------------------------------
   // Batch Renderer API
   // --------------------------------------------------------------------------
@@ -220,8 +500,9 @@ namespace ikan {
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  ---------------------------------------------------------");
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Max Quads per Batch             | {0}", quad_data_->max_element);
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Max Texture Slots per Batch     | {0}", kMaxTextureSlotsInShader);
-      IK_CORE_WARN(LogModule::Batch2DRenderer, "  Vertex Buffer used              | {0} B ({1} KB) ",
-                   quad_data_->max_vertices * sizeof(QuadData::Vertex), quad_data_->max_vertices * sizeof(QuadData::Vertex) / 1000.0f );
+      IK_CORE_WARN(LogModule::Batch2DRenderer, "  Instance Buffer used            | {0} B ({1} KB) ",
+                   quad_data_->max_element * sizeof(QuadData::Instance),
+                   quad_data_->max_element * sizeof(QuadData::Instance) / 1000.0f );
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Index Buffer used               | {0} B ({1} KB) ",
                    quad_data_->max_indices * sizeof(uint32_t), quad_data_->max_indices * sizeof(uint32_t) / 1000.0f );
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Shader Used                     | {0}", quad_data_->shader->GetName());
@@ -235,9 +516,9 @@ namespace ikan {
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Max Circles per Batch           | {0}", circle_data_->max_element);
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Max Texture Slots Batch         | {0}", kMaxTextureSlotsInShader);
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Max Texture Slots per Batch     | {0}", kMaxTextureSlotsInShader);
-      IK_CORE_WARN(LogModule::Batch2DRenderer, "  Vertex Buffer used              | {0} B ({1} KB) ",
-                   circle_data_->max_vertices * sizeof(CircleData::Vertex),
-                   circle_data_->max_vertices * sizeof(CircleData::Vertex) / 1000.0f );
+      IK_CORE_WARN(LogModule::Batch2DRenderer, "  Instance Buffer used            | {0} B ({1} KB) ",
+                   circle_data_->max_element * sizeof(CircleData::Instance),
+                   circle_data_->max_element * sizeof(CircleData::Instance) / 1000.0f );
       IK_CORE_WARN(LogModule::Batch2DRenderer, "  Vertex Buffer used              | {0} B ({1} KB) ",
                    circle_data_->max_indices * sizeof(uint32_t),
                    circle_data_->max_indices * sizeof(uint32_t) / 1000.0f );
@@ -257,6 +538,11 @@ namespace ikan {
       delete line_data_;
     }
     
+    // Pages of atlas are layers of pool, so atlas is destroyed first
+    delete sprite_atlas_;
+    sprite_atlas_ = nullptr;
+    delete texture_array_pool_;
+    texture_array_pool_ = nullptr;
   }
   
   void BatchRenderer::InitQuadData(uint32_t max_quads) {
@@ -276,60 +562,34 @@ namespace ikan {
     quad_data_ = new QuadData();
 
     quad_data_->max_element = max_quads;
-    quad_data_->max_vertices = max_quads * BatchRendererData::VertexForSingleElement;
-    quad_data_->max_indices = max_quads * BatchRendererData::IndicesForSingleElement;
+    quad_data_->max_vertices = BatchRendererData::VertexForSingleElement;
     
     // Create Pipeline instance
     quad_data_->pipeline = Pipeline::Create();
     
-    // Allocating the memory for vertex Buffer Pointer
-    quad_data_->vertex_buffer_base_ptr = new QuadData::Vertex[quad_data_->max_vertices];
-    
-    // Create vertes Buffer
-    quad_data_->vertex_buffer = VertexBuffer::Create(quad_data_->max_vertices * sizeof(QuadData::Vertex));
-    quad_data_->vertex_buffer->AddLayout({
-      { "a_Position",     ShaderDataType::Float3 },
-      { "a_Color",        ShaderDataType::Float4 },
-      { "a_TexCoords",    ShaderDataType::Float2 },
-      { "a_TexIndex",     ShaderDataType::Float },
-      { "a_TilingFactor", ShaderDataType::Float },
-      { "a_ObjectID",     ShaderDataType::Int },
-    });
+    // Unit quad is the per vertex stream at location 0
+    quad_data_->InitUnitQuad();
+    
+    // Create instance Buffer. Instances are written directly in its mapped regions
+    quad_data_->vertex_buffer = StreamVertexBuffer::Create(quad_data_->max_element * sizeof(QuadData::Instance));
+    quad_data_->vertex_buffer->AddLayout(BufferLayout({
+      { "a_TransformRow0", ShaderDataType::Float4 },
+      { "a_TransformRow1", ShaderDataType::Float4 },
+      { "a_TransformRow2", ShaderDataType::Float4 },
+      { "a_Color",         ShaderDataType::Float4 },
+      { "a_TexIndex",      ShaderDataType::Float },
+      { "a_TilingFactor",  ShaderDataType::Float },
+      { "a_TexLayer",      ShaderDataType::Float },
+      { "a_TexRect",       ShaderDataType::Float4 },
+      { "a_ObjectID",      ShaderDataType::Int },
+    }, true /* per instance */));
     quad_data_->pipeline->AddVertexBuffer(quad_data_->vertex_buffer);
     
     // Setup the Quad Shader
     quad_data_->shader = Renderer::GetShader(AM::CoreAsset("shaders/batch_quad_shader.glsl"));
     
-    // Create Index Buffer
-    uint32_t* quad_indices = new uint32_t[quad_data_->max_indices];
-    
-    uint32_t offset = 0;
-    for (size_t i = 0; i < quad_data_->max_indices; i += BatchRendererData::IndicesForSingleElement) {
-      quad_indices[i + 0] = offset + 0;
-      quad_indices[i + 1] = offset + 1;
-      quad_indices[i + 2] = offset + 2;
-      
-      quad_indices[i + 3] = offset + 2;
-      quad_indices[i + 4] = offset + 3;
-      quad_indices[i + 5] = offset + 0;
-      
-      offset += 4;
-    }
-    
-    // Create Index Buffer in GPU for storing Indices
-    std::shared_ptr<IndexBuffer> ib = IndexBuffer::CreateWithCount(quad_indices, quad_data_->max_indices);
-    quad_data_->pipeline->SetIndexBuffer(ib);
-    delete[] quad_indices;
-    
-    // Creating white texture for colorful quads witout any texture or sprite
-    uint32_t whiteTextureData = 0xffffffff;
-    quad_data_->texture_slots[0] = Texture::Create(1, 1, &whiteTextureData, sizeof(uint32_t));
-    
-    // Setting basic Vertex point of quad
-    quad_data_->vertex_base_position[0] = { -0.5f, -0.5f, 0.0f, 1.0f };
-    quad_data_->vertex_base_position[1] = {  0.5f, -0.5f, 0.0f, 1.0f };
-    quad_data_->vertex_base_position[2] = {  0.5f,  0.5f, 0.0f, 1.0f };
-    quad_data_->vertex_base_position[3] = { -0.5f,  0.5f, 0.0f, 1.0f };
+    // Textures of quads are sampled from texture arrays
+    CreateTextureArrayPool();
     
     Renderer2DStats::Get().max_quads = quad_data_->max_element;
 
@@ -337,8 +597,9 @@ namespace ikan {
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  ---------------------------------------------------------");
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Max Quads per Batch             | {0}", quad_data_->max_element);
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Max Texture Slots per Batch     | {0}", kMaxTextureSlotsInShader);
-    IK_CORE_INFO(LogModule::Batch2DRenderer, "  Vertex Buffer used              | {0} B ({1} KB) ",
-                 quad_data_->max_vertices * sizeof(QuadData::Vertex), quad_data_->max_vertices * sizeof(QuadData::Vertex) / 1000.0f );
+    IK_CORE_INFO(LogModule::Batch2DRenderer, "  Instance Buffer used            | {0} B ({1} KB) ",
+                 quad_data_->max_element * sizeof(QuadData::Instance),
+                 quad_data_->max_element * sizeof(QuadData::Instance) / 1000.0f );
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Index Buffer used               | {0} B ({1} KB) ",
                  quad_data_->max_indices * sizeof(uint32_t), quad_data_->max_indices * sizeof(uint32_t) / 1000.0f );
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Shader Used                     | {0}", quad_data_->shader->GetName());
@@ -362,61 +623,33 @@ namespace ikan {
     circle_data_ = new CircleData();
         
     circle_data_->max_element = max_circles;
-    circle_data_->max_vertices = max_circles * BatchRendererData::VertexForSingleElement;
-    circle_data_->max_indices = max_circles * BatchRendererData::IndicesForSingleElement;
-    
-    // Allocating the memory for vertex Buffer Pointer
-    circle_data_->vertex_buffer_base_ptr = new CircleData::Vertex[circle_data_->max_vertices];
+    circle_data_->max_vertices = BatchRendererData::VertexForSingleElement;
     
     // Create Pipeline instance
     circle_data_->pipeline = Pipeline::Create();
     
-    // Create vertes Buffer
-    circle_data_->vertex_buffer = VertexBuffer::Create(circle_data_->max_vertices * sizeof(CircleData::Vertex));
-    circle_data_->vertex_buffer->AddLayout({
-      { "a_Position",     ShaderDataType::Float3 },
-      { "a_Color",        ShaderDataType::Float4 },
-      { "a_TexCoords",    ShaderDataType::Float2 },
-      { "a_TexIndex",     ShaderDataType::Float },
-      { "a_TilingFactor", ShaderDataType::Float },
-      { "a_LocalPosition",ShaderDataType::Float3 },
-      { "a_Thickness",    ShaderDataType::Float },
-      { "a_Fade",         ShaderDataType::Float },
-      { "a_ObjectID",     ShaderDataType::Int },
-    });
+    // Unit quad is the per vertex stream at location 0
+    circle_data_->InitUnitQuad();
+    
+    // Create instance Buffer. Instances are written directly in its mapped regions
+    circle_data_->vertex_buffer = StreamVertexBuffer::Create(circle_data_->max_element *
+                                                             sizeof(CircleData::Instance));
+    circle_data_->vertex_buffer->AddLayout(BufferLayout({
+      { "a_TransformRow0", ShaderDataType::Float4 },
+      { "a_TransformRow1", ShaderDataType::Float4 },
+      { "a_TransformRow2", ShaderDataType::Float4 },
+      { "a_Color",         ShaderDataType::Float4 },
+      { "a_TexIndex",      ShaderDataType::Float },
+      { "a_TilingFactor",  ShaderDataType::Float },
+      { "a_TexLayer",      ShaderDataType::Float },
+      { "a_Thickness",     ShaderDataType::Float },
+      { "a_Fade",          ShaderDataType::Float },
+      { "a_ObjectID",      ShaderDataType::Int },
+    }, true /* per instance */));
     circle_data_->pipeline->AddVertexBuffer(circle_data_->vertex_buffer);
     
-    // Create Index Buffer
-    uint32_t* quad_indices = new uint32_t[circle_data_->max_indices];
-    
-    uint32_t offset = 0;
-    for (size_t i = 0; i < circle_data_->max_indices; i += BatchRendererData::IndicesForSingleElement) {
-      quad_indices[i + 0] = offset + 0;
-      quad_indices[i + 1] = offset + 1;
-      quad_indices[i + 2] = offset + 2;
-      
-      quad_indices[i + 3] = offset + 2;
-      quad_indices[i + 4] = offset + 3;
-      quad_indices[i + 5] = offset + 0;
-      
-      offset += 4;
-    }
-    
-    // Create Index Buffer in GPU for storing Indices
-    std::shared_ptr<IndexBuffer> ib = IndexBuffer::CreateWithCount(quad_indices, circle_data_->max_indices);
-    circle_data_->pipeline->SetIndexBuffer(ib);
-    delete[] quad_indices;
-    
-    // Creating white texture for colorful quads witout any texture or sprite
-    uint32_t whiteTextureData = 0xffffffff;
-    circle_data_->texture_slots[0] = Texture::Create(1, 1, &whiteTextureData,
-                                                     sizeof(uint32_t));
-    
-    // Setting basic Vertex point of quad
-    circle_data_->vertex_base_position[0] = { -0.5f, -0.5f, 0.0f, 1.0f };
-    circle_data_->vertex_base_position[1] = {  0.5f, -0.5f, 0.0f, 1.0f };
-    circle_data_->vertex_base_position[2] = {  0.5f,  0.5f, 0.0f, 1.0f };
-    circle_data_->vertex_base_position[3] = { -0.5f,  0.5f, 0.0f, 1.0f };
+    // Textures of circles are sampled from texture arrays
+    CreateTextureArrayPool();
     
     // Setup the Circle Shader
     circle_data_->shader = Renderer::GetShader(AM::CoreAsset("shaders/batch_circle_shader.glsl"));
@@ -427,8 +660,9 @@ namespace ikan {
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  ---------------------------------------------------------");
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Max Circle per Batch            | {0}", max_circles);
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Max Texture Slots per Batch     | {0}", kMaxTextureSlotsInShader);
-    IK_CORE_INFO(LogModule::Batch2DRenderer, "  Vertex Buffer used              | {0} B ({1} KB) ",
-                 circle_data_->max_vertices * sizeof(CircleData::Vertex), circle_data_->max_vertices * sizeof(CircleData::Vertex) / 1000.0f );
+    IK_CORE_INFO(LogModule::Batch2DRenderer, "  Instance Buffer used            | {0} B ({1} KB) ",
+                 circle_data_->max_element * sizeof(CircleData::Instance),
+                 circle_data_->max_element * sizeof(CircleData::Instance) / 1000.0f );
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Vertex Buffer used              | {0} B ({1} KB) ",
                  circle_data_->max_indices * sizeof(uint32_t), circle_data_->max_indices * sizeof(uint32_t) / 1000.0f );
     IK_CORE_INFO(LogModule::Batch2DRenderer, "  Shader used                     | {0}", circle_data_->shader->GetName());
@@ -454,14 +688,11 @@ namespace ikan {
     line_data_->max_element = max_lines;
     line_data_->max_vertices = max_lines * line_data_->kVertexForSingleLine;
     
-    // Allocating the memory for vertex Buffer Pointer
-    line_data_->vertex_buffer_base_ptr = new LineData::Vertex[line_data_->max_vertices];
-    
     // Create Pipeline instance
     line_data_->pipeline = Pipeline::Create();
     
-    // Create vertes Buffer
-    line_data_->vertex_buffer = VertexBuffer::Create(line_data_->max_vertices * sizeof(LineData::Vertex));
+    // Create vertes Buffer. Vertices are written directly in its mapped regions
+    line_data_->vertex_buffer = StreamVertexBuffer::Create(line_data_->max_vertices * sizeof(LineData::Vertex));
     line_data_->vertex_buffer->AddLayout({
       { "a_Position",     ShaderDataType::Float3 },
       { "a_Color",        ShaderDataType::Float4 },
@@ -484,6 +715,12 @@ namespace ikan {
   }
   
   void BatchRenderer::BeginBatch(const glm::mat4& camera_view_projection_matrix) {
+    deferred_data_.StartBatch();
+    
+    // Regions of sprites are moved only here, so that they are same for all the quads of batch
+    if (sprite_atlas_)
+      sprite_atlas_->Update();
+    
     // ----------------------------------------------------------------------
     // Start batch for quads
     // ----------------------------------------------------------------------
@@ -519,14 +756,106 @@ namespace ikan {
   }
   
   void BatchRenderer::EndBatch() {
+    FlushDeferredCommands();
     Flush();
   }
   
+  void BatchRenderer::SetDeferredSubmission(bool deferred) {
+    // Commands recorded till now are drawn before switching
+    if (deferred_data_.enabled and !deferred)
+      FlushDeferredCommands();
+    deferred_data_.enabled = deferred;
+  }
+  
+  bool BatchRenderer::IsDeferredSubmission() {
+    return deferred_data_.enabled;
+  }
+  
+  void BatchRenderer::SetSpriteAtlas(bool enable) {
+    use_sprite_atlas_ = enable;
+  }
+  
+  bool BatchRenderer::IsSpriteAtlas() {
+    return use_sprite_atlas_;
+  }
+  
+  void BatchRenderer::SetLayer(uint8_t layer) {
+    deferred_data_.layer = layer;
+  }
+  
+  void BatchRenderer::FlushDeferredCommands() {
+    if (deferred_data_.commands.empty()) {
+      deferred_data_.StartBatch();
+      return;
+    }
+    
+    deferred_data_.SortKeys();
+    
+    // Batches flushed during replay, for texture slots or instances, are counted in 'NextBatch'
+    deferred_data_.replaying = true;
+    for (const DeferredData::Key& key : deferred_data_.keys) {
+      const DeferredData::Command& command = deferred_data_.commands[key.command_idx];
+      const std::shared_ptr<Texture>& texture = deferred_data_.textures[command.texture_id];
+      if (command.circle)
+        DrawCircleInstance(command.transform_rows, texture, command.tiling_factor, command.color, command.thickness,
+                           command.fade, command.object_id);
+      else
+        DrawQuadInstance(command.transform_rows, texture, command.texture_rect, command.tiling_factor,
+                         command.color, command.object_id);
+    }
+    deferred_data_.replaying = false;
+    
+    if (deferred_data_.immediate_flushes > deferred_data_.replay_flushes)
+      Renderer2DStats::Get().texture_flushes_avoided += deferred_data_.immediate_flushes -
+                                                        deferred_data_.replay_flushes;
+    
+    deferred_data_.StartBatch();
+  }
+  
+  void BatchRenderer::RecordCommand(bool circle,
+                                    const glm::mat4& transform,
+                                    const std::shared_ptr<Texture>& texture,
+                                    const glm::vec2* texture_coords,
+                                    float tiling_factor,
+                                    const glm::vec4& tint_color,
+                                    float thickness,
+                                    float fade,
+                                    int32_t object_id) {
+    DeferredData::Command& command = deferred_data_.commands.emplace_back();
+    GetTransformRows(transform, command.transform_rows);
+    command.color = tint_color;
+    command.texture_rect = texture_coords ? glm::vec4(texture_coords[0], texture_coords[2]) : glm::vec4(0, 0, 1, 1);
+    command.tiling_factor = tiling_factor;
+    command.thickness = thickness;
+    command.fade = fade;
+    command.object_id = object_id;
+    command.texture_id = deferred_data_.GetTextureId(texture);
+    command.circle = circle;
+    
+    // Commands are grouped by texture array, as all the textures of an array take one slot. Array of packed
+    // textures is array of their atlas page
+    uint32_t array_id = 0;
+    if (texture) {
+      glm::vec4 texture_rect = command.texture_rect;
+      array_id = GetTextureLocation(texture, tiling_factor, texture_coords ? &texture_rect : nullptr).array_index + 1;
+    }
+    if (circle)
+      deferred_data_.SimulateImmediateSlots(deferred_data_.circle_slots, array_id, circle_data_->max_element);
+    else
+      deferred_data_.SimulateImmediateSlots(deferred_data_.quad_slots, array_id, quad_data_->max_element);
+    
+    uint64_t key = (uint64_t)deferred_data_.layer << 56;
+    key |= DeferredData::GetDepthBits(command.transform_rows[2].w) << 32;
+    key |= (uint64_t)(circle ? 1 : 0) << 24;
+    key |= array_id & 0xFFFFFF;
+    deferred_data_.keys.push_back({ key, (uint32_t)deferred_data_.commands.size() - 1 });
+  }
+  
   void BatchRenderer::Flush() {
-    if (quad_data_ and quad_data_->index_count) {
+    if (quad_data_ and quad_data_->instance_count) {
       uint32_t data_size = (uint32_t)((uint8_t*)quad_data_->vertex_buffer_ptr -
                                       (uint8_t*)quad_data_->vertex_buffer_base_ptr);
-      quad_data_->vertex_buffer->SetData(quad_data_->vertex_buffer_base_ptr, data_size);
+      quad_data_->vertex_buffer->Unmap(data_size);
       
       // Bind the shader
       quad_data_->shader->Bind();
@@ -536,13 +865,13 @@ namespace ikan {
         quad_data_->texture_slots[i]->Bind(i);
       
       // Render the Scene
-      Renderer::DrawIndexed(quad_data_->pipeline, quad_data_->index_count);
+      Renderer::DrawIndexedInstanced(quad_data_->pipeline, quad_data_->max_indices, quad_data_->instance_count);
     }
     
-    if (circle_data_ and circle_data_->index_count) {
+    if (circle_data_ and circle_data_->instance_count) {
       uint32_t dataSize = (uint32_t)((uint8_t*)circle_data_->vertex_buffer_ptr -
                                      (uint8_t*)circle_data_->vertex_buffer_base_ptr);
-      circle_data_->vertex_buffer->SetData(circle_data_->vertex_buffer_base_ptr, dataSize);
+      circle_data_->vertex_buffer->Unmap(dataSize);
       
       // Bind the shader
       circle_data_->shader->Bind();
@@ -552,13 +881,14 @@ namespace ikan {
         circle_data_->texture_slots[i]->Bind((uint32_t)i);
       
       // Render the Scene
-      Renderer::DrawIndexed(circle_data_->pipeline, circle_data_->index_count);
+      Renderer::DrawIndexedInstanced(circle_data_->pipeline, circle_data_->max_indices,
+                                     circle_data_->instance_count);
     }
     
     if (line_data_ and line_data_->vertex_count) {
       uint32_t dataSize = (uint32_t)((uint8_t*)line_data_->vertex_buffer_ptr -
                                      (uint8_t*)line_data_->vertex_buffer_base_ptr);
-      line_data_->vertex_buffer->SetData(line_data_->vertex_buffer_base_ptr, dataSize);
+      line_data_->vertex_buffer->Unmap(dataSize);
       
       // Bind the shader
       line_data_->shader->Bind();
@@ -569,7 +899,10 @@ namespace ikan {
   }
   
   void BatchRenderer::NextBatch() {
-    EndBatch();
+    // Recorded commands are not flushed here, as batch is also changed while they are replayed
+    if (deferred_data_.replaying)
+      deferred_data_.replay_flushes++;
+    Flush();
     if (quad_data_) quad_data_->StartBatch();
     if (circle_data_) circle_data_->StartBatch();
     if (line_data_) line_data_->StartBatch();
@@ -634,53 +967,65 @@ namespace ikan {
                                       float tiling_factor,
                                       const glm::vec4& tint_color,
                                       int32_t object_id) {
-    // If number of indices increase in batch then start new batch
-    if (quad_data_->index_count >= quad_data_->max_indices) {
-      IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of indices ({0}) increases "
-                   "in the previous batch", quad_data_->index_count);
+    if (deferred_data_.enabled and !deferred_data_.replaying) {
+      RecordCommand(false, transform, texture, texture_coords, tiling_factor, tint_color, 0.0f, 0.0f, object_id);
+      return;
+    }
+    
+    glm::vec4 transform_rows[3];
+    GetTransformRows(transform, transform_rows);
+    DrawQuadInstance(transform_rows, texture, glm::vec4(texture_coords[0], texture_coords[2]), tiling_factor,
+                     tint_color, object_id);
+  }
+  
+  void BatchRenderer::DrawQuadInstance(const glm::vec4* transform_rows,
+                                       const std::shared_ptr<Texture>& texture,
+                                       glm::vec4 texture_rect,
+                                       float tiling_factor,
+                                       const glm::vec4& tint_color,
+                                       int32_t object_id) {
+    // If number of instances increase in batch then start new batch
+    if (quad_data_->instance_count >= quad_data_->max_element) {
+      IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of instances ({0}) increases "
+                   "in the previous batch", quad_data_->instance_count);
       NextBatch();
     }
     
-    float texture_index = 0.0f;
+    float texture_index = 0.0f, texture_layer = 0.0f;
     if (texture) {
-      // Find if texture is already loaded in current batch
-      for (size_t i = 1; i < quad_data_->texture_slot_index; i++) {
-        if (quad_data_->texture_slots[i].get() == texture.get()) {
-          // Found the current textue in the batch
-          texture_index = (float)i;
-          break;
-        }
-      }
+      // Layer of texture is found in table of atlas or pool, and slot of its array in slots of current batch
+      TextureArrayPool::Location location = GetTextureLocation(texture, tiling_factor, &texture_rect);
+      int32_t slot = quad_data_->GetArraySlot(location.array_index);
       
-      // If current texture slot is not pre loaded then load the texture in
-      // proper slot
-      if (texture_index == 0.0f) {
+      // If array of texture is not bound in current batch then bind it in first free slot
+      if (slot < 0) {
         // If number of slots increases max then start new batch
         if (quad_data_->texture_slot_index >= kMaxTextureSlotsInShader) {
           IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of texture slot ({0}) "
                        "increases in the previous batch",
                        quad_data_->texture_slot_index);
           NextBatch();
+          Renderer2DStats::Get().texture_flushes++;
         }
-        
-        // Loading the current texture in the first free slot slot
-        texture_index = (float)quad_data_->texture_slot_index;
-        quad_data_->texture_slots[quad_data_->texture_slot_index] = texture;
-        quad_data_->texture_slot_index++;
+        slot = (int32_t)quad_data_->AddArraySlot(location.array_index);
       }
+      
+      texture_index = (float)slot;
+      texture_layer = (float)location.layer;
     }
     
-    for (size_t i = 0; i < BatchRendererData::VertexForSingleElement; i++) {
-      quad_data_->vertex_buffer_ptr->position         = transform * quad_data_->vertex_base_position[i];
-      quad_data_->vertex_buffer_ptr->color            = tint_color;
-      quad_data_->vertex_buffer_ptr->texture_coords   = texture_coords[i];
-      quad_data_->vertex_buffer_ptr->texture_index    = texture_index;
-      quad_data_->vertex_buffer_ptr->tiling_factor    = tiling_factor;
-      quad_data_->vertex_buffer_ptr->object_id        = object_id;
-      quad_data_->vertex_buffer_ptr++;
-    }
+    // Vertices are transformed in shader. Texture coordinates of quad are the rectangle from first to third corner
+    quad_data_->MapBatch();
+    quad_data_->vertex_buffer_ptr->SetTransform(transform_rows);
+    quad_data_->vertex_buffer_ptr->color            = tint_color;
+    quad_data_->vertex_buffer_ptr->texture_index    = texture_index;
+    quad_data_->vertex_buffer_ptr->tiling_factor    = tiling_factor;
+    quad_data_->vertex_buffer_ptr->texture_layer    = texture_layer;
+    quad_data_->vertex_buffer_ptr->texture_rect     = texture_rect;
+    quad_data_->vertex_buffer_ptr->object_id        = object_id;
+    quad_data_->vertex_buffer_ptr++;
     
-    quad_data_->index_count += BatchRendererData::IndicesForSingleElement;
+    quad_data_->instance_count++;
     
     RendererStatistics::Get().index_count += BatchRendererData::IndicesForSingleElement;
     RendererStatistics::Get().vertex_count += BatchRendererData::VertexForSingleElement;
@@ -744,55 +1089,66 @@ namespace ikan {
                                         float thickness,
                                         float fade,
                                         int32_t object_id) {
-    // If number of indices increase in batch then start new batch
-    if (circle_data_->index_count >= circle_data_->max_indices) {
-      IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of indices ({0}) increases "
-                   "in the previous batch", circle_data_->index_count);
+    if (deferred_data_.enabled and !deferred_data_.replaying) {
+      RecordCommand(true, transform, texture, nullptr, tiling_factor, tint_color, thickness, fade, object_id);
+      return;
+    }
+    
+    glm::vec4 transform_rows[3];
+    GetTransformRows(transform, transform_rows);
+    DrawCircleInstance(transform_rows, texture, tiling_factor, tint_color, thickness, fade, object_id);
+  }
+  
+  void BatchRenderer::DrawCircleInstance(const glm::vec4* transform_rows,
+                                         const std::shared_ptr<Texture>& texture,
+                                         float tiling_factor,
+                                         const glm::vec4& tint_color,
+                                         float thickness,
+                                         float fade,
+                                         int32_t object_id) {
+    // If number of instances increase in batch then start new batch
+    if (circle_data_->instance_count >= circle_data_->max_element) {
+      IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of instances ({0}) increases "
+                   "in the previous batch", circle_data_->instance_count);
       NextBatch();
     }
     
-    float texture_index = 0.0f;
+    float texture_index = 0.0f, texture_layer = 0.0f;
     if (texture) {
-      // Find if texture is already loaded in current batch
-      for (size_t i = 1; i < circle_data_->texture_slot_index; i++) {
-        if (circle_data_->texture_slots[i].get() == texture.get()) {
-          // Found the current textue in the batch
-          texture_index = (float)i;
-          break;
-        }
-      }
+      // Layer of texture is found in table of pool, and slot of its array in slots of current batch
+      TextureArrayPool::Location location = texture_array_pool_->GetLocation(texture);
+      int32_t slot = circle_data_->GetArraySlot(location.array_index);
       
-      // If current texture slot is not pre loaded then load the texture in proper slot
-      if (texture_index == 0.0f) {
+      // If array of texture is not bound in current batch then bind it in first free slot
+      if (slot < 0) {
         // If number of slots increases max then start new batch
         if (circle_data_->texture_slot_index >= kMaxTextureSlotsInShader) {
           IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of texture slot ({0}) "
                        "increases in the previous batch",
                        circle_data_->texture_slot_index);
           NextBatch();
+          Renderer2DStats::Get().texture_flushes++;
         }
-        
-        // Loading the current texture in the first free slot slot
-        texture_index = (float)circle_data_->texture_slot_index;
-        circle_data_->texture_slots[circle_data_->texture_slot_index] = texture;
-        circle_data_->texture_slot_index++;
+        slot = (int32_t)circle_data_->AddArraySlot(location.array_index);
       }
+      
+      texture_index = (float)slot;
+      texture_layer = (float)location.layer;
     }
     
-    for (size_t i = 0; i < BatchRendererData::VertexForSingleElement; i++) {
-      circle_data_->vertex_buffer_ptr->position         = transform * circle_data_->vertex_base_position[i];
-      circle_data_->vertex_buffer_ptr->color            = tint_color;
-      circle_data_->vertex_buffer_ptr->texture_coords   = 2.0f * circle_data_->vertex_base_position[i];
-      circle_data_->vertex_buffer_ptr->texture_index    = texture_index;
-      circle_data_->vertex_buffer_ptr->tiling_factor    = tiling_factor;
-      circle_data_->vertex_buffer_ptr->local_position   = 2.0f * circle_data_->vertex_base_position[i];
-      circle_data_->vertex_buffer_ptr->thickness        = thickness;
-      circle_data_->vertex_buffer_ptr->fade             = fade;
-      circle_data_->vertex_buffer_ptr->object_id        = object_id;
-      circle_data_->vertex_buffer_ptr++;
-    }
+    // Vertices, local position and texture coordinates are computed in shader from unit quad
+    circle_data_->MapBatch();
+    circle_data_->vertex_buffer_ptr->SetTransform(transform_rows);
+    circle_data_->vertex_buffer_ptr->color            = tint_color;
+    circle_data_->vertex_buffer_ptr->texture_index    = texture_index;
+    circle_data_->vertex_buffer_ptr->tiling_factor    = tiling_factor;
+    circle_data_->vertex_buffer_ptr->texture_layer    = texture_layer;
+    circle_data_->vertex_buffer_ptr->thickness        = thickness;
+    circle_data_->vertex_buffer_ptr->fade             = fade;
+    circle_data_->vertex_buffer_ptr->object_id        = object_id;
+    circle_data_->vertex_buffer_ptr++;
     
-    circle_data_->index_count += BatchRendererData::IndicesForSingleElement;
+    circle_data_->instance_count++;
     
     RendererStatistics::Get().index_count += BatchRendererData::IndicesForSingleElement;
     RendererStatistics::Get().vertex_count += BatchRendererData::VertexForSingleElement;
@@ -803,6 +1159,14 @@ namespace ikan {
   void BatchRenderer::DrawLine(const glm::vec3& p0,
                                const glm::vec3& p1,
                                const glm::vec4& color) {
+    // If number of vertices increase in batch then start new batch, as batch can not grow in stream buffer
+    if (line_data_->vertex_count + LineData::kVertexForSingleLine > line_data_->max_vertices) {
+      IK_CORE_WARN(LogModule::Batch2DRenderer, "Starts the new batch as number of lines ({0}) increases "
+                   "in the previous batch", line_data_->vertex_count / LineData::kVertexForSingleLine);
+      NextBatch();
+    }
+    
+    line_data_->MapBatch();
     line_data_->vertex_buffer_ptr->position = p0;
     line_data_->vertex_buffer_ptr->color = color;
     line_data_->vertex_buffer_ptr++;
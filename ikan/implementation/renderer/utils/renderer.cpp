@@ -10,6 +10,7 @@
 #include "renderer/graphics/shader.hpp"
 #include "renderer/graphics/texture.hpp"
 #include "renderer/graphics/pipeline.hpp"
+#include "renderer/graphics/renderer_buffer.hpp"
 #include "renderer/utils/renderer_stats.hpp"
 #include "renderer/utils/batch_2d_renderer.hpp"
 #include "renderer/utils/text_renderer.hpp"
@@ -164,6 +165,10 @@ namespace ikan {
     return renderer_data_->api;
   }
   
+  void Renderer::EndFrame() {
+    StreamVertexBuffer::EndFrame();
+  }
+  
   // -------------------------------------------------------------------------
   // Renderer Stats API
   // -------------------------------------------------------------------------
@@ -223,6 +228,10 @@ namespace ikan {
   void Renderer::DrawIndexed(const std::shared_ptr<Pipeline>& pipeline, uint32_t count) {
     renderer_data_->renderer_api_instance->DrawIndexed(pipeline, count);
   }
+  void Renderer::DrawIndexedInstanced(const std::shared_ptr<Pipeline>& pipeline, uint32_t count,
+                                      uint32_t instance_count) {
+    renderer_data_->renderer_api_instance->DrawIndexedInstanced(pipeline, count, instance_count);
+  }
   void Renderer::DrawLines(const std::shared_ptr<Pipeline>& pipeline, uint32_t vertex_count) {
     renderer_data_->renderer_api_instance->DrawLines(pipeline, vertex_count);
   }
@@ -17,12 +17,16 @@ namespace ikan {
     circles = 0;
     quads = 0;
     lines = 0;
+    texture_flushes = 0;
+    texture_flushes_avoided = 0;
   }
   
   void Renderer2DStats::ResetEachFrame() {
     circles = 0;
     quads = 0;
     lines = 0;
+    texture_flushes = 0;
+    texture_flushes_avoided = 0;
   }
   
   void Renderer2DStats::RenderGui(bool *is_open) {
@@ -31,7 +35,7 @@ namespace ikan {
     ImGui::Begin("Renderer 2D Stats", is_open);
     ImGui::PushID("Renderer 2D Stats");
     
-    ImGui::Columns(6);
+    ImGui::Columns(8);
     
     ImGui::SetColumnWidth(0, 80);
     ImGui::Text("%d", max_quads);
@@ -62,6 +66,16 @@ namespace ikan {
     ImGui::Text("%d", lines);
     PropertyGrid::HoveredMsg("Num Lines Rendered");
     ImGui::NextColumn();
+    
+    ImGui::SetColumnWidth(6, 80);
+    ImGui::Text("%d", texture_flushes);
+    PropertyGrid::HoveredMsg("Num Batches Flushed as Texture Slots were Full");
+    ImGui::NextColumn();
+    
+    ImGui::SetColumnWidth(7, 80);
+    ImGui::Text("%d", texture_flushes_avoided);
+    PropertyGrid::HoveredMsg("Num Texture Slot Flushes Avoided by Sorted Submission");
+    ImGui::NextColumn();
 
     
     ImGui::NextColumn();
@@ -0,0 +1,365 @@
+//
+//  sprite_atlas.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "sprite_atlas.hpp"
+#include "renderer/graphics/texture.hpp"
+
+namespace ikan {
+  
+  namespace sprite_atlas_utils {
+    
+    /// Destroyed textures are searched once in these many updates (batches), as all the entries are visited
+    static constexpr uint32_t kSweepUpdates = 60;
+    /// Textures of re-pack copied in new pages in each update. Each texture takes a copy for itself and for each
+    /// edge and corner of its extrusion
+    static constexpr uint32_t kRepackTexturesPerUpdate = 32;
+    
+  } // namespace sprite_atlas_utils
+  
+  // --------------------------------------------------------------------------
+  // Skyline
+  // --------------------------------------------------------------------------
+  void SpriteAtlas::Skyline::Reset(uint32_t page_size) {
+    size = page_size;
+    nodes.clear();
+    nodes.push_back({ 0, 0, page_size });
+  }
+  
+  bool SpriteAtlas::Skyline::Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y) {
+    // Returns the lowest row where rectangle fits, when its left edge is at start of node
+    auto fit = [this, width, height](size_t node_idx, uint32_t& fit_y) {
+      if (nodes[node_idx].x + width > size)
+        return false;
+      
+      fit_y = 0;
+      uint32_t width_left = width;
+      for (size_t i = node_idx; width_left > 0; i++) {
+        fit_y = std::max(fit_y, nodes[i].y);
+        if (fit_y + height > size)
+          return false;
+        width_left -= std::min(width_left, nodes[i].width);
+      }
+      return true;
+    };
+    
+    // Bottom left : position with lowest top edge, then with narrowest node to waste less space
+    int32_t best_idx = -1;
+    uint32_t best_top = std::numeric_limits<uint32_t>::max(), best_width = std::numeric_limits<uint32_t>::max();
+    for (size_t i = 0; i < nodes.size(); i++) {
+      uint32_t fit_y = 0;
+      if (!fit(i, fit_y))
+        continue;
+      if (fit_y + height < best_top or (fit_y + height == best_top and nodes[i].width < best_width)) {
+        best_idx = (int32_t)i;
+        best_top = fit_y + height;
+        best_width = nodes[i].width;
+        x = nodes[i].x;
+        y = fit_y;
+      }
+    }
+    if (best_idx < 0)
+      return false;
+    
+    // New node covers the top of rectangle, nodes under it are cut or removed
+    nodes.insert(nodes.begin() + best_idx, { x, y + height, width });
+    for (size_t i = (size_t)best_idx + 1; i < nodes.size();) {
+      uint32_t prev_end = nodes[i - 1].x + nodes[i - 1].width;
+      if (nodes[i].x >= prev_end)
+        break;
+      
+      uint32_t shrink = prev_end - nodes[i].x;
+      if (nodes[i].width <= shrink) {
+        nodes.erase(nodes.begin() + (int64_t)i);
+        continue;
+      }
+      nodes[i].x += shrink;
+      nodes[i].width -= shrink;
+      break;
+    }
+    
+    // Neighbour nodes at same height are merged
+    for (size_t i = 0; i + 1 < nodes.size();) {
+      if (nodes[i].y == nodes[i + 1].y) {
+        nodes[i].width += nodes[i + 1].width;
+        nodes.erase(nodes.begin() + (int64_t)i + 1);
+      }
+      else {
+        i++;
+      }
+    }
+    return true;
+  }
+  
+  // --------------------------------------------------------------------------
+  // Sprite Atlas
+  // --------------------------------------------------------------------------
+  SpriteAtlas::SpriteAtlas(TextureArrayPool& pool, const Setting& setting)
+  : pool_(pool), setting_(setting) {
+    IK_CORE_ASSERT(setting_.padding >= setting_.extrusion, "Padding of atlas must not be less than extrusion");
+    IK_CORE_ASSERT(setting_.max_sprite_size + 2 * setting_.padding <= setting_.page_size,
+                   "Biggest sprite must fit in page of atlas");
+    
+    IK_CORE_INFO(LogModule::Texture, "Creating Sprite Atlas ...");
+    IK_CORE_INFO(LogModule::Texture, "  Page Size         | {0} x {0}", setting_.page_size);
+    IK_CORE_INFO(LogModule::Texture, "  Max Sprite Size   | {0} x {0}", setting_.max_sprite_size);
+    IK_CORE_INFO(LogModule::Texture, "  Padding           | {0} ({1} extruded)", setting_.padding, setting_.extrusion);
+    IK_CORE_INFO(LogModule::Texture, "  Repack Threshold  | {0}", setting_.repack_threshold);
+  }
+  
+  SpriteAtlas::~SpriteAtlas() {
+    IK_CORE_WARN(LogModule::Texture, "Destroying Sprite Atlas ({0} Pages, {1} Sprites) !!!", pages_.size(),
+                 num_sprites_);
+    if (repack_) {
+      if (repack_->thread.joinable())
+        repack_->thread.join();
+      for (const Page& page : repack_->pages)
+        pool_.FreeLayer(page.location);
+    }
+    for (const Page& page : pages_)
+      pool_.FreeLayer(page.location);
+  }
+  
+  const SpriteAtlas::Region* SpriteAtlas::GetRegion(const std::shared_ptr<Texture>& texture) {
+    auto it = entries_.find(texture.get());
+    if (it != entries_.end()) {
+      if (!it->second.texture.expired())
+        return it->second.packed ? &it->second.region : nullptr;
+      
+      // Texture stored at this address is destroyed, its area stays as hole till re-pack
+      if (it->second.packed) {
+        destroyed_area_ += it->second.area;
+        num_sprites_--;
+      }
+      entries_.erase(it);
+    }
+    
+    Entry& entry = entries_[texture.get()];
+    entry.texture = texture;
+    
+    // Only small textures with color are packed. Other textures are stored in the entry as not packed, so that
+    // they are checked only once
+    uint32_t width = texture->GetWidth(), height = texture->GetHeight();
+    TextureFormat format = texture->GetFormat();
+    if (width > 0 and height > 0 and width <= setting_.max_sprite_size and height <= setting_.max_sprite_size and
+        (format == TextureFormat::RGBA or format == TextureFormat::RGB))
+      Pack(texture, entry);
+    return entry.packed ? &entry.region : nullptr;
+  }
+  
+  void SpriteAtlas::Pack(const std::shared_ptr<Texture>& texture, Entry& entry) {
+    const uint32_t padded_width = texture->GetWidth() + 2 * setting_.padding;
+    const uint32_t padded_height = texture->GetHeight() + 2 * setting_.padding;
+    const bool linear = texture->IsLinear();
+    
+    uint32_t x = 0, y = 0;
+    uint32_t page_idx = 0;
+    for (; page_idx < pages_.size(); page_idx++)
+      if (pages_[page_idx].linear == linear and pages_[page_idx].skyline.Insert(padded_width, padded_height, x, y))
+        break;
+    
+    if (page_idx == pages_.size()) {
+      pages_.push_back(CreatePage(linear));
+      pages_[page_idx].skyline.Insert(padded_width, padded_height, x, y);
+      IK_CORE_DEBUG(LogModule::Texture, "Sprite Atlas page {0} added at layer {1} of Texture Array {2}", page_idx,
+                    pages_[page_idx].location.layer, pages_[page_idx].location.array_index);
+    }
+    
+    entry.region = Upload(*texture, pages_[page_idx], x, y);
+    entry.area = (uint64_t)padded_width * padded_height;
+    entry.packed = true;
+    
+    packed_area_ += entry.area;
+    num_sprites_++;
+  }
+  
+  SpriteAtlas::Page SpriteAtlas::CreatePage(bool linear) {
+    Page page;
+    page.location = pool_.AllocateLayer(setting_.page_size, setting_.page_size, TextureFormat::RGBA, linear);
+    page.skyline.Reset(setting_.page_size);
+    page.linear = linear;
+    return page;
+  }
+  
+  SpriteAtlas::Region SpriteAtlas::Upload(const Texture& texture, const Page& page, uint32_t x, uint32_t y) {
+    x += setting_.padding;
+    y += setting_.padding;
+    pool_.GetArray(page.location.array_index)->SetRegion(page.location.layer, x, y, texture, setting_.extrusion);
+    
+    const float inv_page_size = 1.0f / (float)setting_.page_size;
+    Region region;
+    region.location = page.location;
+    region.uv_min = { (float)x * inv_page_size, (float)y * inv_page_size };
+    region.uv_size = { (float)texture.GetWidth() * inv_page_size, (float)texture.GetHeight() * inv_page_size };
+    return region;
+  }
+  
+  void SpriteAtlas::Update() {
+    // Finished re-pack is continued first, as its swap drops the destroyed textures
+    if (repack_ and repack_->done)
+      ApplyRepack();
+    
+    if (++update_idx_ % sprite_atlas_utils::kSweepUpdates != 0)
+      return;
+    
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.texture.expired()) {
+        if (it->second.packed) {
+          destroyed_area_ += it->second.area;
+          num_sprites_--;
+        }
+        it = entries_.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+    
+    if (!repack_ and destroyed_area_ > 0 and GetFragmentation() > setting_.repack_threshold)
+      StartRepack();
+  }
+  
+  void SpriteAtlas::StartRepack() {
+    repack_ = std::make_unique<Repack>();
+    for (const auto& [texture_ptr, entry] : entries_) {
+      if (!entry.packed)
+        continue;
+      std::shared_ptr<Texture> texture = entry.texture.lock();
+      if (!texture)
+        continue;
+      
+      repack_->textures.push_back(texture);
+      repack_->sizes.push_back({ texture->GetWidth() + 2 * setting_.padding,
+        texture->GetHeight() + 2 * setting_.padding });
+      repack_->linear.push_back(texture->IsLinear());
+    }
+    
+    IK_CORE_INFO(LogModule::Texture, "Re-packing {0} sprites of Sprite Atlas ({1} Pages, {2} fragmented)",
+                 repack_->textures.size(), pages_.size(), GetFragmentation());
+    
+    // Background thread only reads the sizes and writes the placements, pages are filled by 'Update'
+    Repack* repack = repack_.get();
+    const uint32_t page_size = setting_.page_size;
+    repack_->thread = std::thread([repack, page_size]() {
+      // Tallest textures first, as they leave less space under the skyline
+      std::vector<uint32_t> order(repack->sizes.size());
+      for (uint32_t i = 0; i < order.size(); i++)
+        order[i] = i;
+      std::stable_sort(order.begin(), order.end(), [repack](uint32_t a, uint32_t b) {
+        if (repack->sizes[a].y != repack->sizes[b].y)
+          return repack->sizes[a].y > repack->sizes[b].y;
+        return repack->sizes[a].x > repack->sizes[b].x;
+      });
+      
+      repack->placements.resize(order.size());
+      for (uint32_t idx : order) {
+        const glm::uvec2& size = repack->sizes[idx];
+        Repack::Placement& placement = repack->placements[idx];
+        
+        uint32_t page = 0;
+        for (; page < repack->skylines.size(); page++)
+          if (repack->page_linear[page] == repack->linear[idx] and
+              repack->skylines[page].Insert(size.x, size.y, placement.x, placement.y))
+            break;
+        
+        if (page == repack->skylines.size()) {
+          repack->skylines.emplace_back().Reset(page_size);
+          repack->page_linear.push_back(repack->linear[idx]);
+          repack->skylines.back().Insert(size.x, size.y, placement.x, placement.y);
+        }
+        placement.page = page;
+      }
+      repack->done = true;
+    });
+  }
+  
+  void SpriteAtlas::ApplyRepack() {
+    // New pages are allocated in layers other than old pages, as old pages are sampled till the swap
+    if (repack_->thread.joinable()) {
+      repack_->thread.join();
+      for (size_t page_idx = 0; page_idx < repack_->skylines.size(); page_idx++) {
+        repack_->pages.push_back(CreatePage(repack_->page_linear[page_idx]));
+        repack_->pages.back().skyline = std::move(repack_->skylines[page_idx]);
+      }
+    }
+    
+    // Few textures are copied in each update, so that re-pack does not stall a single frame
+    const uint32_t num_textures = (uint32_t)repack_->textures.size();
+    const uint32_t end = std::min(repack_->next_texture + sprite_atlas_utils::kRepackTexturesPerUpdate,
+                                  num_textures);
+    for (uint32_t i = repack_->next_texture; i < end; i++) {
+      std::shared_ptr<Texture> texture = repack_->textures[i].lock();
+      if (!texture)
+        continue;
+      const Repack::Placement& placement = repack_->placements[i];
+      
+      Entry& entry = repack_->entries[texture.get()];
+      entry.texture = texture;
+      entry.region = Upload(*texture, repack_->pages[placement.page], placement.x, placement.y);
+      entry.area = (uint64_t)repack_->sizes[i].x * repack_->sizes[i].y;
+      entry.packed = true;
+      
+      repack_->packed_area += entry.area;
+      repack_->num_sprites++;
+    }
+    repack_->next_texture = end;
+    if (end < num_textures)
+      return;
+    
+    // All the textures are copied, new pages replace the old pages. Draws of previous batches are already
+    // submitted, and this batch has not used any region yet
+    const uint32_t old_num_pages = (uint32_t)pages_.size();
+    for (const Page& page : pages_)
+      pool_.FreeLayer(page.location);
+    pages_.swap(repack_->pages);
+    repack_->pages.clear();
+    
+    std::unordered_map<const Texture*, Entry>& entries = repack_->entries;
+    packed_area_ = repack_->packed_area;
+    destroyed_area_ = 0;
+    num_sprites_ = repack_->num_sprites;
+    
+    // Textures packed while re-pack was running are packed again in new pages. Textures that are not packed are
+    // kept as they are
+    std::vector<std::shared_ptr<Texture>> late_textures;
+    for (const auto& [texture_ptr, entry] : entries_) {
+      if (entries.find(texture_ptr) != entries.end())
+        continue;
+      std::shared_ptr<Texture> texture = entry.texture.lock();
+      if (!texture)
+        continue;
+      
+      if (entry.packed)
+        late_textures.push_back(texture);
+      else
+        entries.emplace(texture_ptr, entry);
+    }
+    entries_.swap(entries);
+    
+    for (const std::shared_ptr<Texture>& texture : late_textures) {
+      Entry& entry = entries_[texture.get()];
+      entry.texture = texture;
+      Pack(texture, entry);
+    }
+    
+    IK_CORE_INFO(LogModule::Texture, "Sprite Atlas re-packed : {0} sprites in {1} Pages (was {2} Pages)",
+                 num_sprites_, pages_.size(), old_num_pages);
+    repack_.reset();
+  }
+  
+  float SpriteAtlas::GetFragmentation() const {
+    return packed_area_ > 0 ? (float)destroyed_area_ / (float)packed_area_ : 0.0f;
+  }
+  
+  uint32_t SpriteAtlas::GetNumPages() const {
+    return (uint32_t)pages_.size();
+  }
+  
+  uint32_t SpriteAtlas::GetNumSprites() const {
+    return num_sprites_;
+  }
+  
+}
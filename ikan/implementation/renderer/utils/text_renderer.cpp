@@ -26,10 +26,12 @@ namespace ikan {
     
     // Fixed Constants
     static constexpr uint32_t VertexForSingleChar = 6;
+    /// Batches of text in region of a frame in stream buffer
+    static constexpr uint32_t kBatchesPerFrame = 64;
     
     /// Renderer Data storage
     std::shared_ptr<Pipeline> pipeline;
-    std::shared_ptr<VertexBuffer> vertex_buffer;
+    std::shared_ptr<StreamVertexBuffer> vertex_buffer;
     std::shared_ptr<Shader> shader;
     
     std::array<std::shared_ptr<CharTexture>, kMaxTextureSlotsInShader> char_textures;
@@ -38,7 +40,8 @@ namespace ikan {
     std::map<char, std::shared_ptr<CharTexture>> char_texture_map;
     
     // -------------- Variables ------------------
-    /// Base pointer of Vertex Data. This is start of Batch data for single draw call
+    /// Base pointer of Vertex Data, in mapped region of stream buffer. This is start of Batch data for single
+    /// draw call
     Vertex* vertex_buffer_base_ptr = nullptr;
     /// Incrememntal Vetrtex Data Pointer to store all the batch data in Buffer
     Vertex* vertex_buffer_ptr = nullptr;
@@ -55,10 +58,7 @@ namespace ikan {
     /// Destructir
     virtual ~TextData() {
       IK_CORE_WARN(LogModule::Text, "Destroying Text Data instance and clearing the data !!!");
-      delete [] vertex_buffer_base_ptr;
       vertex_buffer_base_ptr = nullptr;
-      
-      RendererStatistics::Get().vertex_buffer_size -= TextData::VertexForSingleChar * sizeof(TextData::Vertex);
     }
   };
   static TextData* text_data_;
@@ -66,14 +66,13 @@ namespace ikan {
   void TextRenderer::Init() {
     text_data_ = new TextData();
     
-    // Allocating the memory for vertex Buffer Pointer
-    text_data_->vertex_buffer_base_ptr = new TextData::Vertex[TextData::VertexForSingleChar * kMaxTextureSlotsInShader];
-    
     // Create Pipeline instance
     text_data_->pipeline = Pipeline::Create();
     
-    // Create vertes Buffer
-    text_data_->vertex_buffer = VertexBuffer::Create(sizeof(TextData::Vertex) * TextData::VertexForSingleChar * kMaxTextureSlotsInShader);
+    // Create vertes Buffer. Vertices are written directly in its mapped regions. Batch is flushed each time all
+    // the texture slots are used, so a frame has many small batches
+    text_data_->vertex_buffer = StreamVertexBuffer::Create(sizeof(TextData::Vertex) * TextData::VertexForSingleChar *
+                                                           kMaxTextureSlotsInShader, TextData::kBatchesPerFrame);
     text_data_->vertex_buffer->AddLayout({
       { "a_Position",  ShaderDataType::Float3 },
       { "a_Color",     ShaderDataType::Float4 },
@@ -160,8 +159,11 @@ namespace ikan {
     NextBatch();
   }
   void TextRenderer::EndBatch() {
+    if (text_data_->num_slots_used == 0)
+      return;
+    
     uint32_t dataSize = (uint32_t)((uint8_t*)text_data_->vertex_buffer_ptr - (uint8_t*)text_data_->vertex_buffer_base_ptr);
-    text_data_->vertex_buffer->SetData(text_data_->vertex_buffer_base_ptr, dataSize);
+    text_data_->vertex_buffer->Unmap(dataSize);
     
     // Render the Scene
     text_data_->shader->Bind();
@@ -188,6 +190,12 @@ namespace ikan {
       
       std::shared_ptr<CharTexture> ch = text_data_->char_texture_map[*c];
       
+      // Batch is mapped in stream buffer at its first char
+      if (!text_data_->vertex_buffer_base_ptr) {
+        text_data_->vertex_buffer_base_ptr = (TextData::Vertex*)text_data_->vertex_buffer->Map();
+        text_data_->vertex_buffer_ptr = text_data_->vertex_buffer_base_ptr;
+      }
+      
       float xpos = position.x + ch->GetBearing().x * scale.x;
       float ypos = position.y - (ch->GetSize().y - ch->GetBearing().y) * scale.y;
       float zpos = position.z;
@@ -236,7 +244,8 @@ namespace ikan {
   }
   
   void TextRenderer::NextBatch() {
-    text_data_->vertex_buffer_ptr = text_data_->vertex_buffer_base_ptr;
+    text_data_->vertex_buffer_base_ptr = nullptr;
+    text_data_->vertex_buffer_ptr = nullptr;
     text_data_->num_slots_used = 0;
   }
   
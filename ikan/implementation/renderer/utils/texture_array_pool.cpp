@@ -0,0 +1,159 @@
+//
+//  texture_array_pool.cpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "texture_array_pool.hpp"
+#include "renderer/graphics/texture.hpp"
+
+namespace ikan {
+  
+  namespace texture_array_pool_utils {
+    
+    /// This function returns the number of bytes of pixel
+    /// - Parameter format: pixel format
+    static uint32_t GetBytesPerPixel(TextureFormat format) {
+      switch (format) {
+        case TextureFormat::RGBA:  return 4;
+        case TextureFormat::RGB:   return 3;
+        case TextureFormat::Red:   return 1;
+        case TextureFormat::None:  return 0;
+      }
+      return 0;
+    }
+    
+    /// This function returns the key of group. Bits from most significant : width (24), height (24),
+    /// format (8) and filter (8)
+    static uint64_t GetGroupKey(uint32_t width, uint32_t height, TextureFormat format, bool linear) {
+      return ((uint64_t)width << 40) | ((uint64_t)(height & 0xFFFFFF) << 16) | ((uint64_t)format << 8) |
+      (linear ? 1 : 0);
+    }
+    
+  } // namespace texture_array_pool_utils
+  
+  TextureArrayPool::TextureArrayPool(const std::shared_ptr<Texture>& default_texture)
+  : default_texture_(default_texture) {
+    IK_CORE_INFO(LogModule::Texture, "Creating Texture Array Pool ...");
+    GetLocation(default_texture_);
+  }
+  
+  TextureArrayPool::~TextureArrayPool() {
+    IK_CORE_WARN(LogModule::Texture, "Destroying Texture Array Pool ({0} Arrays, {1} Textures) !!!",
+                 arrays_.size(), entries_.size());
+  }
+  
+  TextureArrayPool::Location TextureArrayPool::GetLocation(const std::shared_ptr<Texture>& texture) {
+    auto it = entries_.find(texture.get());
+    if (it != entries_.end()) {
+      if (!it->second.texture.expired())
+        return it->second.location;
+      
+      // Texture stored at this address is destroyed, its layer is freed before the new texture is inserted
+      FreeLayer(it->second.location);
+      entries_.erase(it);
+    }
+    
+    Location location = Insert(texture);
+    entries_.emplace(texture.get(), Entry{ texture, location });
+    return location;
+  }
+  
+  TextureArrayPool::Location TextureArrayPool::Insert(const std::shared_ptr<Texture>& texture) {
+    uint32_t width = texture->GetWidth(), height = texture->GetHeight();
+    TextureFormat format = texture->GetFormat();
+    bool linear = texture->IsLinear();
+    
+    // Textures without data (failed to load) are drawn with default texture
+    uint32_t bytes_per_pixel = texture_array_pool_utils::GetBytesPerPixel(format);
+    if (width == 0 or height == 0 or bytes_per_pixel == 0) {
+      IK_CORE_WARN(LogModule::Texture, "Texture {0} has no data, using the default texture", texture->GetName());
+      return Location();
+    }
+    
+    Location location = AllocateLayer(width, height, format, linear);
+    arrays_[location.array_index].array->SetLayer(location.layer, *texture);
+    return location;
+  }
+  
+  TextureArrayPool::Location TextureArrayPool::AllocateLayer(uint32_t width,
+                                                             uint32_t height,
+                                                             TextureFormat format,
+                                                             bool linear) {
+    uint32_t bytes_per_pixel = texture_array_pool_utils::GetBytesPerPixel(format);
+    IK_CORE_ASSERT(width > 0 and height > 0 and bytes_per_pixel > 0, "Invalid layer of Texture Array");
+    
+    std::vector<uint32_t>& group = groups_[texture_array_pool_utils::GetGroupKey(width, height, format, linear)];
+    auto find_free_array = [this, &group]() -> int32_t {
+      for (uint32_t array_index : group)
+        if (!arrays_[array_index].free_layers.empty())
+          return (int32_t)array_index;
+      return -1;
+    };
+    
+    // Layers of destroyed textures are collected only when group is full, before creating new array
+    int32_t array_index = find_free_array();
+    if (array_index < 0 and !group.empty()) {
+      Collect();
+      array_index = find_free_array();
+    }
+    
+    if (array_index < 0) {
+      // Group starts with single layer, and each next array has double layers, limited by memory of array
+      uint64_t layer_size = (uint64_t)width * height * bytes_per_pixel;
+      uint64_t max_layers = std::max<uint64_t>(kMaxArraySize / layer_size, 1);
+      uint32_t num_layers = (uint32_t)std::min<uint64_t>({
+        (uint64_t)kMinLayersPerArray << std::min<size_t>(group.size(), 8), kMaxLayersPerArray, max_layers
+      });
+      
+      array_index = (int32_t)arrays_.size();
+      ArrayData& array_data = arrays_.emplace_back();
+      array_data.array = TextureArray::Create(width, height, format, linear, num_layers);
+      
+      // Free layers are popped from back, so that layers are used in order
+      array_data.free_layers.resize(num_layers);
+      for (uint32_t layer = 0; layer < num_layers; layer++)
+        array_data.free_layers[layer] = num_layers - 1 - layer;
+      group.push_back((uint32_t)array_index);
+      
+      IK_CORE_DEBUG(LogModule::Texture, "Texture Array {0} created for {1} x {2} textures with {3} layers",
+                    array_index, width, height, num_layers);
+    }
+    
+    ArrayData& array_data = arrays_[(size_t)array_index];
+    Location location;
+    location.array_index = (uint32_t)array_index;
+    location.layer = array_data.free_layers.back();
+    array_data.free_layers.pop_back();
+    return location;
+  }
+  
+  void TextureArrayPool::FreeLayer(const Location& location) {
+    // First layer of first array is of default texture, also returned for textures without data
+    if (location.array_index == 0 and location.layer == 0)
+      return;
+    arrays_[location.array_index].free_layers.push_back(location.layer);
+  }
+  
+  void TextureArrayPool::Collect() {
+    for (auto it = entries_.begin(); it != entries_.end();) {
+      if (it->second.texture.expired()) {
+        FreeLayer(it->second.location);
+        it = entries_.erase(it);
+      }
+      else {
+        ++it;
+      }
+    }
+  }
+  
+  const std::shared_ptr<TextureArray>& TextureArrayPool::GetArray(uint32_t array_index) const {
+    return arrays_[array_index].array;
+  }
+  
+  uint32_t TextureArrayPool::GetNumArrays() const {
+    return (uint32_t)arrays_.size();
+  }
+  
+}
@@ -22,13 +22,11 @@ namespace ikan {
     // ----------------------------
     /// This constructor creates the Editor Camera instance and initialize all the parameters
     /// - Parameters:
-    ///   - update_rays: update rays for each frame
     ///   - aspect_ratio: Aspect ratio of the famera
     ///   - fov: FOV of the camera in radians
     ///   - near_plane: Near plane of camera
     ///   - far_plane: far plane of camera
-    EditorCamera(bool update_rays = false,
-                 float aspect_ratio = 16.0f / 9.0f,
+    EditorCamera(float aspect_ratio = 16.0f / 9.0f,
                  float fov = glm::radians(75.0f),
                  float near_plane = 0.01f,
                  float far_plane = 100000.0f);
@@ -79,8 +77,10 @@ namespace ikan {
     [[nodiscard]] uint32_t GetViewportHeight() const;
     /// This function returns the editor camera viewport width
     [[nodiscard]] uint32_t GetViewportWidth() const;
-    /// This function returns the ray Directions of the camera
-    [[nodiscard]] const std::vector<glm::vec3>& GetRayDirections() const;
+    /// This function returns the inverse of View Matrix
+    [[nodiscard]] const glm::mat4& GetInverseView() const;
+    /// This function returns the inverse of Projection Matrix
+    [[nodiscard]] const glm::mat4& GetInverseProjection() const;
 
   private:
     // -------------------
@@ -90,8 +90,6 @@ namespace ikan {
     void UpdateCameraView();
     /// This function updates the camera Projection matrix
     void UpdateCameraProjection();
-    /// This function calculates the ray directions
-    void UpdateRayDirections();
     /// This function updates the zoom value of the camera
     void MouseZoom(float delta);
     /// This function updates the mouse pan value
@@ -127,8 +125,6 @@ namespace ikan {
     glm::mat4 projection_view_matrix_ = glm::mat4(1.0f);
     glm::mat4 inverse_projection_{ 1.0f };
     glm::mat4 inverse_view_{ 1.0f };
-    
-    std::vector<glm::vec3> ray_directions_;
 
     glm::vec3 forward_direction_{0.0f, 0.0f, 0.0f};
     glm::vec3 position_ = glm::vec3(0.0f);
@@ -143,7 +139,6 @@ namespace ikan {
     float pitch_ = 0.4f, yaw_ = 0.5f;
     
     bool new_update_ = true;
-    bool update_rays_ = false;
   };
   
 }
@@ -27,7 +27,7 @@ namespace ikan {
     EditorCamera, ContentBrowserPanel, ScenePanelManager,
     
     // Ray Tracing
-    HitPayload, Ray, Sphere, RayMaterial,
+    HitPayload, Ray, Sphere, RayMaterial, RayBvh, RayMesh, RayCheckpoint,
     
     // Imgui
     Imgui,
@@ -82,6 +82,9 @@ namespace ikan {
       case LogModule::Ray: return "Ray";
       case LogModule::Sphere: return "Sphere";
       case LogModule::RayMaterial: return "RayMaterial";
+      case LogModule::RayBvh: return "RayBvh";
+      case LogModule::RayMesh: return "RayMesh";
+      case LogModule::RayCheckpoint: return "RayCheckpoint";
         
       case LogModule::Imgui: return "ImGui";
         
@@ -227,6 +227,9 @@ namespace ikan {
     Logger::GetDetail(GetModuleName(LogModule::Ray)).enabled =                    true;
     Logger::GetDetail(GetModuleName(LogModule::Sphere)).enabled =                 true;
     Logger::GetDetail(GetModuleName(LogModule::RayMaterial)).enabled =            true;
+    Logger::GetDetail(GetModuleName(LogModule::RayBvh)).enabled =                 true;
+    Logger::GetDetail(GetModuleName(LogModule::RayMesh)).enabled =                true;
+    Logger::GetDetail(GetModuleName(LogModule::RayCheckpoint)).enabled =          true;
     Logger::GetDetail(GetModuleName(LogModule::Imgui)).enabled =                  true;
     Logger::GetDetail(GetModuleName(LogModule::Physics)).enabled =                true;
   }
@@ -0,0 +1,102 @@
+//
+//  random_generator.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include <glm/glm.hpp>
+
+namespace ikan {
+
+  /// This class is the PCG32 random number generator (pcg-random.org). Unlike 'rand()' it has no global state,
+  /// so each thread (or each pixel) can own a generator and sequences are reproducible for same seed and stream.
+  /// - Important: Functions are defined in header as they are called for each bounce of each pixel
+  class RandomGenerator {
+  public:
+    /// This constructor seeds the generator
+    /// - Parameters:
+    ///   - seed: initial state
+    ///   - stream: sequence selector. Generators with different streams produce different sequences
+    RandomGenerator(uint64_t seed = 0x853c49e6748fea9bULL, uint64_t stream = 0xda3e39cb94b95bdbULL) {
+      state_ = 0u;
+      increment_ = (stream << 1u) | 1u;
+      NextUInt();
+      state_ += seed;
+      NextUInt();
+    }
+
+    /// This function creates the generator for a pixel. Same input always creates the same sequence
+    /// - Parameters:
+    ///   - pixel_idx: index of pixel
+    ///   - frame_idx: index of frame (sample)
+    ///   - bounce: bounce of path
+    ///   - seed: global seed of renderer
+    static RandomGenerator ForPixel(uint32_t pixel_idx, uint32_t frame_idx, uint32_t bounce, uint32_t seed = 0) {
+      uint64_t state = Hash(((uint64_t)frame_idx << 32) | bounce) ^ Hash((uint64_t)seed + 0x9e3779b97f4a7c15ULL);
+      return RandomGenerator(state, pixel_idx);
+    }
+
+    /// This function returns the next random 32 bit number
+    uint32_t NextUInt() {
+      uint64_t old_state = state_;
+      state_ = old_state * 6364136223846793005ULL + increment_;
+      uint32_t xor_shifted = (uint32_t)(((old_state >> 18u) ^ old_state) >> 27u);
+      uint32_t rot = (uint32_t)(old_state >> 59u);
+      return (xor_shifted >> rot) | (xor_shifted << ((-rot) & 31));
+    }
+    /// This function returns the random float in range [0, 1)
+    float NextFloat() {
+      // Upper 24 bits fit exactly in float mantissa
+      return (NextUInt() >> 8) * (1.0f / 16777216.0f);
+    }
+    /// This function returns the random float in range [min, max)
+    /// - Parameters:
+    ///   - min: Minimum range of random number:
+    ///   - max: Maximum range of random number:
+    float NextFloat(float min, float max) {
+      return min + (max - min) * NextFloat();
+    }
+    /// This function returns the random vector with values in range [min, max)
+    /// - Parameters:
+    ///   - min: Minimum range of random number:
+    ///   - max: Maximum range of random number:
+    glm::vec3 NextVec3(float min, float max) {
+      float x = NextFloat(min, max);
+      float y = NextFloat(min, max);
+      float z = NextFloat(min, max);
+      return glm::vec3(x, y, z);
+    }
+    /// This function returns the random point inside the unit sphere
+    glm::vec3 InUnitSphere() {
+      while (true) {
+        glm::vec3 p = NextVec3(-1.0f, 1.0f);
+        if (glm::dot(p, p) < 1.0f)
+          return p;
+      }
+    }
+    /// This function returns the random point on the unit sphere. Unlike 'InUnitSphere' it has no rejection loop,
+    /// so it always uses two random numbers
+    glm::vec3 OnUnitSphere() {
+      float z = NextFloat(-1.0f, 1.0f);
+      float phi = NextFloat() * 6.28318531f;
+      float r = std::sqrt(std::max(1.0f - z * z, 0.0f));
+      return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+
+    /// This function mixes the bits of value (SplitMix64 finalizer)
+    /// - Parameter value: value to be hashed
+    static uint64_t Hash(uint64_t value) {
+      value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9ULL;
+      value = (value ^ (value >> 27)) * 0x94d049bb133111ebULL;
+      return value ^ (value >> 31);
+    }
+
+  private:
+    uint64_t state_ = 0;
+    uint64_t increment_ = 0;
+  };
+
+}
@@ -0,0 +1,66 @@
+//
+//  thread_pool.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+
+namespace ikan {
+  
+  /// This class stores the persistent worker threads to run the parallel loops. It is portable replacement of
+  /// 'dispatch_apply', which is not available out of Apple platforms. Calling thread also takes part in the loop
+  class ThreadPool {
+  public:
+    /// Job of parallel loop. Called with index of loop and index of thread [0, GetNumThreads())
+    using Job = std::function<void(uint32_t index, uint32_t thread_idx)>;
+    
+    /// This constructor creates the worker threads
+    /// - Parameter num_threads: number of threads including the calling thread. 0 for all hardware threads
+    ThreadPool(uint32_t num_threads = 0);
+    /// This destructor joins all the worker threads
+    ~ThreadPool();
+    
+    /// This function runs the job for each index in range [0, count) and waits for all of them to finish.
+    /// Indices are picked in increasing order, so order of indices decides the locality of work
+    /// - Parameters:
+    ///   - count: number of jobs
+    ///   - job: job function
+    void ParallelFor(uint32_t count, const Job& job);
+    
+    /// This function returns the number of threads including the calling thread
+    uint32_t GetNumThreads() const;
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(ThreadPool);
+    
+  private:
+    /// This function is the loop of each worker thread
+    /// - Parameter thread_idx: index of thread
+    void WorkerLoop(uint32_t thread_idx);
+    /// This function runs the jobs of current loop till all indices are picked
+    /// - Parameter thread_idx: index of thread
+    void RunJobs(uint32_t thread_idx);
+    
+    std::vector<std::thread> workers_;
+    
+    std::mutex mutex_;
+    std::condition_variable start_condition_;
+    std::condition_variable finish_condition_;
+    
+    const Job* job_ = nullptr;
+    uint32_t job_count_ = 0;
+    uint64_t generation_ = 0;
+    uint32_t active_workers_ = 0;
+    bool stop_ = false;
+    
+    std::atomic<uint32_t> next_index_ = 0;
+  };
+  
+}
@@ -52,9 +52,11 @@
 #include <core/utils/asset_manager.hpp>
 #include <core/utils/buffers.hpp>
 #include <core/utils/string_utils.hpp>
+#include <core/utils/thread_pool.hpp>
 
 #include <core/math/maths.hpp>
 #include <core/math/uuid.hpp>
+#include <core/math/random_generator.hpp>
 
 #include <core/events/mouse_event.hpp>
 #include <core/events/application_event.hpp>
@@ -101,6 +103,15 @@
 #include <ray_tracing/ray_renderer.hpp>
 #include <ray_tracing/hit_payload.hpp>
 #include <ray_tracing/ray_sphere.hpp>
+#include <ray_tracing/ray_bvh.hpp>
+#include <ray_tracing/ray_sphere_soa.hpp>
+#include <ray_tracing/ray_mesh.hpp>
+#include <ray_tracing/ray_camera.hpp>
+#include <ray_tracing/ray_scene_serializer.hpp>
+#include <ray_tracing/ray_denoiser.hpp>
+#include <ray_tracing/ray_wavefront.hpp>
+#include <ray_tracing/ray_sampler.hpp>
+#include <ray_tracing/ray_checkpoint.hpp>
 
 // Physics
 #include <box2d/box2d.h>
@@ -16,7 +16,9 @@ namespace ikan {
     glm::vec3 world_normal;
     glm::vec3 world_position;
     bool front_face = false;
-    int32_t object_idx = -1;
+    int32_t object_idx = -1; // Id of sphere or mesh instance, as returned by RayScene::GetObjectId()
+    int32_t material_idx = -1;
+    int32_t light_idx = -1; // Index of scene light if surface is emissive
     
     /// This function update the normal direction
     /// - Parameters:
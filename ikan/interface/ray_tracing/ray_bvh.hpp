@@ -0,0 +1,241 @@
+//
+//  ray_bvh.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "ray.hpp"
+#include "ray_sphere.hpp"
+#include "core/utils/thread_pool.hpp"
+
+namespace ikan {
+
+  /// This class stores the Bounding Volume Hierarchy of the ray tracing primitives. Tree is build using the
+  /// binned Surface Area Heuristic and stored as flat array of nodes, where children of a node are always
+  /// stored next to each other. Primitives are never reordered, instead the BVH stores the indices of primitives
+  /// in leaf order.
+  /// When primitives move, the tree can be refit instead of rebuilt : topology is kept and only the bounds of
+  /// nodes are updated. Quality of refit tree is tracked as its SAH cost, so that caller can rebuild when the
+  /// cost grows too much. Tree is never deeper than the traversal stack, node at the depth limit stays a leaf.
+  /// BVH that is marked dirty is not built for any primitives till it is built or refit again.
+  class RayBvh {
+  public:
+    /// Bounding box of one primitive used to build the tree
+    struct Bounds {
+      glm::vec3 min{std::numeric_limits<float>::max()};
+      glm::vec3 max{-std::numeric_limits<float>::max()};
+
+      /// This function grows the bounds to include the point
+      /// - Parameter point: point to be included
+      void Grow(const glm::vec3& point);
+      /// This function grows the bounds to include other bounds
+      /// - Parameter other: bounds to be included
+      void Grow(const Bounds& other);
+      /// This function returns the half surface area of bounds
+      float HalfArea() const;
+      /// This function returns the center of bounds
+      glm::vec3 Center() const;
+    };
+
+    /// Node of the BVH tree (32 Bytes, 2 nodes per cache line)
+    struct Node {
+      glm::vec3 aabb_min;
+      uint32_t left_first = 0; // Index of left child if interior node, else index of first primitive
+      glm::vec3 aabb_max;
+      uint32_t count = 0;      // Number of primitives. 0 for interior node
+
+      /// This function returns true if node is leaf
+      bool IsLeaf() const { return count > 0; }
+    };
+
+    static constexpr uint32_t kNumBins = 12;
+    static constexpr uint32_t kMaxLeafSize = 8;
+    static constexpr float kTraversalCost = 1.0f; // Cost of visiting node relative to one primitive test
+    static constexpr uint32_t kMaxStackSize = 64; // Also the maximum depth of tree
+    static constexpr uint32_t kInvalidNode = std::numeric_limits<uint32_t>::max();
+
+    /// Default constructor
+    RayBvh() = default;
+
+    /// This function builds the BVH from the bounds of primitives
+    /// - Parameter primitive_bounds: bounds of each primitive
+    void Build(const std::vector<Bounds>& primitive_bounds);
+    /// This function builds the BVH over the spheres
+    /// - Parameter spheres: spheres of the scene
+    void Build(const std::vector<RaySphere>& spheres);
+    /// This function clears the BVH data
+    void Clear();
+    /// This function updates the bounds of nodes after primitives changed, without changing the tree. If many
+    /// primitives changed, all the nodes are refit bottom up one level at a time, and each level in parallel. Else
+    /// only the ancestors of changed primitives are refit
+    /// - Parameters:
+    ///   - primitive_bounds: bounds of each primitive. Number of primitives should be same as of build
+    ///   - changed_primitives: indices of primitives whose bounds changed
+    ///   - thread_pool: thread pool for parallel refit. Refit is serial if null
+    void Refit(const std::vector<Bounds>& primitive_bounds,
+               const std::vector<uint32_t>& changed_primitives,
+               ThreadPool* thread_pool = nullptr);
+    /// This function marks the BVH out of date with its primitives. Call it after moving or resizing the
+    /// primitives. 'IsBuilt()' returns false till the next build or refit
+    void MarkDirty();
+
+    /// This function finds the closest sphere hit by the ray
+    /// - Parameters:
+    ///   - ray: ray to be traced
+    ///   - spheres: spheres used to build the BVH
+    ///   - hit_distance: closest hit distance (input is max distance to be checked)
+    ///   - object_idx: closest sphere index output
+    bool Intersect(const Ray& ray,
+                   const std::vector<RaySphere>& spheres,
+                   float& hit_distance,
+                   int32_t& object_idx) const;
+
+    /// This function traverse the tree front to back and calls leaf function for each leaf hit by the ray. Leaf
+    /// function should update the hit distance with closest hit, nodes farther than hit distance are skipped.
+    /// - Parameters:
+    ///   - ray: ray to be traced
+    ///   - hit_distance: closest hit distance
+    ///   - leaf_func: function called with first primitive and number of primitives of leaf
+    template<typename LeafFunc>
+    void Traverse(const Ray& ray, float& hit_distance, LeafFunc&& leaf_func) const;
+
+    // ----------------------
+    // Getters
+    // ----------------------
+    /// This function returns the nodes of the BVH
+    const std::vector<Node>& GetNodes() const;
+    /// This function returns the primitive indices in leaf order
+    const std::vector<uint32_t>& GetPrimitiveIndices() const;
+    /// This function returns the number of primitives used to build the BVH
+    uint32_t GetPrimitiveCount() const;
+    /// This function returns true if BVH is build for 'num_primitives' primitives and is not marked dirty after
+    /// - Parameter num_primitives: number of primitives in scene
+    bool IsBuilt(size_t num_primitives) const;
+    /// This function returns true if BVH is marked dirty after its last build or refit
+    bool IsDirty() const;
+    /// This function returns the index of primitive in leaf order
+    /// - Parameter primitive_idx: index of primitive
+    uint32_t GetPrimitiveSlot(uint32_t primitive_idx) const;
+    /// This function returns the SAH cost of tree relative to the area of root. Cost grows when refit nodes
+    /// overlap more
+    float GetCost() const;
+    /// This function returns the SAH cost of tree right after the last build
+    float GetBuildCost() const;
+
+    /// This function returns the bounds of sphere
+    /// - Parameter sphere: sphere
+    static Bounds GetBounds(const RaySphere& sphere);
+
+    /// This function returns the distance of ray entering the aabb. returns float max if ray misses the aabb
+    /// - Parameters:
+    ///   - origin: ray origin
+    ///   - inv_direction: reciprocal of ray direction
+    ///   - node: node of tree
+    ///   - hit_distance: closest hit distance
+    static float IntersectAABB(const glm::vec3& origin,
+                               const glm::vec3& inv_direction,
+                               const Node& node,
+                               float hit_distance);
+
+    DEFINE_COPY_MOVE_CONSTRUCTORS(RayBvh);
+
+  private:
+    /// This function updates the bounds of node from its primitives
+    /// - Parameters:
+    ///   - node_idx: node index
+    ///   - primitive_bounds: bounds of each primitive
+    void UpdateNodeBounds(uint32_t node_idx, const std::vector<Bounds>& primitive_bounds);
+    /// This function updates the bounds of node from its primitives if leaf, else from its children
+    /// - Parameters:
+    ///   - node_idx: node index
+    ///   - primitive_bounds: bounds of each primitive
+    void RefitNode(uint32_t node_idx, const std::vector<Bounds>& primitive_bounds);
+    /// This function returns the SAH cost of node, not normalised by root area
+    /// - Parameter node: node of tree
+    static float GetNodeCost(const Node& node);
+    /// This function stores the parent, depth order and primitive leaves of the built tree, used by refit
+    void BuildRefitData();
+    /// This function finds the best split plane of node using binned SAH. Returns cost of split
+    /// - Parameters:
+    ///   - node: node to be splitted
+    ///   - centroids: centroid of each primitive
+    ///   - primitive_bounds: bounds of each primitive
+    ///   - axis: best axis output
+    ///   - split_position: best split position output
+    float FindBestSplit(const Node& node,
+                        const std::vector<glm::vec3>& centroids,
+                        const std::vector<Bounds>& primitive_bounds,
+                        int32_t& axis,
+                        float& split_position) const;
+
+    std::vector<Node> nodes_;
+    std::vector<uint32_t> primitive_indices_;
+
+    // Refit data
+    std::vector<uint32_t> parent_indices_; // kInvalidNode for root
+    std::vector<uint32_t> primitive_leaves_; // Leaf node of each primitive
+    std::vector<uint32_t> primitive_slots_; // Index of each primitive in leaf order
+    std::vector<uint32_t> level_nodes_; // Node indices ordered by depth
+    std::vector<uint32_t> level_offsets_; // First entry of each depth in level nodes, and end
+    std::vector<uint32_t> refit_nodes_; // Nodes to be refit by partial refit
+    std::vector<uint8_t> refit_flags_; // Nodes already added to refit nodes
+    float sah_cost_ = 0.0f; // Sum of cost of nodes, not normalised
+    float build_cost_ = 0.0f;
+    bool dirty_ = false; // Primitives changed after last build or refit
+  };
+
+  template<typename LeafFunc>
+  void RayBvh::Traverse(const Ray& ray, float& hit_distance, LeafFunc&& leaf_func) const {
+    if (nodes_.empty())
+      return;
+
+    const glm::vec3 inv_direction = 1.0f / ray.direction;
+    if (IntersectAABB(ray.origin, inv_direction, nodes_[0], hit_distance) == std::numeric_limits<float>::max())
+      return;
+
+    // Stack stores the node index with the entry distance, so that node farther than the closest hit found
+    // after pushing it can be skipped without testing its bounds again
+    struct StackEntry { uint32_t node_idx; float distance; };
+    StackEntry stack[kMaxStackSize];
+    uint32_t stack_ptr = 0;
+    stack[stack_ptr++] = { 0, 0.0f };
+
+    while (stack_ptr > 0) {
+      StackEntry entry = stack[--stack_ptr];
+      if (entry.distance >= hit_distance)
+        continue;
+
+      const Node* node = &nodes_[entry.node_idx];
+      while (!node->IsLeaf()) {
+        const Node* child_1 = &nodes_[node->left_first];
+        const Node* child_2 = &nodes_[node->left_first + 1];
+        float dist_1 = IntersectAABB(ray.origin, inv_direction, *child_1, hit_distance);
+        float dist_2 = IntersectAABB(ray.origin, inv_direction, *child_2, hit_distance);
+
+        // Visit the nearer child first
+        if (dist_1 > dist_2) {
+          std::swap(dist_1, dist_2);
+          std::swap(child_1, child_2);
+        }
+
+        if (dist_1 == std::numeric_limits<float>::max()) {
+          node = nullptr;
+          break;
+        }
+        if (dist_2 != std::numeric_limits<float>::max()) {
+          // Build limits the depth of tree to stack size, and one entry is pushed per level at most
+          IK_ASSERT(stack_ptr < kMaxStackSize, "BVH traversal stack overflow");
+          stack[stack_ptr++] = { uint32_t(child_2 - nodes_.data()), dist_2 };
+        }
+        node = child_1;
+      }
+
+      if (node)
+        leaf_func(node->left_first, node->count);
+    }
+  }
+
+}
@@ -0,0 +1,74 @@
+//
+//  ray_camera.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+namespace ikan {
+  
+  /// This class is the pin hole camera used by ray renderer without editor. It does not depend on window, events
+  /// or graphics context so it can be used to render the scene offline (headless). Camera only stores the
+  /// matrices, ray renderer generates the rays of each pixel from them
+  class RayCamera {
+  public:
+    /// This constructor creates the ray camera
+    /// - Parameters:
+    ///   - fov: vertical FOV of the camera in radians
+    ///   - near_plane: Near plane of camera
+    ///   - far_plane: far plane of camera
+    RayCamera(float fov = glm::radians(45.0f), float near_plane = 0.1f, float far_plane = 100.0f);
+    
+    /// This function places the camera at position looking at target
+    /// - Parameters:
+    ///   - position: position of camera
+    ///   - target: point camera is looking at
+    ///   - up: up direction of world
+    void LookAt(const glm::vec3& position, const glm::vec3& target, const glm::vec3& up = glm::vec3(0.0f, 1.0f, 0.0f));
+    /// This function updates the vertical FOV of camera
+    /// - Parameter fov: vertical FOV in radians
+    void SetFOV(float fov);
+    /// This function updates the viewport size of camera
+    /// - Parameters:
+    ///   - width: New width
+    ///   - height: new height
+    void SetViewportSize(uint32_t width, uint32_t height);
+    
+    // ---------------
+    // Getters
+    // ---------------
+    /// This function returns the Position of camera
+    const glm::vec3& GetPosition() const;
+    /// This function returns the target of camera
+    const glm::vec3& GetTarget() const;
+    /// This function returns the vertical FOV of camera in radians
+    float GetFOV() const;
+    /// This function returns the inverse of view matrix
+    const glm::mat4& GetInverseView() const;
+    /// This function returns the inverse of projection matrix
+    const glm::mat4& GetInverseProjection() const;
+    /// This function returns the camera viewport width
+    uint32_t GetViewportWidth() const;
+    /// This function returns the camera viewport height
+    uint32_t GetViewportHeight() const;
+    
+  private:
+    /// This function updates the camera projection matrix
+    void UpdateProjection();
+    
+    float fov_ = glm::radians(45.0f);
+    float near_plane_ = 0.1f, far_plane_ = 100.0f;
+    
+    glm::vec3 position_ = glm::vec3(0.0f, 0.0f, 6.0f);
+    glm::vec3 target_ = glm::vec3(0.0f);
+    glm::vec3 up_ = glm::vec3(0.0f, 1.0f, 0.0f);
+    
+    glm::mat4 inverse_view_ = glm::mat4(1.0f);
+    glm::mat4 inverse_projection_ = glm::mat4(1.0f);
+    
+    uint32_t viewport_width_ = 0, viewport_height_ = 0;
+  };
+  
+}
@@ -0,0 +1,118 @@
+//
+//  ray_checkpoint.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+namespace ikan {
+
+  /// This class reads and writes the checkpoint of accumulated ray traced image. Checkpoint is a binary file in
+  /// native byte order : header, state of each tile and the accumulation buffers without row padding. Buffers store
+  /// the sums of samples, so partial renders of the same view are merged by adding them. File is memory mapped on
+  /// open, so only the pages that are read are loaded.
+  class RayCheckpoint {
+  public:
+    /// Render state of checkpoint. Estimator fields are applied to renderer on resume, so that the new samples
+    /// continue the same sequences
+    struct Header {
+      uint32_t magic = 0;
+      uint32_t version = 0;
+      uint32_t width = 0, height = 0;
+      uint32_t tile_size = 0, num_tiles = 0;
+      uint32_t frame_index = 1;
+
+      // Estimator
+      uint32_t seed = 0;
+      uint32_t sampler = 0;
+      uint32_t max_depth = 0;
+      uint32_t russian_roulette = 0;
+      uint32_t russian_roulette_depth = 0;
+      uint32_t next_event_estimation = 0;
+
+      // Camera rays of last frame (origin, direction of pixel (0, 0) and its change for one pixel)
+      glm::vec3 origin = glm::vec3(0.0f);
+      glm::vec3 corner = glm::vec3(0.0f);
+      glm::vec3 step_x = glm::vec3(0.0f);
+      glm::vec3 step_y = glm::vec3(0.0f);
+    };
+    /// Adaptive sampling state of one tile
+    struct TileRecord {
+      uint32_t x = 0, y = 0;
+      uint32_t width = 0, height = 0;
+      uint32_t total_samples = 0;
+      uint32_t num_samples = 1;
+      uint32_t min_pixel_samples = 0;
+      uint32_t num_frames = 0;
+      float error = std::numeric_limits<float>::max();
+      uint32_t converged = 0;
+    };
+    /// Accumulation buffers of image. Each row starts 'stride' pixels after the previous one
+    struct Buffers {
+      const glm::vec4* accumulation = nullptr; // Sum of color, alpha is number of samples
+      const glm::vec4* albedo = nullptr;
+      const glm::vec4* normal_depth = nullptr;
+      const float* luminance_sq = nullptr;
+      uint32_t stride = 0;
+    };
+
+    /// Default constructor
+    RayCheckpoint() = default;
+    /// This destructor unmaps the file
+    ~RayCheckpoint();
+
+    /// This function maps the checkpoint file in memory and validates its header and size. Returns false if file
+    /// can not be opened or is not a valid checkpoint
+    /// - Parameter file_path: path of checkpoint file
+    bool Open(const std::string& file_path);
+    /// This function unmaps the file
+    void Close();
+
+    // ----------------------
+    // Getters
+    // ----------------------
+    /// This function returns the header of opened checkpoint
+    const Header& GetHeader() const;
+    /// This function returns the tiles of opened checkpoint (header.num_tiles entries)
+    const TileRecord* GetTiles() const;
+    /// This function returns the buffers of opened checkpoint. Pointers are into the mapped file, valid till close
+    const Buffers& GetBuffers() const;
+
+    // ----------------------
+    // Static API
+    // ----------------------
+    /// This function writes the checkpoint. File is written next to the path and renamed at the end, so that
+    /// a crash while writing never leaves a broken checkpoint behind
+    /// - Parameters:
+    ///   - file_path: path of checkpoint file
+    ///   - header: header (magic and version are filled)
+    ///   - tiles: state of tiles
+    ///   - buffers: accumulation buffers
+    static bool Write(const std::string& file_path,
+                      Header header,
+                      const std::vector<TileRecord>& tiles,
+                      const Buffers& buffers);
+    /// This function merges the checkpoints of independent renders of the same view into one, as if all their
+    /// samples were traced by one render. Sums of samples are added, so each pixel is weighted by its sample
+    /// count. Renders must have same size, tiles, camera and estimator, and different seed
+    /// - Parameters:
+    ///   - input_paths: paths of checkpoints to be merged
+    ///   - output_path: path of merged checkpoint
+    static bool Merge(const std::vector<std::string>& input_paths, const std::string& output_path);
+
+    static constexpr uint32_t kMagic = 0x54524b49; // "IKRT"
+    static constexpr uint32_t kVersion = 1;
+
+    DELETE_COPY_MOVE_CONSTRUCTORS(RayCheckpoint);
+
+  private:
+    void* mapped_data_ = nullptr;
+    size_t mapped_size_ = 0;
+    const Header* header_ = nullptr;
+    const TileRecord* tiles_ = nullptr;
+    Buffers buffers_;
+  };
+
+}
@@ -0,0 +1,104 @@
+//
+//  ray_denoiser.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "core/utils/thread_pool.hpp"
+
+namespace ikan {
+  
+  /// This class removes the noise of path traced image using the edge avoiding A-Trous wavelet filter. Filter is
+  /// guided by albedo, normal and depth of first hit so that edges of geometry stay sharp. Color is divided by
+  /// albedo before filtering, so that textures are not blurred with the lighting.
+  /// Buffers are stored as planes of floats, so that inner loop of filter runs on continuous memory.
+  class RayDenoiser {
+  public:
+    struct Setting {
+      uint32_t iterations = 5; // Filter size grows as 2^iteration
+      float color_sigma = 0.5f; // Halved for each iteration, as noise reduces after each pass
+      float normal_sigma = 0.3f;
+      float depth_sigma = 0.1f; // Relative to depth of pixel
+      
+      bool operator==(const Setting& other) const = default;
+    };
+    
+    /// Depth stored for the pixels that hit nothing
+    static constexpr float kSkyDepth = 1e6f;
+    
+    /// Default constructor
+    RayDenoiser() = default;
+    
+    /// This function resizes the buffers
+    /// - Parameters:
+    ///   - width: width of image
+    ///   - height: height of image
+    void Resize(uint32_t width, uint32_t height);
+    /// This function runs the filter on input pixels
+    /// - Parameters:
+    ///   - thread_pool: thread pool to filter the rows in parallel
+    ///   - setting: filter setting
+    void Denoise(ThreadPool& thread_pool, const Setting& setting);
+    
+    /// This function stores the input pixel
+    /// - Parameters:
+    ///   - pixel_idx: index of pixel
+    ///   - color: noisy color
+    ///   - albedo: albedo of first hit
+    ///   - normal: world normal of first hit
+    ///   - depth: distance of first hit
+    void SetPixel(uint32_t pixel_idx, const glm::vec3& color, const glm::vec3& albedo, const glm::vec3& normal, float depth) {
+      for (int32_t c = 0; c < 3; c++) {
+        // Lighting is filtered without albedo and multiplied again in output
+        float safe_albedo = std::max(albedo[c], kMinAlbedo);
+        color_[c][pixel_idx] = color[c] / safe_albedo;
+        albedo_[c][pixel_idx] = safe_albedo;
+        normal_[c][pixel_idx] = normal[c];
+      }
+      depth_[pixel_idx] = depth;
+    }
+    /// This function returns the denoised pixel
+    /// - Parameter pixel_idx: index of pixel
+    glm::vec3 GetPixel(uint32_t pixel_idx) const {
+      return glm::vec3(output_[0][pixel_idx] * albedo_[0][pixel_idx],
+                       output_[1][pixel_idx] * albedo_[1][pixel_idx],
+                       output_[2][pixel_idx] * albedo_[2][pixel_idx]);
+    }
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(RayDenoiser);
+    
+  private:
+    static constexpr float kMinAlbedo = 0.01f;
+    
+    /// This function runs one iteration of filter on a row
+    /// - Parameters:
+    ///   - y: row index
+    ///   - step: distance between taps of filter
+    ///   - setting: filter setting
+    ///   - inv_color_sigma_sq: inverse of squared color sigma of this iteration
+    ///   - src: source planes
+    ///   - dst: destination planes
+    ///   - scratch: scratch memory of 5 rows
+    void FilterRow(uint32_t y,
+                   uint32_t step,
+                   const Setting& setting,
+                   float inv_color_sigma_sq,
+                   const float* const src[3],
+                   float* const dst[3],
+                   float* scratch) const;
+    
+    uint32_t width_ = 0, height_ = 0;
+    
+    float* output_[3] = { nullptr, nullptr, nullptr }; // Points to the planes of last iteration
+    std::vector<float> color_[3];
+    std::vector<float> temp_[3];
+    std::vector<float> albedo_[3];
+    std::vector<float> normal_[3];
+    std::vector<float> depth_;
+    std::vector<float> scratch_; // 5 rows per thread
+  };
+  
+}
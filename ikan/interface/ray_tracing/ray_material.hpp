@@ -9,12 +9,13 @@
 
 #include "ray.hpp"
 #include "hit_payload.hpp"
+#include "ray_sampler.hpp"
 
 namespace ikan {
   
   struct RayMaterial {
     enum class Type : uint8_t {
-      None, Metal, Lambertian, Dielectric
+      None, Metal, Lambertian, Dielectric, Emissive
     };
     
     glm::vec3 albedo;
@@ -26,14 +27,22 @@ namespace ikan {
     // dielectric prop
     float refractive_index = 0.1;
     
+    // emissive prop : emitted radiance is albedo times intensity. Emissive surface does not scatter
+    float intensity = 1.0f;
+    
+    /// This function returns the radiance emitted by the material. Zero for other than emissive material
+    glm::vec3 GetEmission() const;
+    
     /// This function scatters the ray based on the material property
     /// - Parameters:
     ///   - ray_in: current ray
     ///   - payload: hit payload
+    ///   - sampler: sampler of the bounce
     ///   - attenuation: output color
     ///   - scattered_ray: output ray
     bool Scatter(const Ray& ray_in,
                  const HitPayload& payload,
+                 RaySampler& sampler,
                  glm::vec3& attenuation,
                  Ray& scattered_ray) const;
     
@@ -50,30 +59,36 @@ namespace ikan {
     /// - Parameters:
     ///   - ray_in: current ray
     ///   - payload: hit payload
+    ///   - sampler: sampler of the bounce
     ///   - attenuation: output color
     ///   - scattered_ray: output ray
     bool ScatterMatelic(const Ray& ray_in,
                         const HitPayload& payload,
+                        RaySampler& sampler,
                         glm::vec3& attenuation,
                         Ray& scattered_ray) const;
     /// This function scatters the ray For lambertian
     /// - Parameters:
     ///   - ray_in: current ray
     ///   - payload: hit payload
+    ///   - sampler: sampler of the bounce
     ///   - attenuation: output color
     ///   - scattered_ray: output ray
     bool ScatterLambertian(const Ray& ray_in,
                            const HitPayload& payload,
+                           RaySampler& sampler,
                            glm::vec3& attenuation,
                            Ray& scattered_ray) const;
     /// This function scatters the ray For Dielectric
     /// - Parameters:
     ///   - ray_in: current ray
     ///   - payload: hit payload
+    ///   - sampler: sampler of the bounce
     ///   - attenuation: output color
     ///   - scattered_ray: output ray
     bool ScatterDielectric(const Ray& ray_in,
                            const HitPayload& payload,
+                           RaySampler& sampler,
                            glm::vec3& attenuation,
                            Ray& scattered_ray) const;
   };
@@ -0,0 +1,99 @@
+//
+//  ray_mesh.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "ray_bvh.hpp"
+#include "ray_sphere_soa.hpp"
+
+namespace ikan {
+
+  /// This class stores the triangle mesh with its own BVH (bottom level acceleration structure). Mesh is defined
+  /// in object space and placed in scene by instances, so one mesh can be drawn many times without copying its
+  /// triangles. Vertices of triangles are stored in BVH leaf order as Structure of Arrays, so that 4 triangles of
+  /// a leaf are tested at once.
+  class RayMesh {
+  public:
+    std::vector<glm::vec3> positions;
+    std::vector<uint32_t> indices; // 3 vertex indices for each triangle
+    std::string file_path; // Source file of mesh, if loaded from file
+
+    /// Default constructor
+    RayMesh() = default;
+
+    /// This function loads the positions and faces of Wavefront OBJ file. Polygons are triangulated as fan.
+    /// Texture coordinates, normals and materials of file are ignored
+    /// - Parameter file_path: path of OBJ file
+    bool LoadObj(const std::string& file_path);
+    /// This function builds the BVH and triangle arrays. Call it after editing the positions or indices
+    void Build();
+    /// This function clears the mesh data
+    void Clear();
+
+    /// This function finds the closest triangle hit by the ray. Intersection is watertight : ray passing through
+    /// the shared edge or vertex of triangles always hits one of them
+    /// - Parameters:
+    ///   - ray: ray in object space of mesh. Direction need not to be normalised
+    ///   - kernel: kernel used to intersect the triangles of BVH leaves (8 wide kernel uses 4 wide)
+    ///   - hit_distance: closest hit distance (input is max distance to be checked)
+    ///   - triangle_idx: closest triangle index output
+    bool Intersect(const Ray& ray, RaySphereSoA::Kernel kernel, float& hit_distance, uint32_t& triangle_idx) const;
+
+    // ----------------------
+    // Getters
+    // ----------------------
+    /// This function returns the object space normal of triangle. Normal follows the counter clockwise winding
+    /// - Parameter triangle_idx: index of triangle
+    const glm::vec3& GetNormal(uint32_t triangle_idx) const;
+    /// This function returns the object space bounds of mesh
+    RayBvh::Bounds GetBounds() const;
+    /// This function returns the number of triangles
+    uint32_t GetNumTriangles() const;
+    /// This function returns true if mesh is built after last edit
+    bool IsBuilt() const;
+
+    DEFINE_COPY_MOVE_CONSTRUCTORS(RayMesh);
+
+  private:
+    /// Per ray data of watertight intersection. Ray is sheared so that it points along +z of a permuted space
+    struct WatertightRay {
+      int32_t kx = 0, ky = 1, kz = 2; // Permutation of axes, kz is the largest component of direction
+      float shear_x = 0.0f, shear_y = 0.0f, shear_z = 1.0f;
+      glm::vec3 origin;
+
+      /// This constructor computes the permutation and shear of ray
+      /// - Parameter ray: ray to be traced
+      WatertightRay(const Ray& ray);
+    };
+
+    bool IntersectScalar(const WatertightRay& ray, uint32_t first, uint32_t count, float& hit_distance, uint32_t& triangle_idx) const;
+    bool IntersectSimd4(const WatertightRay& ray, uint32_t first, uint32_t count, float& hit_distance, uint32_t& triangle_idx) const;
+
+    RayBvh bvh_;
+
+    // Triangle vertices in BVH leaf order, padded with degenerate triangles to SIMD width
+    std::vector<float> vertex_0_[3];
+    std::vector<float> vertex_1_[3];
+    std::vector<float> vertex_2_[3];
+    std::vector<uint32_t> triangle_indices_; // Index of triangle in mesh for each slot
+    std::vector<glm::vec3> normals_; // Normal of each triangle, in mesh order
+    uint32_t num_triangles_ = 0;
+  };
+
+  /// Instance of mesh in the ray scene
+  struct RayMeshInstance {
+    uint32_t mesh_index = 0;
+    int32_t material_index = 0;
+    glm::vec3 position = glm::vec3(0.0f);
+    glm::vec3 rotation = glm::vec3(0.0f); // Euler angles in radians
+    glm::vec3 scale = glm::vec3(1.0f);
+
+    /// This function returns the object to world transform of instance
+    glm::mat4 GetTransform() const;
+  };
+
+}
@@ -8,28 +8,152 @@
 #pragma once
 
 #include "ray_scene.hpp"
+#include "ray_camera.hpp"
+#include "ray_denoiser.hpp"
+#include "ray_wavefront.hpp"
+#include "ray_checkpoint.hpp"
+#include "core/utils/thread_pool.hpp"
+#include <deque>
+
+// Headless build (IK_HEADLESS) has no graphics context, so renderer has no GPU image and no editor camera
+#ifndef IK_HEADLESS
 #include "renderer/graphics/texture.hpp"
 #include "camera/editor_camera.hpp"
+#endif
 
 namespace ikan {
+  
+#ifdef IK_HEADLESS
+  class Image;
+#endif
     
   class RayRenderer {
   public:
+    /// Integrator used to trace the paths
+    enum class Integrator : uint8_t {
+      Megakernel, Wavefront
+    };
+    
     struct Setting {
       bool accumulate = true;
       bool render = true;
+      
+      /// Megakernel traces each path to the end before starting next one. Wavefront advances all the paths of a tile
+      /// one bounce at a time and shades them in per material type queues
+      Integrator integrator = Integrator::Megakernel;
+      
+      /// Kernel used to intersect the spheres of BVH leaves. Can be changed at runtime to compare throughput
+      RaySphereSoA::Kernel sphere_kernel = RaySphereSoA::GetBestKernel();
+      
+      /// Size of square tile in pixels rendered by one worker at a time. Rounded up to multiple of pixels per
+      /// cache line of image buffer
+      uint32_t tile_size = 32;
+      
+      /// Seed of random generator. Two renders with same seed produce same image
+      uint32_t seed = 0;
+      /// Sequence of random numbers of paths. Owen scrambled Sobol converges faster than independent random numbers,
+      /// blue noise has same error spread as high frequency noise over the screen
+      RaySampler::Type sampler = RaySampler::Type::Sobol;
+      
+      /// Maximum number of rays traced for one path (camera ray and bounces)
+      uint32_t max_depth = 10;
+      /// Terminate the paths randomly based on their throughput after 'russian_roulette_depth' bounces. Surviving
+      /// paths are reweighted, so the converged image does not change
+      bool russian_roulette = true;
+      uint32_t russian_roulette_depth = 3;
+      
+      /// Sample the emissive spheres and triangles directly from diffuse surfaces with shadow rays, and combine it
+      /// with BSDF sampling by multiple importance sampling. Small bright lights converge in a fraction of samples
+      bool next_event_estimation = true;
+      
+      /// Track the variance of each pixel and stop sampling the tiles whose relative error is below threshold.
+      /// Samples saved by converged tiles are given to the noisy tiles in next frames. Off by default, so that every
+      /// pixel gets the same samples unless the caller opts in
+      bool adaptive_sampling = false;
+      float adaptive_threshold = 0.02f;
+      uint32_t adaptive_min_samples = 16; // Samples per pixel before a tile can be converged
+      uint32_t adaptive_max_samples = 8; // Maximum samples per pixel of a tile in one frame
+      /// Debug view : show the number of samples spent on each pixel instead of color (blue : few, red : most)
+      bool show_sample_heatmap = false;
+      
+      /// Filter the accumulated image using albedo, normal and depth of first hit. Gives clean preview at few
+      /// samples per pixel
+      bool denoise = false;
+      RayDenoiser::Setting denoiser;
+      
+      /// Keep the accumulated samples when camera moves. History of each pixel is fetched from previous frame at
+      /// the first hit of its new sample, and rejected if previous frame saw a different surface there. Camera moves
+      /// are detected by renderer, so application should not reset the frame index on camera move in this mode
+      bool temporal_reprojection = false;
+      float reprojection_depth_tolerance = 0.05f; // Relative difference of depth to accept the history
+      uint32_t reprojection_max_samples = 32; // History is reduced to this many samples, so that old frames fade out
+      
+      /// Render at reduced resolution (1/4 or 1/16 of pixels, or less) while camera moves, and upscale it to the
+      /// image. Resolution is chosen so that the frame takes about 'target_frame_time_ms', and is refined to full
+      /// resolution in next frames after the camera stops
+      bool interactive_preview = false;
+      float target_frame_time_ms = 16.0f;
+      
+      /// Trace the frames on background thread, which keeps accumulating across the calls of 'Render()'. Render
+      /// call never waits for tracing : it only uploads the tiles finished since last call, till the upload takes
+      /// 'frame_budget_ms'. Rest of the tiles are uploaded in next calls. Scene is read by background thread, so
+      /// call 'StopAsyncRender()' before changing it
+      bool async_render = false;
+      float frame_budget_ms = 4.0f;
+      /// Stop accumulating after these many frames. 0 for no limit
+      uint32_t max_frames = 0;
+      
+      bool operator==(const Setting& other) const = default;
     };
     
-    /// Default destructor
-    RayRenderer() = default;
+    /// Statistics of last rendered frame
+    struct Statistics {
+      uint64_t num_rays = 0; // Number of rays traced (camera rays and bounces)
+      uint64_t num_paths = 0;
+      uint64_t num_roulette_terminations = 0; // Number of paths terminated by russian roulette
+      float average_path_length = 0.0f; // Average number of rays traced per path
+      uint32_t num_converged_tiles = 0;
+      float render_time_ms = 0.0f;
+      uint32_t preview_scale = 1; // Pixels per side of one traced pixel. 1 for full resolution frame
+      uint32_t num_accumulated_frames = 0; // Frames accumulated since last reset
+      
+      // Asynchronous render : work of last 'Render()' call on calling thread, and finished tiles left for next calls
+      float upload_time_ms = 0.0f;
+      uint32_t num_uploaded_tiles = 0;
+      uint32_t num_pending_tiles = 0;
+      
+      // Dirty region of last edit : tiles and pixels whose accumulation was restarted by 'InvalidateObjects()'
+      uint32_t num_invalidated_tiles = 0;
+      uint64_t num_invalidated_pixels = 0;
+    };
+    
+    /// Rectangle of pixels of image
+    struct Region {
+      uint32_t x = 0, y = 0;
+      uint32_t width = 0, height = 0;
+    };
+    
+    /// This constructor creates the ray renderer
+    /// - Parameter headless: if true, no GPU image is created and result is only available in CPU memory. Use it to
+    ///                       render without window or graphics context
+    RayRenderer(bool headless = false);
+    /// This destructor deletes the image buffers
+    ~RayRenderer();
     
     DELETE_COPY_MOVE_CONSTRUCTORS(RayRenderer)
     
+#ifndef IK_HEADLESS
     /// This function renders the scene using editor camera
     /// - Parameters:
     ///   - scene: scene reference
     ///   - camera: editor camera reference
     void Render(const RayScene& scene, const EditorCamera& camera);
+#endif
+    /// This function renders the scene using ray camera
+    /// - Parameters:
+    ///   - scene: scene reference
+    ///   - camera: ray camera reference
+    void Render(const RayScene& scene, const RayCamera& camera);
     /// This function resize the rendere
     /// - Parameters:
     ///   - width: view port width
@@ -37,22 +161,252 @@ namespace ikan {
     void Resize(uint32_t width, uint32_t height);
     /// This function reset the accumulation
     void ResetFrameIndex();
+    /// This function restarts the accumulation of the pixels influenced by the objects and keeps the samples of
+    /// rest of the image. Use it after editing the material of objects. Pixels that see the object directly are
+    /// restarted, and whole tiles whose paths bounced off it. Applied at the start of next frame
+    /// - Note: Only appearance is tracked. Moving, adding or removing the objects changes the shadows and needs
+    ///         'ResetFrameIndex()'
+    /// - Parameter object_ids: ids of edited objects, as returned by 'RayScene::GetObjectId()'
+    void InvalidateObjects(const std::vector<uint32_t>& object_ids);
+    /// This function restarts the accumulation of the pixels influenced by the objects using the material. Light of
+    /// emissive material reaches the pixels by shadow rays, which are not tracked, so its edit resets the accumulation
+    /// - Parameters:
+    ///   - scene: scene of material
+    ///   - material_idx: index of edited material
+    void InvalidateMaterial(const RayScene& scene, uint32_t material_idx);
+    /// This function updates the image from accumulated samples without tracing any ray. Use it to apply the
+    /// change of debug view when rendering is stopped
+    void ResolveImage();
+    /// This function stops the background render of asynchronous mode and waits for the tiles in progress. Image
+    /// gets the last traced samples. Next 'Render()' call restarts it
+    void StopAsyncRender();
+    /// This function writes the accumulated samples, frame index, state of tiles and estimator setting (sampler,
+    /// seed, path options) to checkpoint file. Stops the background render of asynchronous mode
+    /// - Parameter file_path: path of checkpoint file
+    bool SaveCheckpoint(const std::string& file_path);
+    /// This function resumes the render of checkpoint file. Image is resized to its size, its estimator setting is
+    /// applied and next frames continue the accumulation exactly where it stopped. Render it with the camera of
+    /// saved render. Returns false if file is not a valid checkpoint
+    /// - Parameter file_path: path of checkpoint file
+    bool LoadCheckpoint(const std::string& file_path);
+    /// This function traces the samples [first_sample, first_sample + num_samples) of each pixel of region. They are
+    /// the same samples that a render reaching them would trace, so regions and sample ranges traced by many
+    /// renderers (or processes) add up to the image of one render. Accumulation of renderer is reset. Adaptive
+    /// sampling and denoiser are not used
+    /// - Parameters:
+    ///   - scene: scene reference
+    ///   - camera: ray camera reference
+    ///   - region: pixels to be traced, inside the image
+    ///   - first_sample: index of first sample of each pixel, 0 for first sample of render
+    ///   - num_samples: samples per pixel
+    /// - Returns: sums of samples of region, pointing to its first pixel. Valid till next render
+    RayCheckpoint::Buffers TraceRegion(const RayScene& scene,
+                                       const RayCamera& camera,
+                                       const Region& region,
+                                       uint32_t first_sample,
+                                       uint32_t num_samples);
+    /// This function adds the samples of region traced by 'TraceRegion()' of other renderer to the accumulation.
+    /// Accumulation is restarted if it was reset or camera is different. Call 'ResolveImage()' to see the samples
+    /// - Parameters:
+    ///   - camera: ray camera of samples
+    ///   - region: pixels of samples, inside the image
+    ///   - samples: sums of samples, pointing to first pixel of region
+    void AccumulateRegion(const RayCamera& camera, const Region& region, const RayCheckpoint::Buffers& samples);
 
     // ----------------------
     // Getters
     // ----------------------
-    /// This function returns the image pointer
+    /// This function returns the image pointer. nullptr for headless renderer
     std::shared_ptr<Image> GetFinalImage() const;
+    /// This function returns the RGBA8 pixels of last rendered frame, first row is bottom of the image. In
+    /// asynchronous mode it has the tiles uploaded till now
+    const uint32_t* GetImageData() const;
+    /// This function returns the width of image
+    uint32_t GetWidth() const;
+    /// This function returns the height of image
+    uint32_t GetHeight() const;
+    /// This function returns the statistics of last rendered frame
+    const Statistics& GetStatistics() const;
     /// This function returns the setting reference
     Setting& GetSetting();
     
+    /// This function returns the integrator name
+    /// - Parameter integrator: integrator type
+    static const char* GetIntegratorName(Integrator integrator);
+    
   private:
+    /// Rectangle of pixels rendered by one worker
+    struct Tile {
+      uint32_t x = 0, y = 0;
+      uint32_t width = 0, height = 0;
+      
+      // Adaptive sampling. All pixels of a tile have same number of samples
+      uint32_t total_samples = 0; // Samples accumulated per pixel
+      uint32_t num_samples = 1; // Samples per pixel in next frame
+      uint32_t min_pixel_samples = 0; // Samples of pixel with fewest samples. Less than total after reprojection
+      float error = std::numeric_limits<float>::max(); // Max relative error of pixels
+      bool converged = false;
+      uint32_t num_frames = 0; // Frames accumulated since reset, limited by 'max_frames'
+      
+      // Footprint of objects on the accumulated samples of tile, as sorted object ids. Objects seen at first hit are
+      // also in object id buffer, so their edit only restarts the pixels that saw them
+      std::vector<uint32_t> visible_objects;
+      std::vector<uint32_t> footprint; // Objects hit by paths after their first hit
+      bool footprint_unknown = false; // Too many objects or reprojected history of other tiles, any edit resets tile
+      
+      /// This function restarts the accumulation of tile
+      void Reset();
+    };
+    
+    /// First hit data of a path, used to guide the denoiser
+    struct AuxiliarySample {
+      glm::vec3 albedo = glm::vec3(1.0f);
+      glm::vec3 normal = glm::vec3(0.0f);
+      float depth = RayDenoiser::kSkyDepth;
+      int32_t object_id = -1; // -1 for sky
+    };
+    
+    /// Generator of camera rays. Rays are generated for each row of tile while rendering, instead of storing the
+    /// direction of each pixel in camera
+    struct PrimaryRays {
+      glm::vec3 origin = glm::vec3(0.0f);
+      glm::vec3 corner = glm::vec3(0.0f, 0.0f, -1.0f); // Unnormalised direction of pixel (0, 0)
+      glm::vec3 step_x = glm::vec3(0.0f); // Change of unnormalised direction for one pixel
+      glm::vec3 step_y = glm::vec3(0.0f);
+      glm::mat3 inverse_basis = glm::mat3(1.0f); // Maps direction to (x, y, 1) * distance
+      
+      /// This function updates the generator from camera
+      /// - Parameters:
+      ///   - position: position of camera
+      ///   - inverse_view: inverse of camera view matrix
+      ///   - inverse_projection: inverse of camera projection matrix
+      ///   - width: width of image
+      ///   - height: height of image
+      void Update(const glm::vec3& position,
+                  const glm::mat4& inverse_view,
+                  const glm::mat4& inverse_projection,
+                  uint32_t width,
+                  uint32_t height);
+      /// This function updates the inverse basis from corner and steps
+      void UpdateInverseBasis();
+      /// This function generates the directions of pixels in range [x, x + count) of row y
+      /// - Parameters:
+      ///   - x: first pixel
+      ///   - y: row of pixels
+      ///   - count: number of pixels
+      ///   - directions: normalised direction of each pixel output
+      void GenerateRow(uint32_t x, uint32_t y, uint32_t count, glm::vec3* directions) const;
+      /// This function finds the pixel whose ray has the direction. Returns false if direction is behind camera
+      /// - Parameters:
+      ///   - direction: direction from camera origin
+      ///   - pixel: pixel coordinate output
+      bool Project(const glm::vec3& direction, glm::vec2& pixel) const;
+      /// This function returns true if both generators create same rays
+      /// - Parameter other: other generator
+      bool operator==(const PrimaryRays& other) const;
+    };
+    
+    /// Counters of paths traced by one worker
+    struct PathCounters {
+      uint64_t num_rays = 0;
+      uint64_t num_paths = 0;
+      uint64_t num_roulette_terminations = 0;
+    };
+    
     // Member function
+    /// This function renders the scene, or hands it to background thread in asynchronous mode
+    /// - Parameters:
+    ///   - scene: scene reference
+    ///   - rays: camera rays
+    void Render(const RayScene& scene, const PrimaryRays& rays);
+    /// This function updates the camera rays and detects the camera move
+    /// - Parameter rays: camera rays of new frame
+    void UpdateCamera(const PrimaryRays& rays);
+    /// This function renders one frame using active scene and active camera data
+    /// - Returns: false if there was nothing to trace (rendering disabled, max frames reached or all tiles converged)
+    bool RenderFrame();
+    /// This function loads the image to GPU, or hands all the tiles to main thread in asynchronous mode
+    void PublishImage();
+    /// This function returns the image with rows of 'width' pixels. Padded rows are copied to packed image
+    const uint32_t* PackImage();
+    /// This function loads the pixels to GPU image. Does nothing for headless renderer
+    /// - Parameter data: pixels of whole image
+    void UploadImage(const uint32_t* data);
+    /// This function loads the pixels of tile to GPU image. Does nothing for headless renderer
+    /// - Parameters:
+    ///   - data: pixels of whole image
+    ///   - tile: tile to be loaded
+    void UploadImage(const uint32_t* data, const Tile& tile);
+    /// This function restarts the accumulation of tiles and pixels influenced by the objects invalidated since last
+    /// frame
+    void ApplyInvalidations();
+    
+    // Asynchronous render
+    /// This function starts the background render thread
+    void StartAsyncRender();
+    /// This function is the loop of background render thread. It renders frames while there is something to trace,
+    /// and waits for new input otherwise
+    void AsyncRenderLoop();
+    /// This function copies the finished tile to staging image and queues it for upload. Called by background thread
+    /// - Parameter tile_idx: index of tile
+    void PublishTile(uint32_t tile_idx);
+    /// This function copies the queued tiles from staging image and uploads them, till upload takes frame budget.
+    /// Called by main thread
+    void UploadTiles();
+    /// This function returns the resolution divisor of next frame. Coarse while camera moves, then halved in
+    /// each frame till full resolution
+    uint32_t SelectPreviewScale() const;
+    /// This function traces one sample for each block of pixels and upscales the result to image. Accumulation
+    /// buffers are not changed
+    /// - Parameter scale: pixels per side of block
+    /// - Returns: counters of paths traced
+    PathCounters RenderPreview(uint32_t scale);
+    /// This function updates the average render time of one path
+    /// - Parameter time_per_path_ms: measured time of one path in last frame
+    void UpdatePathCost(float time_per_path_ms);
+    /// This function splits the image in tiles and orders them along the morton curve
+    void UpdateTiles();
+    /// This function renders all the pixels of the tile and updates the error of tile
+    /// - Parameters:
+    ///   - tile: tile to be rendered
+    ///   - thread_idx: index of thread rendering the tile
+    ///   - trace_rays: if false, only image is updated from accumulated samples
+    /// - Returns: counters of paths traced in tile
+    PathCounters RenderTile(Tile& tile, uint32_t thread_idx, bool trace_rays = true);
+    /// This function traces all the samples of tile using wavefront integrator of thread
+    /// - Parameters:
+    ///   - tile: tile to be rendered
+    ///   - num_samples: samples per pixel
+    ///   - thread_idx: index of thread rendering the tile
+    ///   - counters: path counters, updated for all the paths
+    void TraceTileWavefront(const Tile& tile, uint32_t num_samples, uint32_t thread_idx, PathCounters& counters);
+    /// This function adds the history of previous frame to the pixel, if previous frame saw the same surface
+    /// - Parameters:
+    ///   - x: x index of pixel
+    ///   - y: y index of pixel
+    ///   - direction: direction of camera ray of pixel
+    ///   - auxiliary: first hit of new sample of pixel
+    void ReprojectHistory(uint32_t x, uint32_t y, const glm::vec3& direction, const AuxiliarySample& auxiliary);
+    /// This function fills the input of denoiser from accumulated image, filters it and writes it to image data
+    void DenoiseImage();
+    /// This function marks the converged tiles and distributes their samples to the noisy tiles for next frame
+    void UpdateAdaptiveSampling();
     /// This function returns the color value of each pixel
     /// - Parameters:
     ///   - x: x index of pixle
     ///   - y: y index of pixel
-    glm::vec4 PerPixel(uint32_t x, uint32_t y);
+    ///   - direction: direction of camera ray
+    ///   - sample_idx: index of sample of this pixel starting from 0, used to seed the sampler
+    ///   - counters: path counters, updated for each path
+    ///   - auxiliary: first hit data output
+    ///   - hit_objects: objects hit after first hit are added to it. Can be null
+    glm::vec4 PerPixel(uint32_t x,
+                       uint32_t y,
+                       const glm::vec3& direction,
+                       uint32_t sample_idx,
+                       PathCounters& counters,
+                       AuxiliarySample& auxiliary,
+                       RayScene::ObjectSet* hit_objects);
     /// This function trace the rays on the hitable objects
     /// - Parameters:
     ///   - ray: ray of camera
@@ -61,25 +415,88 @@ namespace ikan {
     /// This function trace the  Close hitrays on the hitable objects
     /// - Parameters:
     ///   - ray: ray of camera
-    ///   - hit_distance: hti distance
-    ///   - object_idx: object index
-    HitPayload ClosestHit(const Ray& ray, float hit_distance, int32_t object_idx);
+    ///   - hit: closest hit of scene
+    HitPayload ClosestHit(const Ray& ray, const RayScene::Hit& hit);
     /// This function trace the Miss rays on the hitable objects
     /// - Parameters:
     ///   - ray: ray of camera
     HitPayload Miss(const Ray& ray);
 
     // Member variables
+    bool headless_ = false;
     std::shared_ptr<Image> final_image_ = nullptr;
+    // Rows of image are padded to cache line too, and packed to 'packed_image_data_' when they are published
     uint32_t* image_data_ = nullptr;
+    uint32_t image_stride_ = 0;
+    std::vector<uint32_t> packed_image_data_; // Empty if image rows need no padding
 
+    // Rows of accumulation buffer are padded to cache line, so that rows of tiles never share a cache line. Alpha
+    // of accumulation is the number of samples of pixel
     glm::vec4* accumulation_data_ = nullptr;
+    float* luminance_sq_data_ = nullptr; // Sum of squared luminance of samples, to estimate the variance
+    glm::vec4* albedo_data_ = nullptr; // Sum of first hit albedo
+    glm::vec4* normal_depth_data_ = nullptr; // Sum of first hit normal (xyz) and depth (w)
+    uint32_t accumulation_stride_ = 0;
+    // First hit object of samples of each pixel. -1 for sky, 'kMixedObjects' if samples saw different objects. Rows
+    // have the padded stride of image
+    int32_t* object_id_data_ = nullptr;
+    
+    // Buffers of frame before camera move, used by temporal reprojection. Allocated on first camera move
+    glm::vec4* history_accumulation_data_ = nullptr;
+    float* history_luminance_sq_data_ = nullptr;
+    glm::vec4* history_albedo_data_ = nullptr;
+    glm::vec4* history_normal_depth_data_ = nullptr;
+    bool reproject_history_ = false;
     uint32_t frame_index_ = 1;
     
+    uint32_t width_ = 0, height_ = 0;
+    uint32_t tile_size_ = 0;
+    std::vector<Tile> tiles_;
+    uint32_t max_tile_samples_ = 1; // Used to normalise the sample heatmap
+    ThreadPool thread_pool_;
+    std::vector<RayWavefront> wavefronts_; // One for each thread
+    std::vector<std::vector<glm::vec3>> row_directions_; // Camera rays of one row of tile, one for each thread
+    std::vector<RayScene::ObjectSet> hit_objects_, visible_objects_; // Objects hit by tile, one for each thread
+    RayDenoiser denoiser_;
+    
     const RayScene* active_scene_ = nullptr;
-    const EditorCamera* active_camera_ = nullptr;
+    PrimaryRays primary_rays_;
+    PrimaryRays previous_rays_; // Camera rays of the frame before camera move
+    bool camera_moved_ = false; // Camera rays changed since last frame
+    
+    // Interactive preview
+    std::vector<glm::vec4> preview_data_; // Colors of reduced resolution frame
+    uint32_t preview_scale_ = 1; // Scale of last frame
+    float time_per_path_ms_ = 0.0f; // Average render time of one path, used to select the preview scale
+    float upscale_time_ms_ = 0.0f; // Time of last upscale to full resolution
+    
+    // Asynchronous render. Frame state (buffers, tiles and 'setting_') is owned by background thread while it
+    // runs. Main thread only touches the members below, under mutex
+    std::thread render_thread_;
+    std::mutex async_mutex_;
+    std::condition_variable async_condition_;
+    std::atomic<bool> async_stop_ = false;
+    std::atomic<bool> async_cancel_ = false; // Skip rest of tiles of current frame, as its input is outdated
+    bool publish_tiles_ = false; // Frame is rendered by background thread, finished tiles are handed to main thread
+    // Input of next frame
+    Setting async_setting_;
+    const RayScene* async_scene_ = nullptr;
+    PrimaryRays async_rays_;
+    bool async_input_changed_ = false;
+    bool async_reset_ = false;
+    std::vector<uint32_t> pending_invalidations_; // Objects edited since last frame. Used in both modes
+    // Output of finished tiles
+    std::vector<uint32_t> staging_data_; // Pixels of published tiles
+    std::vector<uint32_t> display_data_; // Pixels of uploaded tiles, returned as image data
+    std::vector<Tile> async_tiles_; // Copy of tiles, as tiles of background thread change after each frame
+    std::vector<uint8_t> tile_queued_;
+    std::deque<uint32_t> queued_tiles_; // Published tiles in order of finishing, each tile at most once
+    Statistics async_statistics_;
     
+    Setting requested_setting_; // Setting edited by application, copied to 'setting_' at the start of frame
     Setting setting_;
+    Statistics statistics_;
+    Statistics published_statistics_; // Statistics returned to application
   };
 
 }
@@ -0,0 +1,196 @@
+//
+//  ray_sampler.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "core/math/random_generator.hpp"
+
+namespace ikan {
+
+  /// This class provides the random numbers of one bounce of a path. Integrators draw the dimensions of bounce in a
+  /// fixed order (light choice, light point, scatter direction, roulette ...) and map them to directions without
+  /// rejection loop, so that same draw of every sample of pixel comes from the same sequence.
+  /// - Random   : independent uniform numbers of PCG32, the reference estimator.
+  /// - Sobol    : Owen scrambled Sobol (0, 2) sequence. Every draw is a separately scrambled and shuffled 2D Sobol
+  ///              sequence (padding), and scramble is seeded per pixel, so error of pixels is uncorrelated.
+  /// - BlueNoise: Same sequence is shared by all the pixels and shifted toroidally per pixel by a blue noise mask
+  ///              (Cranley Patterson rotation), so that error of neighbouring pixels cancels out on screen.
+  /// - Important: Functions are defined in header as they are called for each bounce of each pixel
+  class RaySampler {
+  public:
+    enum class Type : uint8_t {
+      Random, Sobol, BlueNoise
+    };
+
+    /// This constructor creates the sampler of one bounce of a pixel sample. Same input always creates the same
+    /// sequence
+    /// - Parameters:
+    ///   - type: type of sampler
+    ///   - x: x coordinate of pixel
+    ///   - y: y coordinate of pixel
+    ///   - sample_idx: index of sample of pixel, starting from 0 so that first 2^n samples are a full Sobol net
+    ///   - bounce: bounce of path
+    ///   - seed: global seed of renderer
+    RaySampler(Type type, uint32_t x, uint32_t y, uint32_t sample_idx, uint32_t bounce, uint32_t seed)
+    : type_(type), x_(x), y_(y), sample_idx_(sample_idx) {
+      if (type_ == Type::Random) {
+        rng_ = RandomGenerator::ForPixel(x | (y << 16), sample_idx, bounce, seed);
+        return;
+      }
+      // Blue noise sampler shares the scramble of all pixels, the mask decorrelates them instead
+      const uint64_t pixel = type_ == Type::Sobol ? (((uint64_t)y << 32) | x) : 0;
+      seed_ = RandomGenerator::Hash(RandomGenerator::Hash(pixel) ^ (((uint64_t)bounce << 32) | seed));
+      if (type_ == Type::BlueNoise)
+        blue_noise_ = GetBlueNoiseMask();
+    }
+
+    /// This function returns the next dimension in range [0, 1)
+    float Next1D() {
+      if (type_ == Type::Random)
+        return rng_.NextFloat();
+
+      const uint64_t draw_seed = NextDrawSeed();
+      const uint32_t index = ShuffleIndex(draw_seed);
+      // First Sobol dimension is the bit reversed index, so its nested scramble needs no reversal of index
+      float u = ToFloat(ReverseBits(LaineKarrasPermutation(index, (uint32_t)(draw_seed >> 32))));
+      if (type_ == Type::BlueNoise)
+        u = Wrap(u + GetBlueNoise(x_ + (uint32_t)draw_seed, y_ + (uint32_t)(draw_seed >> 8)));
+      return u;
+    }
+    /// This function returns the next two dimensions in range [0, 1). Both come from one 2D Sobol point, so they
+    /// are stratified together
+    glm::vec2 Next2D() {
+      if (type_ == Type::Random) {
+        float u = rng_.NextFloat();
+        float v = rng_.NextFloat();
+        return glm::vec2(u, v);
+      }
+
+      const uint64_t draw_seed = NextDrawSeed();
+      const uint32_t index = ShuffleIndex(draw_seed);
+      glm::vec2 u(ToFloat(ReverseBits(LaineKarrasPermutation(index, (uint32_t)(draw_seed >> 32)))),
+                  ToFloat(NestedUniformScramble(GetSobol2(index), (uint32_t)(draw_seed >> 16))));
+      if (type_ == Type::BlueNoise) {
+        u.x = Wrap(u.x + GetBlueNoise(x_ + (uint32_t)draw_seed, y_ + (uint32_t)(draw_seed >> 8)));
+        u.y = Wrap(u.y + GetBlueNoise(x_ + (uint32_t)(draw_seed >> 40), y_ + (uint32_t)(draw_seed >> 48)));
+      }
+      return u;
+    }
+
+    // ----------------------
+    // Warping
+    // ----------------------
+    /// This function maps the 2D sample to the uniform direction on unit sphere
+    /// - Parameter u: sample in [0, 1)
+    static glm::vec3 SampleSphere(const glm::vec2& u) {
+      float z = 1.0f - 2.0f * u.x;
+      float phi = u.y * 6.28318531f;
+      float r = std::sqrt(std::max(1.0f - z * z, 0.0f));
+      return glm::vec3(r * std::cos(phi), r * std::sin(phi), z);
+    }
+    /// This function maps the samples to the uniform point inside the unit sphere
+    /// - Parameters:
+    ///   - u: sample of direction in [0, 1)
+    ///   - u_radius: sample of radius in [0, 1)
+    static glm::vec3 SampleBall(const glm::vec2& u, float u_radius) {
+      return SampleSphere(u) * std::cbrt(u_radius);
+    }
+
+    /// This function returns the name of sampler type
+    /// - Parameter type: type of sampler
+    static const char* GetTypeName(Type type);
+    /// This function creates the shared data of sampler type (blue noise mask) if not created yet. Call it before
+    /// rendering, so that first frame does not stall on it
+    /// - Parameter type: type of sampler
+    static void Prepare(Type type);
+
+    /// Size of square blue noise mask in pixels. Mask is tiled over the image
+    static constexpr uint32_t kBlueNoiseSize = 64;
+
+  private:
+    /// This function returns the seed of next draw. Each draw is an independently scrambled sequence
+    uint64_t NextDrawSeed() {
+      return RandomGenerator::Hash(seed_ + 0x9e3779b97f4a7c15ULL * ++num_draws_);
+    }
+    /// This function shuffles the sample index of draw by Owen scrambling it. Shuffle only permutes the samples
+    /// inside the aligned power of two blocks, so first 2^n samples are still a full net
+    /// - Parameter draw_seed: seed of draw
+    uint32_t ShuffleIndex(uint64_t draw_seed) const {
+      return NestedUniformScramble(sample_idx_, (uint32_t)(draw_seed >> 24));
+    }
+
+    /// This function returns the second dimension of Sobol sequence (primitive polynomial x + 1)
+    /// - Parameter index: index of sample
+    static uint32_t GetSobol2(uint32_t index) {
+      uint32_t result = 0;
+      for (uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1) {
+        if (index & 1)
+          result ^= v;
+      }
+      return result;
+    }
+    /// This function reverses the bits of value
+    /// - Parameter value: value to be reversed
+    static uint32_t ReverseBits(uint32_t value) {
+      value = (value << 16) | (value >> 16);
+      value = ((value & 0x00ff00ff) << 8) | ((value & 0xff00ff00) >> 8);
+      value = ((value & 0x0f0f0f0f) << 4) | ((value & 0xf0f0f0f0) >> 4);
+      value = ((value & 0x33333333) << 2) | ((value & 0xcccccccc) >> 2);
+      value = ((value & 0x55555555) << 1) | ((value & 0xaaaaaaaa) >> 1);
+      return value;
+    }
+    /// This function is the hash based permutation of Laine and Karras. Each bit is flipped based on the lower bits
+    /// only, so applied to the reversed bits it is an Owen scramble (Burley, Practical Hash-based Owen Scrambling)
+    /// - Parameters:
+    ///   - value: value to be permuted
+    ///   - seed: seed of permutation
+    static uint32_t LaineKarrasPermutation(uint32_t value, uint32_t seed) {
+      value += seed;
+      value ^= value * 0x6c50b47cu;
+      value ^= value * 0xb82f1e52u;
+      value ^= value * 0xc7afe638u;
+      value ^= value * 0x8d22f6e6u;
+      return value;
+    }
+    /// This function Owen scrambles the fixed point value in [0, 1)
+    /// - Parameters:
+    ///   - value: value to be scrambled
+    ///   - seed: seed of scramble
+    static uint32_t NestedUniformScramble(uint32_t value, uint32_t seed) {
+      return ReverseBits(LaineKarrasPermutation(ReverseBits(value), seed));
+    }
+    /// This function converts the fixed point value to float in [0, 1)
+    /// - Parameter value: fixed point value
+    static float ToFloat(uint32_t value) {
+      // Upper 24 bits fit exactly in float mantissa
+      return (value >> 8) * (1.0f / 16777216.0f);
+    }
+    /// This function wraps the value in [0, 2) to [0, 1)
+    /// - Parameter value: value to be wrapped
+    static float Wrap(float value) {
+      return value >= 1.0f ? value - 1.0f : value;
+    }
+    /// This function returns the value of blue noise mask at pixel. Mask is tiled, so any coordinate is valid
+    /// - Parameters:
+    ///   - x: x coordinate of pixel
+    ///   - y: y coordinate of pixel
+    float GetBlueNoise(uint32_t x, uint32_t y) const {
+      return blue_noise_[(y % kBlueNoiseSize) * kBlueNoiseSize + (x % kBlueNoiseSize)];
+    }
+    /// This function returns the blue noise mask. Mask is generated by void and cluster method at first use
+    static const float* GetBlueNoiseMask();
+
+    Type type_ = Type::Random;
+    uint32_t x_ = 0, y_ = 0;
+    uint32_t sample_idx_ = 0;
+    uint32_t num_draws_ = 0;
+    uint64_t seed_ = 0;
+    const float* blue_noise_ = nullptr;
+    RandomGenerator rng_;
+  };
+
+}
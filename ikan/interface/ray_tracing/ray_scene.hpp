@@ -9,16 +9,171 @@
 
 #include "ray_material.hpp"
 #include "ray_sphere.hpp"
+#include "ray_bvh.hpp"
+#include "ray_sphere_soa.hpp"
+#include "ray_mesh.hpp"
 
 namespace ikan {
   
   class RayScene {
   public:
+    /// Closest hit of ray in scene. Either sphere index or instance index is valid
+    struct Hit {
+      float distance = std::numeric_limits<float>::max();
+      int32_t sphere_idx = -1;
+      int32_t instance_idx = -1;
+      uint32_t triangle_idx = 0; // Triangle of instance mesh
+    };
+    /// Point of light sampled for next event estimation
+    struct LightSample {
+      glm::vec3 direction = glm::vec3(0.0f); // Normalised direction from shaded position to light
+      float distance = 0.0f; // Distance of sampled point from shaded position
+      glm::vec3 radiance = glm::vec3(0.0f);
+      float pdf = 0.0f; // Solid angle pdf of direction, including the probability of choosing the light
+    };
+    /// Set of object ids, used to collect the objects hit by paths. Insert is constant time and clear does not touch
+    /// the ids, so one set is reused for all the tiles of a worker
+    class ObjectSet {
+    public:
+      /// This function removes all the objects and makes room for ids below 'num_objects'
+      /// - Parameter num_objects: number of objects of scene
+      void Clear(uint32_t num_objects);
+      /// This function adds the object, if not added since last clear
+      /// - Parameter object_id: id returned by 'GetObjectId()'
+      void Insert(uint32_t object_id) {
+        if (stamps_[object_id] == stamp_)
+          return;
+        stamps_[object_id] = stamp_;
+        objects_.push_back(object_id);
+      }
+      /// This function returns the objects in order of adding
+      const std::vector<uint32_t>& GetObjects() const { return objects_; }
+      
+    private:
+      std::vector<uint32_t> stamps_; // Object is in set if its stamp is current stamp
+      uint32_t stamp_ = 0;
+      std::vector<uint32_t> objects_;
+    };
+    
     std::vector<RaySphere> spheres;
     std::vector<RayMaterial> materials;
+    std::vector<RayMesh> meshes;
+    std::vector<RayMeshInstance> mesh_instances;
+    /// Radiance of rays leaving the scene
+    glm::vec3 sky_color = glm::vec3(0.6f, 0.7f, 0.9f);
+    
+    /// Acceleration structure of spheres. Call 'BuildAccelerationStructure()' after adding or removing the spheres,
+    /// and 'MarkSphereChanged()' with 'UpdateAccelerationStructure()' after moving them. Spheres are tested one by
+    /// one while the BVH is dirty
+    RayBvh bvh;
+    /// Structure of array copy of spheres in BVH leaf order, used by SIMD intersection kernels
+    RaySphereSoA sphere_soa;
+    /// Top level acceleration structure over the world bounds of mesh instances. Each instance leaf traverses the
+    /// BVH of its mesh in object space. Call 'BuildAccelerationStructure()' after changing the instances
+    RayBvh instance_bvh;
+    /// BVH is rebuilt when SAH cost of refit tree is more than this fraction above the cost of last build
+    float bvh_rebuild_threshold = 0.25f;
+    
+    /// This function builds the acceleration structure and SoA copy of all the spheres of scene, the meshes that
+    /// are not built, the acceleration structure of mesh instances and the list of lights
+    void BuildAccelerationStructure();
+    /// This function marks the sphere as changed. Call it after changing position or radius of sphere
+    /// - Parameter sphere_idx: index of sphere
+    void MarkSphereChanged(uint32_t sphere_idx);
+    /// This function refits the acceleration structure to the changed spheres, or rebuilds it if refit tree got too
+    /// slow, number of spheres or mesh instances changed, or a BVH is marked dirty without any changed sphere.
+    /// Returns true if rebuilt
+    /// - Parameter thread_pool: thread pool for parallel refit. Can be null
+    bool UpdateAccelerationStructure(ThreadPool* thread_pool = nullptr);
+    /// This function finds the closest sphere or mesh instance hit by the ray. Spheres are tested one by one if
+    /// acceleration structure is not built
+    /// - Parameters:
+    ///   - ray: ray to be traced
+    ///   - kernel: kernel used to intersect the spheres and triangles of BVH leaves
+    ///   - hit: closest hit output (input distance is max distance to be checked)
+    bool Intersect(const Ray& ray, RaySphereSoA::Kernel kernel, Hit& hit) const;
+    /// This function returns the outward world normal and material of hit surface
+    /// - Parameters:
+    ///   - ray: ray that hit the surface
+    ///   - hit: hit returned by 'Intersect()'
+    ///   - normal: outward world normal output (not flipped to face the ray)
+    ///   - material_index: material index output
+    void GetSurface(const Ray& ray, const Hit& hit, glm::vec3& normal, int32_t& material_index) const;
+    /// This function returns true if anything is hit by the ray before the distance. Hits close to the distance are
+    /// ignored, so that the sampled light does not shadow itself
+    /// - Parameters:
+    ///   - ray: shadow ray with normalised direction
+    ///   - distance: distance of light
+    ///   - kernel: kernel used to intersect the spheres and triangles of BVH leaves
+    bool IsOccluded(const Ray& ray, float distance, RaySphereSoA::Kernel kernel) const;
+    /// This function returns the id of hit object. Spheres are numbered first, then the mesh instances
+    /// - Parameter hit: hit returned by 'Intersect()'
+    uint32_t GetObjectId(const Hit& hit) const;
+    /// This function returns the number of object ids (spheres and mesh instances)
+    uint32_t GetNumObjects() const;
+    
+    // ----------------------
+    // Lights
+    // ----------------------
+    /// This function samples a point on the emissive spheres and triangles for next event estimation. Light is
+    /// chosen with probability proportional to its power. Spheres are sampled in the cone they cover, triangles
+    /// uniformly on their area. Returns false if scene has no lights or light can not be seen from the position
+    /// - Parameters:
+    ///   - position: shaded position
+    ///   - sampler: sampler of the bounce. One dimension chooses the light and two the point on it
+    ///   - sample: sampled light output
+    bool SampleLight(const glm::vec3& position, RaySampler& sampler, LightSample& sample) const;
+    /// This function returns the solid angle pdf of 'SampleLight()' sampling the point of light. Used to weight the
+    /// light hit by BSDF sampled ray
+    /// - Parameters:
+    ///   - light_idx: index of light returned by 'GetLightIndex()'
+    ///   - position: shaded position
+    ///   - light_position: hit point on light
+    float GetLightPdf(int32_t light_idx, const glm::vec3& position, const glm::vec3& light_position) const;
+    /// This function returns the index of light of hit surface. Returns -1 if surface is not emissive
+    /// - Parameter hit: hit returned by 'Intersect()'
+    int32_t GetLightIndex(const Hit& hit) const;
+    /// This function returns the number of emissive spheres and triangles
+    uint32_t GetNumLights() const;
+    /// This function returns true if material is emissive, or was emissive when lights were built
+    /// - Parameter material_idx: index of material
+    bool IsLightMaterial(uint32_t material_idx) const;
+    /// This function returns the multiple importance sampling weight of sample using power heuristic
+    /// - Parameters:
+    ///   - pdf: pdf of strategy that generated the sample
+    ///   - other_pdf: pdf of other strategy generating the same sample
+    static float GetMisWeight(float pdf, float other_pdf);
     
     RayScene() = default;
     DEFINE_COPY_MOVE_CONSTRUCTORS(RayScene)
+    
+  private:
+    /// Emissive sphere or emissive triangle of mesh instance
+    struct Light {
+      int32_t sphere_idx = -1; // Triangle light if -1
+      int32_t material_index = 0;
+      glm::vec3 vertex = glm::vec3(0.0f); // World vertex and edges of triangle
+      glm::vec3 edge_1 = glm::vec3(0.0f);
+      glm::vec3 edge_2 = glm::vec3(0.0f);
+      glm::vec3 normal = glm::vec3(0.0f);
+      float area = 0.0f;
+    };
+    
+    /// This function collects the emissive spheres and triangles, and builds the distribution of their power
+    void BuildLights();
+    /// This function returns the probability of choosing the light
+    /// - Parameter light_idx: index of light
+    float GetLightProbability(uint32_t light_idx) const;
+    
+    std::vector<RayBvh::Bounds> sphere_bounds_; // Bounds of spheres used by last build or refit
+    std::vector<uint32_t> changed_spheres_;
+    std::vector<uint8_t> sphere_changed_flags_; // Spheres already in changed list
+    std::vector<glm::mat4> instance_inverse_transforms_; // World to object transform of each instance
+    
+    std::vector<Light> lights_;
+    std::vector<float> light_cdf_; // Cumulative probability of choosing the lights
+    std::vector<int32_t> sphere_lights_; // Light index of each sphere, -1 if not emissive
+    std::vector<int32_t> instance_lights_; // Light index of first triangle of each instance, -1 if not emissive
   };
 
 }
@@ -0,0 +1,42 @@
+//
+//  ray_scene_serializer.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "ray_scene.hpp"
+#include "ray_camera.hpp"
+
+namespace ikan {
+  
+  /// This class saves and loads the ray tracing scene (materials, spheres, meshes, mesh instances and camera) as
+  /// yaml file. Meshes are referenced by the path of their OBJ file
+  class RaySceneSerializer {
+  public:
+    /// This Constructor creates instance of ray scene serializer
+    /// - Parameters:
+    ///   - scene: scene pointer
+    ///   - camera: camera pointer. Can be nullptr if camera should not be saved or loaded
+    RaySceneSerializer(RayScene* scene, RayCamera* camera = nullptr);
+    /// This destructor destroyes ray scene serializer
+    ~RaySceneSerializer();
+    
+    /// This functions serializes(Saves) the scene at path 'file_path'
+    /// - Parameter file_path: path where scene need to be saved
+    void Serialize(const std::string& file_path);
+    /// This functions deserializes(Opens) the scene from path 'file_path'. Acceleration structures are build
+    /// after loading
+    /// - Parameter file_path: path which need to be loaded
+    bool Deserialize(const std::string& file_path);
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(RaySceneSerializer);
+    
+  private:
+    RayScene* scene_;
+    RayCamera* camera_;
+  };
+  
+}
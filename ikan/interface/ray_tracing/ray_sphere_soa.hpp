@@ -0,0 +1,77 @@
+//
+//  ray_sphere_soa.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "ray.hpp"
+#include "ray_sphere.hpp"
+
+namespace ikan {
+
+  /// This structure stores the spheres as Structure of Arrays, so that one ray can be tested against 4 or 8
+  /// spheres at once. Spheres are stored in BVH leaf order so that a leaf is a continuous range of the arrays.
+  /// Arrays are padded to the maximum SIMD width with spheres that never hit.
+  struct RaySphereSoA {
+    /// Intersection kernel used to test the spheres
+    enum class Kernel : uint8_t {
+      Scalar, Simd4 /* SSE / NEON */, Simd8 /* AVX2 */
+    };
+
+    static constexpr uint32_t kMaxSimdWidth = 8;
+
+    std::vector<float> center_x;
+    std::vector<float> center_y;
+    std::vector<float> center_z;
+    std::vector<float> radius_sq;
+    std::vector<int32_t> material_index;
+    std::vector<uint32_t> sphere_index; // Index of sphere in scene
+    uint32_t count = 0;
+
+    /// This function builds the arrays from spheres
+    /// - Parameters:
+    ///   - spheres: spheres of scene
+    ///   - order: order of spheres (BVH primitive indices)
+    void Build(const std::vector<RaySphere>& spheres, const std::vector<uint32_t>& order);
+    /// This function clears the arrays
+    void Clear();
+    /// This function copies the moved sphere to its slot. Order of spheres is not changed
+    /// - Parameters:
+    ///   - slot: index of sphere in arrays (BVH leaf order)
+    ///   - sphere: sphere data
+    void Update(uint32_t slot, const RaySphere& sphere);
+
+    /// This function finds the closest sphere in range [first, first + num_spheres) hit by the ray
+    /// - Parameters:
+    ///   - kernel: kernel to be used for intersection
+    ///   - ray: ray to be traced
+    ///   - first: first sphere of range
+    ///   - num_spheres: number of spheres in range
+    ///   - hit_distance: closest hit distance (input is max distance to be checked)
+    ///   - object_idx: scene index of closest sphere output
+    bool Intersect(Kernel kernel,
+                   const Ray& ray,
+                   uint32_t first,
+                   uint32_t num_spheres,
+                   float& hit_distance,
+                   int32_t& object_idx) const;
+
+    /// This function returns true if kernel is supported by this machine
+    /// - Parameter kernel: kernel type
+    static bool IsSupported(Kernel kernel);
+    /// This function returns the widest kernel supported by this machine
+    static Kernel GetBestKernel();
+    /// This function returns the kernel name
+    /// - Parameter kernel: kernel type
+    static const char* GetKernelName(Kernel kernel);
+
+  private:
+    bool IntersectScalar(const Ray& ray, uint32_t first, uint32_t num_spheres, float& hit_distance, int32_t& object_idx) const;
+    bool IntersectSimd4(const Ray& ray, uint32_t first, uint32_t num_spheres, float& hit_distance, int32_t& object_idx) const;
+    bool IntersectSimd8(const Ray& ray, uint32_t first, uint32_t num_spheres, float& hit_distance, int32_t& object_idx) const;
+  };
+
+}
@@ -0,0 +1,156 @@
+//
+//  ray_wavefront.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "ray_scene.hpp"
+
+namespace ikan {
+
+  /// This class traces the paths using wavefront integrator. Instead of tracing each path to the end, all the paths
+  /// are advanced one bounce at a time : rays are intersected in bulk, hits are binned by material type and each
+  /// bin is shaded in its own loop, so shading loops have no branch on material type.
+  /// Paths are stored as Structure of Arrays and physically reordered by material after each intersection, so each
+  /// shading loop reads continuous memory.
+  class RayWavefront {
+  public:
+    /// Parameters of paths, copied from the renderer setting
+    struct PathSetting {
+      RaySphereSoA::Kernel sphere_kernel = RaySphereSoA::Kernel::Scalar;
+      uint32_t max_depth = 10;
+      bool russian_roulette = true;
+      uint32_t russian_roulette_depth = 3;
+      uint32_t seed = 0;
+      RaySampler::Type sampler = RaySampler::Type::Sobol;
+      uint32_t width = 0; // Width of image, to find the pixel coordinate of path for sampler
+      glm::vec3 sky_color = glm::vec3(0.0f);
+      bool next_event_estimation = true;
+    };
+
+    /// Default constructor
+    RayWavefront() = default;
+
+    /// This function removes all the paths
+    void Clear();
+    /// This function adds the camera path. Result of path is stored at the index of path in order of adding
+    /// - Parameters:
+    ///   - origin: origin of camera ray
+    ///   - direction: direction of camera ray
+    ///   - pixel_idx: index of pixel, used to seed the sampler
+    ///   - sample_idx: index of sample of pixel starting from 0, used to seed the sampler
+    void AddPath(const glm::vec3& origin, const glm::vec3& direction, uint32_t pixel_idx, uint32_t sample_idx);
+    /// This function traces all the paths till they leave the scene, are absorbed or terminated
+    /// - Parameters:
+    ///   - scene: scene to be traced
+    ///   - setting: path setting
+    ///   - hit_objects: objects hit after the first hit of paths are added to it. Can be null
+    void Trace(const RayScene& scene, const PathSetting& setting, RayScene::ObjectSet* hit_objects = nullptr);
+
+    // ----------------------
+    // Getters
+    // ----------------------
+    /// This function returns the number of paths added since last clear
+    uint32_t GetNumPaths() const;
+    /// This function returns the color of path
+    /// - Parameter path_idx: index of path
+    const glm::vec3& GetColor(uint32_t path_idx) const;
+    /// This function returns the albedo of first hit of path
+    /// - Parameter path_idx: index of path
+    const glm::vec3& GetAlbedo(uint32_t path_idx) const;
+    /// This function returns the world normal of first hit of path
+    /// - Parameter path_idx: index of path
+    const glm::vec3& GetNormal(uint32_t path_idx) const;
+    /// This function returns the distance of first hit of path
+    /// - Parameter path_idx: index of path
+    float GetDepth(uint32_t path_idx) const;
+    /// This function returns the id of first hit object of path. -1 if path missed the scene
+    /// - Parameter path_idx: index of path
+    int32_t GetObjectId(uint32_t path_idx) const;
+    /// This function returns the number of rays traced by last trace
+    uint64_t GetNumRays() const;
+    /// This function returns the number of paths terminated by russian roulette in last trace
+    uint64_t GetNumRouletteTerminations() const;
+
+    DELETE_COPY_MOVE_CONSTRUCTORS(RayWavefront);
+
+  private:
+    /// State of active paths stored as Structure of Arrays
+    struct PathBuffer {
+      std::vector<float> origin[3]; // Hit position after intersection
+      std::vector<float> direction[3];
+      std::vector<float> throughput[3];
+      std::vector<float> normal[3];
+      std::vector<uint32_t> path_idx; // Index of result
+      std::vector<uint32_t> pixel_idx;
+      std::vector<uint32_t> sample_idx;
+      std::vector<int32_t> material_idx;
+      std::vector<float> bsdf_pdf; // Pdf of BSDF sampling the ray, 0 for camera ray and specular bounce
+      std::vector<uint8_t> front_face;
+      std::vector<uint8_t> state;
+
+      /// This function resizes all the arrays
+      /// - Parameter size: number of paths
+      void Resize(size_t size);
+      /// This function copies one path from other buffer
+      /// - Parameters:
+      ///   - dst_idx: index of path in this buffer
+      ///   - src: source buffer
+      ///   - src_idx: index of path in source buffer
+      void Copy(uint32_t dst_idx, const PathBuffer& src, uint32_t src_idx);
+    };
+
+    /// This function intersects the active paths and bins them by material type in other path buffer. Paths that
+    /// miss the scene or hit the emissive surface are finished here
+    /// - Parameters:
+    ///   - scene: scene to be traced
+    ///   - setting: path setting
+    ///   - bounce: index of bounce
+    ///   - hit_objects: objects hit after first bounce are added to it. Can be null
+    ///   - bin_offsets: first path of each material type output (kNumBins + 1 entries)
+    void IntersectAndBin(const RayScene& scene,
+                         const PathSetting& setting,
+                         uint32_t bounce,
+                         RayScene::ObjectSet* hit_objects,
+                         uint32_t* bin_offsets);
+    /// This function shades the paths of one material type. Diffuse paths also sample the lights
+    /// - Parameters:
+    ///   - paths: binned path buffer
+    ///   - begin: first path of material type
+    ///   - end: end of paths of material type
+    ///   - scene: scene to be traced
+    ///   - setting: path setting
+    ///   - bounce: index of bounce
+    template<RayMaterial::Type kType>
+    void Shade(PathBuffer& paths,
+               uint32_t begin,
+               uint32_t end,
+               const RayScene& scene,
+               const PathSetting& setting,
+               uint32_t bounce);
+    /// This function removes the finished paths of binned buffer and makes it the active buffer
+    /// - Parameter num_paths: number of paths in binned buffer
+    void Compact(uint32_t num_paths);
+
+    static constexpr uint32_t kNumBins = 4; // One bin for each scattering material type
+
+    // Results of paths, indexed by order of adding
+    std::vector<glm::vec3> color_;
+    std::vector<glm::vec3> albedo_;
+    std::vector<glm::vec3> normal_;
+    std::vector<float> depth_;
+    std::vector<int32_t> object_id_;
+
+    PathBuffer buffers_[2];
+    uint32_t active_buffer_ = 0;
+    uint32_t num_active_paths_ = 0;
+    std::vector<uint8_t> bins_; // Material type of each active path, kNumBins for miss
+
+    uint64_t num_rays_ = 0;
+    uint64_t num_roulette_terminations_ = 0;
+  };
+
+}
@@ -54,11 +54,19 @@ namespace ikan {
     /// This Costructor initialize the vector of layout elements with
     /// initializer list
     BufferLayout(const std::initializer_list<BufferElement>& elements);
+    /// This Costructor initialize the vector of layout elements with initializer list, and sets if attributes
+    /// advance once per instance instead of once per vertex
+    /// - Parameters:
+    ///   - elements: elements of layout
+    ///   - per_instance: true if buffer stores one element per instance
+    BufferLayout(const std::initializer_list<BufferElement>& elements, bool per_instance);
     
     /// This function returns the elements vector
     const std::vector<BufferElement> GetElements() const;
     /// This function returns the stride value
     uint32_t GetStride() const;
+    /// This function returns true if attributes of layout advance once per instance
+    bool IsPerInstance() const;
     
     // Iterators to access the vector
     std::vector<BufferElement>::iterator begin();
@@ -77,6 +85,7 @@ namespace ikan {
     // Member variable
     std::vector<BufferElement> elements_;
     uint32_t stride_ = 0;
+    bool per_instance_ = false;
   };
   
   /// This class is the interface of Renderer Vertex Buffer, to store the vertices of the objects.
@@ -112,6 +121,9 @@ namespace ikan {
     [[nodiscard]] virtual uint32_t GetSize() const = 0;
     /// This function returns the renderer ID of Vertex Buffer
     [[nodiscard]] virtual RendererID GetRendererID() const = 0;
+    /// This function returns the offset of vertices of next draw call in buffer. Always 0 except for stream
+    /// vertex buffer, where each batch is written in different region
+    [[nodiscard]] virtual uint32_t GetBaseOffset() const = 0;
 
     // -----------------
     // Static Function
@@ -127,6 +139,56 @@ namespace ikan {
     /// - Parameter size: size of data
     [[nodiscard]] static std::shared_ptr<VertexBuffer> Create(uint32_t size);
   };
+  
+  /// This class is the interface of Renderer Stream Vertex Buffer, for vertices that are rewritten in each batch.
+  /// Buffer is split in regions of frames used one after the other, and vertices of each batch of a frame are
+  /// written directly in the mapped memory of its region, after the batches before it. A region is reused only
+  /// after GPU has finished drawing the frame from it, so writing the next frames neither stalls on nor orphans
+  /// the previous ones
+  class StreamVertexBuffer : public VertexBuffer {
+  public:
+    /// Number of regions of stream buffer by default (frame being written, two frames being drawn)
+    static constexpr uint32_t kDefaultNumRegions = 3;
+    /// Number of batches in region of a frame by default. Batches after these move to next region in same frame
+    static constexpr uint32_t kDefaultBatchesPerFrame = 8;
+    
+    // -------------
+    // Destrcutor
+    // -------------
+    virtual ~StreamVertexBuffer() = default;
+    
+    // -------------
+    // Fundamentals
+    // -------------
+    /// This function returns the pointer to write the vertices of next batch, in region of current frame. Waits
+    /// at first batch of frame if GPU is still drawing from the region
+    [[nodiscard]] virtual void* Map() = 0;
+    /// This function ends the writing of batch. Next draw calls of pipeline use the vertices of batch
+    /// - Parameter size: number of bytes written in batch
+    virtual void Unmap(uint32_t size) = 0;
+    
+    // -------------
+    // Getters
+    // -------------
+    /// This function returns the maximum size of one batch
+    [[nodiscard]] virtual uint32_t GetBatchSize() const = 0;
+    
+    // -----------------
+    // Static Function
+    // -----------------
+    /// This static function creates the instance of Stream Vertex Buffer based on the supported API
+    /// - Parameters:
+    ///   - batch_size: size of data of single batch
+    ///   - batches_per_frame: number of batches in region of a frame
+    ///   - num_regions: number of regions in buffer
+    [[nodiscard]] static std::shared_ptr<StreamVertexBuffer> Create(uint32_t batch_size,
+                                                                    uint32_t batches_per_frame =
+                                                                    kDefaultBatchesPerFrame,
+                                                                    uint32_t num_regions = kDefaultNumRegions);
+    /// This static function ends the frame of all the stream buffers. Draw calls of the frame are fenced, and next
+    /// batches are written in next region
+    static void EndFrame();
+  };
 
   /// This class is the interface of Renderer Vertex Buffer, to store the vertices of the objects.
   class IndexBuffer {
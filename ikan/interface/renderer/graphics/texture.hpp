@@ -16,7 +16,7 @@
 namespace ikan {
   
   enum class TextureFormat  {
-    None = 0, RGBA
+    None = 0, RGBA, RGB, Red
   };
   
   class Texture;
@@ -53,6 +53,10 @@ namespace ikan {
     [[nodiscard]] virtual const std::string& GetfilePath() const = 0;
     /// This function returns name of texture
     [[nodiscard]] virtual const std::string& GetName() const = 0;
+    /// This function returns the pixel format of Texture
+    [[nodiscard]] virtual TextureFormat GetFormat() const = 0;
+    /// This function returns true if Texture is sampled with linear filter
+    [[nodiscard]] virtual bool IsLinear() const = 0;
 
     // -----------------
     // Static Function
@@ -75,6 +79,69 @@ namespace ikan {
                                                          uint32_t size);
   };
   
+  /// Interface class for array of 2D textures of same size and format, each stored in a layer. All the layers are
+  /// sampled through one shader slot, the layer is selected by third texture coordinate.
+  class TextureArray {
+  public:
+    // -------------
+    // Destrcutor
+    // -------------
+    /// Default virtual destructor
+    virtual ~TextureArray() = default;
+    
+    // -------------
+    // Fundamentals
+    // -------------
+    /// This function binds the Texture Array to a slot of shader
+    /// - Parameter slot: Slot of shader
+    virtual void Bind(uint32_t slot = 0) const = 0;
+    /// This function unbinds the Texture Array from shader slot
+    virtual void Unbind() const = 0;
+    /// This function copies the texture in a layer of array. Texture must have the size and format of array
+    /// - Parameters:
+    ///   - layer: index of layer
+    ///   - texture: texture to be copied
+    virtual void SetLayer(uint32_t layer, const Texture& texture) = 0;
+    /// This function copies the texture in a rectangle of layer, and repeats its edge pixels around it
+    /// - Parameters:
+    ///   - layer: index of layer
+    ///   - x: first column of rectangle
+    ///   - y: first row of rectangle
+    ///   - texture: texture to be copied
+    ///   - extrusion: number of times edge pixels are repeated out of rectangle
+    virtual void SetRegion(uint32_t layer, uint32_t x, uint32_t y, const Texture& texture, uint32_t extrusion = 0) = 0;
+
+    // -------------
+    // Getters
+    // -------------
+    /// This function returns the Renderer ID of Texture Array
+    [[nodiscard]] virtual RendererID GetRendererID() const = 0;
+    /// This function returns the Width of each layer
+    [[nodiscard]] virtual uint32_t GetWidth() const = 0;
+    /// This function returns the Height of each layer
+    [[nodiscard]] virtual uint32_t GetHeight() const = 0;
+    /// This function returns the number of layers
+    [[nodiscard]] virtual uint32_t GetNumLayers() const = 0;
+    /// This function returns the pixel format of layers
+    [[nodiscard]] virtual TextureFormat GetFormat() const = 0;
+
+    // -----------------
+    // Static Function
+    // -----------------
+    /// This static functions creates the Texture Array with empty layers
+    /// - Parameters:
+    ///   - width: width of each layer
+    ///   - height: height of each layer
+    ///   - format: pixel format of layers
+    ///   - linear: min linear flag
+    ///   - num_layers: number of layers
+    [[nodiscard]] static std::shared_ptr<TextureArray> Create(uint32_t width,
+                                                              uint32_t height,
+                                                              TextureFormat format,
+                                                              bool linear,
+                                                              uint32_t num_layers);
+  };
+  
   /// Wrepper class to load texture and render as sprite
   class SubTexture {
   public:
@@ -198,6 +265,14 @@ namespace ikan {
     /// This function loads the data in GPU
     /// - Parameter data: data to be loaded
     virtual void SetData(void* data) = 0;
+    /// This function loads the rectangle of data in GPU. Image must be loaded once with full data before
+    /// - Parameters:
+    ///   - data: data of whole image, only the pixels of rectangle are read
+    ///   - x: first column of rectangle
+    ///   - y: first row of rectangle
+    ///   - width: width of rectangle
+    ///   - height: height of rectangle
+    virtual void SetData(void* data, uint32_t x, uint32_t y, uint32_t width, uint32_t height) = 0;
     /// This function loads the data in GPU
     /// - Parameters:
     ///   - width: width of image
@@ -33,6 +33,31 @@ namespace ikan {
     /// This function Ends the current batch by rendering all the vertex
     static void EndBatch();
     
+    /// This function enables the deferred submission of quads and circles. Draw calls are recorded as commands
+    /// with a 64 bit sort key (layer, depth, shader, texture array), which are sorted at the end of batch before
+    /// the vertices are generated. Sprites of an array submitted between sprites of other arrays are then drawn in
+    /// one batch, instead of flushing the batch each time the 16 texture slots are full.
+    /// - Note: Order of quads with same layer and depth is by texture array, then by submission
+    /// - Parameter deferred: true to record and sort the draw calls, false to write vertices in submission order
+    static void SetDeferredSubmission(bool deferred);
+    /// This function returns true if deferred submission is enabled
+    static bool IsDeferredSubmission();
+    /// This function sets the layer of next quads and circles in deferred submission. Lower layers are drawn first,
+    /// whatever their depth. Reset to 0 at the start of batch
+    /// - Parameter layer: layer of next draw calls
+    static void SetLayer(uint8_t layer);
+    
+    /// This function enables the sprite atlas. Textures not bigger than 256 pixels are packed in pages of 1024 x
+    /// 1024 at their first draw, so that untiled quads of many small textures take one texture slot. Pages are
+    /// packed again in background when half of their area is of destroyed textures, and copied in new pages over
+    /// next few batches.
+    /// - Note: Atlas is disabled by default, scenes with many small sprites should enable it
+    /// - Note: Tiled quads, quads with coordinates outside the texture and circles are drawn from texture arrays
+    /// - Parameter enable: true to sample the small textures from atlas
+    static void SetSpriteAtlas(bool enable);
+    /// This function returns true if sprite atlas is enabled
+    static bool IsSpriteAtlas();
+    
     /// This funcition initialize the quad renderer data
     /// - Parameter max_quads: max quad to be renderered in single batch
     static void InitQuadData(uint32_t max_quads = 50);
@@ -175,6 +200,8 @@ namespace ikan {
     static void Flush();
     /// This function moves to next batch in single frame
     static void NextBatch();
+    /// This function sorts the recorded draw calls of deferred submission and generates their vertices
+    static void FlushDeferredCommands();
     
     // ---------------------------------------------------
     // Internal Helper API for Rendering Quad and Circle
@@ -210,6 +237,56 @@ namespace ikan {
                                   float thickness,
                                   float fade,
                                   int32_t object_id);
+    /// This function writes the instance of quad in current batch
+    /// - Parameters:
+    ///   - transform_rows: first three rows of transform matrix of quad
+    ///   - texture: texture to be binded in quad
+    ///   - texture_rect: min (xy) and max (zw) texture coordinates
+    ///   - tiling_factor: tiling factor of texture
+    ///   - tint_color: color of quad
+    ///   - object_id: object/pixel id
+    static void DrawQuadInstance(const glm::vec4* transform_rows,
+                                 const std::shared_ptr<Texture>& texture,
+                                 glm::vec4 texture_rect,
+                                 float tiling_factor,
+                                 const glm::vec4& tint_color,
+                                 int32_t object_id);
+    /// This function writes the instance of circle in current batch
+    /// - Parameters:
+    ///   - transform_rows: first three rows of transform matrix of circle
+    ///   - texture: texture to be binded in circle
+    ///   - tiling_factor: tiling factor of texture
+    ///   - tint_color: color of circle
+    ///   - thickness: thickness of circle
+    ///   - fade: cirlce face
+    ///   - object_id: object/pixel id
+    static void DrawCircleInstance(const glm::vec4* transform_rows,
+                                   const std::shared_ptr<Texture>& texture,
+                                   float tiling_factor,
+                                   const glm::vec4& tint_color,
+                                   float thickness,
+                                   float fade,
+                                   int32_t object_id);
+    /// This function records the draw call of quad or circle in deferred submission
+    /// - Parameters:
+    ///   - circle: true for circle, false for quad
+    ///   - transform: transform matrix of shape
+    ///   - texture: texture to be binded in shape
+    ///   - texture_coords: texture coordinates (quad only)
+    ///   - tiling_factor: tiling factor of texture
+    ///   - tint_color: color of shape
+    ///   - thickness: thickness of circle
+    ///   - fade: cirlce face
+    ///   - object_id: object/pixel id
+    static void RecordCommand(bool circle,
+                              const glm::mat4& transform,
+                              const std::shared_ptr<Texture>& texture,
+                              const glm::vec2* texture_coords,
+                              float tiling_factor,
+                              const glm::vec4& tint_color,
+                              float thickness,
+                              float fade,
+                              int32_t object_id);
 
   };
   
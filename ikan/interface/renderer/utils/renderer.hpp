@@ -135,6 +135,9 @@ namespace ikan {
     static void SetApi(Api api);
     /// This function returns the current API supported
     static Api GetApi();
+    /// This function ends the frame of renderer. Stream vertex buffers fence the draw calls of frame, and write the
+    /// batches of next frame in their next region
+    static void EndFrame();
     
     // -------------------------------
     // Renderer Stats API
@@ -187,6 +190,14 @@ namespace ikan {
     ///   - count: number of Indices (if 0 then use index buffer of Vertex array)
     static void DrawIndexed(const std::shared_ptr<Pipeline>& pipeline,
                             uint32_t count = 0);
+    /// This API draws the indexed vertices of pipeline once per instance
+    /// - Parameters:
+    ///   - pipeline: pipeline having vertex buffers (per vertex and per instance) and index buffer
+    ///   - count: number of Indices of single instance (if 0 then use index buffer of Vertex array)
+    ///   - instance_count: number of instances
+    static void DrawIndexedInstanced(const std::shared_ptr<Pipeline>& pipeline,
+                                     uint32_t count,
+                                     uint32_t instance_count);
     /// This API draws Lines Vertex Array
     /// - Parameters:
     ///   - pipeline: pipeline having vertex buffer and index buffer
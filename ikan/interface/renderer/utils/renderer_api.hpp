@@ -85,6 +85,14 @@ namespace ikan {
     ///   - count: number of Indices (if 0 then use index buffer of Vertex array)
     virtual void DrawIndexed(const std::shared_ptr<Pipeline>& pipeline,
                              uint32_t count = 0) const = 0;
+    /// This API draws the indexed vertices of pipeline once per instance
+    /// - Parameters:
+    ///   - pipeline: pipeline having vertex buffers (per vertex and per instance) and index buffer
+    ///   - count: number of Indices of single instance (if 0 then use index buffer of Vertex array)
+    ///   - instance_count: number of instances
+    virtual void DrawIndexedInstanced(const std::shared_ptr<Pipeline>& pipeline,
+                                      uint32_t count,
+                                      uint32_t instance_count) const = 0;
     /// This API draws Lines Vertex Array
     /// - Parameters:
     ///   - pipeline: pipeline having vertex buffer and index buffer
@@ -12,6 +12,9 @@ namespace ikan {
   struct Renderer2DStats {
     uint32_t max_quads = 0, max_circles = 0, max_lines = 0;
     uint32_t quads = 0, circles = 0, lines = 0;
+    /// Batches flushed because all the texture slots were used, and batch flushes (for texture slots or instances)
+    /// that deferred submission avoided
+    uint32_t texture_flushes = 0, texture_flushes_avoided = 0;
     
     void Reset();
     void ResetEachFrame();
@@ -0,0 +1,172 @@
+//
+//  sprite_atlas.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "renderer/utils/texture_array_pool.hpp"
+
+#include <thread>
+#include <atomic>
+
+// This file includes the atlas of small textures used by batch renderer. Sprites of many small images are then
+// sampled from few atlas pages instead of a texture (or texture array) each
+
+namespace ikan {
+  
+  class Texture;
+  
+  /// This class packs the small textures in atlas pages, which are layers of texture array pool. Textures are
+  /// packed at first use with skyline packer (bottom left, best fit), with padding between them and their edge
+  /// pixels extruded in padding. Region of a texture is found with one lookup in table of texture handles.
+  /// Packing of destroyed textures leave holes in pages, so when their area passes the threshold, all the live
+  /// textures are packed again by a background thread. They are then copied in new pages over next few 'Update'
+  /// calls, while regions of old pages are still used, and old pages are freed when the new pages are swapped in.
+  class SpriteAtlas {
+  public:
+    /// Setting of atlas
+    struct Setting {
+      uint32_t page_size = 1024;      // Width and height of page
+      uint32_t max_sprite_size = 256; // Textures bigger than this (width or height) are not packed
+      uint32_t padding = 2;           // Pixels around each texture, must not be less than extrusion
+      uint32_t extrusion = 1;         // Number of times edge pixels are repeated in padding
+      float repack_threshold = 0.5f;  // Fraction of packed area of destroyed textures to start re-pack
+    };
+    
+    /// Region of texture in atlas
+    struct Region {
+      TextureArrayPool::Location location;
+      glm::vec2 uv_min;
+      glm::vec2 uv_size;
+    };
+    
+    /// This constructor creates the atlas without any page
+    /// - Parameters:
+    ///   - pool: pool of texture arrays, which stores the pages
+    ///   - setting: setting of atlas
+    SpriteAtlas(TextureArrayPool& pool, const Setting& setting);
+    /// This destructor waits for the re-pack and frees the pages
+    ~SpriteAtlas();
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(SpriteAtlas);
+    
+    /// This function returns the region of texture, packing it at first call. Returns nullptr if texture is not
+    /// packed (too big, or format without color)
+    /// - Parameter texture: texture
+    const Region* GetRegion(const std::shared_ptr<Texture>& texture);
+    /// This function continues the finished re-pack, finds the destroyed textures and starts new re-pack if
+    /// fragmentation passes the threshold. To be called at the start of each batch, before any region is used
+    void Update();
+    
+    /// This function returns the fraction of packed area of destroyed textures
+    float GetFragmentation() const;
+    /// This function returns the number of pages
+    uint32_t GetNumPages() const;
+    /// This function returns the number of packed textures
+    uint32_t GetNumSprites() const;
+  
+  private:
+    /// Skyline of a page. Each node is a horizontal segment of top edge of packed area
+    struct Skyline {
+      struct Node {
+        uint32_t x, y, width;
+      };
+      std::vector<Node> nodes;
+      uint32_t size = 0;
+      
+      /// This function resets the skyline of empty page
+      /// - Parameter page_size: size of page
+      void Reset(uint32_t page_size);
+      /// This function finds the bottom left position of rectangle, and adds the rectangle to skyline. Returns
+      /// false if rectangle does not fit
+      /// - Parameters:
+      ///   - width: width of rectangle
+      ///   - height: height of rectangle
+      ///   - x: first column of rectangle
+      ///   - y: first row of rectangle
+      bool Insert(uint32_t width, uint32_t height, uint32_t& x, uint32_t& y);
+    };
+    
+    /// Page of atlas, stored in layer of pool
+    struct Page {
+      TextureArrayPool::Location location;
+      Skyline skyline;
+      bool linear = true;
+    };
+    
+    /// Packed texture. Handle is kept weak so that atlas does not keep the texture alive
+    struct Entry {
+      std::weak_ptr<Texture> texture;
+      Region region;
+      uint64_t area = 0; // Area including padding
+      bool packed = false;
+    };
+    
+    /// Packing of live textures, done by background thread
+    struct Repack {
+      /// Position of texture in new pages
+      struct Placement {
+        uint32_t page, x, y;
+      };
+      
+      std::thread thread;
+      std::atomic<bool> done = false;
+      
+      // Input : handles are weak, textures destroyed before they are copied are skipped
+      std::vector<std::weak_ptr<Texture>> textures;
+      std::vector<glm::uvec2> sizes;
+      std::vector<bool> linear;
+      
+      // Output : skylines of new pages, with their filter
+      std::vector<Placement> placements;
+      std::vector<Skyline> skylines;
+      std::vector<bool> page_linear;
+      
+      // New pages and their entries, filled over few updates after thread is done
+      std::vector<Page> pages;
+      std::unordered_map<const Texture*, Entry> entries;
+      uint32_t next_texture = 0;
+      uint64_t packed_area = 0;
+      uint32_t num_sprites = 0;
+    };
+    
+    // Member Functions
+    /// This function packs the texture in first page that has space, adding new page if none has
+    /// - Parameters:
+    ///   - texture: texture to be packed
+    ///   - entry: entry to store the region
+    void Pack(const std::shared_ptr<Texture>& texture, Entry& entry);
+    /// This function creates empty page in free layer of pool
+    /// - Parameter linear: min linear flag of page
+    Page CreatePage(bool linear);
+    /// This function copies the texture in page and returns its region
+    /// - Parameters:
+    ///   - texture: texture
+    ///   - page: page
+    ///   - x: first column of padded rectangle
+    ///   - y: first row of padded rectangle
+    Region Upload(const Texture& texture, const Page& page, uint32_t x, uint32_t y);
+    /// This function starts the re-pack of live textures in background thread
+    void StartRepack();
+    /// This function copies next few textures of finished re-pack in new pages. When all are copied, new pages
+    /// replace the old pages, which are then freed
+    void ApplyRepack();
+    
+    // Member Variables
+    TextureArrayPool& pool_;
+    Setting setting_;
+    std::vector<Page> pages_;
+    /// Table of texture handles, also has the textures that are not packed
+    std::unordered_map<const Texture*, Entry> entries_;
+    
+    uint64_t packed_area_ = 0, destroyed_area_ = 0;
+    uint32_t num_sprites_ = 0;
+    uint32_t update_idx_ = 0;
+    
+    std::unique_ptr<Repack> repack_;
+  };
+  
+}
@@ -0,0 +1,96 @@
+//
+//  texture_array_pool.hpp
+//  ikan
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+// This file includes the pool of texture arrays used by batch renderer. Textures are copied in layers of arrays
+// grouped by size, format and filter, so that one shader slot samples many textures
+
+namespace ikan {
+  
+  class Texture;
+  class TextureArray;
+  enum class TextureFormat;
+  
+  /// This class stores the textures as layers of texture arrays. Each group of same size, format and filter owns
+  /// its arrays, and a texture is copied in free layer of its group at first use. Location of a texture is then
+  /// found with one lookup in table of texture handles.
+  /// - Note: Layers of destroyed textures are reused, they are collected when a group has no free layer
+  class TextureArrayPool {
+  public:
+    /// Location of texture in pool
+    struct Location {
+      uint32_t array_index = 0;
+      uint32_t layer = 0;
+    };
+    
+    /// Number of layers in first array of group. Each next array is created only when all the arrays of group are
+    /// full, with double layers, so that group of a single (big) texture takes only its own memory
+    static constexpr uint32_t kMinLayersPerArray = 1;
+    /// Max number of layers in an array (minimum of GL_MAX_ARRAY_TEXTURE_LAYERS)
+    static constexpr uint32_t kMaxLayersPerArray = 256;
+    /// Max memory of an array. Array has at least one layer, even if layer is bigger
+    static constexpr uint32_t kMaxArraySize = 16 * 1024 * 1024;
+    
+    /// This constructor creates the pool with default texture, which is stored at first layer of first array
+    /// - Parameter default_texture: texture of location returned for the textures without data
+    TextureArrayPool(const std::shared_ptr<Texture>& default_texture);
+    /// This destructor destroys all the texture arrays
+    ~TextureArrayPool();
+    
+    DELETE_COPY_MOVE_CONSTRUCTORS(TextureArrayPool);
+    
+    /// This function returns the location of texture. Texture is copied in free layer of its group at first call
+    /// - Parameter texture: texture
+    Location GetLocation(const std::shared_ptr<Texture>& texture);
+    /// This function allocates a free layer of group, without any texture. Layer is owned by caller till it is
+    /// freed with 'FreeLayer'
+    /// - Parameters:
+    ///   - width: width of layer
+    ///   - height: height of layer
+    ///   - format: pixel format of layer
+    ///   - linear: min linear flag
+    Location AllocateLayer(uint32_t width, uint32_t height, TextureFormat format, bool linear);
+    /// This function frees the layer of location
+    /// - Parameter location: location
+    void FreeLayer(const Location& location);
+    /// This function returns the texture array at index
+    /// - Parameter array_index: index of array
+    const std::shared_ptr<TextureArray>& GetArray(uint32_t array_index) const;
+    /// This function returns the number of texture arrays
+    uint32_t GetNumArrays() const;
+    /// This function frees the layers of destroyed textures
+    void Collect();
+  
+  private:
+    /// Texture array of a group with its free layers
+    struct ArrayData {
+      std::shared_ptr<TextureArray> array;
+      std::vector<uint32_t> free_layers;
+    };
+    
+    /// Layer of texture. Handle is kept weak so that pool does not keep the texture alive
+    struct Entry {
+      std::weak_ptr<Texture> texture;
+      Location location;
+    };
+    
+    // Member Functions
+    /// This function copies the texture in free layer of its group
+    /// - Parameter texture: texture
+    Location Insert(const std::shared_ptr<Texture>& texture);
+    
+    // Member Variables
+    std::shared_ptr<Texture> default_texture_;
+    std::vector<ArrayData> arrays_;
+    /// Indices of arrays of each group, mapped by key of size, format and filter
+    std::unordered_map<uint64_t, std::vector<uint32_t>> groups_;
+    /// Table of texture handles
+    std::unordered_map<const Texture*, Entry> entries_;
+  };
+  
+}
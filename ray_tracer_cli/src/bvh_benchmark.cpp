@@ -0,0 +1,138 @@
+//
+//  bvh_benchmark.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "bvh_benchmark.hpp"
+
+using namespace ikan;
+
+namespace ray_tracer {
+  
+  /// Number of random rays traced after each update to measure the quality of tree
+  static constexpr uint32_t kNumRays = 65536;
+  /// Distance moved by each sphere in one frame
+  static constexpr float kSpeed = 0.05f;
+  /// Smallest number of spheres of sweep
+  static constexpr uint32_t kSweepStartSpheres = 1000;
+  
+  /// Way of updating the BVH after spheres move
+  enum class Strategy : uint8_t {
+    Rebuild, Refit, RefitAndRebuild
+  };
+  
+  static const char* GetStrategyName(Strategy strategy) {
+    switch (strategy) {
+      case Strategy::Rebuild: return "rebuild";
+      case Strategy::Refit: return "refit";
+      case Strategy::RefitAndRebuild: return "refit + rebuild";
+    }
+    return "";
+  }
+  
+  /// Random scene of the benchmark. Spheres fill a cube and bounce on its walls
+  struct AnimatedScene {
+    RayScene scene;
+    std::vector<glm::vec3> velocities;
+    float half_size = 0.0f;
+    
+    /// This function creates the random spheres
+    /// - Parameters:
+    ///   - num_spheres: number of spheres
+    ///   - seed: seed of random generator
+    AnimatedScene(uint32_t num_spheres, uint32_t seed) {
+      // Density of one sphere in 8 unit cube
+      half_size = std::cbrt((float)num_spheres);
+      RandomGenerator rng(seed);
+      scene.materials.emplace_back();
+      scene.spheres.resize(num_spheres);
+      velocities.resize(num_spheres);
+      for (uint32_t i = 0; i < num_spheres; i++) {
+        scene.spheres[i] = RaySphere(rng.NextVec3(-half_size, half_size), rng.NextFloat(0.2f, 0.5f), 0);
+        velocities[i] = rng.OnUnitSphere() * kSpeed;
+      }
+    }
+    
+    /// This function moves all the spheres by one frame
+    void Animate() {
+      for (uint32_t i = 0; i < (uint32_t)scene.spheres.size(); i++) {
+        glm::vec3& position = scene.spheres[i].position;
+        position += velocities[i];
+        for (int32_t c = 0; c < 3; c++) {
+          if (std::abs(position[c]) > half_size)
+            velocities[i][c] = -velocities[i][c];
+        }
+        scene.MarkSphereChanged(i);
+      }
+    }
+  };
+  
+  /// This function runs all the strategies for one sphere count and prints a row for each
+  /// - Parameters:
+  ///   - options: command line options
+  ///   - num_spheres: number of spheres
+  ///   - thread_pool: thread pool for refit and ray tracing
+  static void RunStrategies(const CliOptions& options, uint32_t num_spheres, ThreadPool& thread_pool) {
+    for (Strategy strategy : { Strategy::Rebuild, Strategy::Refit, Strategy::RefitAndRebuild }) {
+      AnimatedScene animated_scene(num_spheres, options.seed);
+      RayScene& scene = animated_scene.scene;
+      scene.bvh_rebuild_threshold = strategy == Strategy::Refit ? std::numeric_limits<float>::max() : 0.25f;
+      scene.BuildAccelerationStructure();
+      
+      double update_time_ms = 0.0, trace_time_ms = 0.0;
+      uint32_t num_rebuilds = 0;
+      for (uint32_t frame = 0; frame < options.frames; frame++) {
+        animated_scene.Animate();
+        
+        auto update_start_time = std::chrono::high_resolution_clock::now();
+        if (strategy == Strategy::Rebuild) {
+          scene.BuildAccelerationStructure();
+          num_rebuilds++;
+        }
+        else {
+          num_rebuilds += scene.UpdateAccelerationStructure(&thread_pool) ? 1 : 0;
+        }
+        auto trace_start_time = std::chrono::high_resolution_clock::now();
+        update_time_ms += std::chrono::duration<double, std::milli>(trace_start_time - update_start_time).count();
+        
+        // Same rays in every frame and strategy
+        std::atomic<uint32_t> num_hits = 0;
+        thread_pool.ParallelFor(kNumRays / 256, [&](uint32_t batch_idx, uint32_t) {
+          uint32_t batch_hits = 0;
+          for (uint32_t i = batch_idx * 256; i < (batch_idx + 1) * 256; i++) {
+            RandomGenerator rng = RandomGenerator::ForPixel(i, 1, 0, options.seed);
+            Ray ray(rng.NextVec3(-animated_scene.half_size, animated_scene.half_size), rng.OnUnitSphere());
+            RayScene::Hit hit;
+            batch_hits += scene.Intersect(ray, options.sphere_kernel, hit) ? 1 : 0;
+          }
+          num_hits.fetch_add(batch_hits, std::memory_order_relaxed);
+        });
+        trace_time_ms += std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                   trace_start_time).count();
+      }
+      
+      double rays_per_second = trace_time_ms > 0.0 ? (double)kNumRays * options.frames / (trace_time_ms / 1000.0) : 0.0;
+      printf("%10u %-16s %12.3f %11.3fM %10u %10.3f\n", num_spheres, GetStrategyName(strategy),
+             update_time_ms / options.frames, rays_per_second / 1e6, num_rebuilds, scene.bvh.GetCost());
+    }
+  }
+  
+  int BvhBenchmark::Run(const CliOptions& options) {
+    ThreadPool thread_pool;
+    printf("BVH benchmark : %u spheres, %u frames, %u threads\n", options.bvh_benchmark_spheres, options.frames,
+           thread_pool.GetNumThreads());
+    printf("%10s %-16s %12s %12s %10s %10s\n", "Spheres", "Strategy", "Update (ms)", "Rays / sec", "Rebuilds",
+           "SAH cost");
+    
+    // Sweep grows the sphere count 4 times each step, so that scaling of update time and tree quality is visible
+    if (options.bvh_sweep) {
+      for (uint32_t num_spheres = kSweepStartSpheres; num_spheres < options.bvh_benchmark_spheres; num_spheres *= 4)
+        RunStrategies(options, num_spheres, thread_pool);
+    }
+    RunStrategies(options, options.bvh_benchmark_spheres, thread_pool);
+    return 0;
+  }
+  
+}
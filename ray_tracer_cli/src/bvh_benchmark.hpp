@@ -0,0 +1,27 @@
+//
+//  bvh_benchmark.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "cli_options.hpp"
+
+namespace ray_tracer {
+  
+  /// This class measures the cost of keeping the BVH of animated spheres up to date. Random spheres move every
+  /// frame, and the BVH is either rebuilt, refit or refit with rebuild on SAH cost growth. Update time and ray
+  /// throughput of the updated tree are reported for each strategy, either for one sphere count or for a sweep of
+  /// growing counts
+  class BvhBenchmark {
+  public:
+    /// This function runs the benchmark and prints the results. Returns exit code of tool
+    /// - Parameter options: command line options (spheres, frames, sweep, seed and kernel are used)
+    static int Run(const CliOptions& options);
+    
+    MAKE_PURE_STATIC(BvhBenchmark);
+  };
+  
+}
@@ -0,0 +1,226 @@
+//
+//  cli_options.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "cli_options.hpp"
+
+namespace ray_tracer {
+  
+  /// This function parses the unsigned integer argument
+  static bool ParseUInt(const char* value, uint32_t& result) {
+    char* end = nullptr;
+    unsigned long parsed = std::strtoul(value, &end, 10);
+    if (end == value or *end != '\0' or parsed > std::numeric_limits<uint32_t>::max())
+      return false;
+    result = (uint32_t)parsed;
+    return true;
+  }
+  
+  /// This function parses the floating point argument
+  static bool ParseFloat(const char* value, float& result) {
+    char* end = nullptr;
+    result = std::strtof(value, &end);
+    return end != value and *end == '\0';
+  }
+  
+  void CliOptions::PrintUsage(const char* program) {
+    printf("Usage: %s <scene.yml> [options]\n", program);
+    printf("       %s --bvh-benchmark <spheres> [--frames <count>] [--sweep] [--seed <value>] [--kernel <name>]\n",
+           program);
+    printf("       %s <scene.yml> --sampler-benchmark <samples> [--reference <samples>] [options]\n", program);
+    printf("       %s <scene.yml> --edit-benchmark <material> [options]\n", program);
+    printf("       %s --merge <output.ckpt> <input.ckpt> <input.ckpt> ... [-o <image>] [--denoise]\n", program);
+    printf("       %s <scene.yml> --farm <workers> [--farm-samples <count>] [--farm-timeout <s>] [options]\n",
+           program);
+    printf("Options:\n");
+    printf("  -o, --output <path>    Output image (.png or .ppm). Default render.png\n");
+    printf("  -w, --width <pixels>   Image width. Default 1280\n");
+    printf("  -h, --height <pixels>  Image height. Default 720\n");
+    printf("  -s, --samples <count>  Samples per pixel. Default 64\n");
+    printf("      --seed <value>     Seed of random generator. Default 0\n");
+    printf("      --tile <pixels>    Tile size. Default 32\n");
+    printf("      --kernel <name>    Sphere kernel : scalar, simd4 or simd8. Default best supported\n");
+    printf("      --integrator <name> Path integrator : megakernel or wavefront. Default megakernel\n");
+    printf("      --sampler <name>   Sample sequence : random, sobol or bluenoise. Default sobol\n");
+    printf("      --max-depth <rays> Maximum rays traced per path. Default 10\n");
+    printf("      --no-roulette      Disable russian roulette path termination\n");
+    printf("      --no-nee           Disable light sampling. Lights are only found by BSDF sampled rays\n");
+    printf("      --adaptive         Stop sampling converged tiles and spend the samples on noisy tiles\n");
+    printf("      --threshold <err>  Relative error of converged tile for adaptive sampling. Default 0.02\n");
+    printf("      --heatmap <path>   Write the heatmap of samples spent per pixel\n");
+    printf("      --denoise          Filter the image using albedo, normal and depth of first hit\n");
+    printf("      --async <ms>       Trace on background thread like editor : render is called at 60 Hz and uploads\n");
+    printf("                         finished tiles for at most <ms> per call\n");
+    printf("      --bvh-benchmark <spheres> Compare BVH rebuild and refit for animated random spheres\n");
+    printf("      --frames <count>   Animated frames of BVH benchmark. Default 60\n");
+    printf("      --sweep            Run BVH benchmark for 1K, 4K, 16K ... spheres up to <spheres>\n");
+    printf("      --sampler-benchmark <samples> Compare error vs samples per pixel of all the samplers\n");
+    printf("      --reference <samples> Samples of reference image of sampler benchmark. Default 16 x samples\n");
+    printf("      --edit-benchmark <material> Change the albedo of material after render, and compare re-render of\n");
+    printf("                         dirty region with full re-render\n");
+    printf("      --checkpoint <path> Write the accumulated samples to checkpoint after render\n");
+    printf("      --checkpoint-every <frames> Also write the checkpoint after every <frames> frames\n");
+    printf("      --resume <path>    Continue the render of checkpoint till total samples per pixel\n");
+    printf("      --merge <path>     Merge the checkpoints of renders with different seeds, weighted by samples\n");
+    printf("      --farm <workers>   Render with worker processes, which pull the regions and sample ranges and\n");
+    printf("                         send back their samples. Job of a dead worker is traced by other worker\n");
+    printf("      --farm-samples <count> Samples per pixel of one job of farm. Default 16\n");
+    printf("      --farm-timeout <s> Worker taking longer for one job is stopped, and the job is traced by other\n");
+    printf("                         worker. Default 60\n");
+    printf("      --help             Print this message\n");
+  }
+  
+  bool CliOptions::Parse(int argc, const char* argv[]) {
+    std::vector<std::string> positional_args;
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (arg == "--help") {
+        return false;
+      }
+      if (arg == "--no-roulette") {
+        russian_roulette = false;
+        continue;
+      }
+      if (arg == "--no-nee") {
+        next_event_estimation = false;
+        continue;
+      }
+      if (arg == "--adaptive") {
+        adaptive_sampling = true;
+        continue;
+      }
+      if (arg == "--denoise") {
+        denoise = true;
+        continue;
+      }
+      if (arg == "--sweep") {
+        bvh_sweep = true;
+        continue;
+      }
+      
+      // Scene path, or input checkpoints of merge, are the only arguments without option name
+      if (arg[0] != '-') {
+        positional_args.push_back(arg);
+        continue;
+      }
+      
+      if (i + 1 >= argc) {
+        printf("Missing value for %s\n", arg.c_str());
+        return false;
+      }
+      const char* value = argv[++i];
+      
+      bool valid = true;
+      if (arg == "-o" or arg == "--output") output_path = value;
+      else if (arg == "-w" or arg == "--width") valid = ParseUInt(value, width) and width > 0;
+      else if (arg == "-h" or arg == "--height") valid = ParseUInt(value, height) and height > 0;
+      else if (arg == "-s" or arg == "--samples") valid = ParseUInt(value, samples) and samples > 0;
+      else if (arg == "--seed") valid = ParseUInt(value, seed);
+      else if (arg == "--tile") valid = ParseUInt(value, tile_size) and tile_size > 0;
+      else if (arg == "--max-depth") valid = ParseUInt(value, max_depth) and max_depth > 0;
+      else if (arg == "--threshold") valid = ParseFloat(value, adaptive_threshold) and adaptive_threshold > 0.0f;
+      else if (arg == "--heatmap") heatmap_path = value;
+      else if (arg == "--async") valid = ParseFloat(value, async_budget_ms) and async_budget_ms > 0.0f;
+      else if (arg == "--bvh-benchmark") valid = ParseUInt(value, bvh_benchmark_spheres) and bvh_benchmark_spheres > 0;
+      else if (arg == "--frames") valid = ParseUInt(value, frames) and frames > 0;
+      else if (arg == "--sampler-benchmark")
+        valid = ParseUInt(value, sampler_benchmark_samples) and sampler_benchmark_samples > 0;
+      else if (arg == "--reference") valid = ParseUInt(value, reference_samples) and reference_samples > 0;
+      else if (arg == "--checkpoint") checkpoint_path = value;
+      else if (arg == "--checkpoint-every") valid = ParseUInt(value, checkpoint_interval) and checkpoint_interval > 0;
+      else if (arg == "--resume") resume_path = value;
+      else if (arg == "--merge") merge_output_path = value;
+      else if (arg == "--farm") valid = ParseUInt(value, farm_workers) and farm_workers > 0;
+      else if (arg == "--farm-samples") valid = ParseUInt(value, farm_samples) and farm_samples > 0;
+      else if (arg == "--farm-timeout") valid = ParseUInt(value, farm_timeout) and farm_timeout > 0;
+      else if (arg == "--farm-worker") {
+        uint32_t socket = 0;
+        valid = ParseUInt(value, socket) and socket <= (uint32_t)std::numeric_limits<int32_t>::max();
+        farm_worker_socket = (int32_t)socket;
+      }
+      else if (arg == "--edit-benchmark") {
+        uint32_t material = 0;
+        valid = ParseUInt(value, material) and material <= (uint32_t)std::numeric_limits<int32_t>::max();
+        edit_benchmark_material = (int32_t)material;
+      }
+      else if (arg == "--sampler") {
+        std::string name = value;
+        if (name == "random") sampler = ikan::RaySampler::Type::Random;
+        else if (name == "sobol") sampler = ikan::RaySampler::Type::Sobol;
+        else if (name == "bluenoise") sampler = ikan::RaySampler::Type::BlueNoise;
+        else valid = false;
+      }
+      else if (arg == "--integrator") {
+        std::string name = value;
+        if (name == "megakernel") integrator = ikan::RayRenderer::Integrator::Megakernel;
+        else if (name == "wavefront") integrator = ikan::RayRenderer::Integrator::Wavefront;
+        else valid = false;
+      }
+      else if (arg == "--kernel") {
+        std::string kernel = value;
+        if (kernel == "scalar") sphere_kernel = ikan::RaySphereSoA::Kernel::Scalar;
+        else if (kernel == "simd4") sphere_kernel = ikan::RaySphereSoA::Kernel::Simd4;
+        else if (kernel == "simd8") sphere_kernel = ikan::RaySphereSoA::Kernel::Simd8;
+        else valid = false;
+        
+        if (valid and !ikan::RaySphereSoA::IsSupported(sphere_kernel)) {
+          printf("Kernel %s is not supported on this machine\n", value);
+          return false;
+        }
+      }
+      else {
+        printf("Unknown option %s\n", arg.c_str());
+        return false;
+      }
+      
+      if (!valid) {
+        printf("Invalid value %s for %s\n", value, arg.c_str());
+        return false;
+      }
+    }
+    
+    if (!merge_output_path.empty()) {
+      if (positional_args.size() < 2) {
+        printf("At least two checkpoints are needed to merge\n");
+        return false;
+      }
+      merge_input_paths = positional_args;
+      return true;
+    }
+    
+    if (positional_args.size() > 1) {
+      printf("Only one scene can be rendered. Unexpected argument %s\n", positional_args[1].c_str());
+      return false;
+    }
+    if (!positional_args.empty())
+      scene_path = positional_args[0];
+    if (scene_path.empty() and bvh_benchmark_spheres == 0) {
+      printf("Scene file is not provided\n");
+      return false;
+    }
+    // Farm starts its jobs from first sample, so resumed samples would be traced again
+    if (farm_workers > 0 and !resume_path.empty()) {
+      printf("Farm can not resume a checkpoint, resume it without --farm\n");
+      return false;
+    }
+    return true;
+  }
+  
+  void CliOptions::Apply(ikan::RayRenderer::Setting& setting) const {
+    setting.accumulate = true;
+    setting.seed = seed;
+    setting.tile_size = tile_size;
+    setting.sphere_kernel = sphere_kernel;
+    setting.integrator = integrator;
+    setting.sampler = sampler;
+    setting.max_depth = max_depth;
+    setting.russian_roulette = russian_roulette;
+    setting.next_event_estimation = next_event_estimation;
+    setting.adaptive_sampling = adaptive_sampling;
+    setting.adaptive_threshold = adaptive_threshold;
+  }
+  
+}
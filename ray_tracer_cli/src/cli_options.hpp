@@ -0,0 +1,69 @@
+//
+//  cli_options.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+namespace ray_tracer {
+  
+  /// Options of the ray tracer command line tool
+  struct CliOptions {
+    std::string scene_path;
+    std::string output_path = "render.png";
+    
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    uint32_t samples = 64;   // Samples (accumulated frames) per pixel
+    uint32_t seed = 0;
+    uint32_t tile_size = 32;
+    uint32_t max_depth = 10;
+    bool russian_roulette = true;
+    bool next_event_estimation = true;
+    
+    bool adaptive_sampling = false; // Off by default, so that every pixel gets exactly 'samples' samples
+    float adaptive_threshold = 0.02f;
+    std::string heatmap_path; // Image of samples spent per pixel. Not written if empty
+    
+    bool denoise = false;
+    float async_budget_ms = 0.0f; // Trace on background thread and upload within this budget at 60 Hz if not 0
+    ikan::RaySphereSoA::Kernel sphere_kernel = ikan::RaySphereSoA::GetBestKernel();
+    ikan::RayRenderer::Integrator integrator = ikan::RayRenderer::Integrator::Megakernel;
+    ikan::RaySampler::Type sampler = ikan::RaySampler::Type::Sobol;
+    
+    uint32_t bvh_benchmark_spheres = 0; // Run the BVH update benchmark instead of rendering if not 0
+    uint32_t frames = 60; // Animated frames of BVH benchmark
+    bool bvh_sweep = false; // Run the BVH benchmark for growing sphere counts up to 'bvh_benchmark_spheres'
+    
+    uint32_t sampler_benchmark_samples = 0; // Run the sampler error benchmark up to these samples if not 0
+    uint32_t reference_samples = 0; // Samples of reference image of sampler benchmark. 16 x benchmark samples if 0
+    
+    int32_t edit_benchmark_material = -1; // Run the material edit benchmark on this material if not -1
+    
+    std::string checkpoint_path; // Checkpoint written after render. Not written if empty
+    uint32_t checkpoint_interval = 0; // Checkpoint is also written after every these many frames if not 0
+    std::string resume_path; // Render continues from this checkpoint if not empty
+    std::string merge_output_path; // Merge the input checkpoints to this checkpoint instead of rendering if not empty
+    std::vector<std::string> merge_input_paths;
+    
+    uint32_t farm_workers = 0; // Render with these many worker processes if not 0
+    uint32_t farm_samples = 16; // Samples per pixel of one job of farm
+    uint32_t farm_timeout = 60; // Seconds a worker may spend on one job before it is stopped and the job traced again
+    int32_t farm_worker_socket = -1; // Run as farm worker on this socket of coordinator if not -1
+    
+    /// This function parses the command line arguments. Prints the usage and returns false for invalid arguments
+    /// - Parameters:
+    ///   - argc: number of arguments
+    ///   - argv: arguments
+    bool Parse(int argc, const char* argv[]);
+    /// This function copies the render options to renderer setting
+    /// - Parameter setting: setting of renderer
+    void Apply(ikan::RayRenderer::Setting& setting) const;
+    /// This function prints the usage of command line tool
+    /// - Parameter program: name of executable
+    static void PrintUsage(const char* program);
+  };
+  
+}
@@ -0,0 +1,107 @@
+//
+//  edit_benchmark.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "edit_benchmark.hpp"
+#include "image_compare.hpp"
+
+using namespace ikan;
+
+namespace ray_tracer {
+  
+  /// Work of renders of one image
+  struct RenderCost {
+    double render_time_ms = 0.0;
+    uint64_t num_paths = 0;
+  };
+  
+  /// This function renders the frames of all the samples. Tiles that already have all the frames trace nothing
+  /// - Parameters:
+  ///   - renderer: renderer
+  ///   - scene: scene to be rendered
+  ///   - camera: camera of scene
+  ///   - num_frames: number of frames
+  static RenderCost Render(RayRenderer& renderer, const RayScene& scene, const RayCamera& camera, uint32_t num_frames) {
+    RenderCost cost;
+    for (uint32_t frame = 0; frame < num_frames; frame++) {
+      renderer.Render(scene, camera);
+      cost.render_time_ms += renderer.GetStatistics().render_time_ms;
+      cost.num_paths += renderer.GetStatistics().num_paths;
+    }
+    return cost;
+  }
+  
+  int EditBenchmark::Run(const CliOptions& options) {
+    RayScene scene;
+    RayCamera camera;
+    RaySceneSerializer serializer(&scene, &camera);
+    if (!serializer.Deserialize(options.scene_path)) {
+      printf("Failed to load scene %s\n", options.scene_path.c_str());
+      return 1;
+    }
+    camera.SetViewportSize(options.width, options.height);
+    
+    const uint32_t material_idx = (uint32_t)options.edit_benchmark_material;
+    if (material_idx >= scene.materials.size()) {
+      printf("Scene has no material %u\n", material_idx);
+      return 1;
+    }
+    printf("Edit benchmark : %s, %u x %u, %u samples per pixel\n", options.scene_path.c_str(), options.width,
+           options.height, options.samples);
+    
+    // Frames are limited, so that tiles restarted by edit get same samples as a full render
+    auto create_renderer = [&options](uint32_t seed) {
+      auto renderer = std::make_unique<RayRenderer>(true /* headless */);
+      options.Apply(renderer->GetSetting());
+      renderer->GetSetting().seed = seed;
+      renderer->GetSetting().max_frames = options.samples;
+      renderer->Resize(options.width, options.height);
+      return renderer;
+    };
+    
+    std::unique_ptr<RayRenderer> renderer = create_renderer(options.seed);
+    Render(*renderer, scene, camera, options.samples);
+    
+    // Channels of albedo are rotated, so that surface changes its color but not its brightness much
+    RayMaterial& material = scene.materials[material_idx];
+    const glm::vec3 old_albedo = material.albedo;
+    material.albedo = glm::vec3(old_albedo.b, old_albedo.r, old_albedo.g);
+    renderer->InvalidateMaterial(scene, material_idx);
+    
+    const RenderCost dirty_cost = Render(*renderer, scene, camera, options.samples);
+    const RayRenderer::Statistics& statistics = renderer->GetStatistics();
+    const std::vector<glm::vec3> dirty_image = ImageCompare::GetImage(*renderer);
+    
+    std::unique_ptr<RayRenderer> full_renderer = create_renderer(options.seed);
+    const RenderCost full_cost = Render(*full_renderer, scene, camera, options.samples);
+    const std::vector<glm::vec3> full_image = ImageCompare::GetImage(*full_renderer);
+    
+    // Difference of independent renders of edited scene is the error that can not be told from noise
+    std::unique_ptr<RayRenderer> other_renderer = create_renderer(options.seed + 1);
+    Render(*other_renderer, scene, camera, options.samples);
+    const std::vector<glm::vec3> other_image = ImageCompare::GetImage(*other_renderer);
+    
+    const uint64_t num_pixels = (uint64_t)options.width * options.height;
+    printf("Edit       : albedo of material %u (%.2f, %.2f, %.2f) -> (%.2f, %.2f, %.2f)\n", material_idx,
+           old_albedo.r, old_albedo.g, old_albedo.b, material.albedo.r, material.albedo.g, material.albedo.b);
+    if (scene.IsLightMaterial(material_idx))
+      printf("Dirty      : emissive material, whole image restarted\n");
+    else
+      printf("Dirty      : %u tiles, %llu of %llu pixels (%.1f%%) restarted\n",
+             statistics.num_invalidated_tiles, (unsigned long long)statistics.num_invalidated_pixels,
+             (unsigned long long)num_pixels, 100.0 * statistics.num_invalidated_pixels / num_pixels);
+    printf("%-11s: %10s  %12s\n", "Re-render", "Time (ms)", "Paths");
+    printf("%-11s: %10.3f  %12llu\n", "  Dirty", dirty_cost.render_time_ms, (unsigned long long)dirty_cost.num_paths);
+    printf("%-11s: %10.3f  %12llu\n", "  Full", full_cost.render_time_ms, (unsigned long long)full_cost.num_paths);
+    printf("Speedup    : %.2f x\n",
+           dirty_cost.render_time_ms > 0.0 ? full_cost.render_time_ms / dirty_cost.render_time_ms : 0.0);
+    printf("RMSE       : %.3f dirty vs full, %.3f full vs other seed (noise)\n",
+           ImageCompare::GetError(dirty_image, full_image, options.width, options.height),
+           ImageCompare::GetError(other_image, full_image, options.width, options.height));
+    return 0;
+  }
+  
+}
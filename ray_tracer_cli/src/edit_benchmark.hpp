@@ -0,0 +1,26 @@
+//
+//  edit_benchmark.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "cli_options.hpp"
+
+namespace ray_tracer {
+  
+  /// This class measures the re-render of a material edit. Scene is accumulated, the albedo of material is changed
+  /// and only the dirty region is accumulated again. Its cost and result are compared with restarting the whole
+  /// accumulation, and the difference is printed next to the noise of two full renders of other seeds
+  class EditBenchmark {
+  public:
+    /// This function runs the benchmark and prints the results. Returns exit code of tool
+    /// - Parameter options: command line options (scene, size, render options, samples and material are used)
+    static int Run(const CliOptions& options);
+    
+    MAKE_PURE_STATIC(EditBenchmark);
+  };
+  
+}
@@ -0,0 +1,46 @@
+//
+//  image_compare.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "image_compare.hpp"
+
+using namespace ikan;
+
+namespace ray_tracer {
+  
+  std::vector<glm::vec3> ImageCompare::GetImage(const RayRenderer& renderer) {
+    std::vector<glm::vec3> image((size_t)renderer.GetWidth() * renderer.GetHeight());
+    const uint32_t* data = renderer.GetImageData();
+    for (size_t i = 0; i < image.size(); i++)
+      image[i] = glm::vec3(data[i] & 0xff, (data[i] >> 8) & 0xff, (data[i] >> 16) & 0xff);
+    return image;
+  }
+  
+  double ImageCompare::GetError(const std::vector<glm::vec3>& image,
+                                const std::vector<glm::vec3>& reference,
+                                uint32_t width,
+                                uint32_t height,
+                                int32_t blur_radius) {
+    double sum = 0.0;
+    for (int32_t y = 0; y < (int32_t)height; y++) {
+      for (int32_t x = 0; x < (int32_t)width; x++) {
+        glm::vec3 error(0.0f);
+        uint32_t count = 0;
+        for (int32_t by = std::max(y - blur_radius, 0); by <= std::min(y + blur_radius, (int32_t)height - 1); by++) {
+          for (int32_t bx = std::max(x - blur_radius, 0); bx <= std::min(x + blur_radius, (int32_t)width - 1); bx++) {
+            size_t pixel_idx = (size_t)by * width + bx;
+            error += image[pixel_idx] - reference[pixel_idx];
+            count++;
+          }
+        }
+        error /= (float)count;
+        sum += glm::dot(error, error) / 3.0;
+      }
+    }
+    return std::sqrt(sum / ((double)width * height));
+  }
+  
+}
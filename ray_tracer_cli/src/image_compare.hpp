@@ -0,0 +1,34 @@
+//
+//  image_compare.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+namespace ray_tracer {
+  
+  /// This class compares the rendered images of benchmarks
+  class ImageCompare {
+  public:
+    /// This function returns the 8 bit color of renderer image as float
+    /// - Parameter renderer: renderer
+    static std::vector<glm::vec3> GetImage(const ikan::RayRenderer& renderer);
+    /// This function returns the root mean square error of image
+    /// - Parameters:
+    ///   - image: image
+    ///   - reference: reference image
+    ///   - width: width of image
+    ///   - height: height of image
+    ///   - blur_radius: error of pixel is averaged over the box of this radius before squaring. 0 for plain RMSE
+    static double GetError(const std::vector<glm::vec3>& image,
+                           const std::vector<glm::vec3>& reference,
+                           uint32_t width,
+                           uint32_t height,
+                           int32_t blur_radius = 0);
+    
+    MAKE_PURE_STATIC(ImageCompare);
+  };
+  
+}
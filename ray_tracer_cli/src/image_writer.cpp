@@ -0,0 +1,61 @@
+//
+//  image_writer.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "image_writer.hpp"
+
+#include <filesystem>
+#include <stb_image_write.h>
+
+namespace ray_tracer {
+  
+  /// This function returns the RGB bytes of image rows from top to bottom
+  static std::vector<uint8_t> GetRgbRows(const uint32_t* pixels, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> data((size_t)width * height * 3);
+    for (uint32_t y = 0; y < height; y++) {
+      // Renderer stores bottom row first
+      const uint32_t* src_row = pixels + (size_t)(height - 1 - y) * width;
+      uint8_t* dst_row = data.data() + (size_t)y * width * 3;
+      for (uint32_t x = 0; x < width; x++) {
+        uint32_t pixel = src_row[x];
+        *dst_row++ = uint8_t(pixel & 0xff);
+        *dst_row++ = uint8_t((pixel >> 8) & 0xff);
+        *dst_row++ = uint8_t((pixel >> 16) & 0xff);
+      }
+    }
+    return data;
+  }
+  
+  bool ImageWriter::Write(const std::string& file_path, const uint32_t* pixels, uint32_t width, uint32_t height) {
+    std::string extension = std::filesystem::path(file_path).extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    
+    if (extension == ".png")
+      return WritePNG(file_path, pixels, width, height);
+    if (extension == ".ppm")
+      return WritePPM(file_path, pixels, width, height);
+    
+    IK_ERROR("Image Writer", "Unsupported image format {0}. Use .png or .ppm", extension);
+    return false;
+  }
+  
+  bool ImageWriter::WritePPM(const std::string& file_path, const uint32_t* pixels, uint32_t width, uint32_t height) {
+    std::ofstream file(file_path, std::ios::binary);
+    if (!file)
+      return false;
+    
+    std::vector<uint8_t> data = GetRgbRows(pixels, width, height);
+    file << "P6\n" << width << " " << height << "\n255\n";
+    file.write((const char*)data.data(), data.size());
+    return file.good();
+  }
+  
+  bool ImageWriter::WritePNG(const std::string& file_path, const uint32_t* pixels, uint32_t width, uint32_t height) {
+    std::vector<uint8_t> data = GetRgbRows(pixels, width, height);
+    return stbi_write_png(file_path.c_str(), (int)width, (int)height, 3, data.data(), (int)width * 3) != 0;
+  }
+  
+}
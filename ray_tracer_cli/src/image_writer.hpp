@@ -0,0 +1,40 @@
+//
+//  image_writer.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+namespace ray_tracer {
+  
+  /// This class writes the RGBA8 pixels of ray renderer to image file. PNG is encoded by stb_image_write
+  class ImageWriter {
+  public:
+    /// This function writes the image. Format is selected from extension of path (.png or .ppm)
+    /// - Parameters:
+    ///   - file_path: path of image file
+    ///   - pixels: RGBA8 pixels, first row is bottom of the image
+    ///   - width: width of image
+    ///   - height: height of image
+    static bool Write(const std::string& file_path, const uint32_t* pixels, uint32_t width, uint32_t height);
+    /// This function writes the image as binary PPM (P6)
+    /// - Parameters:
+    ///   - file_path: path of image file
+    ///   - pixels: RGBA8 pixels, first row is bottom of the image
+    ///   - width: width of image
+    ///   - height: height of image
+    static bool WritePPM(const std::string& file_path, const uint32_t* pixels, uint32_t width, uint32_t height);
+    /// This function writes the image as compressed PNG
+    /// - Parameters:
+    ///   - file_path: path of image file
+    ///   - pixels: RGBA8 pixels, first row is bottom of the image
+    ///   - width: width of image
+    ///   - height: height of image
+    static bool WritePNG(const std::string& file_path, const uint32_t* pixels, uint32_t width, uint32_t height);
+    
+    MAKE_PURE_STATIC(ImageWriter);
+  };
+  
+}
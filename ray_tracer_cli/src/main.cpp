@@ -0,0 +1,240 @@
+//
+//  main.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+// Command line tool to render the ray tracing scene without window or graphics context. Used for batch renders
+// and performance tracking on headless machines
+//
+//   ray_tracer_cli assets/scenes/spheres.yml -o spheres.png -w 1280 -h 720 -s 64
+//   ray_tracer_cli --bvh-benchmark 300000 --frames 60
+//   ray_tracer_cli assets/scenes/lights.yml --sampler-benchmark 256 -w 320 -h 180
+//   ray_tracer_cli assets/scenes/meshes.yml --edit-benchmark 1 -w 320 -h 180
+//   ray_tracer_cli assets/scenes/spheres.yml -s 1024 --checkpoint spheres.ckpt --checkpoint-every 64
+//   ray_tracer_cli --merge merged.ckpt seed_0.ckpt seed_1.ckpt -o merged.png
+//   ray_tracer_cli assets/scenes/meshes.yml -s 256 --farm 4 -o meshes.png
+
+#include "cli_options.hpp"
+#include "image_writer.hpp"
+#include "bvh_benchmark.hpp"
+#include "sampler_benchmark.hpp"
+#include "edit_benchmark.hpp"
+#include "render_farm.hpp"
+#include <unistd.h>
+
+using namespace ikan;
+using namespace ray_tracer;
+
+/// This function renders like the editor : 'Render()' is called at 60 Hz while background thread traces the
+/// samples, and time spent in each call is printed. Returns when all the samples are traced and uploaded. Checkpoint
+/// is written after every 'checkpoint_interval' frames
+static void RenderAsync(RayRenderer& renderer, const RayScene& scene, const RayCamera& camera,
+                        const CliOptions& options) {
+  static constexpr double kFrameTimeMs = 1000.0 / 60.0;
+  RayRenderer::Setting& setting = renderer.GetSetting();
+  setting.async_render = true;
+  setting.frame_budget_ms = options.async_budget_ms;
+  setting.max_frames = options.samples;
+  
+  // Statistics of resumed checkpoint are published before first frame
+  const uint32_t first_frame = renderer.GetStatistics().num_accumulated_frames;
+  uint32_t checkpoint_frame = first_frame;
+  uint32_t num_calls = 0;
+  uint64_t num_uploaded_tiles = 0;
+  double total_call_time_ms = 0.0, max_call_time_ms = 0.0;
+  while (true) {
+    auto call_start_time = std::chrono::high_resolution_clock::now();
+    renderer.Render(scene, camera);
+    double call_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                    call_start_time).count();
+    num_calls++;
+    total_call_time_ms += call_time_ms;
+    max_call_time_ms = std::max(max_call_time_ms, call_time_ms);
+    
+    // Adaptive sampling can converge all the tiles before the last frame. Frame cancelled by checkpoint may also
+    // trace nothing, so only the frames after last checkpoint are checked
+    const RayRenderer::Statistics& statistics = renderer.GetStatistics();
+    num_uploaded_tiles += statistics.num_uploaded_tiles;
+    bool traced = statistics.num_accumulated_frames >= options.samples or
+    (statistics.num_accumulated_frames > checkpoint_frame and statistics.num_paths == 0);
+    if (traced and statistics.num_pending_tiles == 0)
+      break;
+    
+    // Saving stops the background thread, and next 'Render()' starts it again from the saved samples
+    const uint32_t num_frames = statistics.num_accumulated_frames;
+    if (!options.checkpoint_path.empty() and options.checkpoint_interval > 0 and num_frames < options.samples and
+        num_frames / options.checkpoint_interval > checkpoint_frame / options.checkpoint_interval) {
+      renderer.SaveCheckpoint(options.checkpoint_path);
+      checkpoint_frame = num_frames;
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double, std::milli>(std::max(kFrameTimeMs - call_time_ms, 0.0)));
+  }
+  renderer.StopAsyncRender();
+  
+  printf("Async      : %u render calls, %.3f ms average, %.3f ms max (budget %.3f ms), %llu tiles uploaded\n",
+         num_calls, total_call_time_ms / num_calls, max_call_time_ms, options.async_budget_ms,
+         (unsigned long long)num_uploaded_tiles);
+}
+
+/// This function merges the checkpoints of independent renders and writes the image of merged samples. Returns
+/// exit code of tool
+static int MergeCheckpoints(const CliOptions& options) {
+  if (!RayCheckpoint::Merge(options.merge_input_paths, options.merge_output_path)) {
+    printf("Failed to merge the checkpoints. Renders must have same view and setting, and different seed\n");
+    return 1;
+  }
+  
+  RayRenderer renderer(true /* headless */);
+  renderer.GetSetting().denoise = options.denoise;
+  if (!renderer.LoadCheckpoint(options.merge_output_path)) {
+    printf("Failed to load merged checkpoint %s\n", options.merge_output_path.c_str());
+    return 1;
+  }
+  if (!ImageWriter::Write(options.output_path, renderer.GetImageData(), renderer.GetWidth(), renderer.GetHeight())) {
+    printf("Failed to write image %s\n", options.output_path.c_str());
+    return 1;
+  }
+  printf("Merged     : %zu checkpoints to %s, %u x %u, %u frames\n", options.merge_input_paths.size(),
+         options.merge_output_path.c_str(), renderer.GetWidth(), renderer.GetHeight(),
+         renderer.GetStatistics().num_accumulated_frames);
+  printf("Output     : %s\n", options.output_path.c_str());
+  return 0;
+}
+
+int main(int argc, const char* argv[]) {
+  CliOptions options;
+  if (!options.Parse(argc, argv)) {
+    CliOptions::PrintUsage(argv[0]);
+    return 1;
+  }
+  
+  // Only warnings of engine are printed, so that output of tool stays readable. Farm workers write their own log,
+  // as opening the log of coordinator again would truncate it
+  const std::string log_file_name = options.farm_worker_socket >= 0 ?
+  "ray_tracer_cli_worker_" + std::to_string(getpid()) : "ray_tracer_cli";
+  Logger::Init(Logger::Level::Warning, /* Core Log Level */
+               Logger::Level::Info, /* Client Log Level */
+               ".", /* Log saving folder */
+               log_file_name); /* Log file name to be saved */
+  
+  if (options.farm_worker_socket >= 0)
+    return RenderFarm::RunWorker(options);
+  if (options.farm_workers > 0)
+    return RenderFarm::Run(options, argc, argv);
+  if (options.bvh_benchmark_spheres > 0)
+    return BvhBenchmark::Run(options);
+  if (options.sampler_benchmark_samples > 0)
+    return SamplerBenchmark::Run(options);
+  if (options.edit_benchmark_material >= 0)
+    return EditBenchmark::Run(options);
+  if (!options.merge_output_path.empty())
+    return MergeCheckpoints(options);
+  
+  auto wall_start_time = std::chrono::high_resolution_clock::now();
+  
+  RayScene scene;
+  RayCamera camera;
+  RaySceneSerializer serializer(&scene, &camera);
+  if (!serializer.Deserialize(options.scene_path)) {
+    printf("Failed to load scene %s\n", options.scene_path.c_str());
+    return 1;
+  }
+  camera.SetViewportSize(options.width, options.height);
+  
+  RayRenderer renderer(true /* headless */);
+  RayRenderer::Setting& setting = renderer.GetSetting();
+  options.Apply(setting);
+  renderer.Resize(options.width, options.height);
+  
+  // Checkpoint brings its size, sampler and path setting, so that its samples are continued
+  uint32_t first_frame = 0;
+  if (!options.resume_path.empty()) {
+    if (!renderer.LoadCheckpoint(options.resume_path)) {
+      printf("Failed to resume checkpoint %s\n", options.resume_path.c_str());
+      return 1;
+    }
+    first_frame = std::min(renderer.GetStatistics().num_accumulated_frames, options.samples);
+    options.width = renderer.GetWidth();
+    options.height = renderer.GetHeight();
+    camera.SetViewportSize(options.width, options.height);
+  }
+  
+  printf("Scene      : %s (%zu spheres, %zu mesh instances, %zu materials)\n", options.scene_path.c_str(),
+         scene.spheres.size(), scene.mesh_instances.size(), scene.materials.size());
+  printf("Resolution : %u x %u, %u samples per pixel\n", options.width, options.height, options.samples);
+  printf("Kernel     : %s, %s integrator, %s sampler\n", RaySphereSoA::GetKernelName(setting.sphere_kernel),
+         RayRenderer::GetIntegratorName(setting.integrator), RaySampler::GetTypeName(setting.sampler));
+  printf("Max depth  : %u, russian roulette %s, light sampling %s (%u lights)\n", setting.max_depth,
+         setting.russian_roulette ? "on" : "off", setting.next_event_estimation ? "on" : "off", scene.GetNumLights());
+  printf("Adaptive   : %s, denoise %s\n", setting.adaptive_sampling ? "on" : "off", options.denoise ? "on" : "off");
+  if (!options.resume_path.empty())
+    printf("Resumed    : %s at %u of %u frames\n", options.resume_path.c_str(), first_frame, options.samples);
+  
+  uint64_t total_rays = 0, total_paths = 0;
+  double total_render_time_ms = 0.0;
+  if (options.async_budget_ms > 0.0f) {
+    RenderAsync(renderer, scene, camera, options);
+  }
+  else {
+    for (uint32_t sample = first_frame; sample < options.samples; sample++) {
+      renderer.Render(scene, camera);
+      total_rays += renderer.GetStatistics().num_rays;
+      total_paths += renderer.GetStatistics().num_paths;
+      total_render_time_ms += renderer.GetStatistics().render_time_ms;
+      
+      if (!options.checkpoint_path.empty() and options.checkpoint_interval > 0 and
+          (sample + 1) % options.checkpoint_interval == 0 and sample + 1 < options.samples)
+        renderer.SaveCheckpoint(options.checkpoint_path);
+    }
+  }
+  
+  if (!options.checkpoint_path.empty() and !renderer.SaveCheckpoint(options.checkpoint_path)) {
+    printf("Failed to write checkpoint %s\n", options.checkpoint_path.c_str());
+    return 1;
+  }
+  
+  // Denoiser runs once on the final accumulation instead of after each sample
+  if (options.denoise) {
+    setting.denoise = true;
+    renderer.ResolveImage();
+  }
+  
+  if (!ImageWriter::Write(options.output_path, renderer.GetImageData(), renderer.GetWidth(), renderer.GetHeight())) {
+    printf("Failed to write image %s\n", options.output_path.c_str());
+    return 1;
+  }
+  
+  if (!options.heatmap_path.empty()) {
+    setting.denoise = false;
+    setting.show_sample_heatmap = true;
+    renderer.ResolveImage();
+    if (!ImageWriter::Write(options.heatmap_path, renderer.GetImageData(), renderer.GetWidth(), renderer.GetHeight())) {
+      printf("Failed to write image %s\n", options.heatmap_path.c_str());
+      return 1;
+    }
+  }
+  
+  double wall_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                  wall_start_time).count();
+  double rays_per_second = total_render_time_ms > 0.0 ? total_rays / (total_render_time_ms / 1000.0) : 0.0;
+  
+  printf("Output     : %s\n", options.output_path.c_str());
+  if (!options.checkpoint_path.empty())
+    printf("Checkpoint : %s\n", options.checkpoint_path.c_str());
+  // Statistics of each frame are only seen by synchronous render
+  const bool synchronous = options.async_budget_ms <= 0.0f;
+  if (synchronous) {
+    printf("Rays       : %llu (%.3f per path)\n", (unsigned long long)total_rays,
+           total_paths > 0 ? (double)total_rays / total_paths : 0.0);
+    printf("Samples    : %.3f per pixel, %u converged tiles\n", (double)total_paths / (options.width * options.height),
+           renderer.GetStatistics().num_converged_tiles);
+    const uint32_t num_frames = std::max(options.samples - first_frame, 1u);
+    printf("Render     : %.3f ms (%.3f ms per sample)\n", total_render_time_ms, total_render_time_ms / num_frames);
+  }
+  printf("Wall time  : %.3f ms\n", wall_time_ms);
+  if (synchronous)
+    printf("Rays / sec : %.3f M\n", rays_per_second / 1e6);
+  return 0;
+}
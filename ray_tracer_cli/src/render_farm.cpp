@@ -0,0 +1,502 @@
+//
+//  render_farm.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "render_farm.hpp"
+#include "image_writer.hpp"
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <csignal>
+#include <cerrno>
+#include <cstring>
+
+using namespace ikan;
+
+namespace ray_tracer {
+  
+  /// Pixels per side of region of one job. Large enough that sending the result costs little next to tracing it
+  static constexpr uint32_t kJobRegionSize = 128;
+  /// Time a worker may take to send the rest of a message after sending its first bytes
+  static constexpr int32_t kReceiveTimeoutMs = 10000;
+  /// Time coordinator waits for messages before it checks the workers for timed out jobs
+  static constexpr int32_t kPollIntervalMs = 500;
+  
+  enum class MessageType : uint32_t {
+    Ready, Job, Result, Quit
+  };
+  
+  /// Header of each message
+  struct Message {
+    MessageType type = MessageType::Ready;
+    uint32_t job_idx = 0;
+    uint64_t payload_size = 0;
+  };
+  
+  /// Region and sample range traced by one job
+  struct Job {
+    RayRenderer::Region region;
+    uint32_t first_sample = 0;
+    uint32_t num_samples = 0;
+    uint32_t pass = 0;
+  };
+  
+  /// Counters of one job, sent before the buffers of result
+  struct ResultStatistics {
+    uint64_t num_rays = 0;
+    uint64_t num_paths = 0;
+    float render_time_ms = 0.0f;
+  };
+  
+  /// Result of one job received by coordinator
+  struct JobResult {
+    uint32_t job_idx = 0;
+    ResultStatistics statistics;
+    std::vector<glm::vec4> accumulation, albedo, normal_depth;
+    std::vector<float> luminance_sq;
+  };
+  
+  /// Worker process seen by coordinator
+  struct Worker {
+    pid_t pid = -1;
+    int socket = -1;
+    int32_t job_idx = -1; // Job in progress, -1 if idle
+    bool ready = false; // Scene is loaded, worker takes the jobs
+    std::chrono::steady_clock::time_point job_start_time; // Time when job in progress was sent
+  };
+  
+  /// This function writes all the bytes to socket. Returns false if other side is gone
+  /// - Parameters:
+  ///   - socket: socket
+  ///   - data: bytes to be written
+  ///   - size: number of bytes
+  static bool WriteAll(int socket, const void* data, size_t size) {
+    const char* bytes = static_cast<const char*>(data);
+    while (size > 0) {
+      ssize_t written = write(socket, bytes, size);
+      if (written < 0 and errno == EINTR)
+        continue;
+      if (written <= 0)
+        return false;
+      bytes += written;
+      size -= (size_t)written;
+    }
+    return true;
+  }
+  
+  /// This function reads all the bytes from socket. Returns false if other side is gone before sending them, or
+  /// if they are not received in time
+  /// - Parameters:
+  ///   - socket: socket
+  ///   - data: bytes output
+  ///   - size: number of bytes
+  ///   - timeout_ms: time to receive all the bytes. Waits forever if negative
+  static bool ReadAll(int socket, void* data, size_t size, int32_t timeout_ms = -1) {
+    char* bytes = static_cast<char*>(data);
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max(timeout_ms, 0));
+    while (size > 0) {
+      if (timeout_ms >= 0) {
+        const auto now = std::chrono::steady_clock::now();
+        const int64_t remaining_ms = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - now).count();
+        pollfd poll_fd = {socket, POLLIN, 0};
+        int ready = poll(&poll_fd, 1, (int)std::max<int64_t>(remaining_ms, 0));
+        if (ready < 0 and errno == EINTR)
+          continue;
+        if (ready <= 0)
+          return false;
+      }
+      ssize_t num_read = read(socket, bytes, size);
+      if (num_read < 0 and errno == EINTR)
+        continue;
+      if (num_read <= 0)
+        return false;
+      bytes += num_read;
+      size -= (size_t)num_read;
+    }
+    return true;
+  }
+  
+  /// This function sends the message with payload
+  /// - Parameters:
+  ///   - socket: socket
+  ///   - type: type of message
+  ///   - job_idx: index of job
+  ///   - payload: payload bytes
+  ///   - payload_size: number of payload bytes
+  static bool SendMessage(int socket, MessageType type, uint32_t job_idx = 0, const void* payload = nullptr,
+                          size_t payload_size = 0) {
+    Message message;
+    message.type = type;
+    message.job_idx = job_idx;
+    message.payload_size = payload_size;
+    return WriteAll(socket, &message, sizeof(Message)) and WriteAll(socket, payload, payload_size);
+  }
+  
+  /// This function copies the rows of region without padding. Returns the end of copied data
+  /// - Parameters:
+  ///   - output: output bytes
+  ///   - buffer: first pixel of region in buffer
+  ///   - region: region
+  ///   - stride: pixels from one row to next in buffer
+  template<typename T>
+  static char* PackRows(char* output, const T* buffer, const RayRenderer::Region& region, uint32_t stride) {
+    for (uint32_t y = 0; y < region.height; y++) {
+      std::memcpy(output, buffer + (size_t)y * stride, region.width * sizeof(T));
+      output += region.width * sizeof(T);
+    }
+    return output;
+  }
+  
+  /// This function starts the worker process, running this tool with the arguments of coordinator and the socket
+  /// - Parameters:
+  ///   - argc: number of arguments of tool
+  ///   - argv: arguments of tool
+  ///   - worker: worker output
+  static bool StartWorker(int argc, const char* argv[], Worker& worker) {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+      return false;
+    // Sockets are not inherited by other workers, so that death of a worker always closes its socket
+    fcntl(sockets[0], F_SETFD, FD_CLOEXEC);
+    fcntl(sockets[1], F_SETFD, FD_CLOEXEC);
+    
+    // Arguments are prepared before fork, as child may only exec
+    const std::string socket_arg = std::to_string(sockets[1]);
+    std::vector<const char*> args(argv, argv + argc);
+    args.push_back("--farm-worker");
+    args.push_back(socket_arg.c_str());
+    args.push_back(nullptr);
+    
+    pid_t pid = fork();
+    if (pid < 0) {
+      close(sockets[0]);
+      close(sockets[1]);
+      return false;
+    }
+    if (pid == 0) {
+      fcntl(sockets[1], F_SETFD, 0);
+      execvp(args[0], const_cast<char* const*>(args.data()));
+      _exit(127);
+    }
+    
+    close(sockets[1]);
+    worker.pid = pid;
+    worker.socket = sockets[0];
+    worker.job_idx = -1;
+    return true;
+  }
+  
+  /// This function closes the socket of worker and waits for its process
+  /// - Parameters:
+  ///   - worker: worker
+  ///   - kill_process: kill the process instead of waiting for it to quit, as a hung worker would never quit
+  static void StopWorker(Worker& worker, bool kill_process = false) {
+    if (worker.socket < 0)
+      return;
+    if (kill_process)
+      kill(worker.pid, SIGKILL);
+    close(worker.socket);
+    waitpid(worker.pid, nullptr, 0);
+    worker.socket = -1;
+    worker.job_idx = -1;
+  }
+  
+  /// This function asks all the workers to quit and waits for them, on every exit of coordinator
+  /// - Parameters:
+  ///   - workers: workers of farm
+  static void StopWorkers(std::vector<Worker>& workers) {
+    for (Worker& worker : workers) {
+      if (worker.socket >= 0)
+        SendMessage(worker.socket, MessageType::Quit);
+      // Worker tracing a job reads the quit message only after its job, so it is killed instead
+      StopWorker(worker, worker.job_idx >= 0 /* kill_process */);
+    }
+  }
+  
+  int RenderFarm::Run(const CliOptions& options, int argc, const char* argv[]) {
+    auto wall_start_time = std::chrono::high_resolution_clock::now();
+    // Write to socket of dead worker fails instead of killing the coordinator
+    signal(SIGPIPE, SIG_IGN);
+    
+    // Workers are started first, as child of a process with threads may only exec
+    std::vector<Worker> workers(options.farm_workers);
+    for (Worker& worker : workers) {
+      if (!StartWorker(argc, argv, worker)) {
+        printf("Failed to start worker : %s\n", strerror(errno));
+        StopWorkers(workers);
+        return 1;
+      }
+    }
+    
+    RayScene scene;
+    RayCamera camera;
+    RaySceneSerializer serializer(&scene, &camera);
+    if (!serializer.Deserialize(options.scene_path)) {
+      printf("Failed to load scene %s\n", options.scene_path.c_str());
+      StopWorkers(workers);
+      return 1;
+    }
+    camera.SetViewportSize(options.width, options.height);
+    
+    RayRenderer renderer(true /* headless */);
+    options.Apply(renderer.GetSetting());
+    renderer.Resize(options.width, options.height);
+    
+    // All the regions get the samples of a pass before next pass, so that image converges evenly
+    std::vector<Job> jobs;
+    const uint32_t num_passes = (options.samples + options.farm_samples - 1) / options.farm_samples;
+    for (uint32_t pass = 0; pass < num_passes; pass++) {
+      for (uint32_t y = 0; y < options.height; y += kJobRegionSize) {
+        for (uint32_t x = 0; x < options.width; x += kJobRegionSize) {
+          Job& job = jobs.emplace_back();
+          job.region.x = x;
+          job.region.y = y;
+          job.region.width = std::min(kJobRegionSize, options.width - x);
+          job.region.height = std::min(kJobRegionSize, options.height - y);
+          job.first_sample = pass * options.farm_samples;
+          job.num_samples = std::min(options.farm_samples, options.samples - job.first_sample);
+          job.pass = pass;
+        }
+      }
+    }
+    const uint32_t jobs_per_pass = (uint32_t)jobs.size() / num_passes;
+    
+    printf("Scene      : %s (%zu spheres, %zu mesh instances, %zu materials)\n", options.scene_path.c_str(),
+           scene.spheres.size(), scene.mesh_instances.size(), scene.materials.size());
+    printf("Resolution : %u x %u, %u samples per pixel\n", options.width, options.height, options.samples);
+    printf("Farm       : %u workers, %zu jobs (%u x %u pixels, %u samples)\n", options.farm_workers, jobs.size(),
+           kJobRegionSize, kJobRegionSize, options.farm_samples);
+    if (options.adaptive_sampling)
+      printf("Adaptive sampling is not used by farm, all pixels get all the samples\n");
+    
+    std::deque<uint32_t> pending_jobs;
+    for (uint32_t job_idx = 0; job_idx < (uint32_t)jobs.size(); job_idx++)
+      pending_jobs.push_back(job_idx);
+    std::vector<uint32_t> finished_jobs_of_pass(num_passes, 0);
+    uint32_t num_finished_jobs = 0, num_finished_passes = 0, num_requeued_jobs = 0;
+    uint32_t num_alive_workers = options.farm_workers;
+    uint64_t total_rays = 0, total_paths = 0;
+    
+    // Results of passes after the first unfinished pass, added after its checkpoint
+    std::vector<JobResult> early_results;
+    
+    // Idle worker takes next job. Returns false if worker is gone
+    auto assign_job = [&](Worker& worker) {
+      if (pending_jobs.empty())
+        return true;
+      const uint32_t job_idx = pending_jobs.front();
+      pending_jobs.pop_front();
+      worker.job_idx = (int32_t)job_idx;
+      worker.job_start_time = std::chrono::steady_clock::now();
+      return SendMessage(worker.socket, MessageType::Job, job_idx, &jobs[job_idx], sizeof(Job));
+    };
+    // Job of dead or hung worker is traced first by the next free worker
+    auto remove_worker = [&](Worker& worker, const char* reason) {
+      printf("Worker %d %s", worker.pid, reason);
+      if (worker.job_idx >= 0) {
+        pending_jobs.push_front((uint32_t)worker.job_idx);
+        num_requeued_jobs++;
+        printf(", job %d is queued again", worker.job_idx);
+      }
+      printf("\n");
+      StopWorker(worker, true /* kill_process */);
+      num_alive_workers--;
+    };
+    // Adds the samples of result to the accumulation
+    auto accumulate_result = [&](const JobResult& result) {
+      const Job& job = jobs[result.job_idx];
+      RayCheckpoint::Buffers samples;
+      samples.accumulation = result.accumulation.data();
+      samples.albedo = result.albedo.data();
+      samples.normal_depth = result.normal_depth.data();
+      samples.luminance_sq = result.luminance_sq.data();
+      samples.stride = job.region.width;
+      renderer.AccumulateRegion(camera, job.region, samples);
+    };
+    // Reads the result of job of worker and adds it to the accumulation, or keeps it if an earlier pass is not
+    // finished yet. Returns false if worker is gone
+    auto receive_result = [&](Worker& worker, const Message& message) {
+      if (message.job_idx >= jobs.size() or (int32_t)message.job_idx != worker.job_idx)
+        return false;
+      const Job& job = jobs[message.job_idx];
+      const size_t num_pixels = (size_t)job.region.width * job.region.height;
+      if (message.payload_size != sizeof(ResultStatistics) + num_pixels * (3 * sizeof(glm::vec4) + sizeof(float)))
+        return false;
+      JobResult result;
+      result.job_idx = message.job_idx;
+      result.accumulation.resize(num_pixels);
+      result.albedo.resize(num_pixels);
+      result.normal_depth.resize(num_pixels);
+      result.luminance_sq.resize(num_pixels);
+      if (!ReadAll(worker.socket, &result.statistics, sizeof(ResultStatistics), kReceiveTimeoutMs) or
+          !ReadAll(worker.socket, result.accumulation.data(), num_pixels * sizeof(glm::vec4), kReceiveTimeoutMs) or
+          !ReadAll(worker.socket, result.albedo.data(), num_pixels * sizeof(glm::vec4), kReceiveTimeoutMs) or
+          !ReadAll(worker.socket, result.normal_depth.data(), num_pixels * sizeof(glm::vec4), kReceiveTimeoutMs) or
+          !ReadAll(worker.socket, result.luminance_sq.data(), num_pixels * sizeof(float), kReceiveTimeoutMs))
+        return false;
+      worker.job_idx = -1;
+      
+      total_rays += result.statistics.num_rays;
+      total_paths += result.statistics.num_paths;
+      num_finished_jobs++;
+      finished_jobs_of_pass[job.pass]++;
+      if (job.pass == num_finished_passes)
+        accumulate_result(result);
+      else
+        early_results.push_back(std::move(result));
+      return true;
+    };
+    
+    std::vector<pollfd> poll_fds;
+    std::vector<uint32_t> poll_workers;
+    while (num_finished_jobs < jobs.size()) {
+      if (num_alive_workers == 0) {
+        printf("All the workers stopped, %u of %zu jobs are finished\n", num_finished_jobs, jobs.size());
+        StopWorkers(workers);
+        return 1;
+      }
+      
+      poll_fds.clear();
+      poll_workers.clear();
+      for (uint32_t worker_idx = 0; worker_idx < (uint32_t)workers.size(); worker_idx++) {
+        if (workers[worker_idx].socket < 0)
+          continue;
+        poll_fds.push_back({workers[worker_idx].socket, POLLIN, 0});
+        poll_workers.push_back(worker_idx);
+      }
+      if (poll(poll_fds.data(), (nfds_t)poll_fds.size(), kPollIntervalMs) < 0) {
+        if (errno == EINTR)
+          continue;
+        printf("Failed to wait for workers : %s\n", strerror(errno));
+        StopWorkers(workers);
+        return 1;
+      }
+      
+      for (size_t i = 0; i < poll_fds.size(); i++) {
+        if (poll_fds[i].revents == 0)
+          continue;
+        Worker& worker = workers[poll_workers[i]];
+        
+        // Hang up is also read as end of file, after the data sent before it
+        Message message;
+        bool alive = ReadAll(worker.socket, &message, sizeof(Message), kReceiveTimeoutMs);
+        if (alive and message.type == MessageType::Result)
+          alive = receive_result(worker, message);
+        else if (alive)
+          alive = message.type == MessageType::Ready and !worker.ready;
+        worker.ready = true;
+        if (alive)
+          alive = assign_job(worker);
+        if (!alive)
+          remove_worker(worker, "stopped");
+      }
+      
+      // Worker that does not finish its job in time is stopped like a dead one, so that a hung worker never stalls
+      // the farm
+      const auto now = std::chrono::steady_clock::now();
+      for (Worker& worker : workers) {
+        if (worker.socket >= 0 and worker.job_idx >= 0 and
+            now - worker.job_start_time > std::chrono::seconds(options.farm_timeout))
+          remove_worker(worker, "timed out");
+      }
+      
+      // Job of a dead worker waits for a free worker
+      for (Worker& worker : workers) {
+        if (worker.ready and worker.socket >= 0 and worker.job_idx < 0 and !pending_jobs.empty() and
+            !assign_job(worker))
+          remove_worker(worker, "stopped");
+      }
+      
+      // Samples of finished passes are saved, so that a stopped farm can be resumed by single process. Results of
+      // later passes that arrived early are added after the checkpoint, as resume needs same samples in all pixels
+      while (num_finished_passes < num_passes and finished_jobs_of_pass[num_finished_passes] == jobs_per_pass) {
+        num_finished_passes++;
+        double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                      wall_start_time).count();
+        printf("Pass %u/%u  : %u samples per pixel at %.3f ms\n", num_finished_passes, num_passes,
+               std::min(num_finished_passes * options.farm_samples, options.samples), elapsed_ms);
+        if (!options.checkpoint_path.empty())
+          renderer.SaveCheckpoint(options.checkpoint_path);
+        
+        auto next_pass_end = std::stable_partition(early_results.begin(), early_results.end(),
+                                                   [&](const JobResult& result) {
+          return jobs[result.job_idx].pass == num_finished_passes;
+        });
+        std::for_each(early_results.begin(), next_pass_end, accumulate_result);
+        early_results.erase(early_results.begin(), next_pass_end);
+      }
+    }
+    
+    StopWorkers(workers);
+    
+    renderer.GetSetting().denoise = options.denoise;
+    renderer.ResolveImage();
+    if (!ImageWriter::Write(options.output_path, renderer.GetImageData(), renderer.GetWidth(), renderer.GetHeight())) {
+      printf("Failed to write image %s\n", options.output_path.c_str());
+      return 1;
+    }
+    
+    double wall_time_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() -
+                                                                    wall_start_time).count();
+    printf("Output     : %s\n", options.output_path.c_str());
+    if (!options.checkpoint_path.empty())
+      printf("Checkpoint : %s\n", options.checkpoint_path.c_str());
+    printf("Jobs       : %u finished, %u queued again after worker stopped\n", num_finished_jobs, num_requeued_jobs);
+    printf("Rays       : %llu (%.3f M rays/sec over wall time), %llu paths\n", (unsigned long long)total_rays,
+           total_rays / (wall_time_ms / 1000.0) / 1e6, (unsigned long long)total_paths);
+    printf("Wall time  : %.3f ms\n", wall_time_ms);
+    return 0;
+  }
+  
+  int RenderFarm::RunWorker(const CliOptions& options) {
+    const int socket = options.farm_worker_socket;
+    RayScene scene;
+    RayCamera camera;
+    RaySceneSerializer serializer(&scene, &camera);
+    if (!serializer.Deserialize(options.scene_path))
+      return 1;
+    camera.SetViewportSize(options.width, options.height);
+    
+    RayRenderer renderer(true /* headless */);
+    options.Apply(renderer.GetSetting());
+    renderer.Resize(options.width, options.height);
+    
+    if (!SendMessage(socket, MessageType::Ready))
+      return 1;
+    std::vector<char> payload;
+    while (true) {
+      // Coordinator closing the socket also stops the worker
+      Message message;
+      Job job;
+      if (!ReadAll(socket, &message, sizeof(Message)) or message.type != MessageType::Job or
+          message.payload_size != sizeof(Job) or !ReadAll(socket, &job, sizeof(Job)))
+        return message.type == MessageType::Quit ? 0 : 1;
+      
+      RayCheckpoint::Buffers samples = renderer.TraceRegion(scene, camera, job.region, job.first_sample,
+                                                            job.num_samples);
+      ResultStatistics statistics;
+      statistics.num_rays = renderer.GetStatistics().num_rays;
+      statistics.num_paths = renderer.GetStatistics().num_paths;
+      statistics.render_time_ms = renderer.GetStatistics().render_time_ms;
+      
+      // Rows of region are packed without padding of renderer
+      const size_t row_size = job.region.width * (3 * sizeof(glm::vec4) + sizeof(float));
+      payload.resize(sizeof(ResultStatistics) + row_size * job.region.height);
+      char* output = payload.data();
+      std::memcpy(output, &statistics, sizeof(ResultStatistics));
+      output += sizeof(ResultStatistics);
+      output = PackRows(output, samples.accumulation, job.region, samples.stride);
+      output = PackRows(output, samples.albedo, job.region, samples.stride);
+      output = PackRows(output, samples.normal_depth, job.region, samples.stride);
+      output = PackRows(output, samples.luminance_sq, job.region, samples.stride);
+      if (!SendMessage(socket, MessageType::Result, message.job_idx, payload.data(), payload.size()))
+        return 1;
+    }
+  }
+  
+}
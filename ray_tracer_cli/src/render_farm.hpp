@@ -0,0 +1,38 @@
+//
+//  render_farm.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "cli_options.hpp"
+
+namespace ray_tracer {
+  
+  /// This class renders one image with many processes. Coordinator splits the image in regions and the samples in
+  /// passes, and starts the workers as child processes of same tool, connected by a unix socket each. Workers pull
+  /// the jobs (region and sample range) one at a time and send back the sums of samples, which coordinator adds to
+  /// its accumulation as they arrive. Job of a worker that dies, or does not finish it in time, is given to the next
+  /// free worker. Results of a pass that arrive before earlier passes are finished are kept till then, so that the
+  /// checkpoint after each pass has same samples in all pixels.
+  /// - Protocol: each message is a 'Message' header followed by its payload, in native byte order
+  ///   - Worker      : Ready (after loading scene), Result (stats and 4 buffers of region, rows without padding)
+  ///   - Coordinator : Job (region and sample range), Quit
+  class RenderFarm {
+  public:
+    /// This function runs the coordinator, renders the image and prints the results. Returns exit code of tool
+    /// - Parameters:
+    ///   - options: command line options
+    ///   - argc: number of arguments of tool, passed to workers
+    ///   - argv: arguments of tool, passed to workers
+    static int Run(const CliOptions& options, int argc, const char* argv[]);
+    /// This function runs the worker on socket of coordinator till it is asked to quit. Returns exit code of tool
+    /// - Parameter options: command line options (scene, size, render options and socket are used)
+    static int RunWorker(const CliOptions& options);
+    
+    MAKE_PURE_STATIC(RenderFarm);
+  };
+  
+}
@@ -0,0 +1,93 @@
+//
+//  sampler_benchmark.cpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#include "sampler_benchmark.hpp"
+#include "image_compare.hpp"
+
+using namespace ikan;
+
+namespace ray_tracer {
+  
+  static constexpr RaySampler::Type kSamplers[] = {
+    RaySampler::Type::Random, RaySampler::Type::Sobol, RaySampler::Type::BlueNoise
+  };
+  static constexpr uint32_t kNumSamplers = sizeof(kSamplers) / sizeof(kSamplers[0]);
+  
+  int SamplerBenchmark::Run(const CliOptions& options) {
+    RayScene scene;
+    RayCamera camera;
+    RaySceneSerializer serializer(&scene, &camera);
+    if (!serializer.Deserialize(options.scene_path)) {
+      printf("Failed to load scene %s\n", options.scene_path.c_str());
+      return 1;
+    }
+    camera.SetViewportSize(options.width, options.height);
+    
+    const uint32_t max_samples = options.sampler_benchmark_samples;
+    const uint32_t reference_samples = options.reference_samples > 0 ? options.reference_samples : 16 * max_samples;
+    printf("Sampler benchmark : %s, %u x %u, reference %u samples\n", options.scene_path.c_str(), options.width,
+           options.height, reference_samples);
+    
+    // Reference is rendered with other seed, so that its noise is not correlated with any of the samplers
+    RayRenderer reference_renderer(true /* headless */);
+    options.Apply(reference_renderer.GetSetting());
+    reference_renderer.GetSetting().seed = options.seed + 1;
+    reference_renderer.Resize(options.width, options.height);
+    for (uint32_t sample = 0; sample < reference_samples; sample++)
+      reference_renderer.Render(scene, camera);
+    const std::vector<glm::vec3> reference = ImageCompare::GetImage(reference_renderer);
+    
+    // Errors at each power of two samples, and at last sample
+    std::vector<uint32_t> row_samples;
+    std::vector<double> errors[kNumSamplers], blurred_errors[kNumSamplers];
+    double render_time_ms[kNumSamplers] = {};
+    for (uint32_t sampler_idx = 0; sampler_idx < kNumSamplers; sampler_idx++) {
+      RayRenderer renderer(true /* headless */);
+      options.Apply(renderer.GetSetting());
+      renderer.GetSetting().sampler = kSamplers[sampler_idx];
+      renderer.Resize(options.width, options.height);
+      
+      for (uint32_t sample = 1; sample <= max_samples; sample++) {
+        renderer.Render(scene, camera);
+        render_time_ms[sampler_idx] += renderer.GetStatistics().render_time_ms;
+        if ((sample & (sample - 1)) != 0 and sample != max_samples)
+          continue;
+        
+        const std::vector<glm::vec3> image = ImageCompare::GetImage(renderer);
+        errors[sampler_idx].push_back(ImageCompare::GetError(image, reference, options.width, options.height));
+        blurred_errors[sampler_idx].push_back(ImageCompare::GetError(image, reference, options.width, options.height,
+                                                                     1 /* blur_radius */));
+        if (sampler_idx == 0)
+          row_samples.push_back(sample);
+      }
+    }
+    
+    printf("%8s    %-36s  %s\n", "", "RMSE (8 bit)", "RMSE of 3 x 3 blurred error");
+    printf("%8s  ", "Samples");
+    for (uint32_t table = 0; table < 2; table++) {
+      printf(table > 0 ? "  " : "");
+      for (RaySampler::Type sampler : kSamplers)
+        printf(" %11s", RaySampler::GetTypeName(sampler));
+    }
+    printf("\n");
+    for (size_t row = 0; row < row_samples.size(); row++) {
+      printf("%8u  ", row_samples[row]);
+      for (uint32_t sampler_idx = 0; sampler_idx < kNumSamplers; sampler_idx++)
+        printf(" %11.3f", errors[sampler_idx][row]);
+      printf("  ");
+      for (uint32_t sampler_idx = 0; sampler_idx < kNumSamplers; sampler_idx++)
+        printf(" %11.3f", blurred_errors[sampler_idx][row]);
+      printf("\n");
+    }
+    printf("%8s  ", "ms/spp");
+    for (uint32_t sampler_idx = 0; sampler_idx < kNumSamplers; sampler_idx++)
+      printf(" %11.3f", render_time_ms[sampler_idx] / max_samples);
+    printf("\n");
+    return 0;
+  }
+  
+}
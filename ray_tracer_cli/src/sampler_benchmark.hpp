@@ -0,0 +1,27 @@
+//
+//  sampler_benchmark.hpp
+//  ray_tracer_cli
+//
+//  Created by Ashish . on 16/10/26.
+//
+
+#pragma once
+
+#include "cli_options.hpp"
+
+namespace ray_tracer {
+  
+  /// This class measures the error of each sampler against samples per pixel. Scene is rendered once with many
+  /// samples as reference, then with each sampler and the RMSE of image is printed at every power of two samples.
+  /// Error is also printed after blurring it by 3 x 3 box, which shows how much of the error is low frequency
+  /// (blotches) that stays visible from a distance
+  class SamplerBenchmark {
+  public:
+    /// This function runs the benchmark and prints the results. Returns exit code of tool
+    /// - Parameter options: command line options (scene, size, render options and benchmark samples are used)
+    static int Run(const CliOptions& options);
+    
+    MAKE_PURE_STATIC(SamplerBenchmark);
+  };
+  
+}